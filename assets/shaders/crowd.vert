@@ -0,0 +1,52 @@
+#version 410 core
+
+// One bone endpoint per vertex, drawn once per character. Poses come from the baked pose buffer
+// (two texels per joint: position, rotation); each character has two texels in u_Instances:
+// (placement, phase in seconds) and (first frame, frame count, frame time, 0). With u_PerInstance
+// the poses were already evaluated, one frame per character, e.g. by GPU forward kinematics.
+layout(location = 0) in float a_Joint;
+
+layout(location = 0) out vec3 v_Position;
+
+uniform samplerBuffer u_Poses;
+uniform samplerBuffer u_Instances;
+uniform int           u_Joints;
+uniform float         u_Time;
+uniform bool          u_PerInstance;
+
+layout(std140) uniform FrameConstants {
+    mat4  u_Projection;
+    mat4  u_View;
+    vec3  u_Eye;
+    float u_Clock;
+};
+
+vec3 FetchPosition(int frame, int joint)
+{
+    return texelFetch(u_Poses, (frame * u_Joints + joint) * 2).xyz;
+}
+
+void main()
+{
+    vec4  placement = texelFetch(u_Instances, gl_InstanceID * 2);
+    int   joint     = int(a_Joint + .5);
+    if (u_PerInstance)
+    {
+        v_Position  = FetchPosition(gl_InstanceID, joint) + placement.xyz;
+        gl_Position = u_Projection * u_View * vec4(v_Position, 1.);
+        return;
+    }
+
+    vec4  range     = texelFetch(u_Instances, gl_InstanceID * 2 + 1);
+    int   first     = int(range.x);
+    float frames    = range.y;
+
+    // Looping playback, the last frame blends back into the first
+    float pos = mod((u_Time + placement.w) / range.z, frames);
+    int   f0  = int(pos);
+    int   f1  = f0 + 1 < int(frames) ? f0 + 1 : 0;
+    vec3  p   = mix(FetchPosition(first + f0, joint), FetchPosition(first + f1, joint), pos - float(f0));
+
+    v_Position  = p + placement.xyz;
+    gl_Position = u_Projection * u_View * vec4(v_Position, 1.);
+}
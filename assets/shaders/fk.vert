@@ -0,0 +1,69 @@
+#version 410 core
+
+// Forward kinematics, one vertex per (character, joint), drawn once per hierarchy level with the
+// rasterizer off. Joints of the current level sample their clip and compose with the parent from
+// the previous level's output; finished joints are copied forward. Output and u_Source have two
+// texels per joint, the scene-space position and the global rotation.
+uniform samplerBuffer  u_Source;
+uniform samplerBuffer  u_Tracks;     // Local offset, then rotation, per frame and joint
+uniform samplerBuffer  u_Instances;  // (placement, phase), (first frame, frames, frame time, 0)
+uniform isamplerBuffer u_Hierarchy;  // Parent and depth of each joint
+uniform int            u_Joints;
+uniform int            u_Level;
+uniform float          u_Time;
+uniform float          u_Scale;
+uniform vec3           u_Offset;
+
+out vec4 o_Position;
+out vec4 o_Rotation;
+
+vec4 QuatMul(vec4 a, vec4 b)
+{
+    return vec4(a.w * b.xyz + b.w * a.xyz + cross(a.xyz, b.xyz), a.w * b.w - dot(a.xyz, b.xyz));
+}
+
+vec3 QuatRotate(vec4 q, vec3 v)
+{
+    vec3 t = 2. * cross(q.xyz, v);
+    return v + q.w * t + cross(q.xyz, t);
+}
+
+void main()
+{
+    int   character = gl_VertexID / u_Joints;
+    int   joint     = gl_VertexID - character * u_Joints;
+    ivec2 node      = texelFetch(u_Hierarchy, joint).xy;
+    if (node.y != u_Level)
+    {
+        // Deeper joints are written by later passes
+        bool done  = node.y < u_Level;
+        o_Position = done ? texelFetch(u_Source, gl_VertexID * 2) : vec4(0., 0., 0., 1.);
+        o_Rotation = done ? texelFetch(u_Source, gl_VertexID * 2 + 1) : vec4(0., 0., 0., 1.);
+        return;
+    }
+
+    // Looping playback as in BakedClip::Sample: lerp offsets, nlerp rotations along the short arc
+    vec4  range = texelFetch(u_Instances, character * 2 + 1);
+    float phase = texelFetch(u_Instances, character * 2).w;
+    float pos   = mod((u_Time + phase) / range.z, range.y);
+    int   f0    = int(pos);
+    int   f1    = f0 + 1 < int(range.y) ? f0 + 1 : 0;
+    float a     = pos - float(f0);
+    int   t0    = ((int(range.x) + f0) * u_Joints + joint) * 2;
+    int   t1    = ((int(range.x) + f1) * u_Joints + joint) * 2;
+    vec3  offset = mix(texelFetch(u_Tracks, t0).xyz, texelFetch(u_Tracks, t1).xyz, a);
+    vec4  q0     = texelFetch(u_Tracks, t0 + 1);
+    vec4  q1     = texelFetch(u_Tracks, t1 + 1);
+    vec4  local  = normalize(mix(q0, dot(q0, q1) < 0. ? -q1 : q1, a));
+
+    if (node.x < 0)
+    {
+        o_Position = vec4(u_Offset + u_Scale * offset, 1.);
+        o_Rotation = local;
+        return;
+    }
+    int  parent         = (character * u_Joints + node.x) * 2;
+    vec4 parentRotation = texelFetch(u_Source, parent + 1);
+    o_Position = vec4(texelFetch(u_Source, parent).xyz + u_Scale * QuatRotate(parentRotation, offset), 1.);
+    o_Rotation = QuatMul(parentRotation, local);
+}
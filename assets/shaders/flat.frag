@@ -4,9 +4,12 @@ layout(location = 0) in vec3 v_Position;
 
 layout(location = 0) out vec4 f_Color;
 
-uniform vec3 u_Color;
+layout(std140) uniform DrawConstants {
+    vec4  u_Color;
+    vec4  u_Offset;     // xyz
+};
 
 void main()
 {
-    f_Color = vec4(u_Color, 1.);
+    f_Color = u_Color;
 }
\ No newline at end of file
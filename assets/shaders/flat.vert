@@ -4,12 +4,20 @@ layout(location = 0) in vec3 a_Position;
 
 layout(location = 0) out vec3 v_Position;
 
-uniform mat4 u_Projection;
-uniform mat4 u_View;
-uniform vec3 u_Color;
+layout(std140) uniform FrameConstants {
+    mat4  u_Projection;
+    mat4  u_View;
+    vec3  u_Eye;
+    float u_Clock;
+};
+
+layout(std140) uniform DrawConstants {
+    vec4  u_Color;
+    vec4  u_Offset;     // xyz
+};
 
 void main()
 {
-    v_Position = a_Position;
+    v_Position = a_Position + u_Offset.xyz;
     gl_Position = u_Projection * u_View * vec4(v_Position, 1.);
 }
\ No newline at end of file
@@ -0,0 +1,11 @@
+#version 410 core
+
+layout(location = 0) in vec3 v_Position;
+layout(location = 1) in vec4 v_Color;
+
+layout(location = 0) out vec4 f_Color;
+
+void main()
+{
+    f_Color = v_Color;
+}
@@ -0,0 +1,40 @@
+#version 410 core
+
+// Onion skin: one bone endpoint per vertex, drawn once per ghost. Poses come from the baked pose
+// buffer (two texels per joint: position, rotation); each ghost has one texel in u_Ghosts:
+// (frame in the buffer, signed distance in time over the window, 0, 0).
+layout(location = 0) in float a_Joint;
+
+layout(location = 0) out vec3 v_Position;
+layout(location = 1) out vec4 v_Color;
+
+uniform samplerBuffer u_Poses;
+uniform samplerBuffer u_Ghosts;
+uniform int           u_Joints;
+uniform vec3          u_PastColor;
+uniform vec3          u_FutureColor;
+uniform float         u_NearAlpha;
+uniform float         u_FarAlpha;
+
+layout(std140) uniform FrameConstants {
+    mat4  u_Projection;
+    mat4  u_View;
+    vec3  u_Eye;
+    float u_Clock;
+};
+
+layout(std140) uniform DrawConstants {
+    vec4  u_Color;
+    vec4  u_Offset;     // xyz
+};
+
+void main()
+{
+    vec4 ghost  = texelFetch(u_Ghosts, gl_InstanceID);
+    int  frame  = int(ghost.x + .5);
+    int  joint  = int(a_Joint + .5);
+
+    v_Color     = vec4(ghost.y < 0. ? u_PastColor : u_FutureColor, mix(u_NearAlpha, u_FarAlpha, clamp(abs(ghost.y), 0., 1.)));
+    v_Position  = texelFetch(u_Poses, (frame * u_Joints + joint) * 2).xyz + u_Offset.xyz;
+    gl_Position = u_Projection * u_View * vec4(v_Position, 1.);
+}
@@ -0,0 +1,73 @@
+#version 410 core
+
+// three.vert with skinning. For linear blending the palette holds a row-major 3x4 matrix per
+// joint, three texels each; for dual quaternions two texels, the rotation and the dual part. Both
+// map the rest pose to the current one.
+layout(location = 0) in  vec3 a_Position;
+layout(location = 1) in  vec3 a_Normal;
+layout(location = 2) in  vec2 a_TexCoord;
+layout(location = 3) in  vec4 a_Joints;
+layout(location = 4) in  vec4 a_Weights;
+
+layout(location = 0) out vec3 v_Position;
+layout(location = 1) out vec3 v_Normal;
+layout(location = 2) out vec2 v_TexCoord;
+
+layout(std140) uniform PassConstants {
+    mat4  u_NormalTransform;
+    mat4  u_Model;
+    mat4  u_View;
+    mat4  u_Projection;
+    vec3  u_LightDirection;
+    vec3  u_LightColor;
+    vec3  u_ObjectColor;
+    float u_Ambient;
+    bool  u_HasTexCoord;
+    bool  u_Wireframe;
+    bool  u_Flat;
+};
+
+uniform samplerBuffer u_Palette;
+uniform bool          u_DualQuaternion;
+
+// Rotation by a unit quaternion
+vec3 rotate(vec4 q, vec3 v) {
+    return v + 2. * cross(q.xyz, cross(q.xyz, v) + q.w * v);
+}
+
+void main() {
+    vec3 position, normal;
+    if (u_DualQuaternion) {
+        // Blend in the hemisphere of the first influence, q and -q being the same rotation
+        vec4 pivot = texelFetch(u_Palette, int(a_Joints[0] + .5) * 2);
+        vec4 real  = vec4(0.), dual = vec4(0.);
+        for (int k = 0; k < 4; ++k) {
+            int   joint  = int(a_Joints[k] + .5);
+            vec4  r      = texelFetch(u_Palette, joint * 2);
+            float weight = dot(r, pivot) < 0. ? -a_Weights[k] : a_Weights[k];
+            real += weight * r;
+            dual += weight * texelFetch(u_Palette, joint * 2 + 1);
+        }
+        float norm = length(real);
+        real /= norm;
+        dual /= norm;
+        // Translation 2 * dual * conjugate(real)
+        position = rotate(real, a_Position) + 2. * (real.w * dual.xyz - dual.w * real.xyz + cross(real.xyz, dual.xyz));
+        normal   = rotate(real, a_Normal);
+    } else {
+        vec4 rows[3] = vec4[3](vec4(0.), vec4(0.), vec4(0.));
+        for (int k = 0; k < 4; ++k) {
+            int joint = int(a_Joints[k] + .5);
+            for (int r = 0; r < 3; ++r)
+                rows[r] += a_Weights[k] * texelFetch(u_Palette, joint * 3 + r);
+        }
+        mat4 skin = transpose(mat4(rows[0], rows[1], rows[2], vec4(0., 0., 0., 1.)));
+        position  = vec3(skin * vec4(a_Position, 1.));
+        normal    = vec3(skin * vec4(a_Normal, 0.));
+    }
+
+    v_Position  = vec3(u_Model * vec4(position, 1.));
+    v_Normal    = vec3(u_NormalTransform * vec4(normal, 1.));
+    v_TexCoord  = a_TexCoord;
+    gl_Position = u_Projection * u_View * vec4(v_Position, 1.);
+}
@@ -0,0 +1,38 @@
+#version 410 core
+
+// Joint trajectories over a whole clip, static per clip. Each vertex carries its time and the
+// joint's speed there; the path ahead of u_Time is drawn faded.
+layout(location = 0) in vec3 a_Position;
+layout(location = 1) in vec2 a_Sample;     // (time in seconds, speed in scene units per second)
+
+layout(location = 0) out vec3 v_Position;
+layout(location = 1) out vec4 v_Color;
+
+uniform float u_Time;
+uniform float u_MaxSpeed;
+
+layout(std140) uniform FrameConstants {
+    mat4  u_Projection;
+    mat4  u_View;
+    vec3  u_Eye;
+    float u_Clock;
+};
+
+layout(std140) uniform DrawConstants {
+    vec4  u_Color;
+    vec4  u_Offset;     // xyz
+};
+
+// Slow to fast: blue, green, yellow, red
+vec3 Ramp(float t)
+{
+    return clamp(vec3(1.5 - abs(4. * t - 3.), 1.5 - abs(4. * t - 2.), 1.5 - abs(4. * t - 1.)), 0., 1.);
+}
+
+void main()
+{
+    float ahead = a_Sample.x > u_Time ? 1. : 0.;
+    v_Color     = vec4(Ramp(clamp(a_Sample.y / u_MaxSpeed, 0., 1.)), mix(.9, .25, ahead));
+    v_Position  = a_Position + u_Offset.xyz;
+    gl_Position = u_Projection * u_View * vec4(v_Position, 1.);
+}
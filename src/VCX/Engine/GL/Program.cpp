@@ -1,4 +1,6 @@
+#include <algorithm>
 #include <array>
+#include <cstring>
 
 #include <spdlog/spdlog.h>
 
@@ -8,19 +10,83 @@ namespace VCX::Engine::GL {
     static void CheckProgram(GLuint);
 
     void UniqueProgram::BindUniformBlock(char const * const name, std::uint32_t const bindingPoint) const {
-        glUniformBlockBinding(Get(), glGetUniformBlockIndex(Get(), name), bindingPoint);
+        // programs without the block are left alone
+        if (auto const index { glGetUniformBlockIndex(Get(), name) }; index != GL_INVALID_INDEX)
+            glUniformBlockBinding(Get(), index, bindingPoint);
     }
 
-    GLuint UniqueProgram::CreateProgramFromShaders(std::initializer_list<SharedShader> const & shaders) {
+    GLuint UniqueProgram::CreateProgramFromShaders(std::initializer_list<SharedShader> const & shaders, std::initializer_list<char const *> const & feedbackVaryings) {
         auto const program { glCreateProgram() };
         for (auto const & shader : shaders) {
             glAttachShader(program, shader.Get());
         }
+        if (feedbackVaryings.size() > 0) {
+            glTransformFeedbackVaryings(program, GLsizei(feedbackVaryings.size()), feedbackVaryings.begin(), GL_INTERLEAVED_ATTRIBS);
+        }
         glLinkProgram(program);
         CheckProgram(program);
         return program;
     }
 
+    UniformCollection::UniformCollection(GLuint const program):
+        _program(program) {
+        GLint count { 0 }, maxLength { 0 };
+        glGetProgramiv(program, GL_ACTIVE_UNIFORMS, &count);
+        glGetProgramiv(program, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+        std::vector<GLchar> name(std::max(maxLength, 1));
+        for (GLint i = 0; i < count; ++i) {
+            GLsizei length { 0 };
+            GLint   size { 0 };
+            GLenum  type { 0 };
+            glGetActiveUniform(program, GLuint(i), GLsizei(name.size()), &length, &size, &type, name.data());
+            // members of uniform blocks have no location
+            GLint const location { glGetUniformLocation(program, name.data()) };
+            if (location < 0) continue;
+
+            std::string entryName(name.data(), length);
+            if (entryName.ends_with("[0]")) entryName.resize(entryName.size() - 3);
+            std::uint32_t const bytes { size == 1 ? GetByteSize(type) : 0u };
+            _entries.push_back({ std::move(entryName), location, type, std::uint32_t(_values.size()), bytes });
+            _values.resize(_values.size() + bytes);
+        }
+        std::sort(_entries.begin(), _entries.end(), [](Entry const & a, Entry const & b) { return a.Name < b.Name; });
+    }
+
+    std::uint32_t UniformCollection::GetByteSize(GLenum const type) {
+        switch (type) {
+        case GL_FLOAT_VEC2:
+        case GL_INT_VEC2:   return 8;
+        case GL_FLOAT_VEC3:
+        case GL_INT_VEC3:   return 12;
+        case GL_FLOAT_VEC4:
+        case GL_INT_VEC4:
+        case GL_FLOAT_MAT2: return 16;
+        case GL_FLOAT_MAT3: return 36;
+        case GL_FLOAT_MAT4: return 64;
+        default:            return 4; // scalars, booleans and samplers
+        }
+    }
+
+    int UniformCollection::Find(char const * const name) const {
+        ++_stats.Lookups;
+        auto const iter { std::lower_bound(_entries.begin(), _entries.end(), name, [](Entry const & entry, char const * const key) { return entry.Name < key; }) };
+        return iter != _entries.end() && iter->Name == name ? int(iter - _entries.begin()) : -1;
+    }
+
+    bool UniformCollection::Store(Entry & entry, void const * const value, std::size_t const size) {
+        if (entry.Size != size) return true;
+        std::byte * const shadow { _values.data() + entry.Offset };
+        if (entry.Known && std::memcmp(shadow, value, size) == 0) return false;
+        std::memcpy(shadow, value, size);
+        entry.Known = true;
+        return true;
+    }
+
+    void UniformCollection::Forget(GLint const location) {
+        for (auto & entry : _entries)
+            if (entry.Location == location) entry.Known = false;
+    }
+
     static void CheckProgram(GLuint const program) {
         GLint success;
         glGetProgramiv(program, GL_LINK_STATUS, &success);
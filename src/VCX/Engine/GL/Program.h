@@ -15,6 +15,7 @@ namespace VCX::Engine::GL {
         static auto constexpr & Create = glCreateProgram;
         static auto constexpr & Delete = glDeleteProgram;
         static auto constexpr & Bind   = glUseProgram;
+        static auto constexpr   Cached = State::Binding::Program;
     };
 
     class UniqueProgram : public Unique<ProgramTrait> {
@@ -24,12 +25,18 @@ namespace VCX::Engine::GL {
             _uniforms(Get()) {
         }
 
+        // the varyings are captured by transform feedback, interleaved in this order.
+        UniqueProgram(std::initializer_list<SharedShader> && shaders, std::initializer_list<char const *> && feedbackVaryings):
+            Unique(CreateProgramFromShaders(shaders, feedbackVaryings)),
+            _uniforms(Get()) {
+        }
+
         UniformCollection & GetUniforms() { return _uniforms; }
 
         void BindUniformBlock(char const * const name, std::uint32_t const bindingPoint) const;
 
     private:
-        static GLuint CreateProgramFromShaders(std::initializer_list<SharedShader> const &);
+        static GLuint CreateProgramFromShaders(std::initializer_list<SharedShader> const &, std::initializer_list<char const *> const & feedbackVaryings = {});
 
         UniformCollection _uniforms;
     };
@@ -35,6 +35,7 @@ namespace VCX::Engine::GL {
         int                            const    first,
         int                            const    instanceCount) const {
         gl_using(_vao);
+        State::CountDraw();
         glDrawArraysInstanced(_mode, first, count ? count : _vtxCount, instanceCount);
     }
 
@@ -42,14 +43,13 @@ namespace VCX::Engine::GL {
         VertexLayout  const & layout,
         PrimitiveType const   primitiveType) :
         UniqueRenderItem(layout, primitiveType) {
-        glBindVertexArray(_vao.Get());
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _ebo.Get());
-        glBindVertexArray(0);
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+        gl_using(_vao);
+        gl_using(_ebo);
     }
 
     void UniqueIndexedRenderItem::UpdateElementBuffer(std::span<std::uint32_t const> const & data) {
-        gl_using(_ebo);
+        // through the own vertex array: another one may still be bound, see State
+        gl_using(_vao);
         glBufferData(GL_ELEMENT_ARRAY_BUFFER, data.size_bytes(), data.data(), GL_STATIC_DRAW);
         _idxCount = data.size();
     }
@@ -60,6 +60,7 @@ namespace VCX::Engine::GL {
         int                            const    baseVertex,
         int                            const    instanceCount) const {
         gl_using(_vao);
+        State::CountDraw();
         glDrawElementsInstancedBaseVertex(_mode, count ? count : _idxCount, GL_UNSIGNED_INT, nullptr, instanceCount, baseVertex);
     }
 }
@@ -0,0 +1,218 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+
+#include <glad/glad.h>
+
+namespace VCX::Engine::GL {
+    struct StateStats {
+        std::uint64_t Calls   { 0 }; // state changes issued, including the draws
+        std::uint64_t Skipped { 0 }; // the state held already, or a scope's unbind left out
+        std::uint64_t Draws   { 0 };
+
+        void Reset() { *this = StateStats { }; }
+    };
+
+    // a mirror of the state that Use() scopes and draws change most: the program, the vertex
+    // array, buffer and texture bindings, and a few fixed-function values. binding what is bound
+    // already issues no call, and scopes leave their object bound instead of binding 0 on exit, so
+    // consecutive draws with one program or item bind it once. anything changing this state behind
+    // its back has to go through it or call Invalidate; NewFrame does so before every frame.
+    class State {
+    public:
+        enum class Binding : std::uint8_t {
+            Program,
+            VertexArray,
+            ArrayBuffer,
+            ElementArrayBuffer, // part of the vertex array, forgotten when that changes
+            UniformBuffer,
+            TexelBuffer,        // the GL_TEXTURE_BUFFER buffer target
+            Texture2D,          // textures on the active unit
+            TextureCubeMap,
+            TextureBuffer,
+            Count,
+        };
+
+        // true when the caller has to issue the bind itself.
+        static bool Bind(Binding const binding, GLuint const o) {
+            GLuint & bound { Slot(binding) };
+            if (bound == o) {
+                ++_stats.Skipped;
+                return false;
+            }
+            bound = o;
+            if (binding == Binding::VertexArray) _bound[std::size_t(Binding::ElementArrayBuffer)] = c_Unknown;
+            ++_stats.Calls;
+            return true;
+        }
+
+        // the unbind of a scope: the object stays bound until something else is.
+        static void Release(Binding const) { ++_stats.Skipped; }
+
+        // the object was deleted, GL unbinds it and may hand out its name again.
+        static void Forget(Binding const binding, GLuint const o) {
+            auto const forget = [o](GLuint & bound) { if (bound == o) bound = c_Unknown; };
+            if (binding >= Binding::Texture2D) {
+                for (auto & unit : _textures) std::for_each(unit.begin(), unit.end(), forget);
+                return;
+            }
+            if (binding == Binding::Program || binding == Binding::VertexArray) {
+                forget(_bound[std::size_t(binding)]);
+                if (binding == Binding::VertexArray) _bound[std::size_t(Binding::ElementArrayBuffer)] = c_Unknown;
+                return;
+            }
+            // buffer names are shared by all buffer targets
+            for (std::size_t b { std::size_t(Binding::ArrayBuffer) }; b <= std::size_t(Binding::TexelBuffer); ++b) forget(_bound[b]);
+            for (auto & range : _uniformRanges) forget(range.Buffer);
+        }
+
+        static void UseProgram(GLuint const program) {
+            if (Bind(Binding::Program, program)) glUseProgram(program);
+        }
+
+        // like Bind, on the given unit; the active unit only changes with the binding, so calls on
+        // the bound texture have to make it active themselves.
+        static bool BindTexture(std::uint32_t const unit, Binding const binding, GLuint const o) {
+            if (unit < c_Units && _textures[unit][std::size_t(binding) - std::size_t(Binding::Texture2D)] == o) {
+                ++_stats.Skipped;
+                return false;
+            }
+            ActiveTexture(unit);
+            return Bind(binding, o);
+        }
+
+        static void ActiveTexture(std::uint32_t const unit) {
+            if (_active == unit) {
+                ++_stats.Skipped;
+                return;
+            }
+            ++_stats.Calls;
+            glActiveTexture(GL_TEXTURE0 + unit);
+            _active = unit < c_Units ? unit : c_Unknown;
+        }
+
+        // binds the range to an indexed uniform buffer point, the whole buffer for a zero size;
+        // like GL, it binds the buffer to GL_UNIFORM_BUFFER too.
+        static void BindUniformRange(std::uint32_t const point, GLuint const buffer, GLintptr const offset = 0, GLsizeiptr const size = 0) {
+            UniformRange * const range { point < c_UniformPoints ? &_uniformRanges[point] : nullptr };
+            if (range && range->Buffer == buffer && range->Offset == offset && range->Size == size) {
+                ++_stats.Skipped;
+                return;
+            }
+            ++_stats.Calls;
+            if (size == 0) glBindBufferBase(GL_UNIFORM_BUFFER, point, buffer);
+            else glBindBufferRange(GL_UNIFORM_BUFFER, point, buffer, offset, size);
+            if (range) *range = { buffer, offset, size };
+            _bound[std::size_t(Binding::UniformBuffer)] = buffer;
+        }
+
+        static void LineWidth(float const width) {
+            if (Change(_lineWidth, width)) glLineWidth(width);
+        }
+
+        static void PointSize(float const size) {
+            if (Change(_pointSize, size)) glPointSize(size);
+        }
+
+        static void BlendFunc(GLenum const source, GLenum const destination) {
+            if (_blendSource == source && _blendDestination == destination) {
+                ++_stats.Skipped;
+                return;
+            }
+            ++_stats.Calls;
+            _blendSource      = source;
+            _blendDestination = destination;
+            glBlendFunc(source, destination);
+        }
+
+        // GL_BLEND, GL_DEPTH_TEST, GL_CULL_FACE and GL_RASTERIZER_DISCARD are mirrored, other
+        // capabilities always issue the call.
+        static void Enable(GLenum const capability, bool const enabled = true) {
+            auto const it { std::find(c_Capabilities.begin(), c_Capabilities.end(), capability) };
+            if (it != c_Capabilities.end() && ! Change(_enabled[it - c_Capabilities.begin()], std::int8_t(enabled))) return;
+            if (it == c_Capabilities.end()) ++_stats.Calls;
+            if (enabled) glEnable(capability);
+            else glDisable(capability);
+        }
+
+        static void Disable(GLenum const capability) { Enable(capability, false); }
+
+        static void CountDraw() {
+            ++_stats.Calls;
+            ++_stats.Draws;
+        }
+
+        // nothing is assumed bound or set afterwards.
+        static void Invalidate() {
+            _bound.fill(c_Unknown);
+            for (auto & unit : _textures) unit.fill(c_Unknown);
+            _uniformRanges.fill({ c_Unknown, 0, 0 });
+            _active           = c_Unknown;
+            _lineWidth        = -1.f;
+            _pointSize        = -1.f;
+            _blendSource      = c_Unknown;
+            _blendDestination = c_Unknown;
+            _enabled.fill(-1);
+        }
+
+        // closes the counters of the last frame and forgets the state, which other code, e.g. the
+        // ImGui backend, may have changed in between.
+        static void NewFrame() {
+            _frame = _stats;
+            _stats.Reset();
+            Invalidate();
+        }
+
+        static StateStats const & GetStats() { return _stats; }
+        static StateStats const & GetFrameStats() { return _frame; } // of the last frame
+
+    private:
+        static GLuint constexpr        c_Unknown       { ~GLuint(0) };
+        static std::uint32_t constexpr c_Units         { 32 };
+        static std::uint32_t constexpr c_UniformPoints { 16 };
+
+        static inline std::array<GLenum, 4> const c_Capabilities { GL_BLEND, GL_DEPTH_TEST, GL_CULL_FACE, GL_RASTERIZER_DISCARD };
+
+        struct UniformRange {
+            GLuint     Buffer;
+            GLintptr   Offset;
+            GLsizeiptr Size;
+        };
+
+        static GLuint & Slot(Binding const binding) {
+            if (binding < Binding::Texture2D) return _bound[std::size_t(binding)];
+            // an unknown unit cannot be told apart, every unit's binding is given up
+            if (_active == c_Unknown) {
+                for (auto & unit : _textures) unit[std::size_t(binding) - std::size_t(Binding::Texture2D)] = c_Unknown;
+                static GLuint scratch;
+                return scratch = c_Unknown;
+            }
+            return _textures[_active][std::size_t(binding) - std::size_t(Binding::Texture2D)];
+        }
+
+        template<typename T>
+        static bool Change(T & mirrored, T const value) {
+            if (mirrored == value) {
+                ++_stats.Skipped;
+                return false;
+            }
+            mirrored = value;
+            ++_stats.Calls;
+            return true;
+        }
+
+        static inline std::array<GLuint, std::size_t(Binding::Texture2D)> _bound { };
+        static inline std::array<std::array<GLuint, 3>, c_Units>          _textures { };
+        static inline std::array<UniformRange, c_UniformPoints>           _uniformRanges { };
+        static inline std::array<std::int8_t, 4>                          _enabled { };
+        static inline GLuint                                              _active { c_Unknown };
+        static inline float                                               _lineWidth { -1.f };
+        static inline float                                               _pointSize { -1.f };
+        static inline GLenum                                              _blendSource { c_Unknown };
+        static inline GLenum                                              _blendDestination { c_Unknown };
+        static inline StateStats                                          _stats;
+        static inline StateStats                                          _frame;
+    };
+} // namespace VCX::Engine::GL
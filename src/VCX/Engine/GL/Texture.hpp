@@ -34,6 +34,7 @@ namespace VCX::Engine::GL {
         static auto constexpr & DeleteMany = glDeleteTextures;
         static auto constexpr & Bind       = glBindTexture;
         static GLenum constexpr BindTarget = GL_TEXTURE_2D;
+        static auto constexpr   Cached     = State::Binding::Texture2D;
     };
 
 	struct TextureCubeMapTrait {
@@ -41,6 +42,7 @@ namespace VCX::Engine::GL {
 		static auto constexpr & DeleteMany = glDeleteTextures;
         static auto constexpr & Bind       = glBindTexture;
         static GLenum constexpr BindTarget = GL_TEXTURE_CUBE_MAP;
+        static auto constexpr   Cached     = State::Binding::TextureCubeMap;
 	};
 
     template<typename TypeTrait>
@@ -68,16 +70,19 @@ namespace VCX::Engine::GL {
         }
 
         scope_t Use() const {
-            glActiveTexture(GL_TEXTURE0 + _unit);
-            glBindTexture(TypeEnum, Unique<TypeTrait>::Get());
-            return scope_t([=]() {
-                glActiveTexture(GL_TEXTURE0 + _unit);
-                glBindTexture(TypeEnum, 0);
-            });
+            if (State::BindTexture(_unit, TypeTrait::Cached, Unique<TypeTrait>::Get()))
+                glBindTexture(TypeEnum, Unique<TypeTrait>::Get());
+            return scope_t(ResourceMethods<TypeTrait>::Unbind);
+        }
+
+        // Use, with the unit active too, for calls on the bound texture.
+        scope_t Edit() const {
+            State::ActiveTexture(_unit);
+            return Use();
         }
 
         void UpdateSampler(SamplerOptions && options) const {
-            auto const useThis { Use() };
+            auto const useThis { Edit() };
             glTexParameteri(TypeEnum, GL_TEXTURE_WRAP_S, GLenum(options.WrapU));
             glTexParameteri(TypeEnum, GL_TEXTURE_WRAP_T, GLenum(options.WrapV));
             glTexParameteri(TypeEnum, GL_TEXTURE_WRAP_R, GLenum(options.WrapW));
@@ -88,7 +93,7 @@ namespace VCX::Engine::GL {
         template<TextureFormat Format>
         void Resize(std::size_t const width, std::size_t const height) const
             requires std::is_same_v<TypeTrait, Texture2DTrait> {
-            auto const useThis { Use() };
+            auto const useThis { Edit() };
             glTexImage2D(
                 GL_TEXTURE_2D, 0,
                 InternalFormatEnumOf<Format>,
@@ -100,7 +105,7 @@ namespace VCX::Engine::GL {
         template<TextureFormat Format>
         void Resize(std::size_t const width, std::size_t const height) const
             requires std::is_same_v<TypeTrait, TextureCubeMapTrait> {
-            auto const useThis { Use() };
+            auto const useThis { Edit() };
             for (std::size_t i = 0; i < 6; ++i) {
                 glTexImage2D(
                     GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0,
@@ -113,7 +118,7 @@ namespace VCX::Engine::GL {
 
         template<typename Content>
         void Update(Content const & texture) const {
-            auto const useThis { Use() };
+            auto const useThis { Edit() };
             glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
             UpdateImpl(texture);
             glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
@@ -122,7 +127,7 @@ namespace VCX::Engine::GL {
 
         template<TextureFormat Format>
         auto Download() const {
-            auto const useThis { Use() };
+            auto const useThis { Edit() };
             glPixelStorei(GL_PACK_ALIGNMENT, 1);
             auto ret = DownloadImpl<Format>();
             glPixelStorei(GL_PACK_ALIGNMENT, 4);
@@ -130,7 +135,7 @@ namespace VCX::Engine::GL {
         }
 
         void GenerateMipmap() const {
-            auto const useThis { Use() };
+            auto const useThis { Edit() };
             glGenerateMipmap(TypeEnum);
         }
 
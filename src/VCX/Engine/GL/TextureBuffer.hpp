@@ -0,0 +1,84 @@
+#pragma once
+
+#include <span>
+
+#include "Engine/GL/resource.hpp"
+#include "Engine/prelude.hpp"
+
+namespace VCX::Engine::GL {
+    struct TextureBufferTrait {
+        static auto constexpr & CreateMany = glGenTextures;
+        static auto constexpr & DeleteMany = glDeleteTextures;
+        static auto constexpr & Bind       = glBindTexture;
+        static GLenum constexpr BindTarget = GL_TEXTURE_BUFFER;
+        static auto constexpr   Cached     = State::Binding::TextureBuffer;
+    };
+
+    struct TexelBufferTrait {
+        static auto constexpr & CreateMany = glGenBuffers;
+        static auto constexpr & DeleteMany = glDeleteBuffers;
+        static auto constexpr & Bind       = glBindBuffer;
+        static GLenum constexpr BindTarget = GL_TEXTURE_BUFFER;
+        static auto constexpr   Cached     = State::Binding::TexelBuffer;
+    };
+
+    // buffer texture (samplerBuffer in GLSL): a plain buffer object read with texelFetch, without
+    // the size limits of 2D textures. the texture and its storage buffer are owned together.
+    class UniqueTextureBuffer : public Unique<TextureBufferTrait> {
+    public:
+        explicit UniqueTextureBuffer(GLenum const internalFormat = GL_RGBA32F, std::uint32_t const unit = 0) :
+            _format(internalFormat),
+            _unit(unit) {
+        }
+
+        scope_t Use() const {
+            if (State::BindTexture(_unit, TextureBufferTrait::Cached, Get()))
+                glBindTexture(GL_TEXTURE_BUFFER, Get());
+            return scope_t(ResourceMethods<TextureBufferTrait>::Unbind);
+        }
+
+        // replaces the whole contents, attaching the storage to the texture the first time.
+        void Update(std::span<std::byte const> const & data, DrawFrequency const frequency = DrawFrequency::Static) {
+            Store(data.size(), data.data(), frequency);
+        }
+
+        // sizes the storage without contents, e.g. as a transform feedback target.
+        void Allocate(std::size_t const size, DrawFrequency const frequency = DrawFrequency::Stream) {
+            Store(size, nullptr, frequency);
+        }
+
+        std::size_t   GetByteSize() const { return _size; }
+        std::uint32_t GetUnit() const { return _unit; }
+        GLuint        GetBuffer() const { return _buffer.Get(); }
+
+        void SetUnit(std::uint32_t const unit) { _unit = unit; }
+
+        // texels a buffer texture may address, at least 65536 by the specification.
+        static std::size_t GetMaxTexelCount() {
+            GLint count { 0 };
+            glGetIntegerv(GL_MAX_TEXTURE_BUFFER_SIZE, &count);
+            return std::size_t(count);
+        }
+
+    private:
+        void Store(std::size_t const size, void const * const data, DrawFrequency const frequency) {
+            {
+                auto const useBuffer { _buffer.Use() };
+                glBufferData(GL_TEXTURE_BUFFER, size, data, GLenum(frequency));
+            }
+            if (! _attached) {
+                State::ActiveTexture(_unit);
+                auto const useThis { Use() };
+                glTexBuffer(GL_TEXTURE_BUFFER, _format, _buffer.Get());
+                _attached = true;
+            }
+            _size = size;
+        }
+
+        Unique<TexelBufferTrait> _buffer;
+        GLenum                   _format;
+        std::uint32_t            _unit     = 0;
+        std::size_t              _size     = 0;
+        bool                     _attached = false;
+    };
+}
@@ -9,7 +9,7 @@ namespace VCX::Engine::GL {
         UniqueUniformBlock(std::uint32_t const bindingPoint, DrawFrequency const frequency) {
             auto const useThis { Use() };
             glBufferData(GL_UNIFORM_BUFFER, sizeof(T), nullptr, GLenum(frequency));
-            glBindBufferBase(GL_UNIFORM_BUFFER, bindingPoint, Get());
+            State::BindUniformRange(bindingPoint, Get());
         }
 
         void Update(T const & block) const {
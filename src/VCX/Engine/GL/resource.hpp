@@ -6,6 +6,7 @@
 
 #include <glad/glad.h>
 
+#include "Engine/GL/State.hpp"
 #include "scope.hpp"
 
 #define gl_using(var) \
@@ -40,6 +41,9 @@ namespace VCX::Engine::GL {
         std::is_same_v<std::remove_const_t<decltype(T::BindTarget)>, GLenum>;
         { T::Bind(target, o) } -> std::same_as<void>;
     };
+    template<typename T> concept ResourceCached = requires {
+        { T::Cached } -> std::convertible_to<State::Binding>;
+    };
 
     template<typename T> concept ResourceTrait = (ResourceDelete<T> || ResourceDeleteMany<T>);
     // clang-format on
@@ -57,6 +61,8 @@ namespace VCX::Engine::GL {
         }
 
         static void Delete(GLuint const o) {
+            if constexpr (ResourceCached<Trait>)
+                State::Forget(Trait::Cached, o);
             if constexpr (ResourceDelete<Trait>)
                 return Trait::Delete(o);
             if constexpr (ResourceDeleteMany<Trait>)
@@ -64,13 +70,18 @@ namespace VCX::Engine::GL {
         }
 
         static void Bind(GLuint const o) {
+            if constexpr (ResourceCached<Trait>)
+                if (! State::Bind(Trait::Cached, o)) return;
             if constexpr (ResourceBind<Trait>)
                 Trait::Bind(o);
             if constexpr (ResourceBindToTarget<Trait>)
                 Trait::Bind(Trait::BindTarget, o);
         }
 
+        // cached bindings stay, see State.
         static void Unbind() {
+            if constexpr (ResourceCached<Trait>)
+                return State::Release(Trait::Cached);
             if constexpr (ResourceBind<Trait>)
                 Trait::Bind(0);
             if constexpr (ResourceBindToTarget<Trait>)
@@ -134,6 +145,7 @@ namespace VCX::Engine::GL {
         static auto constexpr & CreateMany = glGenVertexArrays;
         static auto constexpr & DeleteMany = glDeleteVertexArrays;
         static auto constexpr & Bind       = glBindVertexArray;
+        static auto constexpr   Cached     = State::Binding::VertexArray;
     };
 
     struct ArrayBufferTrait {
@@ -141,6 +153,7 @@ namespace VCX::Engine::GL {
         static auto constexpr & DeleteMany = glDeleteBuffers;
         static auto constexpr & Bind       = glBindBuffer;
         static GLenum constexpr BindTarget = GL_ARRAY_BUFFER;
+        static auto constexpr   Cached     = State::Binding::ArrayBuffer;
     };
 
     struct ElementArrayBufferTrait {
@@ -148,6 +161,7 @@ namespace VCX::Engine::GL {
         static auto constexpr & DeleteMany = glDeleteBuffers;
         static auto constexpr & Bind       = glBindBuffer;
         static GLenum constexpr BindTarget = GL_ELEMENT_ARRAY_BUFFER;
+        static auto constexpr   Cached     = State::Binding::ElementArrayBuffer;
     };
 
     struct FramebufferTrait {
@@ -169,6 +183,7 @@ namespace VCX::Engine::GL {
         static auto constexpr & DeleteMany = glDeleteBuffers;
         static auto constexpr & Bind       = glBindBuffer;
         static GLenum constexpr BindTarget = GL_UNIFORM_BUFFER;
+        static auto constexpr   Cached     = State::Binding::UniformBuffer;
     };
 
     struct Texture2DMultisample {
@@ -178,6 +193,11 @@ namespace VCX::Engine::GL {
         static GLenum constexpr BindTarget = GL_TEXTURE_2D_MULTISAMPLE;
     };
 
+    struct QueryTrait {
+        static auto constexpr & CreateMany = glGenQueries;
+        static auto constexpr & DeleteMany = glDeleteQueries;
+    };
+
     // clang-format on
 
     using UniqueVertexArray          = Unique<VertexArrayTrait>;
@@ -187,4 +207,5 @@ namespace VCX::Engine::GL {
     using UniqueRenderbuffer         = Unique<RenderbufferTrait>;
     using UniqueUniformBuffer        = Unique<UniformBufferTrait>;
     using UniqueTexture2DMultiSample = Unique<Texture2DMultisample>;
+    using UniqueQuery                = Unique<QueryTrait>;
 } // namespace VCX::Engine::GL
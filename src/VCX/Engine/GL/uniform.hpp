@@ -1,13 +1,24 @@
 #pragma once
 
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "Engine/GL/State.hpp"
+
 namespace VCX::Engine::GL {
     template<typename T>
     struct UniformTrait {
         static void Set(int, T const &) = delete;
     };
 
-    template<typename T, void (*&Func)(GLint, T)>
+    template<typename T, GLenum GLType, void (*&Func)(GLint, T)>
     struct ScalarUniformTrait {
+        static GLenum constexpr Type = GLType;
+
         static void Set(int const loc, T const & o) {
             Func(loc, o);
         }
@@ -16,8 +27,11 @@ namespace VCX::Engine::GL {
     template<
         typename T,
         typename Element,
+        GLenum GLType,
         void (*&Func)(GLint, GLsizei, Element const *)>
     struct VectorUniformTrait {
+        static GLenum constexpr Type = GLType;
+
         static void Set(int const loc, T const & o) {
             Func(loc, 1, glm::value_ptr(o));
         }
@@ -31,8 +45,11 @@ namespace VCX::Engine::GL {
     template<
         typename T,
         typename Element,
+        GLenum GLType,
         void (*&Func)(GLint, GLsizei, GLboolean, Element const *)>
     struct MatrixUniformTrait {
+        static GLenum constexpr Type = GLType;
+
         static void Set(int const loc, T const & o) {
             Func(loc, 1, GL_FALSE, glm::value_ptr(o));
         }
@@ -43,95 +60,155 @@ namespace VCX::Engine::GL {
         }
     };
 
-#define DECLARE_SCALAR_UNIFORM_TRAIT(type, func) \
-    template<>                                   \
-    struct UniformTrait<type> : public ScalarUniformTrait<type, func> {};
-#define DECLARE_VECTOR_UNIFORM_TRAIT(type, element, func) \
-    template<>                                            \
-    struct UniformTrait<type> : public VectorUniformTrait<type, element, func> {};
-#define DECLARE_MATRIX_UNIFORM_TRAIT(type, element, func) \
-    template<>                                            \
-    struct UniformTrait<type> : public MatrixUniformTrait<type, element, func> {};
+#define DECLARE_SCALAR_UNIFORM_TRAIT(type, gltype, func) \
+    template<>                                           \
+    struct UniformTrait<type> : public ScalarUniformTrait<type, gltype, func> {};
+#define DECLARE_VECTOR_UNIFORM_TRAIT(type, element, gltype, func) \
+    template<>                                                    \
+    struct UniformTrait<type> : public VectorUniformTrait<type, element, gltype, func> {};
+#define DECLARE_MATRIX_UNIFORM_TRAIT(type, element, gltype, func) \
+    template<>                                                    \
+    struct UniformTrait<type> : public MatrixUniformTrait<type, element, gltype, func> {};
 
     // clang-format off
-    DECLARE_SCALAR_UNIFORM_TRAIT(int       , glUniform1i);
-    DECLARE_SCALAR_UNIFORM_TRAIT(float     , glUniform1f);
-    DECLARE_VECTOR_UNIFORM_TRAIT(glm::vec2 , float, glUniform2fv);
-    DECLARE_VECTOR_UNIFORM_TRAIT(glm::vec3 , float, glUniform3fv);
-    DECLARE_VECTOR_UNIFORM_TRAIT(glm::vec4 , float, glUniform4fv);
-    DECLARE_VECTOR_UNIFORM_TRAIT(glm::ivec2, int  , glUniform2iv);
-    DECLARE_VECTOR_UNIFORM_TRAIT(glm::ivec3, int  , glUniform3iv);
-    DECLARE_VECTOR_UNIFORM_TRAIT(glm::ivec4, int  , glUniform4iv);
-    DECLARE_MATRIX_UNIFORM_TRAIT(glm::mat2 , float, glUniformMatrix2fv);
-    DECLARE_MATRIX_UNIFORM_TRAIT(glm::mat3 , float, glUniformMatrix3fv);
-    DECLARE_MATRIX_UNIFORM_TRAIT(glm::mat4 , float, glUniformMatrix4fv);
+    DECLARE_SCALAR_UNIFORM_TRAIT(int       ,        GL_INT       , glUniform1i);
+    DECLARE_SCALAR_UNIFORM_TRAIT(float     ,        GL_FLOAT     , glUniform1f);
+    DECLARE_VECTOR_UNIFORM_TRAIT(glm::vec2 , float, GL_FLOAT_VEC2, glUniform2fv);
+    DECLARE_VECTOR_UNIFORM_TRAIT(glm::vec3 , float, GL_FLOAT_VEC3, glUniform3fv);
+    DECLARE_VECTOR_UNIFORM_TRAIT(glm::vec4 , float, GL_FLOAT_VEC4, glUniform4fv);
+    DECLARE_VECTOR_UNIFORM_TRAIT(glm::ivec2, int  , GL_INT_VEC2  , glUniform2iv);
+    DECLARE_VECTOR_UNIFORM_TRAIT(glm::ivec3, int  , GL_INT_VEC3  , glUniform3iv);
+    DECLARE_VECTOR_UNIFORM_TRAIT(glm::ivec4, int  , GL_INT_VEC4  , glUniform4iv);
+    DECLARE_MATRIX_UNIFORM_TRAIT(glm::mat2 , float, GL_FLOAT_MAT2, glUniformMatrix2fv);
+    DECLARE_MATRIX_UNIFORM_TRAIT(glm::mat3 , float, GL_FLOAT_MAT3, glUniformMatrix3fv);
+    DECLARE_MATRIX_UNIFORM_TRAIT(glm::mat4 , float, GL_FLOAT_MAT4, glUniformMatrix4fv);
     // clang-format on
 
 #undef DECLARE_SCALAR_UNIFORM_TRAIT
 #undef DECLARE_VECTOR_UNIFORM_TRAIT
 #undef DECLARE_MATRIX_UNIFORM_TRAIT
 
+    // a uniform resolved once by name; setting it through the collection involves no strings.
+    // invalid when the program has no such active uniform or its GLSL type does not match T.
+    template<typename T>
+    struct UniformHandle {
+        int Slot { -1 };
+
+        bool IsValid() const { return Slot >= 0; }
+    };
+
+    // totals over all programs since the last Reset, for per-frame readouts.
+    struct UniformStats {
+        std::uint64_t Calls   { 0 }; // glUniform* issued
+        std::uint64_t Skipped { 0 }; // the program held the value already
+        std::uint64_t Lookups { 0 }; // names resolved, by SetByName or GetHandle
+
+        void Reset() { *this = UniformStats { }; }
+
+        UniformStats operator-(UniformStats const & since) const {
+            return { Calls - since.Calls, Skipped - since.Skipped, Lookups - since.Lookups };
+        }
+    };
+
+    // the active uniforms of a linked program, introspected once into a table sorted by name.
+    // non-array values are shadowed, so setting the value a uniform already holds costs no GL call.
     class UniformCollection {
         friend class UniqueProgram;
 
     private:
-        UniformCollection(GLuint const program):
-            _program(program) {
-        }
+        UniformCollection(GLuint const program);
 
     public:
+        static UniformStats & GetStats() { return _stats; }
+
+        template<typename T>
+        UniformHandle<T> GetHandle(char const * const name) const {
+            int const slot { Find(name) };
+            if (slot < 0 || ! Matches<T>(_entries[slot].Type)) return { };
+            return { slot };
+        }
+
+        template<typename T>
+        void Set(UniformHandle<T> const handle, T const & value) {
+            if (! handle.IsValid()) return;
+            Entry & entry { _entries[handle.Slot] };
+            if (! Store(entry, &value, sizeof(T))) {
+                ++_stats.Skipped;
+                return;
+            }
+            ++_stats.Calls;
+            State::UseProgram(_program);
+            UniformTrait<T>::Set(entry.Location, value);
+        }
 
         template<typename T>
         void SetByName(
             char const * const name,
             T const &          value) {
-            glUseProgram(_program);
-            UniformTrait<T>::Set(GetLocationByName(name), value);
-            glUseProgram(0);
+            int const slot { Find(name) };
+            if (slot >= 0) Set(UniformHandle<T> { slot }, value);
         }
 
         template<typename T, std::size_t N>
         void SetByName(
             char const * const name,
             std::array<T, N> const &          value) {
-            glUseProgram(_program);
-            UniformTrait<T>::template Set<N>(GetLocationByName(name), value);
-            glUseProgram(0);
+            int const slot { Find(name) };
+            if (slot < 0) return;
+            ++_stats.Calls;
+            State::UseProgram(_program);
+            UniformTrait<T>::template Set<N>(_entries[slot].Location, value);
         }
 
         template<typename T>
         void SetByLocation(
             int       location,
             T const & value) {
-            glUseProgram(_program);
+            Forget(location);
+            ++_stats.Calls;
+            State::UseProgram(_program);
             if (location >= 0)
                 UniformTrait<T>::Set(location, value);
-            glUseProgram(0);
         }
 
         template<typename T, std::size_t N>
         void SetByLocation(
             int       location,
             std::array<T, N> const &          value) {
-            glUseProgram(_program);
+            Forget(location);
+            ++_stats.Calls;
+            State::UseProgram(_program);
             UniformTrait<T>::template Set<N>(location, value);
-            glUseProgram(0);
         }
 
+        std::size_t GetActiveCount() const { return _entries.size(); }
+
     private:
-        GLuint                                 _program;
-        std::unordered_map<std::string, GLint> _locations;
-
-        GLint GetLocationByName(char const * const name) {
-            if (auto const iter { _locations.find(name) };
-                iter != _locations.cend())
-                return iter->second;
-            if (auto const loc { glGetUniformLocation(_program, name) };
-                loc >= 0) {
-                _locations[name] = loc;
-                return loc;
-            }
-            return -1;
+        struct Entry {
+            std::string   Name;          // arrays without the "[0]"
+            GLint         Location;
+            GLenum        Type;
+            std::uint32_t Offset;        // of the shadowed value in _values
+            std::uint32_t Size;          // of the shadowed value, 0 for arrays
+            bool          Known { false };
+        };
+
+        template<typename T>
+        static bool Matches(GLenum const type) {
+            if constexpr (std::is_same_v<T, int>) return GetByteSize(type) == sizeof(int) && type != GL_FLOAT;
+            else return GetByteSize(type) == sizeof(T) && type == UniformTrait<T>::Type;
         }
+
+        static std::uint32_t GetByteSize(GLenum const type);
+
+        int  Find(char const * const name) const;
+        bool Store(Entry & entry, void const * const value, std::size_t const size); // false when unchanged
+        void Forget(GLint const location);
+
+        GLuint                    _program;
+        std::vector<Entry>        _entries;
+        std::vector<std::byte>    _values;
+
+        inline static UniformStats _stats;
     };
 } // namespace VCX::Engine::GL
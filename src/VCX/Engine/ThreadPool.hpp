@@ -0,0 +1,124 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace VCX::Engine {
+    // persistent workers for data-parallel loops; the calling thread takes part in the work,
+    // and nested calls (from inside a loop body) simply run inline.
+    class ThreadPool {
+    public:
+        explicit ThreadPool(std::uint32_t const workers = std::max(std::thread::hardware_concurrency(), 1u) - 1) {
+            for (std::uint32_t i = 0; i < workers; ++i)
+                _workers.emplace_back([this]() { Work(); });
+        }
+
+        ~ThreadPool() {
+            {
+                std::lock_guard lock(_mutex);
+                _stopping = true;
+            }
+            _wake.notify_all();
+            for (auto & worker : _workers) worker.join();
+        }
+
+        ThreadPool(ThreadPool const &)             = delete;
+        ThreadPool & operator=(ThreadPool const &) = delete;
+
+        static ThreadPool & Global() {
+            static ThreadPool pool;
+            return pool;
+        }
+
+        std::uint32_t GetThreadCount() const { return std::uint32_t(_workers.size()) + 1; }
+
+        // calls func(begin, end) over [0, count) in chunks of `grain` items and returns once all
+        // chunks are done. func must not throw.
+        template<typename F>
+        void ParallelFor(std::size_t const count, std::size_t const grain, F && func) {
+            if (count == 0) return;
+            std::size_t const chunk = std::max<std::size_t>(grain, 1);
+            if (_workers.empty() || count <= chunk || s_inside) {
+                func(std::size_t(0), count);
+                return;
+            }
+
+            std::function<void(std::size_t, std::size_t)> body = std::ref(func);
+            std::lock_guard submit(_submit);
+
+            auto job = std::make_shared<Job>(&body, count, chunk);
+            {
+                std::lock_guard lock(_mutex);
+                _job = job;
+                ++_generation;
+            }
+            _wake.notify_all();
+
+            Run(*job);
+
+            std::unique_lock lock(_mutex);
+            _done.wait(lock, [&]() { return job->Finished.load() == job->Chunks; });
+            _job.reset();
+        }
+
+    private:
+        struct Job {
+            Job(std::function<void(std::size_t, std::size_t)> const * body, std::size_t const count, std::size_t const grain):
+                Body(body), Count(count), Grain(grain), Chunks((count + grain - 1) / grain) {}
+
+            std::function<void(std::size_t, std::size_t)> const * Body;
+            std::size_t const        Count;
+            std::size_t const        Grain;
+            std::size_t const        Chunks;
+            std::atomic<std::size_t> Next     = 0;
+            std::atomic<std::size_t> Finished = 0;
+        };
+
+        void Run(Job & job) {
+            bool const inside = s_inside;
+            s_inside = true;
+            for (std::size_t c; (c = job.Next.fetch_add(1)) < job.Chunks;) {
+                std::size_t const begin = c * job.Grain;
+                (*job.Body)(begin, std::min(job.Count, begin + job.Grain));
+                if (job.Finished.fetch_add(1) + 1 == job.Chunks) {
+                    std::lock_guard lock(_mutex);
+                    _done.notify_all();
+                }
+            }
+            s_inside = inside;
+        }
+
+        void Work() {
+            std::uint64_t seen = 0;
+            while (true) {
+                std::shared_ptr<Job> job;
+                {
+                    std::unique_lock lock(_mutex);
+                    _wake.wait(lock, [&]() { return _stopping || (_job && _generation != seen); });
+                    if (_stopping) return;
+                    seen = _generation;
+                    job  = _job;
+                }
+                Run(*job);
+            }
+        }
+
+        static inline thread_local bool s_inside = false;
+
+        std::vector<std::thread> _workers;
+        std::mutex               _submit;
+        std::mutex               _mutex;
+        std::condition_variable  _wake;
+        std::condition_variable  _done;
+        std::shared_ptr<Job>     _job;
+        std::uint64_t            _generation = 0;
+        bool                     _stopping   = false;
+    };
+}
@@ -11,6 +11,7 @@
 #include "imgui_impl_opengl3.h"
 
 #include "Engine/App.h"
+#include "Engine/GL/State.hpp"
 
 static GLFWwindow *                      g_glfwWindow;
 static std::function<void()>             g_glfwWindowRefreshCallback;
@@ -205,6 +206,7 @@ namespace VCX::Engine::Internal {
         ImGui_ImplGlfw_NewFrame();
         ImGui::NewFrame();
 
+        GL::State::NewFrame();
         app.OnFrame();
 
         ImGui::Render();
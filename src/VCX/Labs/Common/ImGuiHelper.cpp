@@ -54,7 +54,7 @@ namespace VCX::Labs::Common::ImGuiHelper {
 
         if (enableWrite) {
             saving = true;
-            gl_using(tex);
+            auto const useTex { tex.Edit() };
             char * rawImg = new char[sizeof(char) * texSize.first * texSize.second * 3];
             glPixelStorei(GL_PACK_ALIGNMENT, 1);
             glGetTexImage(GL_TEXTURE_2D, 0, GL_RGB, GL_UNSIGNED_BYTE, rawImg);
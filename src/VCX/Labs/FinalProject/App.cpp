@@ -9,6 +9,13 @@ namespace VCX::Labs::FinalProject {
     {}
 
     void App::OnFrame() {
-        _ui.Setup(_cases, _caseId);
+        auto & profiler = Profiler::Global();
+        profiler.NewFrame();
+        {
+            // The cases render from inside their windows, so this holds them too
+            PROFILE_ZONE("UI");
+            _ui.Setup(_cases, _caseId);
+        }
+        profiler.RenderOverlay();
     }
 }
\ No newline at end of file
@@ -5,7 +5,11 @@
 #include "Engine/app.h"
 
 #include "Labs/FinalProject/CaseBVH.h"
+#include "Labs/FinalProject/CaseCrowd.h"
 #include "Labs/FinalProject/CaseSkeleton.h"
+#include "Labs/FinalProject/ClipIndex.h"
+#include "Labs/FinalProject/ClipLibrary.h"
+#include "Labs/FinalProject/Profiler.h"
 #include "Labs/Common/UI.h"
 
 namespace VCX::Labs::FinalProject {
@@ -15,12 +19,18 @@ namespace VCX::Labs::FinalProject {
 
         std::size_t     _caseId = 0;
 
-        CaseSkeleton _caseSkeleton;
-        CaseBVH      _caseBVH;
+        // Shared by every case, declared first so they outlive them
+        ClipLibrary  _clipLibrary;
+        ClipIndexer  _clipIndexer;
+
+        CaseSkeleton _caseSkeleton { _clipLibrary, _clipIndexer };
+        CaseBVH      _caseBVH      { _clipLibrary, _clipIndexer };
+        CaseCrowd    _caseCrowd    { _clipLibrary };
 
         std::vector<std::reference_wrapper<Common::ICase>> _cases = {
             _caseSkeleton,
-            _caseBVH
+            _caseBVH,
+            _caseCrowd
         };
     public:
         App();
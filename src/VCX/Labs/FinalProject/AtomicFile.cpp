@@ -0,0 +1,33 @@
+#include <fstream>
+#include <thread>
+
+#include <fmt/core.h>
+
+#include "Labs/FinalProject/AtomicFile.h"
+
+namespace VCX::Labs::FinalProject
+{
+    bool WriteFileAtomic(std::filesystem::path const & path, std::function<void(std::ostream & file)> const & write)
+    {
+        std::error_code ec;
+        if (path.has_parent_path()) std::filesystem::create_directories(path.parent_path(), ec);
+
+        // Named after the thread, so writers of the same path do not share a temporary
+        auto temp = path;
+        temp += fmt::format(".{}.tmp", std::hash<std::thread::id>()(std::this_thread::get_id()));
+        bool written = false;
+        {
+            std::ofstream file(temp, std::ios::binary | std::ios::trunc);
+            if (file.is_open())
+            {
+                write(file);
+                file.flush();
+                written = bool(file);
+            }
+        }
+        if (written) std::filesystem::rename(temp, path, ec);
+        if (written && ! ec) return true;
+        std::filesystem::remove(temp, ec);
+        return false;
+    }
+}
@@ -0,0 +1,13 @@
+#pragma once
+
+#include <filesystem>
+#include <functional>
+#include <ostream>
+
+namespace VCX::Labs::FinalProject
+{
+    // Writes `path` through a temporary file beside it, flushed and then renamed over it, so a
+    // concurrent reader sees either the old file or the whole new one. The parent directory is
+    // created; the temporary is removed when `write` leaves the stream failed or the rename fails.
+    bool WriteFileAtomic(std::filesystem::path const & path, std::function<void(std::ostream & file)> const & write);
+}
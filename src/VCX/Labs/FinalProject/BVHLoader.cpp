@@ -1,4 +1,9 @@
+#include <cstdlib>
+
+#include <fmt/core.h>
+
 #include "Labs/FinalProject/BVHLoader.h"
+#include "Labs/FinalProject/Profiler.h"
 
 namespace VCX::Labs::FinalProject
 {
@@ -6,8 +11,6 @@ namespace VCX::Labs::FinalProject
 
     void BVHLoader::Load(const char* fp, Skeleton & skeleton, Action & action)
     {
-        std::string str;
-
         std::ifstream infile;
         infile.open(fp);
         
@@ -16,14 +19,49 @@ namespace VCX::Labs::FinalProject
             return;
         }
 
-        // Clear existing skeleton data
+        Load(infile, skeleton, action);
+
+        infile.close();
+    }
+
+    void BVHLoader::Load(std::istream & infile, Skeleton & skeleton, Action & action)
+    {
+        LoadSampled(infile, skeleton, action, 0);
+    }
+
+    BVHSummary BVHLoader::LoadSampled(std::istream & infile, Skeleton & skeleton, Action & action, std::uint32_t const maxFrames)
+    {
+        BVHSummary Summary;
+
+        // Clear existing skeleton and action data
         skeleton.Clear();
-        
-        // Clear existing action data
-        action.FrameParams.clear();
-        action.TimeIndex = 0;
-        action.Reset(); // Use Reset() to clear private members
-        
+        action.Bind(nullptr);
+
+        if (auto clip = LoadClip(infile, maxFrames, &Summary))
+        {
+            skeleton.Build(clip->Skeleton);
+            action.Bind(std::move(clip));
+        }
+        return Summary;
+    }
+
+    std::shared_ptr<Clip const> BVHLoader::LoadClip(const char* fp, std::uint32_t const maxFrames, BVHSummary * summary)
+    {
+        std::ifstream infile(fp);
+        if (!infile.is_open()) {
+            std::cerr << "Failed to open file: " << fp << std::endl;
+            return nullptr;
+        }
+        return LoadClip(infile, maxFrames, summary);
+    }
+
+    std::shared_ptr<Clip const> BVHLoader::LoadClip(std::istream & infile, std::uint32_t const maxFrames, BVHSummary * summary)
+    {
+        PROFILE_ZONE("BVH parse");
+        std::string str;
+        SkeletonDef def;
+        auto        clip = std::make_shared<Clip>();
+
         bool Hierachy = true;
 
         while(std::getline(infile, str))
@@ -39,107 +77,134 @@ namespace VCX::Labs::FinalProject
                 const std::string & tmp = item.at(0);
                 if (tmp == "ROOT")
                 {
-                    ConstructTree(skeleton.Root, item.at(1), infile);
+                    ConstructTree(def, -1, item.at(1), infile);
                 }
             }
-            else
+            else if (def.GetJointCount() > 0)
             {
-                ConstructAction(action, infile);
+                // Rows are laid out by the interned definition, which is known by now
+                clip->Skeleton = SkeletonRegistry::Global().Intern(std::move(def));
+                auto const Summary = ConstructAction(*clip, infile, maxFrames);
+                if (summary) *summary = Summary;
             }
         }
 
-        infile.close();
+        if (!clip->Skeleton) {
+            if (def.GetJointCount() == 0) return nullptr;
+            clip->Skeleton = SkeletonRegistry::Global().Intern(std::move(def));
+        }
+        return clip;
     }
 
 
-    void BVHLoader::ConstructTree(Joint * & ptr, std::string const& Name, std::ifstream& infile)
+    void BVHLoader::ConstructTree(SkeletonDef & def, int const parent, std::string const& Name, std::istream& infile)
     {
         std::vector<std::string> item;
 
         GetLine(infile, item); // get '{'
 
-        ptr       = new Joint();
-        ptr->Name = Name;
+        int const self = def.GetJointCount();
+        def.Names.push_back(Name);
+        def.Parents.push_back(parent);
+        def.PositionOrder.push_back({ 0, 1, 2 });
+        def.RotationOrder.push_back({ 2, 0, 1 });
+        def.Channels.push_back(0);
+        def.ChannelOffsets.push_back(-1);
 
         // Get Offset
         GetLine(infile, item);
-        ptr->LocalOffset = { std::stof(item.at(1)), std::stof(item.at(2)), std::stof(item.at(3)) };
+        def.Offsets.push_back({ std::stof(item.at(1)), std::stof(item.at(2)), std::stof(item.at(3)) });
 
         if (Name != EndSiteName)
         {
             // Get Channels
             GetLine(infile, item);
-            for (int i = 0; i < std::stoi(item.at(1)); ++i)
+            int const count = std::stoi(item.at(1));
+            for (int i = 0; i < count; ++i)
             {
                 std::string const& tmp = item.at(2+i);
                 if      (tmp == "Xrotation")
-                    ptr->RotationIdx[i%3] = 0;
+                    def.RotationOrder[self][i%3] = 0;
                 else if (tmp == "Yrotation")
-                    ptr->RotationIdx[i%3] = 1;
+                    def.RotationOrder[self][i%3] = 1;
                 else if (tmp == "Zrotation")
-                    ptr->RotationIdx[i%3] = 2;
+                    def.RotationOrder[self][i%3] = 2;
                 else if (tmp == "Xposition")
-                    ptr->PositionIdx[i%3] = 0;
+                    def.PositionOrder[self][i%3] = 0;
                 else if (tmp == "Yposition")
-                    ptr->PositionIdx[i%3] = 1;
+                    def.PositionOrder[self][i%3] = 1;
                 else if (tmp == "Zposition")
-                    ptr->PositionIdx[i%3] = 2;
+                    def.PositionOrder[self][i%3] = 2;
                 else
                     std::cerr << "UnKnow Character encounterd while reading bvh: " << tmp << std::endl; 
             }
+            def.Channels[self]       = std::uint8_t(count);
+            def.ChannelOffsets[self] = int(def.ChannelCount);
+            def.ChannelCount        += count;
         }
 
-        Joint *NextPtr = nullptr;
         while(GetLine(infile, item), item.at(0) != "}")
         {
             std::string tmp;
             if (item.at(0) == "JOINT") tmp = item.at(1);
             else                       tmp = EndSiteName;
 
-            if (NextPtr == nullptr)
-            {
-                ConstructTree(ptr->ChiPtr, tmp, infile);
-                NextPtr = ptr->ChiPtr;
-            }
-            else
-            {
-                ConstructTree(NextPtr->BroPtr, tmp, infile);
-                NextPtr = NextPtr->BroPtr;
-            }
+            ConstructTree(def, self, tmp, infile);
         }
     }
 
 
-    void BVHLoader::ConstructAction(Action & action, std::ifstream & infile)
+    BVHSummary BVHLoader::ConstructAction(Clip & clip, std::istream & infile, std::uint32_t const maxFrames)
     {
         std::vector<std::string> item;
 
         // Get Frames
         GetLine(infile, item);
-        if (item.at(0) == "Frames:") action.Frames = std::uint32_t( std::stoi(item.at(1)) );
+        if (item.at(0) == "Frames:") clip.Frames = std::uint32_t( std::stoi(item.at(1)) );
         else                        std::cerr << "Incomplete file struct encountered, \'Frames:\' not founded" << std::endl; 
 
         // Get FrameTime
         GetLine(infile, item);
         if ((item.at(0) == "Frame") && 
-        (item.at(1) == "Time:")) action.FrameTime = std::stof(item.at(2));
+        (item.at(1) == "Time:")) clip.FrameTime = std::stof(item.at(2));
         else                        std::cerr << "Incomplete file struct encountered, \'Frame Time:\' not founded" << std::endl; 
 
-        // Read Whole Contains
-        for (int lineNum = 0; lineNum < action.Frames; ++lineNum)
+        // Keep every Stride-th frame only, skipped lines are never converted
+        BVHSummary const    Summary { clip.Frames, clip.FrameTime };
+        std::uint32_t const Frames = Summary.Frames;
+        std::uint32_t const Stride = (maxFrames == 0 || Frames <= maxFrames) ? 1 : (Frames + maxFrames - 1) / maxFrames;
+        std::uint32_t const Width  = clip.Skeleton->ChannelCount;
+
+        // Read Whole Contains, one flat row per kept frame
+        std::string line;
+        clip.Channels.clear();
+        clip.Channels.reserve(std::size_t((Frames + Stride - 1) / Stride) * Width);
+        for (std::uint32_t lineNum = 0; lineNum < Frames && std::getline(infile, line); ++lineNum)
         {
-            action.FrameParams.push_back(std::vector<float>());
-            GetLine(infile, item);
+            if (lineNum % Stride != 0) continue;
 
-            for (auto value : item)
+            char const * ptr   = line.c_str();
+            std::size_t  count = 0;
+            for (char * end; count < Width; ++count, ptr = end)
             {
-                action.FrameParams.at(lineNum).push_back(std::stof(value));
+                float const value = std::strtof(ptr, &end);
+                if (end == ptr) break;
+                clip.Channels.push_back(value);
+            }
+            if (count < Width)
+            {
+                std::cerr << "Incomplete frame encountered while reading bvh: " << count << " of " << Width << " channels" << std::endl;
+                clip.Channels.resize(clip.Channels.size() + Width - count, 0.f);
             }
         }
+
+        clip.Frames     = Width ? std::uint32_t(clip.Channels.size() / Width) : 0;
+        clip.FrameTime *= Stride;
+        return Summary;
     }
 
 
-    void BVHLoader::GetLine(std::ifstream& infile, std::vector<std::string>& item)
+    void BVHLoader::GetLine(std::istream& infile, std::vector<std::string>& item)
     {
         item.clear();
         std::string str;
@@ -180,4 +245,51 @@ namespace VCX::Labs::FinalProject
 
         return ret_value;
     }
-}
\ No newline at end of file
+
+    static void WriteJoint(std::ostream & out, SkeletonDef const & def, std::uint32_t const joint, int const depth)
+    {
+        static constexpr char const * c_Axes = "XYZ";
+        std::string const indent(depth, '\t');
+        glm::vec3 const & offset = def.Offsets[joint];
+        if (def.Names[joint] == "???") out << indent << "End Site\n";
+        else out << indent << (def.Parents[joint] < 0 ? "ROOT " : "JOINT ") << def.Names[joint] << '\n';
+        out << indent << "{\n" << indent << fmt::format("\tOFFSET {} {} {}\n", offset.x, offset.y, offset.z);
+        if (def.Names[joint] != "???")
+        {
+            out << indent << "\tCHANNELS " << int(def.Channels[joint]);
+            if (def.Channels[joint] == 6)
+                for (int i = 0; i < 3; ++i) out << ' ' << c_Axes[def.PositionOrder[joint][i]] << "position";
+            if (def.Channels[joint] != 0)
+                for (int i = 0; i < 3; ++i) out << ' ' << c_Axes[def.RotationOrder[joint][i]] << "rotation";
+            out << '\n';
+        }
+        // Children follow their parent in file order
+        for (std::uint32_t child = joint + 1; child < def.GetJointCount() && def.Parents[child] >= int(joint); ++child)
+            if (def.Parents[child] == int(joint)) WriteJoint(out, def, child, depth + 1);
+        out << indent << "}\n";
+    }
+
+    bool SaveBVH(Clip const & clip, std::string const & path)
+    {
+        std::ofstream out(path);
+        if (! out.is_open()) return false;
+
+        SkeletonDef const & def = *clip.Skeleton;
+        out << "HIERARCHY\n";
+        if (def.GetJointCount() > 0) WriteJoint(out, def, 0, 0);
+        out << "MOTION\nFrames: " << clip.Frames << '\n' << fmt::format("Frame Time: {}\n", clip.FrameTime);
+        std::string line;
+        for (std::uint32_t f = 0; f < clip.Frames; ++f)
+        {
+            float const * row = clip.GetFrame(f);
+            line.clear();
+            for (std::uint32_t c = 0; c < def.ChannelCount; ++c)
+            {
+                if (c > 0) line += ' ';
+                line += fmt::format("{}", row[c]);
+            }
+            out << line << '\n';
+        }
+        return bool(out);
+    }
+}
@@ -4,11 +4,19 @@
 #include <iostream>
 #include <string>
 #include <vector>
+#include <memory>
+#include "Labs/FinalProject/Clip.h"
 #include "Labs/FinalProject/Player.h"
 #include "Labs/FinalProject/Skeleton.h"
 
 namespace VCX::Labs::FinalProject
 {
+    // Motion header as written in the file, independent of how many frames were kept.
+    struct BVHSummary
+    {
+        std::uint32_t   Frames    = 0;
+        float           FrameTime = 0.f;
+    };
 
     class BVHLoader
     {
@@ -16,15 +24,30 @@ namespace VCX::Labs::FinalProject
         BVHLoader();
 
         void Load(const char* fp, Skeleton & skeleton, Action & action);
+        void Load(std::istream & infile, Skeleton & skeleton, Action & action);
+
+        // Parses the hierarchy but keeps at most `maxFrames` evenly spaced motion frames, so a clip
+        // can be previewed without converting all of its frames. The action then describes the
+        // decimated clip; the returned summary describes the file.
+        BVHSummary LoadSampled(std::istream & infile, Skeleton & skeleton, Action & action, std::uint32_t const maxFrames);
+
+        // Motion only, the hierarchy is interned in the global SkeletonRegistry. nullptr if the
+        // file cannot be opened or has no hierarchy.
+        std::shared_ptr<Clip const> LoadClip(const char* fp, std::uint32_t const maxFrames = 0, BVHSummary * summary = nullptr);
+        std::shared_ptr<Clip const> LoadClip(std::istream & infile, std::uint32_t const maxFrames = 0, BVHSummary * summary = nullptr);
 
     private:
 
         std::vector<std::string> split(std::string& str);
-        void GetLine(std::ifstream& infile, std::vector<std::string>& item);
+        void GetLine(std::istream& infile, std::vector<std::string>& item);
 
-        void ConstructTree(Joint * & ptr, std::string const& Name, std::ifstream& infile);
-        void ConstructAction(Action & action, std::ifstream & infile);
+        void ConstructTree(SkeletonDef & def, int const parent, std::string const& Name, std::istream& infile);
+        BVHSummary ConstructAction(Clip & clip, std::istream & infile, std::uint32_t const maxFrames = 0);
 
         std::string     EndSiteName = "???";
     };
+
+    // Writes a clip as BVH, with the hierarchy, channel orders and frame rows it holds. False if
+    // the file cannot be written.
+    bool SaveBVH(Clip const & clip, std::string const & path);
 }
\ No newline at end of file
@@ -0,0 +1,175 @@
+#include <algorithm>
+#include <cmath>
+#include <glm/gtc/quaternion.hpp>
+
+#include "Labs/FinalProject/Blend.h"
+
+namespace VCX::Labs::FinalProject
+{
+    float EvaluateFadeCurve(FadeCurve const curve, float const x)
+    {
+        float const t = std::clamp(x, 0.f, 1.f);
+        switch (curve)
+        {
+        case FadeCurve::SmoothStep: return t * t * (3.f - 2.f * t);
+        case FadeCurve::EaseIn:     return t * t;
+        case FadeCurve::EaseOut:    return t * (2.f - t);
+        default:                    return t;
+        }
+    }
+
+    JointMask JointMask::Uniform(SkeletonDef const & def, float const weight)
+    {
+        return JointMask { .Weights = std::vector<float>(def.GetJointCount(), weight) };
+    }
+
+    JointMask JointMask::Subtree(SkeletonDef const & def, std::string_view const joint, float const inside, float const outside)
+    {
+        JointMask  mask  = Uniform(def, outside);
+        int const  first = def.Find(joint);
+        if (first < 0) return Uniform(def, inside);
+
+        // Descendants directly follow a joint in depth-first order, until the next joint that is not below it
+        std::vector<bool> below(def.GetJointCount(), false);
+        below[first]        = true;
+        mask.Weights[first] = inside;
+        for (std::uint32_t j = first + 1; j < def.GetJointCount() && def.Parents[j] >= 0 && below[def.Parents[j]]; ++j)
+        {
+            below[j]        = true;
+            mask.Weights[j] = inside;
+        }
+        return mask;
+    }
+
+    JointMask JointMask::Inverted() const
+    {
+        JointMask mask { .Weights = Weights };
+        for (float & w : mask.Weights) w = 1.f - w;
+        return mask;
+    }
+
+    void BlendPoses(Pose const & a, Pose const & b, float const w, float const * jointWeights, Pose & out, BlendMode const mode)
+    {
+        std::uint32_t const joints = std::min(a.GetJointCount(), b.GetJointCount());
+        if (joints == 0) return;
+        if (mode == BlendMode::Slerp)
+        {
+            for (std::uint32_t j = 0; j < joints; ++j)
+            {
+                float const t    = jointWeights ? w * jointWeights[j] : w;
+                out.Rotations[j] = glm::slerp(a.Rotations[j], b.Rotations[j], t);
+                out.Offsets[j]   = a.Offsets[j] + (b.Offsets[j] - a.Offsets[j]) * t;
+            }
+            return;
+        }
+
+        // Nlerp on raw floats, so the loop stays branch-free and vectorizes
+        float const * qa = &a.Rotations[0].x;
+        float const * qb = &b.Rotations[0].x;
+        float *       qo = &out.Rotations[0].x;
+        for (std::uint32_t j = 0; j < joints; ++j)
+        {
+            float const t    = jointWeights ? w * jointWeights[j] : w;
+            float const d    = qa[4 * j] * qb[4 * j] + qa[4 * j + 1] * qb[4 * j + 1] + qa[4 * j + 2] * qb[4 * j + 2] + qa[4 * j + 3] * qb[4 * j + 3];
+            float const tb   = d < 0.f ? -t : t; // Short arc
+            float const ta   = 1.f - t;
+            float       x    = qa[4 * j] * ta + qb[4 * j] * tb;
+            float       y    = qa[4 * j + 1] * ta + qb[4 * j + 1] * tb;
+            float       z    = qa[4 * j + 2] * ta + qb[4 * j + 2] * tb;
+            float       s    = qa[4 * j + 3] * ta + qb[4 * j + 3] * tb;
+            float const inv  = 1.f / std::sqrt(x * x + y * y + z * z + s * s);
+            qo[4 * j]        = x * inv;
+            qo[4 * j + 1]    = y * inv;
+            qo[4 * j + 2]    = z * inv;
+            qo[4 * j + 3]    = s * inv;
+            out.Offsets[j]   = a.Offsets[j] * ta + b.Offsets[j] * t;
+        }
+    }
+
+    void AddPose(Pose & base, Pose const & additive, Pose const & reference, float const w, float const * jointWeights)
+    {
+        glm::quat const     identity { 1.f, 0.f, 0.f, 0.f };
+        std::uint32_t const joints = std::min({ base.GetJointCount(), additive.GetJointCount(), reference.GetJointCount() });
+        for (std::uint32_t j = 0; j < joints; ++j)
+        {
+            float const t     = jointWeights ? w * jointWeights[j] : w;
+            glm::quat   delta = glm::inverse(reference.Rotations[j]) * additive.Rotations[j];
+            if (delta.w < 0.f) delta = -delta;
+            delta             = glm::normalize(identity * (1.f - t) + delta * t);
+            base.Rotations[j] = base.Rotations[j] * delta;
+            base.Offsets[j]  += (additive.Offsets[j] - reference.Offsets[j]) * t;
+        }
+    }
+
+    void BlendLayer::CrossfadeTo(std::shared_ptr<BakedClip const> motion, float const duration, FadeCurve const curve)
+    {
+        if (duration > 0.f && Motion)
+        {
+            FadeFrom     = std::move(Motion);
+            FadeFromTime = Time;
+        }
+        else FadeFrom.reset();
+        Motion       = std::move(motion);
+        Time         = 0.f;
+        FadeDuration = duration;
+        FadeElapsed  = 0.f;
+        Curve        = curve;
+    }
+
+    void BlendLayer::Advance(float const dt)
+    {
+        Time += dt * Speed;
+        if (! FadeFrom) return;
+        FadeFromTime += dt * Speed;
+        FadeElapsed  += dt;
+        if (FadeElapsed >= FadeDuration) FadeFrom.reset();
+    }
+
+    Blender::Blender(std::shared_ptr<SkeletonDef const> skeleton) :
+        Skeleton(std::move(skeleton))
+    {}
+
+    void Blender::Advance(float const dt)
+    {
+        for (auto & layer : Layers) layer.Advance(dt);
+    }
+
+    void Blender::SampleLayer(BlendLayer const & layer, Pose & out)
+    {
+        layer.Motion->Sample(layer.Time, layer.Loop, out);
+        if (! layer.IsFading()) return;
+
+        layer.FadeFrom->Sample(layer.FadeFromTime, layer.Loop, _fade);
+        float const w = EvaluateFadeCurve(layer.Curve, layer.FadeElapsed / layer.FadeDuration);
+        BlendPoses(_fade, out, w, nullptr, out, Mode);
+    }
+
+    void Blender::Evaluate(Pose & out)
+    {
+        std::uint32_t const joints = Skeleton->GetJointCount();
+        out.Resize(joints);
+        _layer.Resize(joints);
+        _fade.Resize(joints);
+        _reference.Resize(joints);
+
+        // Rest pose under everything, in case the base layer is missing or masked
+        std::fill(out.Rotations.begin(), out.Rotations.end(), glm::quat(1.f, 0.f, 0.f, 0.f));
+        std::copy(Skeleton->Offsets.begin(), Skeleton->Offsets.end(), out.Offsets.begin());
+
+        for (auto const & layer : Layers)
+        {
+            // Layers must share the blender's topology, bone lengths may differ
+            if (! layer.Motion || layer.Weight <= 0.f || layer.Motion->Skeleton->GetJointCount() != joints) continue;
+            if (layer.FadeFrom && layer.FadeFrom->Skeleton->GetJointCount() != joints) continue;
+
+            float const * weights = layer.Mask && layer.Mask->Weights.size() == joints ? layer.Mask->Weights.data() : nullptr;
+            SampleLayer(layer, _layer);
+            if (layer.Mode == BlendLayer::Kind::Additive)
+            {
+                layer.Motion->SampleFrame(layer.ReferenceFrame, _reference);
+                AddPose(out, _layer, _reference, layer.Weight, weights);
+            }
+            else BlendPoses(out, _layer, layer.Weight, weights, out, Mode);
+        }
+    }
+}
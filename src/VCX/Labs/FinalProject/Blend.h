@@ -0,0 +1,81 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string_view>
+#include <vector>
+
+#include "Labs/FinalProject/Pose.h"
+
+namespace VCX::Labs::FinalProject
+{
+    enum class FadeCurve { Linear, SmoothStep, EaseIn, EaseOut };
+    enum class BlendMode { Nlerp, Slerp };
+
+    float EvaluateFadeCurve(FadeCurve const curve, float const t);
+
+    // Per-joint weights in [0, 1], e.g. 1 on the upper body and 0 elsewhere.
+    struct JointMask
+    {
+        std::vector<float> Weights;
+
+        static JointMask Uniform(SkeletonDef const & def, float const weight = 1.f);
+        // `inside` on the joint and all its descendants, `outside` on the rest (everything if absent).
+        static JointMask Subtree(SkeletonDef const & def, std::string_view const joint, float const inside = 1.f, float const outside = 0.f);
+        JointMask        Inverted() const;
+    };
+
+    // Batched kernels over flat pose buffers, `out` may alias any input and must already be sized.
+    // With per-joint weights, joint j uses w * jointWeights[j].
+    void BlendPoses(Pose const & a, Pose const & b, float const w, float const * jointWeights, Pose & out, BlendMode const mode = BlendMode::Nlerp);
+    // base * (reference^-1 * additive) scaled by w, offsets likewise as a difference.
+    void AddPose(Pose & base, Pose const & additive, Pose const & reference, float const w, float const * jointWeights = nullptr);
+
+    // One clip sampler with its own clock, fading from the previous clip when switched.
+    struct BlendLayer
+    {
+        enum class Kind { Override, Additive };
+
+        std::shared_ptr<BakedClip const>    Motion;
+        std::shared_ptr<JointMask const>    Mask;                   // nullptr for every joint
+        Kind                                Mode           = Kind::Override;
+        float                               Weight         = 1.f;
+        float                               Time           = 0.f;
+        float                               Speed          = 1.f;
+        bool                                Loop           = true;
+        std::uint32_t                       ReferenceFrame = 0;     // Additive layers add their difference from this frame
+
+        std::shared_ptr<BakedClip const>    FadeFrom;
+        float                               FadeFromTime   = 0.f;
+        float                               FadeDuration   = 0.f;
+        float                               FadeElapsed    = 0.f;
+        FadeCurve                           Curve          = FadeCurve::SmoothStep;
+
+        void  CrossfadeTo(std::shared_ptr<BakedClip const> motion, float const duration, FadeCurve const curve = FadeCurve::SmoothStep);
+        void  Advance(float const dt);
+        bool  IsFading() const { return FadeFrom && FadeElapsed < FadeDuration; }
+    };
+
+    // Evaluates a stack of layers into one local pose: layer 0 is the base, later override layers
+    // blend over it through their masks and additive layers add on top. Scratch buffers are kept,
+    // so evaluation does not allocate once warmed up.
+    class Blender
+    {
+    public:
+        explicit Blender(std::shared_ptr<SkeletonDef const> skeleton = nullptr);
+
+        void Advance(float const dt);
+        void Evaluate(Pose & out);
+
+        std::shared_ptr<SkeletonDef const>  Skeleton;
+        std::vector<BlendLayer>             Layers;
+        BlendMode                           Mode = BlendMode::Nlerp;
+
+    private:
+        void SampleLayer(BlendLayer const & layer, Pose & out);
+
+        Pose                                _layer;
+        Pose                                _fade;
+        Pose                                _reference;
+    };
+}
@@ -4,6 +4,8 @@
 #include <stb_image_write.h>
 #include <filesystem>
 #include <algorithm>
+#include <chrono>
+#include <utility>
 
 namespace VCX::Labs::FinalProject 
 {
@@ -34,8 +36,10 @@ namespace VCX::Labs::FinalProject
 
     void BackGroundRender::render(Engine::GL::UniqueProgram & program)
     {
-        program.GetUniforms().SetByName("u_Color", glm::vec3( 128.0f/255, 128.0f/255, 128.0f/255 )); // Neutral gray color
-        LineItem.Draw({ program.Use() });
+        auto & uniforms = FrameUniforms::Global();
+        std::uint32_t const floor = uniforms.Queue({ .Color = glm::vec4( 128.0f/255, 128.0f/255, 128.0f/255, 1.0f ) }); // Neutral gray color
+        Engine::GL::State::LineWidth(1.f);
+        LineItem.Draw({ program.Use(), uniforms.Use(floor) });
     }
     // BackGround End
 
@@ -49,15 +53,16 @@ namespace VCX::Labs::FinalProject
 
     void SkeletonRender::render(Engine::GL::UniqueProgram & program)
     {
-        program.GetUniforms().SetByName("u_Color", glm::vec3( 1.0f, 0.0f, 0.0f ));
-        glPointSize(10.f);
-        PointItem.Draw({ program.Use() });
-        glPointSize(1.f);
-
-        program.GetUniforms().SetByName("u_Color", glm::vec3( 1.0f, 1.0f, 1.0f ));
-        glLineWidth(3.f);
-        LineItem.Draw({ program.Use() });
-        glLineWidth(1.f);
+        // Both colours go up in one upload
+        auto & uniforms = FrameUniforms::Global();
+        std::uint32_t const joints = uniforms.Queue({ .Color = glm::vec4( 1.0f, 0.0f, 0.0f, 1.0f ) });
+        std::uint32_t const bones  = uniforms.Queue({ .Color = glm::vec4( 1.0f, 1.0f, 1.0f, 1.0f ) });
+        // Sizes are set per draw rather than reset after it, repeating one costs no call
+        Engine::GL::State::PointSize(10.f);
+        PointItem.Draw({ program.Use(), uniforms.Use(joints) });
+
+        Engine::GL::State::LineWidth(3.f);
+        LineItem.Draw({ program.Use(), uniforms.Use(bones) });
     }
 
     void SkeletonRender::load(const Skeleton & skele)
@@ -79,16 +84,21 @@ namespace VCX::Labs::FinalProject
 
 
 
-    CaseBVH::CaseBVH() :
+    CaseBVH::CaseBVH(ClipLibrary & library, ClipIndexer & indexer) :
         _program(
             Engine::GL::UniqueProgram({
                 Engine::GL::SharedShader("assets/shaders/flat.vert"),
-                Engine::GL::SharedShader("assets/shaders/flat.frag")}))
+                Engine::GL::SharedShader("assets/shaders/flat.frag")})),
+        _picker(library, indexer, _filePath),
+        _library(library)
         {
             _cameraManager.AutoRotate = false;
             _cameraManager.Save(_camera);
+            FrameUniforms::Bind(_program);
 
             _BVHLoader.Load(_filePath.c_str(), _skeleton, _action);
+            AnalyzeLoop();
+            ExtractRootMotion();
 
             skeletonRender.loadAll(_skeleton);
         }
@@ -105,51 +115,13 @@ namespace VCX::Labs::FinalProject
             // File selection dropdown
             ImGui::Text("Select BVH File:");
             
-            // Dynamically load BVH files from directory
-            static std::vector<std::string> bvh_files;
-            static bool files_loaded = false;
-            
-            if (!files_loaded) {
-                // Load all BVH files from the directory
-                namespace fs = std::filesystem;
-                std::string bvh_dir = "assets/BVH_data";
-                
-                if (fs::exists(bvh_dir) && fs::is_directory(bvh_dir)) {
-                    for (const auto& entry : fs::directory_iterator(bvh_dir)) {
-                        if (entry.is_regular_file() && entry.path().extension() == ".bvh") {
-                            // Convert to forward slashes for consistency with the rest of the codebase
-                            std::string path_str = entry.path().string();
-                            std::replace(path_str.begin(), path_str.end(), '\\', '/');
-                            bvh_files.push_back(path_str);
-                        }
-                    }
-                }
-                
-                files_loaded = true;
-                
-                // Set default file if available
-                if (!bvh_files.empty()) {
-                    _filePath = bvh_files[0];
-                }
-            }
-            
-            // Create a list of const char* for ImGui combo
-            static std::vector<const char*> bvh_files_ptr;
-            if (!bvh_files_ptr.empty()) {
-                bvh_files_ptr.clear();
-            }
-            for (const auto& file : bvh_files) {
-                bvh_files_ptr.push_back(file.c_str());
-            }
-            
-            static int current_file = 0;
-            if (ImGui::Combo("##bvh_file_combo", &current_file, bvh_files_ptr.data(), static_cast<int>(bvh_files_ptr.size()))) {
-                if (current_file >= 0 && current_file < static_cast<int>(bvh_files.size())) {
-                    _filePath = bvh_files[current_file];
-                    _BVHLoader.Load(_filePath.c_str(), _skeleton, _action);
-                    skeletonRender.loadAll(_skeleton);
-                    _action.Reset();
-                }
+            if (_picker.OnSetupPropsUI()) {
+                _filePath = _picker.GetSelected();
+                _BVHLoader.Load(_filePath.c_str(), _skeleton, _action);
+                AnalyzeLoop();
+                ExtractRootMotion();
+                skeletonRender.loadAll(_skeleton);
+                _action.Reset();
             }
             
             // Animation control buttons
@@ -161,19 +133,94 @@ namespace VCX::Labs::FinalProject
             }
             ImGui::SameLine();
             if (ImGui::Button("Reset")) {
+                if (_playlistMode) _playlist.Start(0);
                 _action.Reset();
                 _stopped = true;
             }
             
-            // Animation progress
+            // Animation progress, of the playlist's current clip in playlist mode
+            Action const & shown = _playlistMode ? _playlist.GetAction() : _action;
             static float progress = 0.0f;
-            if (!_stopped) {
-                progress = static_cast<float>(_action.TimeIndex) / _action.Frames;
+            if (!_stopped && shown.Frames > 0) {
+                progress = static_cast<float>(shown.TimeIndex) / shown.Frames;
             }
             ImGui::ProgressBar(progress, ImVec2(0.0f, 0.0f), nullptr);
             
             // Frame counter
-            ImGui::Text("Frame: %d / %d", _action.TimeIndex, _action.Frames);
+            ImGui::Text("Frame: %d / %d", shown.TimeIndex, shown.Frames);
+            
+            // Seamless loop: jump back from the loop out point to the in point with a crossfade
+            if (ImGui::Checkbox("Seamless Loop", &_seamlessLoop)) {
+                _action.LoopRange = _seamlessLoop ? _loopPoints : LoopPoints { };
+            }
+            if (_loopJob.valid()) {
+                ImGui::TextDisabled("Finding loop points...");
+            } else if (_loopPoints.IsValid()) {
+                ImGui::Text("Loop: %u -> %u, blend %u frames", _loopPoints.Out, _loopPoints.In, _loopPoints.Blend);
+                ImGui::Text("Loop error: %.4f", _loopPoints.Error);
+            } else {
+                ImGui::TextDisabled("No loop points, restarts from frame 0");
+            }
+            
+            // Root motion: the root as captured, in place, or walking on from a placement across loops
+            ImGui::Separator();
+            ImGui::Text("Root Motion:");
+            static const char* rootModes[] = { "As Captured", "In Place", "Accumulated" };
+            int rootMode = static_cast<int>(_action.Root);
+            bool replace = ImGui::Combo("Root", &rootMode, rootModes, IM_ARRAYSIZE(rootModes));
+            if (replace) {
+                _action.Root = static_cast<RootMode>(rootMode);
+                _action.Reset();
+            }
+            if (_action.Root != RootMode::Captured) {
+                replace |= ImGui::DragFloat("Place X", &_action.Placement.Position.x, 0.05f);
+                replace |= ImGui::DragFloat("Place Z", &_action.Placement.Position.z, 0.05f);
+                replace |= ImGui::SliderAngle("Heading", &_action.Placement.Heading, -180.0f, 180.0f);
+            }
+            if (replace && !_playlistMode && _action.Motion) _action.Apply(_skeleton, _action.GetFrame());
+            if (_action.Trajectory && _action.Trajectory->GetFrameCount() > 0) {
+                GroundTransform const travel = _action.Trajectory->Trajectory.front().Inverse() * _action.Trajectory->Trajectory.back();
+                ImGui::Text("Travel: %.2f units, turn %.0f deg", SceneScale * glm::length(travel.Position), glm::degrees(travel.Heading));
+            } else {
+                ImGui::TextDisabled("No root position channels");
+            }
+            
+            // Similar clips: DTW over the library, against the whole clip or a range of its frames
+            ImGui::Separator();
+            ImGui::Text("Similar Clips:");
+            ImGui::Checkbox("Subsequences", &_similarQuery.Subsequence);
+            ImGui::SameLine();
+            ImGui::Checkbox("Frame Range", &_similarRange);
+            if (_similarRange) {
+                ImGui::DragIntRange2("Frames", &_similarFrames[0], &_similarFrames[1], 1.0f, 0, static_cast<int>(_action.Frames));
+            }
+            int k = static_cast<int>(_similarQuery.K);
+            if (ImGui::SliderInt("Top K", &k, 1, 20)) _similarQuery.K = static_cast<std::uint32_t>(k);
+            ImGui::SliderFloat("Band", &_similarQuery.Band, 0.01f, 0.5f, "%.2f");
+            ImGui::BeginDisabled(_similarJob.valid() || !_action.Motion);
+            if (ImGui::Button("Find Similar")) FindSimilar();
+            ImGui::EndDisabled();
+            if (_similarJob.valid()) {
+                ImGui::TextDisabled(_similar.Index ? "Searching..." : "Indexing library...");
+            } else if (_similar.Index) {
+                ImGui::Text("%zu pairs in %.1f ms (%.0f pairs/s)", _similar.Stats.Pairs, _similar.Stats.Seconds * 1e3, _similar.Stats.GetPairsPerSecond());
+                auto const & sequences = _similar.Index->GetSequences();
+                for (std::size_t i = 0; i < _similar.Matches.size(); i++) {
+                    auto const & match = _similar.Matches[i];
+                    std::string const label = fmt::format("{:.3f}  {} [{}, {})##similar{}", match.Distance, sequences[match.Sequence].Name, match.Begin, match.End, i);
+                    if (ImGui::Selectable(label.c_str())) {
+                        _filePath = sequences[match.Sequence].Name;
+                        _BVHLoader.Load(_filePath.c_str(), _skeleton, _action);
+                        AnalyzeLoop();
+                        ExtractRootMotion();
+                        _action.Seek(match.Begin);
+                        _action.Apply(_skeleton, match.Begin);
+                        skeletonRender.loadAll(_skeleton);
+                        _picker.Select(_filePath);
+                        _playlistMode = false;
+                    }
+                }
+            }
             
             // Animation speed control
             ImGui::Separator();
@@ -181,6 +228,132 @@ namespace VCX::Labs::FinalProject
             ImGui::SliderFloat("Speed", &_speed, 0.1f, 3.0f, "%.1f");
             ImGui::Text("Speed: %.1fx", _speed);
             
+            // Foot locking: contacts are detected once per clip, thresholds in leg lengths
+            ImGui::Separator();
+            ImGui::Text("Foot Locking:");
+            if (ImGui::Checkbox("Lock Feet", &_footLocking)) _footLock.Reset();
+            bool redetect = ImGui::SliderFloat("Contact Height", &_footLock.Settings.HeightTolerance, 0.0f, 0.3f, "%.2f legs");
+            redetect     |= ImGui::SliderFloat("Contact Speed", &_footLock.Settings.SpeedThreshold, 0.0f, 2.0f, "%.2f legs/s");
+            ImGui::SliderFloat("Lock Blend", &_footLock.Settings.BlendTime, 0.0f, 0.5f, "%.2f s");
+            if (redetect) _contactClip = nullptr;
+            if (_playlistMode) {
+                ImGui::TextDisabled("Single clip mode only");
+            } else if (_footLocking && !_contacts.Flags.empty()) {
+                std::uint8_t const contact = _contacts.Flags[std::min<std::size_t>(_action.GetFrame(), _contacts.Flags.size() - 1)];
+                ImGui::Text("Contact: %s %s", contact & 1 ? "left" : "-", contact & 2 ? "right" : "-");
+                ImGui::Text("Foot IK: %.3f ms", _footMs);
+            } else if (_footLocking && _contactJob.valid()) {
+                ImGui::TextDisabled("Detecting foot contacts...");
+            } else if (_footLocking && _contactClip) {
+                ImGui::TextDisabled("No legs found on this skeleton");
+            }
+            
+            // Skinned mesh: an OBJ with a .skin sidecar or bound by distance, else tubes around the bones
+            ImGui::Separator();
+            ImGui::Text("Skinned Mesh:");
+            ImGui::Checkbox("Show Mesh", &_showMesh);
+            ImGui::SameLine();
+            ImGui::Checkbox("Show Skeleton", &_showBones);
+            static char meshPath[256] = "assets/models/character.obj";
+            ImGui::InputText("##MeshPath", meshPath, IM_ARRAYSIZE(meshPath));
+            ImGui::SameLine();
+            if (ImGui::Button("Load Mesh")) {
+                _meshPath = meshPath;
+                LoadMesh();
+            }
+            if (_skin.Skeleton) {
+                static const char* sources[] = { "sidecar weights", "automatic binding", "generated body, automatic binding" };
+                ImGui::Text("%zu vertices, %zu triangles", _skin.GetVertexCount(), _skin.Mesh.Indices.size() / 3);
+                ImGui::Text("Weights: %s", sources[static_cast<int>(_skin.Weighting)]);
+                static const char* methods[] = { "Linear Blend", "Dual Quaternion" };
+                int method = static_cast<int>(_skinRender.Skinning);
+                if (ImGui::Combo("Skinning", &method, methods, IM_ARRAYSIZE(methods)))
+                    _skinRender.Skinning = static_cast<SkinRender::Method>(method);
+                ImGui::Text("Palette: %u joints, %zu bytes, %.3f ms", _skin.Skeleton->GetJointCount(), _skinRender.GetPaletteBytes(), _skinRender.GetPaletteMs());
+            }
+            
+            // Onion skin: ghosts every few frames within a window around the shown frame
+            ImGui::Separator();
+            ImGui::Text("Onion Skin:");
+            ImGui::BeginDisabled(_playlistMode);
+            ImGui::Checkbox("Show Ghosts", &_showGhosts);
+            ImGui::SliderFloat("Window (s)", &_onion.Window, 0.1f, 5.0f, "%.1f");
+            ImGui::SliderInt("Every n-th Frame", &_onion.Step, 1, 60);
+            ImGui::Checkbox("Past", &_onion.Past);
+            ImGui::SameLine();
+            ImGui::Checkbox("Future", &_onion.Future);
+            if (_showGhosts)
+                ImGui::Text("%u ghosts in one draw, %.3f ms, %.1f MB baked", _onion.GetGhostCount(), _onion.GetMs(), _onion.GetByteSize() / 1048576.0);
+            ImGui::EndDisabled();
+
+            // Trajectories: whole-clip paths coloured by speed, faded ahead of the shown frame
+            ImGui::Separator();
+            ImGui::Text("Trajectories:");
+            ImGui::BeginDisabled(_playlistMode);
+            ImGui::Checkbox("Show Paths", &_showCurves);
+            ImGui::Checkbox("Root", &_curveRoot);
+            ImGui::SameLine();
+            ImGui::Checkbox("Hands", &_curveHands);
+            ImGui::SameLine();
+            ImGui::Checkbox("Feet", &_curveFeet);
+            if (_showCurves && _curves.GetCurveCount() > 0)
+                ImGui::Text("%u curves, %zu vertices, built in %.2f ms, red at %.2f units/s", _curves.GetCurveCount(), _curves.GetVertexCount(), _curves.GetBuildMs(), _curves.GetMaxSpeed());
+            ImGui::EndDisabled();
+
+            // Playlist: clips played back to back, the next ones loaded in the background
+            ImGui::Separator();
+            ImGui::Text("Playlist:");
+            if (ImGui::Checkbox("Playlist Mode", &_playlistMode)) {
+                // Back to the single clip, which may use another rig
+                if (!_playlistMode && _action.Motion) {
+                    if (_skeleton.Def != _action.Motion->Skeleton) _skeleton.Build(_action.Motion->Skeleton);
+                    _action.Apply(_skeleton, _action.GetFrame());
+                    skeletonRender.loadAll(_skeleton);
+                }
+            }
+            if (ImGui::Button("Add Selected")) {
+                _playlist.Add(_picker.GetSelected());
+            }
+            ImGui::SameLine();
+            if (ImGui::Button("Clear Playlist")) {
+                _playlist.Clear();
+            }
+            
+            bool loop = _playlist.GetLoop();
+            if (ImGui::Checkbox("Loop Playlist", &loop)) _playlist.SetLoop(loop);
+            ImGui::SliderFloat("Crossfade", &_playlist.CrossfadeTime, 0.0f, 2.0f, "%.2f s");
+            int lookahead = static_cast<int>(_playlist.GetLookahead());
+            if (ImGui::SliderInt("Prefetch", &lookahead, 1, 8)) _playlist.SetLookahead(static_cast<std::uint32_t>(lookahead));
+            int budget = static_cast<int>(_playlist.GetBudget() >> 20);
+            if (ImGui::SliderInt("Budget (MB)", &budget, 8, 1024)) _playlist.SetBudget(static_cast<std::size_t>(budget) << 20);
+            ImGui::Text("Prefetched: %.1f MB", _playlist.GetCachedBytes() / 1048576.0);
+            
+            // Items, with reorder/remove buttons; edits are applied after the loop
+            auto const & items = _playlist.GetItems();
+            int moveUp = -1, moveDown = -1, remove = -1;
+            for (int i = 0; i < static_cast<int>(items.size()); i++) {
+                ImGui::PushID(i);
+                if (ImGui::SmallButton("^")) moveUp = i;
+                ImGui::SameLine();
+                if (ImGui::SmallButton("v")) moveDown = i;
+                ImGui::SameLine();
+                if (ImGui::SmallButton("x")) remove = i;
+                ImGui::SameLine();
+                bool const current = _playlistMode && i == static_cast<int>(_playlist.GetCurrent());
+                std::string const label = fmt::format("{}{}", items[i], _playlist.IsReady(items[i]) ? "" : " (loading)");
+                if (ImGui::Selectable(label.c_str(), current)) {
+                    _playlist.Start(i);
+                    _playlistMode = true;
+                }
+                ImGui::PopID();
+            }
+            if (moveUp > 0) _playlist.Swap(moveUp, moveUp - 1);
+            if (moveDown >= 0 && moveDown + 1 < static_cast<int>(items.size())) _playlist.Swap(moveDown, moveDown + 1);
+            if (remove >= 0) _playlist.Remove(remove);
+            if (_playlistMode && _playlist.IsWaiting() && !items.empty()) {
+                ImGui::TextDisabled("Loading %s...", items[_playlist.GetCurrent()].c_str());
+            }
+            
             ImGui::Separator();
             ImGui::Text("Anti-aliasing:");
             // Anti-aliasing sample count options
@@ -202,6 +375,14 @@ namespace VCX::Labs::FinalProject
                 auto size = _frame.GetSize();
                 _frame.Resize(size, _aaSamples);
             }
+            // Uniforms set by handle skip the name lookup, unchanged values skip the GL call; the
+            // camera and per-draw colours come from shared uniform blocks instead
+            ImGui::Text("Uniforms per frame: %llu set, %llu skipped, %llu by name",
+                static_cast<unsigned long long>(_uniformsFrame.Calls), static_cast<unsigned long long>(_uniformsFrame.Skipped), static_cast<unsigned long long>(_uniformsFrame.Lookups));
+            ImGui::Text("Draw blocks per frame: %u draws, %u uploads", FrameUniforms::Global().GetDrawCount(), FrameUniforms::Global().GetUploadCount());
+            // Binds and fixed-function state through the state cache, redundant ones are skipped
+            auto const & gl = Engine::GL::State::GetFrameStats();
+            ImGui::Text("GL state per frame: %llu calls (%llu draws), %llu skipped", static_cast<unsigned long long>(gl.Calls), static_cast<unsigned long long>(gl.Draws), static_cast<unsigned long long>(gl.Skipped));
             
             ImGui::Separator();
             ImGui::Text("Video Export:");
@@ -239,33 +420,70 @@ namespace VCX::Labs::FinalProject
 
         Common::CaseRenderResult CaseBVH::OnRender(std::pair<std::uint32_t, std::uint32_t> const desiredSize)
         {
+            auto const & uniforms = Engine::GL::UniformCollection::GetStats();
+            _uniformsFrame = uniforms - _uniformsLast;
+            _uniformsLast  = uniforms;
+
+            PollLoop();
+            PollSimilar();
+            PollContacts();
+            _footDt += Engine::GetDeltaTime();
             if (!_stopped)
             {
-                _action.Load(_skeleton, Engine::GetDeltaTime() * _speed);
+                // Not in Action::Apply, which the clip indexer also runs for every frame on its workers
+                PROFILE_ZONE("Playback");
+                // Only the latest frame is visible, intermediate ones need not be posed
+                if (!_playlistMode) {
+                    if (_action.Advance(Engine::GetDeltaTime() * _speed)) {
+                        _action.Apply(_skeleton, _action.GetFrame());
+                        LockFeet();
+                    }
+                }
+                else if (_playlist.Update(_skeleton, Engine::GetDeltaTime() * _speed)) skeletonRender.loadAll(_skeleton);
             }
 
             skeletonRender.load(_skeleton);
+            if (_showMesh) {
+                if (_skin.Skeleton != _skeleton.Def) LoadMesh();
+                _skinRender.Update(_skeleton);
+            }
+
+            if (_showGhosts && !_playlistMode && _skeleton.Root) {
+                _onion.Bind(_action.Motion);
+                _onion.Update(_action.GetFrame(), _skeleton.Root->GlobalPosition);
+            }
+
+            if (_showCurves && !_playlistMode) {
+                unsigned const groups = (_curveRoot ? TrajectoryCurves::Root : 0u) | (_curveHands ? TrajectoryCurves::Hands : 0u) | (_curveFeet ? TrajectoryCurves::Feet : 0u);
+                _curves.Build(_action.Motion, groups);
+            }
 
             _frame.Resize(desiredSize, _aaSamples);
 
             _cameraManager.Update(_camera);
 
-            _program.GetUniforms().SetByName("u_Projection", _camera.GetProjectionMatrix((float(desiredSize.first) / desiredSize.second)));
-            _program.GetUniforms().SetByName("u_View"      , _camera.GetViewMatrix());
+            glm::mat4 const projection = _camera.GetProjectionMatrix((float(desiredSize.first) / desiredSize.second));
+            FrameUniforms::Global().Begin(projection, _camera.GetViewMatrix());
 
             gl_using(_frame);
 
-            BackGround.render(_program);
-            skeletonRender.render(_program);
+            {
+                PROFILE_GPU_ZONE("BVH scene");
+                BackGround.render(_program);
+                if (_showMesh) _skinRender.Render(projection, _camera.GetViewMatrix());
+                if (_showCurves && !_playlistMode && _skeleton.Root) _curves.Render(_action.GetFrame(), _skeleton.Root->GlobalPosition);
+                if (_showGhosts && !_playlistMode) _onion.Render();
+                if (_showBones) skeletonRender.render(_program);
+            }
 
-            glPointSize(1.f);
-            
             // Save frame if exporting
             if (_exporting) {
                 SaveFrame(_frame.GetColorAttachment(), desiredSize);
                 
-                // Check if animation is complete
-                if (_action.TimeIndex >= _action.Frames - 1) {
+                // Check if animation is complete, a playlist is exported until stopped
+                // With loop points the clip never reaches its last frame, the export ends at the out point
+                std::uint32_t const last = _action.LoopRange.IsValid() ? _action.LoopRange.Out : _action.Frames - 1;
+                if (!_playlistMode && _action.TimeIndex >= last) {
                     _exporting = false;
                     _stopped = true;
                 }
@@ -281,6 +499,7 @@ namespace VCX::Labs::FinalProject
 
         void CaseBVH::SaveFrame(Engine::GL::UniqueTexture2D const & tex, std::pair<std::uint32_t, std::uint32_t> texSize)
         {
+            PROFILE_ZONE("Frame export");
             // Create export directory if it doesn't exist
             std::filesystem::create_directories(_exportDir);
             
@@ -288,7 +507,7 @@ namespace VCX::Labs::FinalProject
             std::string filename = _exportDir + "/frame_" + fmt::format("{:04d}", _exportFrame) + ".png";
             
             // Save the frame
-            gl_using(tex);
+            auto const useTex = tex.Edit();
             std::vector<unsigned char> rawImg(texSize.first * texSize.second * 3);
             
             glPixelStorei(GL_PACK_ALIGNMENT, 1);
@@ -302,6 +521,102 @@ namespace VCX::Labs::FinalProject
             _exportFrame++;
         }
         
+        void CaseBVH::AnalyzeLoop()
+        {
+            _loopPoints = { };
+            _loopClip   = _action.Motion;
+            // Destroying an unfinished std::async future would wait for it, the old job is left to PollLoop
+            if (_loopJob.valid()) _staleLoopJobs.push_back(std::move(_loopJob));
+            if (!_loopClip) return;
+            _loopJob = std::async(std::launch::async, [path = _filePath, clip = _loopClip]() {
+                return GetLoopPoints(path, *clip);
+            });
+        }
+
+        void CaseBVH::ExtractRootMotion()
+        {
+            if (_action.Motion) _action.Trajectory = std::make_shared<RootMotion const>(GetRootMotion(_filePath, *_action.Motion));
+        }
+
+        void CaseBVH::PollLoop()
+        {
+            std::erase_if(_staleLoopJobs, [](auto const & job) { return job.wait_for(std::chrono::seconds(0)) == std::future_status::ready; });
+            if (!_loopJob.valid() || _loopJob.wait_for(std::chrono::seconds(0)) != std::future_status::ready) return;
+            _loopPoints = _loopJob.get();
+            // Another clip may have been loaded meanwhile
+            if (_action.Motion == _loopClip && _seamlessLoop) _action.LoopRange = _loopPoints;
+        }
+        
+        void CaseBVH::FindSimilar()
+        {
+            auto const          clips = _library.GetClips();
+            auto const          index = _similar.Clips == clips ? _similar.Index : nullptr;
+            std::uint32_t const begin = _similarRange ? static_cast<std::uint32_t>(std::max(_similarFrames[0], 0)) : 0;
+            std::uint32_t const end   = _similarRange ? static_cast<std::uint32_t>(std::max(_similarFrames[1], _similarFrames[0] + 1)) : _action.Frames;
+
+            SimilarityIndex::Query query = _similarQuery;
+            query.Exclude      = _filePath;
+            query.ExcludeBegin = begin;
+            query.ExcludeEnd   = end;
+            _similarJob = std::async(std::launch::async, [clips, index, clip = _action.Motion, query, begin, end]() {
+                ClipList const paths = clips ? *clips : ClipList { };
+                SimilarResult  result {
+                    .Index = index ? index : SimilarityIndex::Build(paths, LoadClipFiles(paths)),
+                    .Clips = clips,
+                };
+                std::vector<float> features;
+                if (result.Index->Featurize(*clip, begin, end, features) && !features.empty()) {
+                    std::uint32_t const length = static_cast<std::uint32_t>(features.size() / result.Index->GetDimensionCount());
+                    result.Matches = result.Index->Search(features.data(), length, query, &result.Stats);
+                }
+                return result;
+            });
+        }
+
+        void CaseBVH::PollSimilar()
+        {
+            if (!_similarJob.valid() || _similarJob.wait_for(std::chrono::seconds(0)) != std::future_status::ready) return;
+            _similar = _similarJob.get();
+        }
+
+        void CaseBVH::LockFeet()
+        {
+            float const dt = std::exchange(_footDt, 0.f);
+            if (!_footLocking || !_action.Motion) return;
+            if (_contactClip != _action.Motion) {
+                _contactClip = _action.Motion;
+                _legs        = LegRig::Find(*_contactClip->Skeleton);
+                _contacts    = { };
+                _footLock.Reset();
+                // As with the loop job, an unfinished future is left to PollContacts rather than waited for
+                if (_contactJob.valid()) _staleContactJobs.push_back(std::move(_contactJob));
+                _contactJob = std::async(std::launch::async, [clip = _contactClip, legs = _legs, settings = _footLock.Settings]() {
+                    return FootContacts::Detect(*BakedClip::Bake(*clip), legs, settings);
+                });
+            }
+            if (_contacts.Flags.empty()) return;
+
+            PROFILE_ZONE("Foot IK");
+            auto const start = std::chrono::steady_clock::now();
+            _footLock.Apply(_legs, _contacts.Flags[std::min<std::size_t>(_action.GetFrame(), _contacts.Flags.size() - 1)], dt, _skeleton);
+            float const ms = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+            _footMs        = _footMs == 0.f ? ms : .9f * _footMs + .1f * ms;
+        }
+
+        void CaseBVH::PollContacts()
+        {
+            std::erase_if(_staleContactJobs, [](auto const & job) { return job.wait_for(std::chrono::seconds(0)) == std::future_status::ready; });
+            if (!_contactJob.valid() || _contactJob.wait_for(std::chrono::seconds(0)) != std::future_status::ready) return;
+            _contacts = _contactJob.get();
+        }
+
+        void CaseBVH::LoadMesh()
+        {
+            if (!_skeleton.Def) return;
+            _skin = SkinnedMesh::Load(_meshPath, _skeleton.Def);
+            _skinRender.Load(_skin);
+        }
+
         void CaseBVH::OnProcessInput(ImVec2 const & pos)
         {
             _cameraManager.ProcessInput(_camera, pos);
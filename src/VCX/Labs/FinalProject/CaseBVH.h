@@ -1,5 +1,6 @@
 #pragma once
 
+#include <future>
 #include <vector>
 #include <string>
 #include <glm/glm.hpp>
@@ -17,6 +18,15 @@
 #include "Labs/FinalProject/Skeleton.h"
 #include "Labs/FinalProject/Player.h"
 #include "Labs/FinalProject/BVHLoader.h"
+#include "Labs/FinalProject/ClipPicker.h"
+#include "Labs/FinalProject/ClipSimilarity.h"
+#include "Labs/FinalProject/FootLock.h"
+#include "Labs/FinalProject/FrameUniforms.h"
+#include "Labs/FinalProject/Profiler.h"
+#include "Labs/FinalProject/OnionSkin.h"
+#include "Labs/FinalProject/Playlist.h"
+#include "Labs/FinalProject/SkinnedMesh.h"
+#include "Labs/FinalProject/TrajectoryCurves.h"
 
 namespace VCX::Labs::FinalProject 
 {   
@@ -47,7 +57,7 @@ namespace VCX::Labs::FinalProject
     class CaseBVH : public Common::ICase 
     {
     public:
-        CaseBVH();
+        CaseBVH(ClipLibrary & library, ClipIndexer & indexer);
 
         virtual std::string_view const GetName() override { return "BVH Animation"; }
 
@@ -57,6 +67,8 @@ namespace VCX::Labs::FinalProject
     
     private:
         Engine::GL::UniqueProgram               _program;
+        Engine::GL::UniformStats                _uniformsLast;  // Totals at the start of the last frame
+        Engine::GL::UniformStats                _uniformsFrame; // Over the last frame
         Engine::GL::UniqueRenderFrame           _frame;
         Engine::Camera                          _camera { .Eye = glm::vec3(-3, 3, 3) };
         Common::OrbitCameraManager              _cameraManager;
@@ -72,6 +84,20 @@ namespace VCX::Labs::FinalProject
         
         // Helper method for saving frames
         void SaveFrame(Engine::GL::UniqueTexture2D const & tex, std::pair<std::uint32_t, std::uint32_t> texSize);
+        // Finds the loop points of the loaded clip in the background, see PollLoop
+        void AnalyzeLoop();
+        void PollLoop();
+        // Splits the loaded clip's root track, cached per file next to the clip metadata
+        void ExtractRootMotion();
+        // Searches the library for clips similar to the loaded one in the background
+        void FindSimilar();
+        void PollSimilar();
+        // Pins the feet in contact after a frame is posed; the contacts of a new clip are detected in
+        // the background, see PollContacts, and the feet are left free until they arrive
+        void LockFeet();
+        void PollContacts();
+        // Binds the mesh to the current skeleton, again whenever a clip of another rig is shown
+        void LoadMesh();
 
         BackGroundRender                        BackGround;
         SkeletonRender                          skeletonRender;
@@ -82,5 +108,60 @@ namespace VCX::Labs::FinalProject
         Skeleton                                _skeleton;
         Action                                  _action;
         BVHLoader                               _BVHLoader;
+        ClipPicker                              _picker;
+        Playlist                                _playlist;
+        bool                                    _playlistMode  { false };
+
+        // Loop points of the loaded clip, cached per file under .cache/loops
+        std::future<LoopPoints>                 _loopJob;
+        std::vector<std::future<LoopPoints>>    _staleLoopJobs;     // Of clips left before their analysis ended
+        std::shared_ptr<Clip const>             _loopClip;
+        LoopPoints                              _loopPoints;
+        bool                                    _seamlessLoop  { true };
+
+        // Similar clips by DTW; the index over the library is built on the first search and
+        // rebuilt when the library changes
+        struct SimilarResult
+        {
+            std::shared_ptr<SimilarityIndex const>      Index;
+            std::shared_ptr<ClipList const>             Clips;
+            std::vector<SimilarityIndex::Match>         Matches;
+            SimilarityIndex::Stats                      Stats;
+        };
+        ClipLibrary &                           _library;
+        std::future<SimilarResult>              _similarJob;
+        SimilarResult                           _similar;
+        SimilarityIndex::Query                  _similarQuery  { .K = 5 };
+        bool                                    _similarRange  { false };   // Only the frames below, otherwise the whole clip
+        int                                     _similarFrames[2] { 0, 0 };
+
+        // Foot locking in single clip mode
+        std::shared_ptr<Clip const>             _contactClip;
+        LegRig                                  _legs;
+        FootContacts                            _contacts;
+        std::future<FootContacts>               _contactJob;
+        std::vector<std::future<FootContacts>>  _staleContactJobs;  // Of clips left before their detection ended
+        FootLock                                _footLock;
+        bool                                    _footLocking   { true };
+        float                                   _footDt        { 0.f };    // Real time since the last solve
+        float                                   _footMs        { 0.f };    // Smoothed IK time
+
+        // Skinned mesh, deformed on the GPU from the joints' matrix palette
+        std::string                             _meshPath      { "assets/models/character.obj" };
+        SkinnedMesh                             _skin;
+        SkinRender                              _skinRender;
+        bool                                    _showMesh      { true };
+        bool                                    _showBones     { true };
+
+        // Onion skin of the single clip: past and future poses from the baked clip, one draw
+        OnionSkin                               _onion;
+        bool                                    _showGhosts    { false };
+
+        // Paths of the root, hands and feet over the whole single clip, built once per clip
+        TrajectoryCurves                        _curves;
+        bool                                    _showCurves    { false };
+        bool                                    _curveRoot     { true };
+        bool                                    _curveHands    { true };
+        bool                                    _curveFeet     { true };
     };
 }
\ No newline at end of file
@@ -0,0 +1,400 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+
+#include <spdlog/spdlog.h>
+
+#include "Engine/app.h"
+#include "Engine/ThreadPool.hpp"
+#include "Labs/FinalProject/BVHLoader.h"
+#include "Labs/FinalProject/CaseCrowd.h"
+
+namespace VCX::Labs::FinalProject
+{
+    static constexpr std::size_t c_MaxCrowdClips = 16;
+    static constexpr float       c_Spacing       = 4.f;
+    static constexpr float       c_MaxGroundStep = .5f;  // Larger root steps are loop wraps or crossfade jumps
+    static constexpr int         c_MaxGpuCount   = 20000;
+    static constexpr int         c_FKRepeats     = 20;
+
+    static std::uint32_t NextRandom(std::uint32_t & state)
+    {
+        // xorshift32
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        return state;
+    }
+
+    // Two texels per character for the pose buffer shaders, (placement, phase) and (first frame,
+    // frames, frame time, 0), on a grid; the index of each character's random range goes to `picks`.
+    static std::vector<glm::vec4> MakeInstances(std::vector<PoseBuffer::Range> const & ranges, std::uint32_t const count, std::vector<std::uint32_t> & picks)
+    {
+        std::uint32_t const    side = std::uint32_t(std::ceil(std::sqrt(float(count))));
+        std::vector<glm::vec4> instances;
+        instances.reserve(std::size_t(count) * 2);
+        picks.resize(count);
+        for (std::uint32_t i = 0; i < count; ++i)
+        {
+            std::uint32_t seed = 2654435761u * (i + 1);
+            picks[i]           = NextRandom(seed) % ranges.size();
+            auto const & range = ranges[picks[i]];
+            float const  phase = float(NextRandom(seed) % 1000) / 1000.f * range.Frames * range.FrameTime;
+            instances.emplace_back((float(i % side) - .5f * (side - 1)) * c_Spacing, 0.f, (float(i / side) - .5f * (side - 1)) * c_Spacing, phase);
+            instances.emplace_back(float(range.First), float(range.Frames), range.FrameTime, 0.f);
+        }
+        return instances;
+    }
+
+    CaseCrowd::CaseCrowd(ClipLibrary & library) :
+        _program(
+            Engine::GL::UniqueProgram({
+                Engine::GL::SharedShader("assets/shaders/flat.vert"),
+                Engine::GL::SharedShader("assets/shaders/flat.frag")})),
+        _bones(Engine::GL::VertexLayout().Add<glm::vec3>("position", Engine::GL::DrawFrequency::Stream, 0), Engine::GL::PrimitiveType::Lines),
+        _library(library),
+        _gpuProgram(
+            Engine::GL::UniqueProgram({
+                Engine::GL::SharedShader("assets/shaders/crowd.vert"),
+                Engine::GL::SharedShader("assets/shaders/flat.frag")})),
+        _gpuBones(Engine::GL::VertexLayout().Add<float>("joint", Engine::GL::DrawFrequency::Static, 0), Engine::GL::PrimitiveType::Lines),
+        _poses(0),
+        _instances(GL_RGBA32F, 1)
+    {
+        _cameraManager.AutoRotate = false;
+        _cameraManager.Save(_camera);
+        FrameUniforms::Bind(_program);
+        FrameUniforms::Bind(_gpuProgram);
+        _gpuProgram.GetUniforms().SetByName("u_Poses", int(_poses.GetUnit()));
+        _gpuProgram.GetUniforms().SetByName("u_Instances", int(_instances.GetUnit()));
+        _gpuTimeUniform = _gpuProgram.GetUniforms().GetHandle<float>("u_Time");
+        _gpuPerInstance = _gpuProgram.GetUniforms().GetHandle<int>("u_PerInstance");
+    }
+
+    void CaseCrowd::OnSetupPropsUI()
+    {
+        ImGui::Text("Crowd Blending");
+        if (_clips.empty())
+        {
+            ImGui::TextDisabled("Loading clips...");
+            return;
+        }
+        ImGui::Text("Clips: %zu, joints per character: %u", _clips.size(), _clips.front()->Skeleton->GetJointCount());
+
+        ImGui::Separator();
+        auto const & gl = Engine::GL::State::GetFrameStats();
+        if (ImGui::Checkbox("GPU playback", &_gpuPlayback) && _gpuPlayback) PopulateGpu();
+        if (_gpuPlayback)
+        {
+            if (ImGui::SliderInt("Characters", &_gpuCount, 1, c_MaxGpuCount)) PopulateGpu();
+            if (ImGui::Checkbox("FK on the GPU", &_gpuFK) && _gpuFK && _feedback.IsEmpty()) _feedback.Build(_clips, true);
+            ImGui::Checkbox("Pause", &_stopped);
+
+            ImGui::Separator();
+            ImGui::Text("Pose buffer: %u frames, %.1f MB", _poses.GetFrameCount(), _poses.GetByteSize() / 1048576.f);
+            if (_gpuFK) ImGui::Text("CPU per frame: %.3f ms (%u FK passes, one draw)", _gpuMs, _feedback.GetLevelCount());
+            else ImGui::Text("CPU per frame: %.3f ms (one uniform, one draw)", _gpuMs);
+            ImGui::Text("GL state per frame: %llu calls (%llu draws), %llu skipped", static_cast<unsigned long long>(gl.Calls), static_cast<unsigned long long>(gl.Draws), static_cast<unsigned long long>(gl.Skipped));
+            ImGui::TextDisabled("Single clips in place, no blending or foot locking");
+
+            ImGui::Separator();
+            if (ImGui::Button("Benchmark FK")) BenchmarkFK();
+            for (auto const & timing : _fkTimings)
+                ImGui::Text("%5u: CPU %.3f ms, GPU %.3f ms (%.3f ms to issue)", timing.Characters, timing.CpuMs, timing.GpuMs, timing.SubmitMs);
+            return;
+        }
+        bool repopulate = ImGui::SliderInt("Characters", &_count, 1, 1000);
+        repopulate     |= ImGui::Checkbox("Upper body layer", &_layered);
+        repopulate     |= ImGui::Checkbox("Additive layer", &_additive);
+        ImGui::SliderFloat("Crossfade", &_fadeTime, 0.0f, 2.0f, "%.2f s");
+        static char const * curves[] = { "Linear", "Smooth Step", "Ease In", "Ease Out" };
+        ImGui::Combo("Curve", &_curve, curves, IM_ARRAYSIZE(curves));
+        if (ImGui::Checkbox("Slerp (else nlerp)", &_slerp))
+            for (auto & ch : _characters) ch.Blend.Mode = _slerp ? BlendMode::Slerp : BlendMode::Nlerp;
+        if (ImGui::Checkbox("Foot locking", &_footLock))
+            for (auto & ch : _characters) ch.Feet.Reset();
+        ImGui::Checkbox("Pause", &_stopped);
+        if (repopulate) Populate();
+
+        ImGui::Separator();
+        ImGui::Text("Blend + FK + IK: %.3f ms (%u threads)", _evalMs, Engine::ThreadPool::Global().GetThreadCount());
+        ImGui::Text("Per character: %.2f us", _characters.empty() ? 0.f : 1000.f * _evalMs / _characters.size());
+        ImGui::Text("Foot IK: %.3f ms CPU, %.2f us per character", _footMs, _characters.empty() ? 0.f : 1000.f * _footMs / _characters.size());
+        ImGui::Text("GL state per frame: %llu calls (%llu draws), %llu skipped", static_cast<unsigned long long>(gl.Calls), static_cast<unsigned long long>(gl.Draws), static_cast<unsigned long long>(gl.Skipped));
+    }
+
+    void CaseCrowd::Populate()
+    {
+        auto const          skeleton = _clips.front()->Skeleton;
+        std::uint32_t const joints   = skeleton->GetJointCount();
+        std::uint32_t const side     = std::uint32_t(std::ceil(std::sqrt(float(_count))));
+        auto                pick     = [&](std::uint32_t & seed) { return _clips[NextRandom(seed) % _clips.size()]; };
+
+        _characters.clear();
+        _characters.resize(_count);
+        for (int i = 0; i < _count; ++i)
+        {
+            Character & ch = _characters[i];
+            ch.Seed        = 2654435761u * std::uint32_t(i + 1);
+            ch.Placement   = { (float(i % side) - .5f * (side - 1)) * c_Spacing, 0.f, (float(i / side) - .5f * (side - 1)) * c_Spacing };
+            ch.NextSwitch  = 2.f + float(NextRandom(ch.Seed) % 4000) / 1000.f;
+            ch.Blend       = Blender(skeleton);
+            ch.Blend.Mode  = _slerp ? BlendMode::Slerp : BlendMode::Nlerp;
+
+            BlendLayer base { .Motion = pick(ch.Seed) };
+            base.Time = float(NextRandom(ch.Seed) % 1000) / 1000.f * base.Motion->GetDuration();
+            ch.Blend.Layers.push_back(base);
+
+            // Upper body from another clip, the legs keep the base clip
+            BlendLayer upper { .Motion = pick(ch.Seed), .Mask = _upperBody, .Weight = _layered ? 1.f : 0.f };
+            ch.Blend.Layers.push_back(upper);
+
+            // Additive: the difference of a clip from its first frame, at half strength on the upper body
+            BlendLayer lean { .Motion = pick(ch.Seed), .Mask = _upperBody, .Mode = BlendLayer::Kind::Additive, .Weight = _additive ? .5f : 0.f };
+            ch.Blend.Layers.push_back(lean);
+        }
+
+        _positions.assign(std::size_t(_count) * joints, glm::vec3(0.f));
+        _rotations.assign(std::size_t(_count) * joints, glm::quat(1.f, 0.f, 0.f, 0.f));
+
+        std::vector<std::uint32_t> indices;
+        indices.reserve(std::size_t(_count) * joints * 2);
+        for (int i = 0; i < _count; ++i)
+        {
+            for (std::uint32_t j = 0; j < joints; ++j)
+            {
+                if (skeleton->Parents[j] < 0) continue;
+                indices.push_back(i * joints + skeleton->Parents[j]);
+                indices.push_back(i * joints + j);
+            }
+        }
+        _bones.UpdateElementBuffer(indices);
+    }
+
+    void CaseCrowd::PopulateGpu()
+    {
+        // The clips are baked to the GPU once, repopulating only rewrites the instance table
+        if (_poses.IsEmpty()) _poses.Build(_clips, true);
+
+        // FeedbackFK lays out its tracks like the pose buffer, the table serves both
+        std::vector<std::uint32_t> picks;
+        _instances.Update(Engine::make_span_bytes<glm::vec4>(MakeInstances(_poses.GetRanges(), _gpuCount, picks)));
+
+        auto const &       skeleton = *_clips.front()->Skeleton;
+        std::vector<float> joints;
+        for (std::uint32_t j = 0; j < skeleton.GetJointCount(); ++j)
+        {
+            if (skeleton.Parents[j] < 0) continue;
+            joints.push_back(float(skeleton.Parents[j]));
+            joints.push_back(float(j));
+        }
+        _gpuBones.UpdateVertexBuffer("joint", Engine::make_span_bytes<float>(joints));
+        _gpuProgram.GetUniforms().SetByName("u_Joints", int(skeleton.GetJointCount()));
+    }
+
+    void CaseCrowd::BenchmarkFK()
+    {
+        if (_feedback.IsEmpty()) _feedback.Build(_clips, true);
+        std::uint32_t const             joints = _feedback.GetJointCount();
+        Engine::GL::UniqueTextureBuffer instances(GL_RGBA32F, _instances.GetUnit());
+        Engine::GL::UniqueQuery         query;
+
+        _fkTimings.clear();
+        for (std::uint32_t const count : { 1u, 100u, 10000u })
+        {
+            std::vector<std::uint32_t>   picks;
+            std::vector<glm::vec4> const texels = MakeInstances(_feedback.GetRanges(), count, picks);
+            instances.Update(Engine::make_span_bytes<glm::vec4>(texels));
+
+            // CPU: the crowd's sampling and FK in parallel, without blending or IK
+            std::vector<glm::vec3> positions(std::size_t(count) * joints);
+            std::vector<glm::quat> rotations(std::size_t(count) * joints);
+            auto                   start = std::chrono::steady_clock::now();
+            for (int r = 0; r < c_FKRepeats; ++r)
+            {
+                Engine::ThreadPool::Global().ParallelFor(count, 16, [&](std::size_t const begin, std::size_t const end) {
+                    Pose pose;
+                    for (std::size_t i = begin; i < end; ++i)
+                    {
+                        _clips[picks[i]]->Sample(r / 60.f + texels[2 * i].w, true, pose);
+                        pose.Offsets[0].x = pose.Offsets[0].z = 0.f;
+                        ForwardKinematics(*_clips[picks[i]]->Skeleton, pose, positions.data() + i * joints, rotations.data() + i * joints);
+                    }
+                });
+            }
+            float const cpuMs = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count() / c_FKRepeats;
+
+            // GPU: the passes' time from a timer query, and how long issuing them takes; the first
+            // evaluation sizes the pose buffers and is not counted
+            _feedback.Evaluate(instances, count, 0.f);
+            glFinish();
+            float    submitMs = 0.f;
+            GLuint64 gpuNs    = 0;
+            for (int r = 0; r < c_FKRepeats; ++r)
+            {
+                glBeginQuery(GL_TIME_ELAPSED, query.Get());
+                start = std::chrono::steady_clock::now();
+                _feedback.Evaluate(instances, count, r / 60.f);
+                submitMs += std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+                glEndQuery(GL_TIME_ELAPSED);
+
+                GLuint64 ns = 0;
+                glGetQueryObjectui64v(query.Get(), GL_QUERY_RESULT, &ns);
+                gpuNs += ns;
+            }
+
+            FKTiming const timing { .Characters = count, .CpuMs = cpuMs, .GpuMs = float(gpuNs * 1e-6 / c_FKRepeats), .SubmitMs = submitMs / c_FKRepeats };
+            _fkTimings.push_back(timing);
+            spdlog::info("CaseCrowd: FK of {} characters, CPU {:.3f} ms on {} threads, GPU {:.3f} ms ({:.3f} ms to issue).",
+                count, timing.CpuMs, Engine::ThreadPool::Global().GetThreadCount(), timing.GpuMs, timing.SubmitMs);
+        }
+    }
+
+    std::uint8_t CaseCrowd::GetContacts(Character const & ch) const
+    {
+        // The legs come from the base layer, from the clip it fades out of for the first half
+        BlendLayer const & base     = ch.Blend.Layers[0];
+        bool const         incoming = ! base.IsFading() || 2.f * base.FadeElapsed >= base.FadeDuration;
+        auto const         iter     = _contacts.find((incoming ? base.Motion : base.FadeFrom).get());
+        return iter == _contacts.end() ? 0 : iter->second.At(incoming ? base.Time : base.FadeFromTime, base.Loop);
+    }
+
+    void CaseCrowd::Evaluate(float const dt)
+    {
+        PROFILE_ZONE("Crowd update");
+        std::uint32_t const       joints = _clips.front()->Skeleton->GetJointCount();
+        FadeCurve const           curve  = FadeCurve(_curve);
+        auto const                start  = std::chrono::steady_clock::now();
+        std::atomic<std::int64_t> footNs = 0;
+
+        Engine::ThreadPool::Global().ParallelFor(_characters.size(), 16, [&](std::size_t const begin, std::size_t const end) {
+            for (std::size_t i = begin; i < end; ++i)
+            {
+                Character & ch = _characters[i];
+                ch.Blend.Advance(dt);
+                if ((ch.NextSwitch -= dt) <= 0.f)
+                {
+                    // Fade the base or the upper body into another clip
+                    auto & layer  = ch.Blend.Layers[NextRandom(ch.Seed) % 2];
+                    layer.CrossfadeTo(_clips[NextRandom(ch.Seed) % _clips.size()], _fadeTime, curve);
+                    ch.NextSwitch = 2.f + float(NextRandom(ch.Seed) % 4000) / 1000.f;
+                }
+                ch.Blend.Evaluate(ch.Local);
+
+                // In place: characters stay on their grid cell, the ground moves under them instead
+                glm::vec3 const root  = SceneScale * glm::vec3(ch.Local.Offsets[0].x, 0.f, ch.Local.Offsets[0].z);
+                glm::vec3       shift = ch.LastRoot - root;
+                ch.LastRoot           = root;
+                if (glm::length(shift) > c_MaxGroundStep) shift = glm::vec3(0.f);
+                ch.Local.Offsets[0].x = 0.f;
+                ch.Local.Offsets[0].z = 0.f;
+
+                glm::vec3 * positions = _positions.data() + i * joints;
+                glm::quat * rotations = _rotations.data() + i * joints;
+                ForwardKinematics(*ch.Blend.Skeleton, ch.Local, positions, rotations);
+                if (_footLock)
+                {
+                    auto const ik = std::chrono::steady_clock::now();
+                    ch.Feet.Apply(_legs, GetContacts(ch), dt, positions, rotations, shift);
+                    footNs += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - ik).count();
+                }
+                for (std::uint32_t j = 0; j < joints; ++j) positions[j] += ch.Placement;
+            }
+        });
+
+        float const ms     = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+        float const footMs = footNs * 1e-6f;
+        _evalMs            = _evalMs == 0.f ? ms : .9f * _evalMs + .1f * ms;
+        _footMs            = _footMs == 0.f ? footMs : .9f * _footMs + .1f * footMs;
+    }
+
+    Common::CaseRenderResult CaseCrowd::OnRender(std::pair<std::uint32_t, std::uint32_t> const desiredSize)
+    {
+        // Bake a handful of library clips in the background, once the library is known
+        if (! _loadStarted && ! _library.IsScanning())
+        {
+            _loadStarted = true;
+            _loading.Emplace([clips = _library.GetClips()]() {
+                ClipSet   baked;
+                BVHLoader loader;
+                for (auto const & path : *clips)
+                {
+                    if (baked.size() >= c_MaxCrowdClips) break;
+                    try
+                    {
+                        auto clip = loader.LoadClip(path.c_str());
+                        if (! clip || clip->Frames == 0) continue;
+                        if (! baked.empty() && clip->Skeleton->TopologyHash != baked.front()->Skeleton->TopologyHash) continue;
+                        baked.push_back(BakedClip::Bake(*clip));
+                    }
+                    catch (std::exception const &) { }
+                }
+                return baked;
+            });
+        }
+        if (_clips.empty() && _loading.HasValue() && ! _loading.Value().empty())
+        {
+            _clips     = _loading.Value();
+            _upperBody = std::make_shared<JointMask const>(JointMask::Subtree(*_clips.front()->Skeleton, "LowerBack"));
+            _legs      = LegRig::Find(*_clips.front()->Skeleton);
+            for (auto const & clip : _clips) _contacts.emplace(clip.get(), FootContacts::Detect(*clip, _legs));
+            Populate();
+        }
+
+        auto const start = std::chrono::steady_clock::now();
+        if (! _gpuPlayback && ! _characters.empty())
+        {
+            if (! _stopped) Evaluate(Engine::GetDeltaTime());
+            _bones.UpdateVertexBuffer("position", Engine::make_span_bytes<glm::vec3>(_positions));
+        }
+
+        _frame.Resize(desiredSize);
+        _cameraManager.Update(_camera);
+        FrameUniforms::Global().Begin(_camera.GetProjectionMatrix((float(desiredSize.first) / desiredSize.second)), _camera.GetViewMatrix());
+        if (_gpuPlayback)
+        {
+            if (! _stopped) _gpuTime += Engine::GetDeltaTime();
+            _gpuProgram.GetUniforms().Set(_gpuTimeUniform, _gpuTime);
+            _gpuProgram.GetUniforms().Set(_gpuPerInstance, int(_gpuFK));
+            if (_gpuFK)
+            {
+                PROFILE_GPU_ZONE("Crowd FK");
+                _feedback.Evaluate(_instances, _gpuCount, _gpuTime);
+            }
+        }
+
+        gl_using(_frame);
+        PROFILE_GPU_ZONE("Crowd draw");
+
+        _background.render(_program);
+        if (_gpuPlayback && ! _poses.IsEmpty())
+        {
+            auto & uniforms = FrameUniforms::Global();
+            Engine::GL::State::LineWidth(2.f);
+            _gpuBones.Draw({ _gpuProgram.Use(), _gpuFK ? _feedback.GetPoses().Use() : _poses.Use(), _instances.Use(), uniforms.Use(uniforms.Queue({ })) }, 0, 0, _gpuCount);
+
+            // CPU side only: the draw is queued, the GPU time is not included
+            float const ms = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+            _gpuMs         = _gpuMs == 0.f ? ms : .9f * _gpuMs + .1f * ms;
+        }
+        else if (! _characters.empty())
+        {
+            auto & uniforms = FrameUniforms::Global();
+            Engine::GL::State::LineWidth(2.f);
+            _bones.Draw({ _program.Use(), uniforms.Use(uniforms.Queue({ })) });
+        }
+
+        return Common::CaseRenderResult {
+            .Fixed     = false,
+            .Flipped   = true,
+            .Image     = _frame.GetColorAttachment(),
+            .ImageSize = desiredSize,
+        };
+    }
+
+    void CaseCrowd::OnProcessInput(ImVec2 const & pos)
+    {
+        _cameraManager.ProcessInput(_camera, pos);
+    }
+}
@@ -0,0 +1,114 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "Engine/Async.hpp"
+#include "Engine/GL/Frame.hpp"
+#include "Engine/GL/Program.h"
+#include "Engine/GL/RenderItem.h"
+#include "Engine/GL/TextureBuffer.hpp"
+#include "Labs/Common/OrbitCameraManager.h"
+#include "Labs/Common/ICase.h"
+
+#include "Labs/FinalProject/Blend.h"
+#include "Labs/FinalProject/CaseBVH.h"
+#include "Labs/FinalProject/ClipLibrary.h"
+#include "Labs/FinalProject/FeedbackFK.h"
+#include "Labs/FinalProject/FootLock.h"
+#include "Labs/FinalProject/PoseBuffer.h"
+
+namespace VCX::Labs::FinalProject
+{
+    class CaseCrowd : public Common::ICase
+    {
+    public:
+        CaseCrowd(ClipLibrary & library);
+
+        virtual std::string_view const GetName() override { return "Crowd Blending"; }
+
+        virtual void OnSetupPropsUI() override;
+        virtual Common::CaseRenderResult OnRender(std::pair<std::uint32_t, std::uint32_t> const desiredSize) override;
+        virtual void OnProcessInput(ImVec2 const & pos) override;
+
+    private:
+        using ClipSet    = std::vector<std::shared_ptr<BakedClip const>>;
+        using ContactMap = std::unordered_map<BakedClip const *, FootContacts>;
+
+        struct Character
+        {
+            Blender         Blend;
+            Pose            Local;
+            float           NextSwitch = 0.f;   // Seconds until the next crossfade
+            glm::vec3       Placement  = { 0.f, 0.f, 0.f };
+            std::uint32_t   Seed       = 1;     // Own random state, characters update in parallel
+            FootLock        Feet;
+            glm::vec3       LastRoot   = { 0.f, 0.f, 0.f }; // Ground position the root was taken from
+        };
+
+        struct FKTiming
+        {
+            std::uint32_t   Characters = 0;
+            float           CpuMs      = 0.f;   // Sampling + FK on all threads
+            float           GpuMs      = 0.f;   // Transform feedback passes, from a timer query
+            float           SubmitMs   = 0.f;   // CPU time to issue them
+        };
+
+        void         Populate();
+        void         PopulateGpu();
+        void         BenchmarkFK();
+        void         Evaluate(float const dt);
+        std::uint8_t GetContacts(Character const & ch) const; // Of the base layer's clip
+
+        Engine::GL::UniqueProgram               _program;
+        Engine::GL::UniqueRenderFrame           _frame;
+        Engine::Camera                          _camera { .ZFar = 500.f, .Eye = glm::vec3(-30, 25, 30) };
+        Common::OrbitCameraManager              _cameraManager;
+        BackGroundRender                        _background;
+        Engine::GL::UniqueIndexedRenderItem     _bones;
+
+        ClipLibrary &                           _library;
+        Engine::Async<ClipSet>                  _loading;
+        bool                                    _loadStarted   { false };
+        ClipSet                                 _clips;             // Baked clips sharing the first clip's topology
+        std::shared_ptr<JointMask const>        _upperBody;
+        LegRig                                  _legs;
+        ContactMap                              _contacts;          // Foot contacts of each clip, detected at load
+
+        std::vector<Character>                  _characters;
+        std::vector<glm::vec3>                  _positions;         // All characters' joints, one draw
+        std::vector<glm::quat>                  _rotations;
+
+        int                                     _count         { 200 };
+        float                                   _fadeTime      { 0.5f };
+        int                                     _curve         { 1 };     // FadeCurve
+        bool                                    _layered       { true };  // Upper body from a second clip
+        bool                                    _additive      { false }; // Extra additive lean layer
+        bool                                    _slerp         { false };
+        bool                                    _stopped       { false };
+        bool                                    _footLock      { true };  // Two-bone IK on the feet in contact
+        float                                   _evalMs        { 0.f };   // Smoothed blend + FK + IK time
+        float                                   _footMs        { 0.f };   // Smoothed IK time, summed over threads
+
+        // GPU playback: each character loops one clip of the pose buffer, posed in the vertex shader
+        // from its instance texels and u_Time, the only per-frame upload
+        Engine::GL::UniqueProgram               _gpuProgram;
+        Engine::GL::UniformHandle<float>        _gpuTimeUniform;
+        Engine::GL::UniformHandle<int>          _gpuPerInstance;
+        Engine::GL::UniqueRenderItem            _gpuBones;          // Joint indices of bone endpoints
+        PoseBuffer                              _poses;
+        Engine::GL::UniqueTextureBuffer         _instances;
+        bool                                    _gpuPlayback   { false };
+        int                                     _gpuCount      { 5000 };
+        float                                   _gpuTime       { 0.f };
+        float                                   _gpuMs         { 0.f };   // Smoothed CPU time of a GPU frame
+
+        // Optionally the poses are not read from the pose buffer but computed each frame from the
+        // local tracks, with forward kinematics in transform feedback passes
+        FeedbackFK                              _feedback;
+        bool                                    _gpuFK         { false };
+        std::vector<FKTiming>                   _fkTimings;
+    };
+}
@@ -7,14 +7,16 @@
 
 namespace VCX::Labs::FinalProject 
 {
-    CaseSkeleton::CaseSkeleton() :
+    CaseSkeleton::CaseSkeleton(ClipLibrary & library, ClipIndexer & indexer) :
         _program(
             Engine::GL::UniqueProgram({
                 Engine::GL::SharedShader("assets/shaders/flat.vert"),
-                Engine::GL::SharedShader("assets/shaders/flat.frag")}))
+                Engine::GL::SharedShader("assets/shaders/flat.frag")})),
+        _picker(library, indexer, _filePath)
         {
             _cameraManager.AutoRotate = false;
             _cameraManager.Save(_camera);
+            FrameUniforms::Bind(_program);
 
             _BVHLoader.Load(_filePath.c_str(), _skeleton, _action);
             _skeleton.ForwardKinematics();
@@ -33,54 +35,14 @@ namespace VCX::Labs::FinalProject
             // File selection dropdown
             ImGui::Text("Select BVH File:");
             
-            // Dynamically load BVH files from directory
-            static std::vector<std::string> bvh_files;
-            static bool files_loaded = false;
-            
-            if (!files_loaded) {
-                // Load all BVH files from the directory
-                namespace fs = std::filesystem;
-                std::string bvh_dir = "assets/BVH_data";
-                
-                if (fs::exists(bvh_dir) && fs::is_directory(bvh_dir)) {
-                    for (const auto& entry : fs::directory_iterator(bvh_dir)) {
-                        if (entry.is_regular_file() && entry.path().extension() == ".bvh") {
-                            // Convert to forward slashes for consistency with the rest of the codebase
-                            std::string path_str = entry.path().string();
-                            std::replace(path_str.begin(), path_str.end(), '\\', '/');
-                            bvh_files.push_back(path_str);
-                        }
-                    }
-                }
-                
-                files_loaded = true;
-                
-                // Set default file if available
-                if (!bvh_files.empty()) {
-                    _filePath = bvh_files[0];
-                }
-            }
-            
-            // Create a list of const char* for ImGui combo
-            static std::vector<const char*> bvh_files_ptr;
-            if (!bvh_files_ptr.empty()) {
-                bvh_files_ptr.clear();
-            }
-            for (const auto& file : bvh_files) {
-                bvh_files_ptr.push_back(file.c_str());
-            }
-            
-            static int current_file = 0;
-            if (ImGui::Combo("##bvh_file_combo", &current_file, bvh_files_ptr.data(), static_cast<int>(bvh_files_ptr.size()))) {
-                if (current_file >= 0 && current_file < static_cast<int>(bvh_files.size())) {
-                    _filePath = bvh_files[current_file];
-                    _BVHLoader.Load(_filePath.c_str(), _skeleton, _action);
-                    _skeleton.ForwardKinematics();
-                    skeletonRender.loadAll(_skeleton);
-                    _action.Reset();
-                    _hoveredJointIndex = -1;
-                    _hoveredJointName.clear();
-                }
+            if (_picker.OnSetupPropsUI()) {
+                _filePath = _picker.GetSelected();
+                _BVHLoader.Load(_filePath.c_str(), _skeleton, _action);
+                _skeleton.ForwardKinematics();
+                skeletonRender.loadAll(_skeleton);
+                _action.Reset();
+                _hoveredJointIndex = -1;
+                _hoveredJointName.clear();
             }
             
             ImGui::Separator();
@@ -122,16 +84,16 @@ namespace VCX::Labs::FinalProject
 
             _cameraManager.Update(_camera);
 
-            _program.GetUniforms().SetByName("u_Projection", _camera.GetProjectionMatrix((float(desiredSize.first) / desiredSize.second)));
-            _program.GetUniforms().SetByName("u_View"      , _camera.GetViewMatrix());
+            FrameUniforms::Global().Begin(_camera.GetProjectionMatrix((float(desiredSize.first) / desiredSize.second)), _camera.GetViewMatrix());
 
             gl_using(_frame);
 
-            BackGround.render(_program);
-            skeletonRender.render(_program);
+            {
+                PROFILE_GPU_ZONE("Skeleton scene");
+                BackGround.render(_program);
+                skeletonRender.render(_program);
+            }
 
-            glPointSize(1.f);
-            
             // Check for joint hover
             CheckJointHover(desiredSize, _lastMousePos);
             
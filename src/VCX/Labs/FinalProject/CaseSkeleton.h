@@ -17,6 +17,7 @@
 #include "Labs/FinalProject/Skeleton.h"
 #include "Labs/FinalProject/Player.h"
 #include "Labs/FinalProject/BVHLoader.h"
+#include "Labs/FinalProject/ClipPicker.h"
 #include "Labs/FinalProject/CaseBVH.h"
 
 namespace VCX::Labs::FinalProject 
@@ -24,7 +25,7 @@ namespace VCX::Labs::FinalProject
     class CaseSkeleton : public Common::ICase 
     {
     public:
-        CaseSkeleton();
+        CaseSkeleton(ClipLibrary & library, ClipIndexer & indexer);
 
         virtual std::string_view const GetName() override { return "Skeleton Structure"; }
 
@@ -44,6 +45,7 @@ namespace VCX::Labs::FinalProject
         Skeleton                                _skeleton;
         Action                                  _action;
         BVHLoader                               _BVHLoader;
+        ClipPicker                              _picker;
         
         // Hover detection
         ImVec2                                  _lastMousePos;
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "Labs/FinalProject/SkeletonDef.h"
+
+namespace VCX::Labs::FinalProject
+{
+    // Motion of one BVH file: raw channel rows over a shared, interned skeleton definition.
+    struct Clip
+    {
+        std::shared_ptr<SkeletonDef const>  Skeleton;
+        std::uint32_t                       Frames    = 0;
+        float                               FrameTime = 0.f;
+        std::vector<float>                  Channels;       // Frames rows of Skeleton->ChannelCount values
+        float const *                       Mapped = nullptr;   // The rows inside a ClipArchive instead, Channels is then empty
+        std::shared_ptr<void const>         Storage;            // Keeps the mapping alive
+
+        float const * GetData() const { return Mapped ? Mapped : Channels.data(); }
+        float const * GetFrame(std::uint32_t const frame) const { return GetData() + std::size_t(frame) * Skeleton->ChannelCount; }
+        float         GetDuration() const { return Frames * FrameTime; }
+    };
+}
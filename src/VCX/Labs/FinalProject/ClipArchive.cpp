@@ -0,0 +1,340 @@
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <unordered_map>
+
+#ifdef _WIN32
+    #ifndef NOMINMAX
+        #define NOMINMAX
+    #endif
+    #ifndef WIN32_LEAN_AND_MEAN
+        #define WIN32_LEAN_AND_MEAN
+    #endif
+    #include <windows.h>
+#else
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+#include <spdlog/spdlog.h>
+
+#include "Engine/ThreadPool.hpp"
+#include "Labs/FinalProject/AtomicFile.h"
+#include "Labs/FinalProject/ClipArchive.h"
+
+namespace VCX::Labs::FinalProject
+{
+    static constexpr std::uint32_t c_ArchiveMagic   = 0x52414C43; // "CLAR"
+    static constexpr std::uint32_t c_ArchiveVersion = 1;
+    static constexpr std::uint64_t c_BlockAlignment = 64;
+    static constexpr std::size_t   c_BatchPerThread = 4;          // Clips loaded per thread before they are written
+
+    struct ArchiveHeader
+    {
+        std::uint32_t   Magic;
+        std::uint32_t   Version;
+        std::uint32_t   ClipCount;
+        std::uint32_t   SkeletonCount;
+        std::uint64_t   TocOffset;
+        std::uint64_t   NamesOffset;
+        std::uint64_t   NamesSize;
+        std::uint64_t   SkeletonsOffset;
+        std::uint64_t   SkeletonsSize;
+        std::uint64_t   Reserved;
+    };
+    static_assert(sizeof(ArchiveHeader) == c_BlockAlignment);
+    static_assert(sizeof(ClipArchive::Entry) == 32);
+
+    // Read-only view of a whole file, unmapped on destruction.
+    struct FileMapping
+    {
+        void const *    Data = nullptr;
+        std::uint64_t   Size = 0;
+
+        FileMapping() = default;
+        FileMapping(FileMapping const &)             = delete;
+        FileMapping & operator=(FileMapping const &) = delete;
+
+        ~FileMapping()
+        {
+            if (! Data) return;
+#ifdef _WIN32
+            UnmapViewOfFile(Data);
+#else
+            munmap(const_cast<void *>(Data), Size);
+#endif
+        }
+    };
+
+    static std::shared_ptr<FileMapping const> MapFile(std::filesystem::path const & path)
+    {
+        auto mapping = std::make_shared<FileMapping>();
+#ifdef _WIN32
+        HANDLE const file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file == INVALID_HANDLE_VALUE) return nullptr;
+        LARGE_INTEGER size;
+        HANDLE const  map = GetFileSizeEx(file, &size) && size.QuadPart > 0 ? CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr) : nullptr;
+        // The view keeps the file open, the handles are not needed past this point
+        if (map)
+        {
+            mapping->Data = MapViewOfFile(map, FILE_MAP_READ, 0, 0, 0);
+            mapping->Size = std::uint64_t(size.QuadPart);
+            CloseHandle(map);
+        }
+        CloseHandle(file);
+#else
+        int const file = open(path.c_str(), O_RDONLY);
+        if (file < 0) return nullptr;
+        struct stat status;
+        if (fstat(file, &status) == 0 && status.st_size > 0)
+        {
+            void * const data = mmap(nullptr, std::size_t(status.st_size), PROT_READ, MAP_PRIVATE, file, 0);
+            if (data != MAP_FAILED)
+            {
+                mapping->Data = data;
+                mapping->Size = std::uint64_t(status.st_size);
+            }
+        }
+        close(file);
+#endif
+        return mapping->Data ? mapping : nullptr;
+    }
+
+    static void WriteSkeleton(std::ostream & file, SkeletonDef const & def)
+    {
+        auto write = [&file](auto const & value) { file.write(reinterpret_cast<char const *>(&value), sizeof(value)); };
+        auto array = [&file](auto const & values) { file.write(reinterpret_cast<char const *>(values.data()), std::streamsize(values.size() * sizeof(values[0]))); };
+
+        write(def.GetJointCount());
+        for (auto const & name : def.Names)
+        {
+            write(std::uint32_t(name.size()));
+            file.write(name.data(), std::streamsize(name.size()));
+        }
+        array(def.Parents);
+        array(def.Offsets);
+        array(def.PositionOrder);
+        array(def.RotationOrder);
+        array(def.Channels);
+        array(def.ChannelOffsets);
+        write(def.ChannelCount);
+    }
+
+    // Reads one definition at `data`, advancing it; false if it runs past `end` or is inconsistent.
+    static bool ReadSkeleton(char const *& data, char const * const end, SkeletonDef & def)
+    {
+        auto read = [&](auto & value) {
+            if (std::size_t(end - data) < sizeof(value)) return false;
+            std::memcpy(&value, data, sizeof(value));
+            data += sizeof(value);
+            return true;
+        };
+        auto array = [&](auto & values, std::size_t const count) {
+            values.resize(count);
+            std::size_t const bytes = count * sizeof(values[0]);
+            if (std::size_t(end - data) < bytes) return false;
+            std::memcpy(values.data(), data, bytes);
+            data += bytes;
+            return true;
+        };
+
+        std::uint32_t joints = 0;
+        if (! read(joints) || joints > (1u << 16)) return false;
+        def.Names.resize(joints);
+        for (auto & name : def.Names)
+        {
+            std::uint32_t length = 0;
+            if (! read(length) || std::size_t(end - data) < length) return false;
+            name.assign(data, length);
+            data += length;
+        }
+        if (! (array(def.Parents, joints) && array(def.Offsets, joints) && array(def.PositionOrder, joints) && array(def.RotationOrder, joints)
+            && array(def.Channels, joints) && array(def.ChannelOffsets, joints) && read(def.ChannelCount))) return false;
+
+        // Parents before their children and channels inside the row, as forward kinematics and GetData indexing assume
+        for (std::uint32_t j = 0; j < joints; ++j)
+        {
+            int const          parent   = def.Parents[j];
+            int const          offset   = def.ChannelOffsets[j];
+            std::uint8_t const channels = def.Channels[j];
+            if (parent < -1 || parent >= int(j)) return false;
+            if (channels != 0 && channels != 3 && channels != 6) return false;
+            if (channels == 0 ? offset != -1 : offset < 0 || std::uint64_t(offset) + channels > def.ChannelCount) return false;
+        }
+        return true;
+    }
+
+    bool ClipArchive::Pack(std::vector<std::string> const & names, ClipSource const & source, std::filesystem::path const & path)
+    {
+        // Entries are stored sorted by name, so that Find can search them
+        std::vector<std::size_t> order(names.size());
+        for (std::size_t i = 0; i < order.size(); ++i) order[i] = i;
+        std::sort(order.begin(), order.end(), [&names](std::size_t const a, std::size_t const b) { return names[a] < names[b]; });
+
+        bool const written = WriteFileAtomic(path, [&](std::ostream & file) {
+            auto write = [&file](auto const & value) { file.write(reinterpret_cast<char const *>(&value), sizeof(value)); };
+            auto align = [&file]() {
+                static constexpr char zeros[c_BlockAlignment] = { };
+                std::uint64_t const   offset                  = std::uint64_t(file.tellp());
+                file.write(zeros, std::streamsize((c_BlockAlignment - offset % c_BlockAlignment) % c_BlockAlignment));
+                return std::uint64_t(file.tellp());
+            };
+
+            ArchiveHeader header { .Magic = c_ArchiveMagic, .Version = c_ArchiveVersion };
+            write(header);
+
+            // Skeletons are kept alive while packing, so an interned definition keeps its address
+            std::vector<std::shared_ptr<SkeletonDef const>>         skeletons;
+            std::unordered_map<SkeletonDef const *, std::uint32_t>  skeletonIds;
+            std::vector<Entry>                                      entries;
+            std::string                                             nameBlock;
+
+            std::size_t const                        batch = c_BatchPerThread * Engine::ThreadPool::Global().GetThreadCount();
+            std::vector<std::shared_ptr<Clip const>> clips(batch);
+            for (std::size_t first = 0; first < order.size(); first += batch)
+            {
+                std::size_t const count = std::min(batch, order.size() - first);
+                Engine::ThreadPool::Global().ParallelFor(count, 1, [&](std::size_t const begin, std::size_t const end) {
+                    for (std::size_t i = begin; i < end; ++i)
+                    {
+                        // The pool does not take exceptions, a clip that fails to load is skipped
+                        try
+                        {
+                            clips[i] = source(order[first + i]);
+                        }
+                        catch (std::exception const & e)
+                        {
+                            spdlog::warn("ClipArchive: cannot load \"{}\": {}", names[order[first + i]], e.what());
+                            clips[i] = nullptr;
+                        }
+                    }
+                });
+                for (std::size_t i = 0; i < count; ++i)
+                {
+                    auto const clip = std::move(clips[i]);
+                    if (! clip || ! clip->Skeleton) continue;
+                    auto [iter, inserted] = skeletonIds.try_emplace(clip->Skeleton.get(), std::uint32_t(skeletons.size()));
+                    if (inserted) skeletons.push_back(clip->Skeleton);
+
+                    std::string const & name = names[order[first + i]];
+                    entries.push_back(Entry {
+                        .Offset       = align(),
+                        .NameOffset   = std::uint32_t(nameBlock.size()),
+                        .NameLength   = std::uint32_t(name.size()),
+                        .Skeleton     = iter->second,
+                        .Frames       = clip->Frames,
+                        .FrameTime    = clip->FrameTime,
+                        .ChannelCount = clip->Skeleton->ChannelCount,
+                    });
+                    nameBlock += name;
+                    file.write(reinterpret_cast<char const *>(clip->GetData()), std::streamsize(std::size_t(clip->Frames) * clip->Skeleton->ChannelCount * sizeof(float)));
+                }
+            }
+
+            header.ClipCount     = std::uint32_t(entries.size());
+            header.SkeletonCount = std::uint32_t(skeletons.size());
+            header.TocOffset     = align();
+            file.write(reinterpret_cast<char const *>(entries.data()), std::streamsize(entries.size() * sizeof(Entry)));
+            header.NamesOffset = std::uint64_t(file.tellp());
+            header.NamesSize   = nameBlock.size();
+            file.write(nameBlock.data(), std::streamsize(nameBlock.size()));
+            header.SkeletonsOffset = align();
+            for (auto const & skeleton : skeletons) WriteSkeleton(file, *skeleton);
+            header.SkeletonsSize = std::uint64_t(file.tellp()) - header.SkeletonsOffset;
+            file.seekp(0);
+            write(header);
+        });
+        if (! written) spdlog::warn("ClipArchive: cannot write \"{}\".", path.string());
+        return written;
+    }
+
+    std::shared_ptr<ClipArchive const> ClipArchive::Open(std::filesystem::path const & path)
+    {
+        auto mapping = MapFile(path);
+        if (! mapping || mapping->Size < sizeof(ArchiveHeader)) return nullptr;
+
+        ArchiveHeader header;
+        std::memcpy(&header, mapping->Data, sizeof(header));
+        std::uint64_t const size = mapping->Size;
+        if (header.Magic != c_ArchiveMagic || header.Version != c_ArchiveVersion
+            || header.TocOffset % alignof(Entry) != 0 || header.TocOffset + std::uint64_t(header.ClipCount) * sizeof(Entry) > size
+            || header.NamesOffset + header.NamesSize > size || header.SkeletonsOffset + header.SkeletonsSize > size)
+        {
+            spdlog::warn("ClipArchive: \"{}\" is not an archive of this version.", path.string());
+            return nullptr;
+        }
+
+        auto archive      = std::make_shared<ClipArchive>();
+        archive->_base    = static_cast<char const *>(mapping->Data);
+        archive->_size    = size;
+        archive->_entries = reinterpret_cast<Entry const *>(archive->_base + header.TocOffset);
+        archive->_count   = header.ClipCount;
+        archive->_names   = archive->_base + header.NamesOffset;
+
+        char const *       data = archive->_base + header.SkeletonsOffset;
+        char const * const end  = data + header.SkeletonsSize;
+        for (std::uint32_t s = 0; s < header.SkeletonCount; ++s)
+        {
+            SkeletonDef def;
+            if (! ReadSkeleton(data, end, def))
+            {
+                spdlog::warn("ClipArchive: \"{}\" is truncated or has an invalid skeleton {}.", path.string(), s);
+                return nullptr;
+            }
+            archive->_skeletons.push_back(SkeletonRegistry::Global().Intern(std::move(def)));
+        }
+
+        // Every block inside the file and the names in order, so that later lookups need no checks
+        for (std::size_t i = 0; i < archive->_count; ++i)
+        {
+            Entry const & entry = archive->_entries[i];
+            bool const    valid = entry.Skeleton < header.SkeletonCount && entry.ChannelCount == archive->_skeletons[entry.Skeleton]->ChannelCount
+                && entry.Offset % alignof(float) == 0 && entry.Offset + std::uint64_t(entry.Frames) * entry.ChannelCount * sizeof(float) <= size
+                && std::uint64_t(entry.NameOffset) + entry.NameLength <= header.NamesSize && (i == 0 || archive->GetName(i - 1) < archive->GetName(i));
+            if (! valid)
+            {
+                spdlog::warn("ClipArchive: \"{}\" has an invalid entry {}.", path.string(), i);
+                return nullptr;
+            }
+        }
+        archive->_mapping = std::move(mapping);
+        return archive;
+    }
+
+    std::string_view ClipArchive::GetName(std::size_t const index) const
+    {
+        return { _names + _entries[index].NameOffset, _entries[index].NameLength };
+    }
+
+    int ClipArchive::Find(std::string_view const name) const
+    {
+        std::size_t low = 0, high = _count;
+        while (low < high)
+        {
+            std::size_t const mid = (low + high) / 2;
+            if (GetName(mid) < name) low = mid + 1;
+            else high = mid;
+        }
+        return low < _count && GetName(low) == name ? int(low) : -1;
+    }
+
+    std::shared_ptr<Clip const> ClipArchive::GetClip(std::size_t const index) const
+    {
+        Entry const & entry = _entries[index];
+        auto          clip  = std::make_shared<Clip>();
+        clip->Skeleton      = _skeletons[entry.Skeleton];
+        clip->Frames        = entry.Frames;
+        clip->FrameTime     = entry.FrameTime;
+        clip->Mapped        = reinterpret_cast<float const *>(_base + entry.Offset);
+        clip->Storage       = _mapping;
+        return clip;
+    }
+
+    std::shared_ptr<Clip const> ClipArchive::GetClip(std::string_view const name) const
+    {
+        int const index = Find(name);
+        return index < 0 ? nullptr : GetClip(std::size_t(index));
+    }
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "Labs/FinalProject/Clip.h"
+#include "Labs/FinalProject/ClipLibrary.h"
+
+namespace VCX::Labs::FinalProject
+{
+    // A whole clip library in one file: the channel rows of every clip in 64-byte aligned blocks,
+    // then a table of contents (name, skeleton, frame count, frame time and block of each clip,
+    // sorted by name) and the skeleton definitions the clips share. The file is mapped read-only
+    // in one go; clips returned by the archive point into the mapping instead of copying their rows.
+    class ClipArchive
+    {
+    public:
+        // Table of contents entry, as stored in the file.
+        struct Entry
+        {
+            std::uint64_t   Offset;         // Of the channel rows from the start of the file
+            std::uint32_t   NameOffset;     // Into the name block
+            std::uint32_t   NameLength;
+            std::uint32_t   Skeleton;       // Into GetSkeletons()
+            std::uint32_t   Frames;
+            float           FrameTime;
+            std::uint32_t   ChannelCount;
+        };
+
+        // Loads the clips in parallel batches and writes them as they come, so only a batch is in
+        // memory at a time. Clips are looked up by `names`, which need not be sorted.
+        static bool Pack(std::vector<std::string> const & names, ClipSource const & source, std::filesystem::path const & path);
+
+        // nullptr if the file is missing, truncated or was written by another version.
+        static std::shared_ptr<ClipArchive const> Open(std::filesystem::path const & path);
+
+        std::size_t                                             GetClipCount() const { return _count; }
+        Entry const &                                           GetEntry(std::size_t const index) const { return _entries[index]; }
+        std::string_view                                        GetName(std::size_t const index) const;
+        std::vector<std::shared_ptr<SkeletonDef const>> const & GetSkeletons() const { return _skeletons; }
+        std::uint64_t                                           GetByteSize() const { return _size; }
+
+        int                         Find(std::string_view const name) const;  // -1 if absent
+        std::shared_ptr<Clip const> GetClip(std::size_t const index) const;
+        std::shared_ptr<Clip const> GetClip(std::string_view const name) const; // nullptr if absent
+
+    private:
+        std::shared_ptr<void const>                         _mapping;   // Unmaps once the archive and its clips are gone
+        char const *                                        _base    = nullptr;
+        std::uint64_t                                       _size    = 0;
+        Entry const *                                       _entries = nullptr;
+        std::size_t                                         _count   = 0;
+        char const *                                        _names   = nullptr;
+        std::vector<std::shared_ptr<SkeletonDef const>>     _skeletons;
+    };
+}
@@ -0,0 +1,287 @@
+#include <algorithm>
+#include <fstream>
+#include <iterator>
+#include <limits>
+#include <sstream>
+
+#include <fmt/core.h>
+#include <spdlog/spdlog.h>
+
+#include "Labs/FinalProject/AtomicFile.h"
+#include "Labs/FinalProject/BVHLoader.h"
+#include "Labs/FinalProject/ClipIndex.h"
+
+namespace VCX::Labs::FinalProject
+{
+    static constexpr std::uint32_t c_CacheMagic   = 0x50494C43; // "CLIP"
+    static constexpr std::uint32_t c_CacheVersion = 1;
+
+    static void DrawLine(Common::ImageRGB & image, glm::vec2 p0, glm::vec2 p1, glm::vec2 const & lo, glm::vec2 const & hi, glm::vec3 const & color)
+    {
+        int const steps = int(std::max(std::abs(p1.x - p0.x), std::abs(p1.y - p0.y))) + 1;
+        for (int i = 0; i <= steps; ++i)
+        {
+            glm::vec2 const p = glm::mix(p0, p1, float(i) / steps);
+            if (p.x < lo.x || p.y < lo.y || p.x >= hi.x || p.y >= hi.y) continue;
+            image.At(std::size_t(p.x), std::size_t(p.y)) = color;
+        }
+    }
+
+    // Front view of one pose, framed on the root horizontally and on the clip bounds vertically.
+    static void RenderTile(
+        Common::ImageRGB &                         image,
+        std::uint32_t const                        tile,
+        std::vector<glm::vec3> const &             positions,
+        std::vector<std::uint32_t> const &         indices,
+        glm::vec3 const &                          boundsMin,
+        glm::vec3 const &                          boundsMax)
+    {
+        float const size   = float(ClipIndexer::ThumbnailTileSize);
+        float const height = std::max(boundsMax.y - boundsMin.y, 1e-3f);
+        float const scale  = .85f * size / height;
+        glm::vec2 const lo { tile * size, 0.f };
+        glm::vec2 const hi { lo.x + size, size };
+
+        auto project = [&](glm::vec3 const & p) {
+            return glm::vec2(
+                lo.x + .5f * size + (p.x - positions[0].x) * scale,
+                size - 1.f - (.075f * size + (p.y - boundsMin.y) * scale));
+        };
+
+        for (std::size_t i = 0; i + 1 < indices.size(); i += 2)
+            DrawLine(image, project(positions[indices[i]]), project(positions[indices[i + 1]]), lo, hi, { .9f, .9f, .9f });
+        for (auto const & p : positions)
+            DrawLine(image, project(p), project(p) + glm::vec2(1.f, 1.f), lo, hi, { 1.f, .25f, .25f });
+    }
+
+    ClipIndexer::ClipIndexer(std::filesystem::path const & cacheDir, std::uint32_t const workers) :
+        _cacheDir(cacheDir)
+    {
+        std::error_code ec;
+        std::filesystem::create_directories(_cacheDir, ec);
+        if (ec) spdlog::warn("ClipIndexer: cannot create cache directory \"{}\": {}", _cacheDir.string(), ec.message());
+
+        std::uint32_t const count = workers ? workers : std::clamp(std::thread::hardware_concurrency(), 2u, 5u) - 1;
+        for (std::uint32_t i = 0; i < count; ++i)
+            _workers.emplace_back([this]() { Work(); });
+    }
+
+    ClipIndexer::~ClipIndexer()
+    {
+        {
+            std::lock_guard lock(_mutex);
+            _stopping = true;
+        }
+        _wake.notify_all();
+        for (auto & worker : _workers) worker.join();
+    }
+
+    void ClipIndexer::Request(std::string const & path)
+    {
+        {
+            std::lock_guard lock(_mutex);
+            if (! _infos.try_emplace(path, nullptr).second) return;
+            _queue.push_back(path);
+            ++_pending;
+        }
+        _wake.notify_one();
+    }
+
+    std::shared_ptr<ClipInfo const> ClipIndexer::Find(std::string const & path) const
+    {
+        std::lock_guard lock(_mutex);
+        if (auto const iter = _infos.find(path); iter != _infos.end()) return iter->second;
+        return nullptr;
+    }
+
+    std::size_t ClipIndexer::GetPendingCount() const
+    {
+        std::lock_guard lock(_mutex);
+        return _pending;
+    }
+
+    Engine::GL::UniqueTexture2D const * ClipIndexer::GetThumbnail(std::string const & path)
+    {
+        if (auto const iter = _thumbnails.find(path); iter != _thumbnails.end()) return iter->second.get();
+
+        auto const info = Find(path);
+        if (! info || info->ThumbnailTiles == 0) return nullptr;
+
+        auto & tex = _thumbnails[path];
+        tex = std::make_unique<Engine::GL::UniqueTexture2D>(
+            info->Thumbnail,
+            Engine::GL::SamplerOptions { .MinFilter = Engine::GL::FilterMode::Linear, .MagFilter = Engine::GL::FilterMode::Linear });
+        return tex.get();
+    }
+
+    std::uint64_t ClipIndexer::HashBytes(std::string_view const bytes)
+    {
+        std::uint64_t hash = 14695981039346656037ull;
+        for (char const c : bytes)
+        {
+            hash ^= std::uint8_t(c);
+            hash *= 1099511628211ull;
+        }
+        return hash;
+    }
+
+    void ClipIndexer::Work()
+    {
+        while (true)
+        {
+            std::string path;
+            {
+                std::unique_lock lock(_mutex);
+                _wake.wait(lock, [this]() { return _stopping || ! _queue.empty(); });
+                if (_stopping) return;
+                path = std::move(_queue.front());
+                _queue.pop_front();
+            }
+
+            auto info = Index(path);
+
+            std::lock_guard lock(_mutex);
+            _infos[path] = info ? info : std::make_shared<ClipInfo const>(ClipInfo { .Path = path });
+            --_pending;
+        }
+    }
+
+    std::shared_ptr<ClipInfo const> ClipIndexer::Index(std::string const & path) const
+    {
+        std::ifstream file(path, std::ios::binary);
+        if (! file.is_open())
+        {
+            spdlog::warn("ClipIndexer: cannot open \"{}\".", path);
+            return nullptr;
+        }
+        std::string const bytes { std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>() };
+        std::uint64_t const hash = HashBytes(bytes);
+
+        if (auto cached = ReadCache(hash))
+        {
+            cached->Path = path;
+            return cached;
+        }
+
+        auto info  = std::make_shared<ClipInfo>();
+        info->Path = path;
+        info->Hash = hash;
+
+        Skeleton  skeleton;
+        Action    action;
+        BVHLoader loader;
+        try
+        {
+            std::istringstream stream(bytes);
+            auto const summary = loader.LoadSampled(stream, skeleton, action, SampledFrames);
+            info->Frames       = summary.Frames;
+            info->FrameTime    = summary.FrameTime;
+            info->Duration     = summary.Frames * summary.FrameTime;
+        }
+        catch (std::exception const & e)
+        {
+            spdlog::warn("ClipIndexer: malformed clip \"{}\": {}", path, e.what());
+            return nullptr;
+        }
+        if (! skeleton.Root || action.Frames == 0) return nullptr;
+
+        info->JointCount = skeleton.GetJointCount();
+
+        // Bounds over every sampled frame, poses kept only for the thumbnail tiles
+        std::uint32_t const        samples = action.Frames;
+        std::vector<std::uint32_t> tileFrames(ThumbnailTileCount);
+        for (std::uint32_t t = 0; t < ThumbnailTileCount; ++t)
+            tileFrames[t] = ThumbnailTileCount > 1 ? t * (samples - 1) / (ThumbnailTileCount - 1) : 0;
+
+        std::vector<std::vector<glm::vec3>> tilePoses(ThumbnailTileCount);
+        std::vector<std::uint32_t>          indices;
+        info->BoundsMin = glm::vec3(std::numeric_limits<float>::max());
+        info->BoundsMax = glm::vec3(std::numeric_limits<float>::lowest());
+        for (std::uint32_t i = 0; i < samples; ++i)
+        {
+            action.Apply(skeleton, i);
+            auto res = skeleton.Convert();
+            for (auto const & p : res.first)
+            {
+                info->BoundsMin = glm::min(info->BoundsMin, p);
+                info->BoundsMax = glm::max(info->BoundsMax, p);
+            }
+            for (std::uint32_t t = 0; t < ThumbnailTileCount; ++t)
+                if (tileFrames[t] == i) tilePoses[t] = res.first;
+            indices = std::move(res.second);
+        }
+
+        info->ThumbnailTiles = ThumbnailTileCount;
+        info->Thumbnail      = Common::CreatePureImageRGB(ThumbnailTileSize * ThumbnailTileCount, ThumbnailTileSize, { .12f, .12f, .14f });
+        for (std::uint32_t t = 0; t < ThumbnailTileCount; ++t)
+            RenderTile(info->Thumbnail, t, tilePoses[t], indices, info->BoundsMin, info->BoundsMax);
+
+        WriteCache(*info);
+        return info;
+    }
+
+    std::filesystem::path ClipIndexer::GetCachePath(std::uint64_t const hash) const
+    {
+        return _cacheDir / fmt::format("{:016x}.clip", hash);
+    }
+
+    std::shared_ptr<ClipInfo> ClipIndexer::ReadCache(std::uint64_t const hash) const
+    {
+        std::ifstream file(GetCachePath(hash), std::ios::binary);
+        if (! file.is_open()) return nullptr;
+
+        auto read = [&file](auto & value) { file.read(reinterpret_cast<char *>(&value), sizeof(value)); };
+
+        std::uint32_t magic = 0, version = 0, width = 0, height = 0;
+        auto          info = std::make_shared<ClipInfo>();
+        read(magic);
+        read(version);
+        read(info->Hash);
+        if (! file || magic != c_CacheMagic || version != c_CacheVersion || info->Hash != hash) return nullptr;
+
+        read(info->Frames);
+        read(info->FrameTime);
+        read(info->Duration);
+        read(info->JointCount);
+        read(info->BoundsMin);
+        read(info->BoundsMax);
+        read(info->ThumbnailTiles);
+        read(width);
+        read(height);
+        if (! file || width != ThumbnailTileSize * info->ThumbnailTiles || height != ThumbnailTileSize) return nullptr;
+
+        std::vector<glm::u8vec3> pixels(std::size_t(width) * height);
+        file.read(reinterpret_cast<char *>(pixels.data()), pixels.size() * sizeof(glm::u8vec3));
+        if (! file) return nullptr;
+
+        info->Thumbnail = Common::ImageRGB(width, height);
+        for (std::uint32_t y = 0; y < height; ++y)
+            for (std::uint32_t x = 0; x < width; ++x)
+                info->Thumbnail.At(x, y) = glm::vec3(pixels[y * width + x]) / 255.f;
+        return info;
+    }
+
+    void ClipIndexer::WriteCache(ClipInfo const & info) const
+    {
+        WriteFileAtomic(GetCachePath(info.Hash), [&info](std::ostream & file) {
+            auto write = [&file](auto const & value) { file.write(reinterpret_cast<char const *>(&value), sizeof(value)); };
+
+            std::uint32_t const width  = info.Thumbnail.GetSizeX();
+            std::uint32_t const height = info.Thumbnail.GetSizeY();
+            write(c_CacheMagic);
+            write(c_CacheVersion);
+            write(info.Hash);
+            write(info.Frames);
+            write(info.FrameTime);
+            write(info.Duration);
+            write(info.JointCount);
+            write(info.BoundsMin);
+            write(info.BoundsMax);
+            write(info.ThumbnailTiles);
+            write(width);
+            write(height);
+            auto const bytes = info.Thumbnail.GetBytes();
+            file.write(reinterpret_cast<char const *>(bytes.data()), bytes.size());
+        });
+    }
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "Engine/GL/Texture.hpp"
+#include "Labs/Common/ImageRGB.h"
+
+namespace VCX::Labs::FinalProject
+{
+    // Summary of a BVH clip, computed from its header and a few sampled frames.
+    struct ClipInfo
+    {
+        std::string         Path;
+        std::uint64_t       Hash           = 0;   // FNV-1a of the file contents, also the cache key
+        std::uint32_t       Frames         = 0;
+        float               FrameTime      = 0.f;
+        float               Duration       = 0.f;
+        std::uint32_t       JointCount     = 0;
+        glm::vec3           BoundsMin      = { 0.f, 0.f, 0.f }; // Scene-space bounds over the sampled frames
+        glm::vec3           BoundsMax      = { 0.f, 0.f, 0.f };
+        std::uint32_t       ThumbnailTiles = 0;
+        Common::ImageRGB    Thumbnail;                          // Square tiles, left to right in time
+    };
+
+    // Indexes clips on background threads and keeps the results in an on-disk cache keyed by
+    // file hash, so a clip is only parsed again when its contents change.
+    class ClipIndexer
+    {
+    public:
+        explicit ClipIndexer(std::filesystem::path const & cacheDir = ".cache/clips", std::uint32_t const workers = 0);
+        ~ClipIndexer();
+
+        ClipIndexer(ClipIndexer const &)             = delete;
+        ClipIndexer & operator=(ClipIndexer const &) = delete;
+
+        void                            Request(std::string const & path);
+        std::shared_ptr<ClipInfo const> Find(std::string const & path) const; // nullptr until indexed
+        std::size_t                     GetPendingCount() const;
+
+        // Uploads the thumbnail strip on first use, must be called from the render thread.
+        Engine::GL::UniqueTexture2D const * GetThumbnail(std::string const & path);
+
+        static std::uint64_t HashBytes(std::string_view const bytes);
+
+        static constexpr std::uint32_t  ThumbnailTileSize  = 48;
+        static constexpr std::uint32_t  ThumbnailTileCount = 8;
+        static constexpr std::uint32_t  SampledFrames      = 64;
+
+    private:
+        void                            Work();
+        std::shared_ptr<ClipInfo const> Index(std::string const & path) const;
+        std::shared_ptr<ClipInfo>       ReadCache(std::uint64_t const hash) const;
+        void                            WriteCache(ClipInfo const & info) const;
+        std::filesystem::path           GetCachePath(std::uint64_t const hash) const;
+
+        std::filesystem::path                                                      _cacheDir;
+        mutable std::mutex                                                         _mutex;
+        std::condition_variable                                                    _wake;
+        std::deque<std::string>                                                    _queue;
+        std::unordered_map<std::string, std::shared_ptr<ClipInfo const>>           _infos;   // nullptr while queued
+        std::unordered_map<std::string, std::unique_ptr<Engine::GL::UniqueTexture2D>> _thumbnails;
+        std::size_t                                                                _pending  = 0; // Requested but not indexed yet
+        std::vector<std::thread>                                                   _workers;
+        bool                                                                       _stopping = false;
+    };
+}
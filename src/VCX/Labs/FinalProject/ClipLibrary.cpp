@@ -0,0 +1,310 @@
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <filesystem>
+#include <unordered_map>
+
+#include <spdlog/spdlog.h>
+
+#ifdef __linux__
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+#include "Labs/FinalProject/BVHLoader.h"
+#include "Labs/FinalProject/ClipLibrary.h"
+
+namespace VCX::Labs::FinalProject
+{
+    static std::string ToGeneric(std::filesystem::path const & path)
+    {
+        // Forward slashes for consistency with the rest of the codebase
+        std::string str = path.string();
+        std::replace(str.begin(), str.end(), '\\', '/');
+        return str;
+    }
+
+    static bool IsClip(std::string_view const path)
+    {
+        return path.size() > 4 && path.substr(path.size() - 4) == ".bvh";
+    }
+
+    ClipLibrary::ClipLibrary(std::string const & root) :
+        _root(root),
+        _clips(std::make_shared<ClipList const>())
+    {
+        _watcher = std::thread([this]() { Watch(); });
+    }
+
+    ClipLibrary::~ClipLibrary()
+    {
+        {
+            std::lock_guard lock(_mutex);
+            _stopping = true;
+        }
+        _wake.notify_all();
+        _watcher.join();
+    }
+
+    std::shared_ptr<ClipList const> ClipLibrary::GetClips() const
+    {
+        std::lock_guard lock(_mutex);
+        return _clips;
+    }
+
+    bool ClipLibrary::IsScanning() const
+    {
+        std::lock_guard lock(_mutex);
+        return _scanning;
+    }
+
+    ClipList FindClips(std::string const & root)
+    {
+        namespace fs = std::filesystem;
+        ClipList        clips;
+        std::error_code ec;
+        for (auto iter = fs::recursive_directory_iterator(root, fs::directory_options::skip_permission_denied, ec);
+             ! ec && iter != fs::recursive_directory_iterator();
+             iter.increment(ec))
+        {
+            if (! iter->is_regular_file(ec)) continue;
+            std::string path = ToGeneric(iter->path());
+            if (IsClip(path)) clips.push_back(std::move(path));
+        }
+        std::sort(clips.begin(), clips.end());
+        return clips;
+    }
+
+    ClipSource LoadClipFiles(ClipList const & paths)
+    {
+        return [paths](std::size_t const index) {
+            BVHLoader loader;
+            return loader.LoadClip(paths[index].c_str());
+        };
+    }
+
+    void ClipLibrary::Scan(std::string const & dir)
+    {
+        for (auto & path : FindClips(dir)) _paths.insert(std::move(path));
+    }
+
+    void ClipLibrary::Publish()
+    {
+        auto clips = std::make_shared<ClipList const>(_paths.begin(), _paths.end());
+        std::lock_guard lock(_mutex);
+        _clips    = std::move(clips);
+        _scanning = false;
+    }
+
+    void ClipLibrary::Watch()
+    {
+#ifdef __linux__
+        int const fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        if (fd >= 0)
+        {
+            std::unordered_map<int, std::string> dirs;
+            auto watch = [&](std::string const & root) {
+                namespace fs = std::filesystem;
+                std::uint32_t const mask = IN_CREATE | IN_CLOSE_WRITE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO | IN_DELETE_SELF | IN_ONLYDIR;
+                if (int const wd = inotify_add_watch(fd, root.c_str(), mask); wd >= 0) dirs[wd] = root;
+                std::error_code ec;
+                for (auto iter = fs::recursive_directory_iterator(root, fs::directory_options::skip_permission_denied, ec);
+                     ! ec && iter != fs::recursive_directory_iterator();
+                     iter.increment(ec))
+                {
+                    if (! iter->is_directory(ec)) continue;
+                    std::string const dir = ToGeneric(iter->path());
+                    if (int const wd = inotify_add_watch(fd, dir.c_str(), mask); wd >= 0) dirs[wd] = dir;
+                }
+            };
+
+            // Watches go in before the first scan, so nothing created in between is missed
+            watch(_root);
+            Scan(_root);
+            Publish();
+
+            alignas(inotify_event) char buffer[16384];
+            while (true)
+            {
+                {
+                    std::lock_guard lock(_mutex);
+                    if (_stopping) break;
+                }
+                pollfd pfd { .fd = fd, .events = POLLIN };
+                if (poll(&pfd, 1, 250) <= 0) continue;
+
+                bool changed = false;
+                for (ssize_t len; (len = read(fd, buffer, sizeof(buffer))) > 0;)
+                {
+                    for (char const * ptr = buffer; ptr < buffer + len;)
+                    {
+                        auto const & event = *reinterpret_cast<inotify_event const *>(ptr);
+                        ptr += sizeof(inotify_event) + event.len;
+
+                        if (event.mask & IN_Q_OVERFLOW)
+                        {
+                            // Directories created among the lost events are unwatched yet; watching a
+                            // directory again returns its existing descriptor
+                            watch(_root);
+                            _paths.clear();
+                            Scan(_root);
+                            changed = true;
+                            continue;
+                        }
+                        if (event.mask & IN_IGNORED)
+                        {
+                            dirs.erase(event.wd);
+                            continue;
+                        }
+                        auto const dir = dirs.find(event.wd);
+                        if (dir == dirs.end() || event.len == 0) continue;
+
+                        std::string const path  = dir->second + "/" + event.name;
+                        bool const        added = event.mask & (IN_CREATE | IN_CLOSE_WRITE | IN_MOVED_TO);
+                        if (event.mask & IN_ISDIR)
+                        {
+                            if (added)
+                            {
+                                watch(path);
+                                Scan(path);
+                            }
+                            else
+                            {
+                                // Everything under "path/", which sorts before "path0"
+                                _paths.erase(_paths.lower_bound(path + '/'), _paths.lower_bound(path + char('/' + 1)));
+                            }
+                            changed = true;
+                        }
+                        else if (IsClip(path))
+                        {
+                            if (added) _paths.insert(path);
+                            else _paths.erase(path);
+                            changed = true;
+                        }
+                    }
+                }
+                if (changed) Publish();
+            }
+            close(fd);
+            return;
+        }
+        spdlog::warn("ClipLibrary: inotify unavailable, falling back to periodic rescans.");
+#endif
+        // Full rescans, published only when the set of files actually changed
+        Scan(_root);
+        Publish();
+        while (true)
+        {
+            {
+                std::unique_lock lock(_mutex);
+                if (_wake.wait_for(lock, std::chrono::seconds(2), [this]() { return _stopping; })) return;
+            }
+            auto previous = std::move(_paths);
+            _paths.clear();
+            Scan(_root);
+            if (_paths != previous) Publish();
+        }
+    }
+
+    ClipFilter::ClipFilter()
+    {
+        _worker = std::thread([this]() { Work(); });
+    }
+
+    ClipFilter::~ClipFilter()
+    {
+        {
+            std::lock_guard lock(_mutex);
+            _stopping = true;
+        }
+        _wake.notify_all();
+        _worker.join();
+    }
+
+    void ClipFilter::Submit(std::shared_ptr<ClipList const> clips, std::string const & query, std::size_t const skip)
+    {
+        auto job = std::make_shared<Result const>(Result { .Clips = std::move(clips), .Query = query, .Skip = skip });
+        {
+            std::lock_guard lock(_mutex);
+            ++_generation;
+            // An empty query needs no matching, publish it right away
+            if (query.empty())
+            {
+                _result = std::move(job);
+                _pending.reset();
+            }
+            else _pending = std::move(job);
+            _busy = _pending != nullptr;
+        }
+        _wake.notify_one();
+    }
+
+    std::shared_ptr<ClipFilter::Result const> ClipFilter::GetResult() const
+    {
+        std::lock_guard lock(_mutex);
+        return _result;
+    }
+
+    bool ClipFilter::IsBusy() const
+    {
+        std::lock_guard lock(_mutex);
+        return _busy;
+    }
+
+    int ClipFilter::Score(std::string_view const text, std::string_view const query)
+    {
+        auto lower = [](char const c) { return char(std::tolower(static_cast<unsigned char>(c))); };
+        auto equal = [&](char const a, char const b) { return lower(a) == lower(b); };
+
+        if (query.empty()) return 0;
+        if (auto const iter = std::search(text.begin(), text.end(), query.begin(), query.end(), equal); iter != text.end())
+            return int(iter - text.begin());
+
+        // Greedy in-order match, scored by the span it covers
+        std::size_t first = std::string_view::npos, pos = 0;
+        for (char const c : query)
+        {
+            while (pos < text.size() && ! equal(text[pos], c)) ++pos;
+            if (pos == text.size()) return -1;
+            if (first == std::string_view::npos) first = pos;
+            ++pos;
+        }
+        return (1 << 16) + int(pos - first - query.size()) * 16 + int(first);
+    }
+
+    void ClipFilter::Work()
+    {
+        while (true)
+        {
+            std::shared_ptr<Result const> job;
+            std::uint64_t                 generation;
+            {
+                std::unique_lock lock(_mutex);
+                _wake.wait(lock, [this]() { return _stopping || _pending; });
+                if (_stopping) return;
+                job        = std::move(_pending);
+                generation = _generation;
+                _pending.reset();
+            }
+
+            std::vector<std::pair<int, std::uint32_t>> scored;
+            for (std::uint32_t i = 0; i < job->Clips->size(); ++i)
+            {
+                std::string_view text = (*job->Clips)[i];
+                text.remove_prefix(std::min(job->Skip, text.size()));
+                if (int const score = Score(text, job->Query); score >= 0) scored.emplace_back(score, i);
+            }
+            std::sort(scored.begin(), scored.end());
+
+            auto result = std::make_shared<Result>(Result { .Clips = job->Clips, .Query = job->Query, .Skip = job->Skip });
+            result->Indices.reserve(scored.size());
+            for (auto const & [score, i] : scored) result->Indices.push_back(i);
+
+            std::lock_guard lock(_mutex);
+            // Anything submitted meanwhile supersedes this result
+            if (generation == _generation) _result = std::move(result);
+            _busy = _pending != nullptr;
+        }
+    }
+}
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace VCX::Labs::FinalProject
+{
+    struct Clip;
+
+    using ClipList = std::vector<std::string>; // Sorted, forward-slashed paths
+
+    // Returns clip `index`, or nullptr to skip it. Called from several threads at once by the batch
+    // builders (motion database, similarity index, clip archive), which skip clips that throw.
+    using ClipSource = std::function<std::shared_ptr<Clip const>(std::size_t const index)>;
+
+    // One synchronous recursive scan, for tools that do not need to follow changes.
+    ClipList FindClips(std::string const & root);
+
+    // Parses `paths[index]` as BVH, throwing on malformed files as BVHLoader does.
+    ClipSource LoadClipFiles(ClipList const & paths);
+
+    // Recursively scans a directory for BVH files on a background thread and keeps the list up
+    // to date as files come and go (inotify on Linux, periodic rescans elsewhere).
+    class ClipLibrary
+    {
+    public:
+        explicit ClipLibrary(std::string const & root = "assets/BVH_data");
+        ~ClipLibrary();
+
+        ClipLibrary(ClipLibrary const &)             = delete;
+        ClipLibrary & operator=(ClipLibrary const &) = delete;
+
+        // Immutable snapshot, replaced (never modified) whenever the library changes.
+        std::shared_ptr<ClipList const> GetClips() const;
+        std::string const &             GetRoot() const { return _root; }
+        bool                            IsScanning() const;
+
+    private:
+        void Watch();
+        void Scan(std::string const & dir);
+        void Publish();
+
+        std::string                     _root;
+        mutable std::mutex              _mutex;
+        std::condition_variable         _wake;
+        std::set<std::string>           _paths;    // Watcher thread only
+        std::shared_ptr<ClipList const> _clips;
+        bool                            _scanning = true;
+        bool                            _stopping = false;
+        std::thread                     _watcher;
+    };
+
+    // Filters a clip list against a query on a background thread. Substring matches come first,
+    // ordered by position, then fuzzy (in-order subsequence) matches ordered by how spread out they are.
+    class ClipFilter
+    {
+    public:
+        struct Result
+        {
+            std::shared_ptr<ClipList const> Clips;
+            std::string                     Query;
+            std::size_t                     Skip = 0;
+            std::vector<std::uint32_t>      Indices; // Into Clips, unused when Query is empty
+        };
+
+        ClipFilter();
+        ~ClipFilter();
+
+        ClipFilter(ClipFilter const &)             = delete;
+        ClipFilter & operator=(ClipFilter const &) = delete;
+
+        // Only the latest submission is processed, older pending ones are dropped. The first
+        // `skip` characters of every path (the library root) are ignored when matching.
+        void                          Submit(std::shared_ptr<ClipList const> clips, std::string const & query, std::size_t const skip = 0);
+        std::shared_ptr<Result const> GetResult() const;
+        bool                          IsBusy() const;
+
+        // Lower is better, negative when `text` does not match.
+        static int Score(std::string_view const text, std::string_view const query);
+
+    private:
+        void Work();
+
+        mutable std::mutex              _mutex;
+        std::condition_variable         _wake;
+        std::shared_ptr<Result const>   _pending;
+        std::shared_ptr<Result const>   _result;
+        std::uint64_t                   _generation = 0;
+        bool                            _busy     = false;
+        bool                            _stopping = false;
+        std::thread                     _worker;
+    };
+}
@@ -0,0 +1,138 @@
+#include <algorithm>
+#include <cmath>
+#include <imgui.h>
+
+#include "Labs/FinalProject/ClipPicker.h"
+
+namespace VCX::Labs::FinalProject
+{
+    ClipPicker::ClipPicker(ClipLibrary & library, ClipIndexer & indexer, std::string const & selected) :
+        _library(library),
+        _indexer(indexer),
+        _selected(selected)
+    {}
+
+    bool ClipPicker::OnSetupPropsUI()
+    {
+        bool const edited = ImGui::InputTextWithHint("##clip_filter", "Filter (substring or fuzzy)", _query, IM_ARRAYSIZE(_query));
+        auto const clips  = _library.GetClips();
+        if (edited || clips != _submitted)
+        {
+            _filter.Submit(clips, _query, _library.GetRoot().size() + 1);
+            _submitted = clips;
+        }
+
+        auto const        result = _filter.GetResult();
+        std::size_t const count  = ! result ? 0 : result->Query.empty() ? result->Clips->size() : result->Indices.size();
+        auto clipAt = [&](std::size_t const row) -> std::string const & {
+            return (*result->Clips)[result->Query.empty() ? row : result->Indices[row]];
+        };
+
+        bool changed = false;
+        ImGui::BeginChild("##clip_list", { 0.f, 10.f * ImGui::GetTextLineHeightWithSpacing() }, true);
+        if (result)
+        {
+            ImGuiListClipper clipper;
+            clipper.Begin(int(count));
+            while (clipper.Step())
+            {
+                for (int row = clipper.DisplayStart; row < clipper.DisplayEnd; ++row)
+                {
+                    std::string const & file     = clipAt(row);
+                    bool const          selected = file == _selected;
+                    _indexer.Request(file);
+
+                    ImGui::PushID(row);
+                    if (ImGui::Selectable(file.c_str() + std::min(_library.GetRoot().size() + 1, file.size()), selected) && ! selected)
+                    {
+                        _selected = file;
+                        changed   = true;
+                    }
+                    ImGui::PopID();
+                    if (ImGui::IsItemHovered())
+                    {
+                        ImGui::BeginTooltip();
+                        ShowInfo(file, true);
+                        ImGui::EndTooltip();
+                    }
+                }
+            }
+            clipper.End();
+
+            // Bring the initial selection into view once the library is known
+            if (_scrollToSelected && ! _library.IsScanning())
+            {
+                for (std::size_t row = 0; row < count; ++row)
+                {
+                    if (clipAt(row) != _selected) continue;
+                    ImGui::SetScrollY(row * ImGui::GetTextLineHeightWithSpacing());
+                    break;
+                }
+                _scrollToSelected = false;
+            }
+        }
+        ImGui::EndChild();
+
+        if (_library.IsScanning()) ImGui::TextDisabled("Scanning %s...", _library.GetRoot().c_str());
+        else
+        {
+            ImGui::TextDisabled("%zu / %zu clips%s", count, clips->size(), _filter.IsBusy() ? " (filtering...)" : "");
+            if (std::size_t const pending = _indexer.GetPendingCount(); pending > 0)
+            {
+                ImGui::SameLine();
+                ImGui::TextDisabled("indexing %zu", pending);
+            }
+        }
+        if (! _selected.empty())
+        {
+            _indexer.Request(_selected);
+            ShowInfo(_selected, false);
+        }
+        return changed;
+    }
+
+    void ClipPicker::Select(std::string const & path)
+    {
+        if (path == _selected) return;
+        _selected         = path;
+        _scrollToSelected = true;
+    }
+
+    void ClipPicker::ShowInfo(std::string const & path, bool const animated)
+    {
+        auto const info = _indexer.Find(path);
+        if (! info)
+        {
+            ImGui::TextDisabled("Indexing...");
+            return;
+        }
+        if (info->Frames == 0)
+        {
+            ImGui::TextDisabled("Unreadable clip");
+            return;
+        }
+
+        if (auto const tex = _indexer.GetThumbnail(path))
+        {
+            auto const  id    = reinterpret_cast<void *>(std::uintptr_t(tex->Get()));
+            float const tiles = float(info->ThumbnailTiles);
+            float const size  = float(ClipIndexer::ThumbnailTileSize);
+            if (animated)
+            {
+                // Cycle through the tiles at the clip's own pace
+                float const u = std::floor(std::fmod(ImGui::GetTime() / info->Duration, 1.) * tiles) / tiles;
+                ImGui::Image(id, { 2.f * size, 2.f * size }, { u, 0.f }, { u + 1.f / tiles, 1.f });
+                ImGui::SameLine();
+            }
+            float const width = std::min(ImGui::GetContentRegionAvail().x, tiles * size);
+            if (! animated) ImGui::Image(id, { width, width / tiles });
+            else ImGui::Image(id, { tiles * size * .5f, size * .5f });
+        }
+        ImGui::Text("%u frames, %.2f s @ %.0f fps, %u joints", info->Frames, info->Duration, 1.f / info->FrameTime, info->JointCount);
+        ImGui::Text(
+            "Bounds %.2f x %.2f x %.2f",
+            info->BoundsMax.x - info->BoundsMin.x,
+            info->BoundsMax.y - info->BoundsMin.y,
+            info->BoundsMax.z - info->BoundsMin.z);
+    }
+}
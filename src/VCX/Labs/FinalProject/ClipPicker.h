@@ -0,0 +1,36 @@
+#pragma once
+
+#include <memory>
+#include <string>
+
+#include "Labs/FinalProject/ClipIndex.h"
+#include "Labs/FinalProject/ClipLibrary.h"
+
+namespace VCX::Labs::FinalProject
+{
+    // Filterable, virtualized list of the library's clips. Only visible rows are drawn and sent
+    // to the indexer, so the cost per frame does not depend on the library size.
+    class ClipPicker
+    {
+    public:
+        ClipPicker(ClipLibrary & library, ClipIndexer & indexer, std::string const & selected);
+
+        // Returns true when the user picked another clip.
+        bool OnSetupPropsUI();
+
+        std::string const & GetSelected() const { return _selected; }
+        // Marks a clip loaded elsewhere as the selected one and scrolls to it.
+        void                Select(std::string const & path);
+
+    private:
+        void ShowInfo(std::string const & path, bool const animated);
+
+        ClipLibrary &                   _library;
+        ClipIndexer &                   _indexer;
+        ClipFilter                      _filter;
+        std::shared_ptr<ClipList const> _submitted;   // Snapshot last handed to the filter
+        char                            _query[128] = "";
+        std::string                     _selected;
+        bool                            _scrollToSelected = true;
+    };
+}
@@ -0,0 +1,361 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <mutex>
+
+#if defined(__SSE2__) || defined(_M_X64)
+    #include <emmintrin.h>
+#endif
+
+#include <spdlog/spdlog.h>
+
+#include "Engine/ThreadPool.hpp"
+#include "Labs/FinalProject/ClipSimilarity.h"
+#include "Labs/FinalProject/Pose.h"
+
+namespace VCX::Labs::FinalProject
+{
+    static constexpr float c_Infinity = std::numeric_limits<float>::infinity();
+
+    // A compared window: whole sequences have Start 0.
+    struct SimilarityCandidate
+    {
+        float           Cost     = 0.f;     // Sum along the warping path
+        std::size_t     Sequence = 0;
+        std::uint32_t   Start    = 0;       // Feature frames
+
+        // Ties go to the earliest sequence and window, whatever order the threads finish in.
+        bool operator<(SimilarityCandidate const & other) const
+        {
+            if (Cost != other.Cost) return Cost < other.Cost;
+            if (Sequence != other.Sequence) return Sequence < other.Sequence;
+            return Start < other.Start;
+        }
+    };
+
+    // Squared distance of two feature rows, `dims` a multiple of 4.
+    static float Distance(float const * a, float const * b, std::uint32_t const dims)
+    {
+#if defined(__SSE2__) || defined(_M_X64)
+        __m128 sum = _mm_setzero_ps();
+        for (std::uint32_t d = 0; d < dims; d += 4)
+        {
+            __m128 const e = _mm_sub_ps(_mm_loadu_ps(a + d), _mm_loadu_ps(b + d));
+            sum            = _mm_add_ps(sum, _mm_mul_ps(e, e));
+        }
+        float sums[4];
+        _mm_storeu_ps(sums, sum);
+        return (sums[0] + sums[1]) + (sums[2] + sums[3]);
+#else
+        float sum = 0.f;
+        for (std::uint32_t d = 0; d < dims; ++d)
+        {
+            float const e = a[d] - b[d];
+            sum          += e * e;
+        }
+        return sum;
+#endif
+    }
+
+    // Squared distance of a feature row to the box [lo, hi], `dims` a multiple of 4.
+    static float BoxDistance(float const * row, float const * lo, float const * hi, std::uint32_t const dims)
+    {
+#if defined(__SSE2__) || defined(_M_X64)
+        __m128 sum = _mm_setzero_ps();
+        for (std::uint32_t d = 0; d < dims; d += 4)
+        {
+            __m128 const v = _mm_loadu_ps(row + d);
+            __m128 const e = _mm_add_ps(_mm_max_ps(_mm_sub_ps(v, _mm_loadu_ps(hi + d)), _mm_setzero_ps()), _mm_max_ps(_mm_sub_ps(_mm_loadu_ps(lo + d), v), _mm_setzero_ps()));
+            sum            = _mm_add_ps(sum, _mm_mul_ps(e, e));
+        }
+        float sums[4];
+        _mm_storeu_ps(sums, sum);
+        return (sums[0] + sums[1]) + (sums[2] + sums[3]);
+#else
+        float sum = 0.f;
+        for (std::uint32_t d = 0; d < dims; ++d)
+        {
+            float const e = std::max({ row[d] - hi[d], lo[d] - row[d], 0.f });
+            sum          += e * e;
+        }
+        return sum;
+#endif
+    }
+
+    // DTW cost of two sequences of `length` rows within a band of `radius`, candidate rows along
+    // the outer loop. Infinite once every path through a row, plus the lower bound `tail[j + 1]` of
+    // the rows left, reaches `bound`. `prev` and `cur` hold `length` costs each.
+    static float Warp(float const * candidate, float const * query, std::uint32_t const length, std::uint32_t const radius, std::uint32_t const dims, float const bound, float const * tail, float * prev, float * cur)
+    {
+        for (std::uint32_t j = 0; j < length; ++j)
+        {
+            std::uint32_t const lo     = j > radius ? j - radius : 0;
+            std::uint32_t const hi     = std::min(j + radius, length - 1);
+            float const *       row    = candidate + std::size_t(j) * dims;
+            float               rowMin = c_Infinity;
+            for (std::uint32_t q = lo; q <= hi; ++q)
+            {
+                float best = j == 0 && q == 0 ? 0.f : c_Infinity;
+                if (q > lo) best = std::min(best, cur[q - 1]);
+                if (j > 0)
+                {
+                    best = std::min(best, prev[q]);
+                    if (q > 0) best = std::min(best, prev[q - 1]);
+                }
+                cur[q] = best + Distance(row, query + std::size_t(q) * dims, dims);
+                rowMin = std::min(rowMin, cur[q]);
+            }
+            // The next row reads one column past this band
+            if (hi + 1 < length) cur[hi + 1] = c_Infinity;
+            if (rowMin + (tail ? tail[j + 1] : 0.f) >= bound) return c_Infinity;
+            std::swap(prev, cur);
+        }
+        return prev[length - 1];
+    }
+
+    std::shared_ptr<SimilarityIndex const> SimilarityIndex::Build(std::vector<std::string> const & names, ClipSource const & source, SimilaritySettings const & settings)
+    {
+        auto const start = std::chrono::steady_clock::now();
+        auto       index = std::make_shared<SimilarityIndex>();
+        index->_settings = settings;
+        index->_dims     = (3 * std::uint32_t(settings.Joints.size()) + 3 + 3) / 4 * 4;
+
+        std::vector<std::vector<float>> rows(names.size());
+        std::vector<Sequence>           sequences(names.size());
+        Engine::ThreadPool::Global().ParallelFor(names.size(), 1, [&](std::size_t const begin, std::size_t const end) {
+            for (std::size_t i = begin; i < end; ++i)
+            {
+                std::shared_ptr<Clip const> clip;
+                try
+                {
+                    clip = source(i);
+                }
+                catch (std::exception const & e)
+                {
+                    spdlog::warn("SimilarityIndex: cannot load \"{}\": {}", names[i], e.what());
+                }
+                if (! clip || clip->Frames == 0) continue;
+                if (! index->Featurize(*clip, 0, clip->Frames, rows[i]))
+                {
+                    spdlog::warn("SimilarityIndex: \"{}\" lacks a feature joint, skipped.", names[i]);
+                    continue;
+                }
+                sequences[i] = Sequence {
+                    .Name   = names[i],
+                    .Frames = clip->Frames,
+                    .Step   = std::max(1.f / (settings.SampleRate * clip->FrameTime), 1.f),
+                    .Length = std::uint32_t(rows[i].size() / index->_dims),
+                };
+            }
+        });
+
+        // Skipped clips leave no sequence
+        for (std::size_t i = 0; i < names.size(); ++i)
+        {
+            if (sequences[i].Length == 0) continue;
+            sequences[i].Offset = std::uint32_t(index->_features.size() / index->_dims);
+            index->_features.insert(index->_features.end(), rows[i].begin(), rows[i].end());
+            index->_sequences.push_back(std::move(sequences[i]));
+        }
+
+        double const seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        spdlog::info("SimilarityIndex: {} clips, {} feature frames in {:.2f} s.", index->_sequences.size(), index->_features.size() / index->_dims, seconds);
+        return index;
+    }
+
+    bool SimilarityIndex::Featurize(Clip const & clip, std::uint32_t const begin, std::uint32_t end, std::vector<float> & out) const
+    {
+        SkeletonDef const & def = *clip.Skeleton;
+        std::vector<int>    joints;
+        for (auto const & name : _settings.Joints)
+        {
+            joints.push_back(def.Find(name));
+            if (joints.back() < 0) return false;
+        }
+
+        out.clear();
+        end = std::min(end, clip.Frames);
+        if (begin >= end) return true;
+
+        // Source frames sampled at the feature rate, nearest frame, never faster than the clip
+        float const         step   = std::max(1.f / (_settings.SampleRate * clip.FrameTime), 1.f);
+        std::uint32_t const length = std::uint32_t(float(end - 1 - begin) / step) + 1;
+        std::uint32_t const count  = def.GetJointCount();
+        auto const          baked  = BakedClip::Bake(clip);
+        Pose                pose;
+        std::vector<glm::vec3> positions(count);
+        std::vector<glm::quat> rotations(count);
+        auto root = [&](std::uint32_t const frame) {
+            baked->SampleFrame(frame, pose);
+            ForwardKinematics(def, pose, positions.data(), rotations.data());
+            return positions[0];
+        };
+
+        out.assign(std::size_t(length) * _dims, 0.f);
+        for (std::uint32_t i = 0; i < length; ++i)
+        {
+            std::uint32_t const frame = std::min(begin + std::uint32_t(std::lround(i * step)), end - 1);
+
+            // Root velocity by central difference over the neighbouring source frames
+            std::uint32_t f0, f1;
+            GetDifferenceFrames(frame, 1, clip.Frames, f0, f1);
+            glm::vec3 const p0 = root(f0);
+            glm::vec3 const p1 = root(f1);
+
+            baked->SampleFrame(frame, pose);
+            ForwardKinematics(def, pose, positions.data(), rotations.data());
+            glm::vec3 origin;
+            glm::quat inverse;
+            GetGroundFrame(positions[0], rotations[0], origin, inverse);
+
+            float * row = out.data() + std::size_t(i) * _dims;
+            for (int const j : joints)
+            {
+                glm::vec3 const p = inverse * (positions[j] - origin);
+                *row++ = p.x, *row++ = p.y, *row++ = p.z;
+            }
+            glm::vec3 const v = f1 > f0 ? inverse * (p1 - p0) * (_settings.RootVelocityWeight / (float(f1 - f0) * clip.FrameTime)) : glm::vec3(0.f);
+            *row++ = v.x, *row++ = v.y, *row++ = v.z;
+        }
+        return true;
+    }
+
+    std::vector<SimilarityIndex::Match> SimilarityIndex::Search(float const * query, std::uint32_t const length, Query const & options, Stats * stats) const
+    {
+        auto const          start  = std::chrono::steady_clock::now();
+        std::uint32_t const dims   = _dims;
+        std::uint32_t const radius = std::min(std::uint32_t(std::lround(std::max(options.Band, 0.f) * length)), length ? length - 1 : 0);
+        std::uint32_t const hop    = std::max<std::uint32_t>(1, std::uint32_t(std::lround(options.Hop * length)));
+        if (length == 0 || options.K == 0) return { };
+
+        // Envelope of the query over the band, the box every row of a candidate is compared within
+        std::vector<float> upper(std::size_t(length) * dims), lower(std::size_t(length) * dims);
+        for (std::uint32_t j = 0; j < length; ++j)
+        {
+            std::uint32_t const lo = j > radius ? j - radius : 0;
+            std::uint32_t const hi = std::min(j + radius, length - 1);
+            for (std::uint32_t d = 0; d < dims; ++d)
+            {
+                float u = query[std::size_t(lo) * dims + d], l = u;
+                for (std::uint32_t q = lo + 1; q <= hi; ++q)
+                {
+                    u = std::max(u, query[std::size_t(q) * dims + d]);
+                    l = std::min(l, query[std::size_t(q) * dims + d]);
+                }
+                upper[std::size_t(j) * dims + d] = u;
+                lower[std::size_t(j) * dims + d] = l;
+            }
+        }
+
+        // Every window to compare; whole clips are resampled to the query length
+        std::vector<SimilarityCandidate> work;
+        for (std::size_t s = 0; s < _sequences.size(); ++s)
+        {
+            Sequence const & sequence = _sequences[s];
+            bool const       excluded = ! options.Exclude.empty() && sequence.Name == options.Exclude;
+            if (! options.Subsequence)
+            {
+                if (! excluded) work.push_back({ 0.f, s, 0 });
+                continue;
+            }
+            if (sequence.Length < length) continue;
+            // Every hop, and the last window so that the end of the clip is covered
+            std::uint32_t const last = sequence.Length - length;
+            for (std::uint32_t w = 0;; w = std::min(w + hop, last))
+            {
+                std::uint32_t const begin = std::uint32_t(std::lround(w * sequence.Step));
+                std::uint32_t const end   = std::min(sequence.Frames, std::uint32_t(std::lround((w + length - 1) * sequence.Step)) + 1);
+                if (! excluded || end <= options.ExcludeBegin || begin >= options.ExcludeEnd) work.push_back({ 0.f, s, w });
+                if (w == last) break;
+            }
+        }
+
+        // Overlapping subsequence matches are resolved at the end, best first. One match overlaps
+        // at most `overlaps` windows, so keeping that many per match is enough for an exact result,
+        // and the worst kept cost bounds the search.
+        std::size_t const                overlaps = options.Subsequence ? 2 * ((length + hop - 1) / hop) : 1;
+        std::size_t const                keep     = std::size_t(options.K) * overlaps;
+        std::mutex                       mutex;
+        std::vector<SimilarityCandidate> kept;
+        std::atomic<float>               threshold = c_Infinity;
+        Stats                            total;
+        Engine::ThreadPool::Global().ParallelFor(work.size(), 4, [&](std::size_t const begin, std::size_t const end) {
+            std::vector<float> resampled(options.Subsequence ? 0 : std::size_t(length) * dims);
+            std::vector<float> tail(length + 1, 0.f);
+            std::vector<float> prev(length), cur(length);
+            Stats              local;
+            for (std::size_t i = begin; i < end; ++i)
+            {
+                Sequence const & sequence  = _sequences[work[i].Sequence];
+                float const *    candidate = _features.data() + (std::size_t(sequence.Offset) + work[i].Start) * dims;
+                if (! options.Subsequence)
+                {
+                    for (std::uint32_t j = 0; j < length; ++j)
+                    {
+                        std::uint32_t const k = length > 1 ? std::uint32_t(std::lround(float(j) * (sequence.Length - 1) / (length - 1))) : 0;
+                        std::copy_n(candidate + std::size_t(k) * dims, dims, resampled.data() + std::size_t(j) * dims);
+                    }
+                    candidate = resampled.data();
+                }
+                ++local.Pairs;
+
+                // LB_Keogh, the distance of each row to the query envelope, also kept per row so
+                // that the warping can add the bound of the rows it has not reached yet
+                float const bound = options.Prune ? threshold.load(std::memory_order_relaxed) : c_Infinity;
+                if (options.Prune)
+                {
+                    float sum = 0.f;
+                    for (std::uint32_t j = length; j-- > 0 && sum < bound;)
+                    {
+                        sum    += BoxDistance(candidate + std::size_t(j) * dims, lower.data() + std::size_t(j) * dims, upper.data() + std::size_t(j) * dims, dims);
+                        tail[j] = sum;
+                    }
+                    if (sum >= bound)
+                    {
+                        ++local.Bounded;
+                        continue;
+                    }
+                }
+
+                float const cost = Warp(candidate, query, length, radius, dims, bound, options.Prune ? tail.data() : nullptr, prev.data(), cur.data());
+                if (cost == c_Infinity)
+                {
+                    ++local.Abandoned;
+                    continue;
+                }
+
+                std::lock_guard lock(mutex);
+                SimilarityCandidate const entry { cost, work[i].Sequence, work[i].Start };
+                if (kept.size() == keep && ! (entry < kept.back())) continue;
+                kept.insert(std::upper_bound(kept.begin(), kept.end(), entry), entry);
+                if (kept.size() > keep) kept.pop_back();
+                if (kept.size() == keep) threshold.store(kept.back().Cost, std::memory_order_relaxed);
+            }
+
+            std::lock_guard lock(mutex);
+            total.Pairs     += local.Pairs;
+            total.Bounded   += local.Bounded;
+            total.Abandoned += local.Abandoned;
+        });
+
+        std::vector<Match> matches;
+        for (auto const & entry : kept)
+        {
+            if (matches.size() == options.K) break;
+            Sequence const & sequence = _sequences[entry.Sequence];
+            Match const      match {
+                     .Sequence = entry.Sequence,
+                     .Begin    = options.Subsequence ? std::uint32_t(std::lround(entry.Start * sequence.Step)) : 0,
+                     .End      = options.Subsequence ? std::min(sequence.Frames, std::uint32_t(std::lround((entry.Start + length - 1) * sequence.Step)) + 1) : sequence.Frames,
+                     .Distance = std::sqrt(entry.Cost / length),
+            };
+            auto overlapping = [&](Match const & other) { return other.Sequence == match.Sequence && other.Begin < match.End && match.Begin < other.End; };
+            if (std::none_of(matches.begin(), matches.end(), overlapping)) matches.push_back(match);
+        }
+
+        total.Seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        if (stats) *stats = total;
+        return matches;
+    }
+}
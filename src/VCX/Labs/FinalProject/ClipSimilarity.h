@@ -0,0 +1,91 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "Labs/FinalProject/Clip.h"
+#include "Labs/FinalProject/ClipLibrary.h"
+
+namespace VCX::Labs::FinalProject
+{
+    // What a frame of a clip's feature sequence holds, in the root's ground frame like the motion
+    // matching features.
+    struct SimilaritySettings
+    {
+        std::vector<std::string>    Joints             { "Head", "LeftHand", "RightHand", "LeftFoot", "RightFoot" }; // Positions
+        float                       SampleRate         = 15.f;  // Feature frames per second
+        float                       RootVelocityWeight = .5f;   // Root velocity in scene units per second
+    };
+
+    // Feature sequences of a set of clips, compared to a query sequence by dynamic time warping
+    // within a Sakoe-Chiba band. Candidates are first bounded by LB_Keogh against the query's
+    // envelope and the warping is abandoned as soon as it cannot beat the k-th best match, so most
+    // of the library is rejected without a full DTW. Candidates are spread over the thread pool.
+    class SimilarityIndex
+    {
+    public:
+        // Frames [Offset, Offset + Length) of the feature array, sampled every Step source frames.
+        struct Sequence
+        {
+            std::string     Name;
+            std::uint32_t   Frames = 0;     // Of the source clip
+            float           Step   = 1.f;
+            std::uint32_t   Offset = 0;
+            std::uint32_t   Length = 0;
+        };
+
+        struct Match
+        {
+            std::size_t     Sequence = 0;
+            std::uint32_t   Begin    = 0;   // Source frames
+            std::uint32_t   End      = 0;
+            float           Distance = std::numeric_limits<float>::infinity(); // RMS feature distance along the warping path
+        };
+
+        struct Query
+        {
+            std::uint32_t   K             = 10;
+            float           Band          = .1f;    // Band radius as a fraction of the query length
+            bool            Subsequence   = false;  // Windows of the query length instead of whole clips resampled to it
+            float           Hop           = .25f;   // Subsequence windows start every Hop query lengths
+            bool            Prune         = true;   // Lower bounds and early abandoning, off for reference timings
+            std::string     Exclude;                // Sequence the query comes from: skipped for whole clips,
+            std::uint32_t   ExcludeBegin  = 0;      // only windows overlapping these source frames otherwise
+            std::uint32_t   ExcludeEnd    = 0;
+        };
+
+        struct Stats
+        {
+            std::size_t     Pairs     = 0;      // Candidates compared
+            std::size_t     Bounded   = 0;      // Rejected by LB_Keogh
+            std::size_t     Abandoned = 0;      // DTW stopped early
+            double          Seconds   = 0.;
+
+            double GetPairsPerSecond() const { return Seconds > 0. ? Pairs / Seconds : 0.; }
+        };
+
+        // Featurizes clips in parallel. Clips missing one of the joints are skipped.
+        static std::shared_ptr<SimilarityIndex const> Build(std::vector<std::string> const & names, ClipSource const & source, SimilaritySettings const & settings = { });
+
+        std::vector<Sequence> const & GetSequences() const { return _sequences; }
+        std::uint32_t                 GetDimensionCount() const { return _dims; }     // Padded to a multiple of 4
+        SimilaritySettings const &    GetSettings() const { return _settings; }
+
+        // Feature sequence of source frames [begin, end) of a clip, false if a joint is missing.
+        bool Featurize(Clip const & clip, std::uint32_t const begin, std::uint32_t const end, std::vector<float> & out) const;
+
+        // The K best matches to a feature sequence of `length` frames, best first. Subsequence
+        // matches of one clip never overlap.
+        std::vector<Match> Search(float const * query, std::uint32_t const length, Query const & options, Stats * stats = nullptr) const;
+
+    private:
+        SimilaritySettings      _settings;
+        std::uint32_t           _dims = 0;
+        std::vector<Sequence>   _sequences;
+        std::vector<float>      _features;  // _dims per frame
+    };
+}
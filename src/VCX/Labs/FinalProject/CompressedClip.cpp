@@ -0,0 +1,377 @@
+#include <algorithm>
+#include <cmath>
+#include <glm/gtc/quaternion.hpp>
+
+#include "Labs/FinalProject/CompressedClip.h"
+#include "Labs/FinalProject/Skeleton.h"
+
+namespace VCX::Labs::FinalProject
+{
+    static constexpr float         c_ComponentRange  = 0.70710678f; // The three smallest components are within +-1/sqrt(2)
+    static constexpr std::uint32_t c_MaxSparseFrames = 65536;       // Key frames are stored in 16 bits
+    static constexpr int           c_MaxRefinements  = 8;
+
+    static void EncodeRotation(glm::quat const & q, std::uint16_t * out)
+    {
+        float const c[4]    = { q.x, q.y, q.z, q.w };
+        int         largest = 0;
+        for (int i = 1; i < 4; ++i)
+            if (std::abs(c[i]) > std::abs(c[largest])) largest = i;
+
+        // q and -q are the same rotation, so the dropped component can always be positive
+        float const sign = c[largest] < 0.f ? -1.f : 1.f;
+        for (int i = 0, k = 0; i < 4; ++i)
+        {
+            if (i == largest) continue;
+            float const v = std::clamp(sign * c[i] / c_ComponentRange * .5f + .5f, 0.f, 1.f);
+            out[k++]      = std::uint16_t(std::lround(v * 32767.f));
+        }
+        out[0] |= std::uint16_t((largest & 1) << 15);
+        out[1] |= std::uint16_t((largest >> 1) << 15);
+    }
+
+    static glm::quat DecodeRotation(std::uint16_t const * in)
+    {
+        int const largest = (in[0] >> 15) | ((in[1] >> 15) << 1);
+        float     c[4];
+        float     sum = 0.f;
+        for (int i = 0, k = 0; i < 4; ++i)
+        {
+            if (i == largest) continue;
+            c[i] = (float(in[k++] & 0x7FFF) / 32767.f * 2.f - 1.f) * c_ComponentRange;
+            sum += c[i] * c[i];
+        }
+        c[largest] = std::sqrt(std::max(1.f - sum, 0.f));
+        return glm::quat(c[3], c[0], c[1], c[2]);
+    }
+
+    static glm::quat Nlerp(glm::quat const & a, glm::quat b, float const t)
+    {
+        if (glm::dot(a, b) < 0.f) b = -b;
+        return glm::normalize(a * (1.f - t) + b * t);
+    }
+
+    // Distance between the two rotations on the unit sphere of quaternions, 2 sin(angle / 4). Unlike
+    // the dot product, it keeps its precision for the tiny angles the tolerances come down to.
+    static float Chord(glm::quat const & a, glm::quat const & b)
+    {
+        return std::min(glm::length(a - b), glm::length(a + b));
+    }
+
+    // Greedy keyframe selection: from each key, the farthest next key such that interpolating
+    // between the two reproduces every frame in between, found by doubling and then bisection.
+    // The first and last frames are always keys.
+    template<typename Fits>
+    static std::vector<std::uint32_t> ReduceKeys(std::uint32_t const frames, Fits && fits)
+    {
+        std::vector<std::uint32_t> keys { 0 };
+        while (keys.back() + 1 < frames)
+        {
+            std::uint32_t const from = keys.back();
+            std::uint32_t       good = from + 1; // Neighbouring frames always fit
+            std::uint32_t       bad  = frames;
+            for (std::uint32_t step = 2; good < frames - 1; step *= 2)
+            {
+                std::uint32_t const to = std::min(from + step, frames - 1);
+                if (! fits(from, to))
+                {
+                    bad = to;
+                    break;
+                }
+                good = to;
+            }
+            while (bad < frames && bad - good > 1)
+            {
+                std::uint32_t const mid = good + (bad - good) / 2;
+                if (fits(from, mid)) good = mid;
+                else bad = mid;
+            }
+            keys.push_back(good);
+        }
+        return keys;
+    }
+
+    std::shared_ptr<CompressedClip> CompressedClip::Encode(BakedClip const & baked, std::vector<float> const & angleTolerance, float const translationTolerance)
+    {
+        auto                clip   = std::make_shared<CompressedClip>();
+        SkeletonDef const & def    = *baked.Skeleton;
+        std::uint32_t const joints = def.GetJointCount();
+        std::uint32_t const frames = baked.Frames;
+        clip->_skeleton            = baked.Skeleton;
+        clip->_frames              = frames;
+        clip->_frameTime           = baked.FrameTime;
+        clip->_rotationTracks.resize(joints);
+        clip->_offsetTracks.resize(joints);
+
+        // Keys of a track: a single one when every frame is within tolerance of the first, all
+        // frames for clips too long for 16-bit key frames, the reduced set otherwise
+        auto select = [frames](Track & track, std::uint32_t const keys, std::vector<std::uint16_t> & keyFrames, auto && constant, auto && fits) {
+            std::vector<std::uint32_t> selected;
+            if (constant()) selected = { 0 };
+            else if (frames > c_MaxSparseFrames)
+            {
+                selected.resize(frames);
+                for (std::uint32_t f = 0; f < frames; ++f) selected[f] = f;
+            }
+            else selected = ReduceKeys(frames, fits);
+
+            track.Keys  = keys;
+            track.Count = std::uint32_t(selected.size());
+            if (track.Count != frames && track.Count > 1)
+            {
+                track.Frames = std::uint32_t(keyFrames.size());
+                for (std::uint32_t const f : selected) keyFrames.push_back(std::uint16_t(f));
+            }
+            return selected;
+        };
+
+        std::vector<glm::quat>     rotations(frames);
+        std::vector<glm::vec3>     offsets(frames);
+        std::vector<std::uint16_t> encoded(std::size_t(frames) * 3);
+        for (std::uint32_t j = 0; j < joints; ++j)
+        {
+            if (def.Channels[j] == 0) continue;
+
+            // Rotations, compared after quantization so the tolerance covers both errors
+            float const chord = 2.f * std::sin(std::min(angleTolerance[j], glm::pi<float>()) * .25f);
+            for (std::uint32_t f = 0; f < frames; ++f)
+            {
+                EncodeRotation(baked.Rotations[std::size_t(f) * joints + j], &encoded[std::size_t(f) * 3]);
+                rotations[f] = DecodeRotation(&encoded[std::size_t(f) * 3]);
+            }
+            auto original = [&](std::uint32_t const f) { return baked.Rotations[std::size_t(f) * joints + j]; };
+            auto constant = [&]() {
+                for (std::uint32_t f = 0; f < frames; ++f)
+                    if (Chord(rotations[0], original(f)) > chord) return false;
+                return true;
+            };
+            auto fits = [&](std::uint32_t const a, std::uint32_t const b) {
+                for (std::uint32_t f = a + 1; f < b; ++f)
+                    if (Chord(Nlerp(rotations[a], rotations[b], float(f - a) / float(b - a)), original(f)) > chord) return false;
+                return true;
+            };
+            for (std::uint32_t const f : select(clip->_rotationTracks[j], std::uint32_t(clip->_rotations.size() / 3), clip->_keyFrames, constant, fits))
+                clip->_rotations.insert(clip->_rotations.end(), &encoded[std::size_t(f) * 3], &encoded[std::size_t(f) * 3] + 3);
+
+            if (def.Channels[j] != 6) continue;
+
+            // Translations, quantized within the track's range
+            RangeTrack & track = clip->_offsetTracks[j];
+            glm::vec3    lo    = baked.Offsets[j];
+            glm::vec3    hi    = lo;
+            for (std::uint32_t f = 0; f < frames; ++f)
+            {
+                lo = glm::min(lo, baked.Offsets[std::size_t(f) * joints + j]);
+                hi = glm::max(hi, baked.Offsets[std::size_t(f) * joints + j]);
+            }
+            track.Min    = lo;
+            track.Extent = hi - lo;
+            for (std::uint32_t f = 0; f < frames; ++f)
+            {
+                glm::vec3 const value = baked.Offsets[std::size_t(f) * joints + j];
+                for (int k = 0; k < 3; ++k)
+                {
+                    float const v                       = track.Extent[k] > 0.f ? (value[k] - lo[k]) / track.Extent[k] : 0.f;
+                    encoded[std::size_t(f) * 3 + k]     = std::uint16_t(std::lround(std::clamp(v, 0.f, 1.f) * 65535.f));
+                    offsets[f][k]                       = lo[k] + track.Extent[k] * (encoded[std::size_t(f) * 3 + k] / 65535.f);
+                }
+            }
+            auto originalOffset = [&](std::uint32_t const f) { return baked.Offsets[std::size_t(f) * joints + j]; };
+            auto constantOffset = [&]() {
+                for (std::uint32_t f = 0; f < frames; ++f)
+                    if (glm::length(offsets[0] - originalOffset(f)) > translationTolerance) return false;
+                return true;
+            };
+            auto fitsOffset = [&](std::uint32_t const a, std::uint32_t const b) {
+                for (std::uint32_t f = a + 1; f < b; ++f)
+                    if (glm::length(glm::mix(offsets[a], offsets[b], float(f - a) / float(b - a)) - originalOffset(f)) > translationTolerance) return false;
+                return true;
+            };
+            for (std::uint32_t const f : select(track, std::uint32_t(clip->_offsets.size() / 3), clip->_keyFrames, constantOffset, fitsOffset))
+                clip->_offsets.insert(clip->_offsets.end(), &encoded[std::size_t(f) * 3], &encoded[std::size_t(f) * 3] + 3);
+        }
+        clip->_keyCount = (clip->_rotations.size() + clip->_offsets.size()) / 3;
+        return clip;
+    }
+
+    std::shared_ptr<CompressedClip const> CompressedClip::Compress(Clip const & clip, float const tolerance)
+    {
+        if (clip.Frames == 0) return nullptr;
+
+        auto const          baked  = BakedClip::Bake(clip);
+        SkeletonDef const & def    = *clip.Skeleton;
+        std::uint32_t const joints = def.GetJointCount();
+
+        // A rotation error of a radians moves the joints below by up to a times their distance.
+        // Children follow their parents, so walking backwards finds each joint's farthest reach.
+        std::vector<float> reach(joints, 0.f);
+        for (std::uint32_t j = joints; j-- > 1;)
+            if (def.Parents[j] >= 0) reach[def.Parents[j]] = std::max(reach[def.Parents[j]], reach[j] + SceneScale * glm::length(def.Offsets[j]));
+
+        // Errors of a chain add up, so the budgets start at half and halve until the whole
+        // skeleton is within tolerance
+        std::vector<float>              angles(joints);
+        std::shared_ptr<CompressedClip> best;
+        float                           error  = 0.f;
+        float                           budget = .5f;
+        for (int i = 0; i < c_MaxRefinements; ++i, budget *= .5f)
+        {
+            for (std::uint32_t j = 0; j < joints; ++j)
+                angles[j] = reach[j] > 0.f ? budget * tolerance / reach[j] : glm::pi<float>();
+            best  = Encode(*baked, angles, budget * tolerance / SceneScale);
+            error = MeasureCompression(clip, *best).MaxError;
+            if (error <= tolerance) break;
+        }
+        if (error > tolerance)
+        {
+            // Still over: every frame that moves a joint becomes a key, only the quantization is left
+            for (std::uint32_t j = 0; j < joints; ++j) angles[j] = reach[j] > 0.f ? 0.f : glm::pi<float>();
+            best  = Encode(*baked, angles, 0.f);
+            error = MeasureCompression(clip, *best).MaxError;
+        }
+        best->_error = error;
+        return best;
+    }
+
+    std::size_t CompressedClip::GetByteSize() const
+    {
+        return sizeof(*this)
+            + _rotationTracks.size() * sizeof(Track)
+            + _offsetTracks.size() * sizeof(RangeTrack)
+            + (_keyFrames.size() + _rotations.size() + _offsets.size()) * sizeof(std::uint16_t);
+    }
+
+    void CompressedClip::FindKeys(Track const & track, float const position, std::uint32_t & k0, std::uint32_t & k1, float & t) const
+    {
+        if (track.Count == _frames)
+        {
+            std::uint32_t const f0 = std::min(std::uint32_t(position), track.Count - 1);
+            std::uint32_t const f1 = std::min(f0 + 1, track.Count - 1);
+            k0                     = track.Keys + f0;
+            k1                     = track.Keys + f1;
+            t                      = f1 > f0 ? position - float(f0) : 0.f;
+            return;
+        }
+        if (track.Count == 1)
+        {
+            k0 = k1 = track.Keys;
+            t       = 0.f;
+            return;
+        }
+
+        // Last key at or before the position, by bisection over this track's key frames only
+        std::uint16_t const * first = _keyFrames.data() + track.Frames;
+        std::uint16_t const * last  = first + track.Count;
+        std::uint32_t const   i0    = std::uint32_t(std::max<std::ptrdiff_t>(std::upper_bound(first, last, position, [](float const p, std::uint16_t const f) { return p < float(f); }) - first, 1) - 1);
+        std::uint32_t const   i1    = std::min(i0 + 1, track.Count - 1);
+        k0                          = track.Keys + i0;
+        k1                          = track.Keys + i1;
+        t                           = i1 > i0 ? std::clamp((position - float(first[i0])) / float(first[i1] - first[i0]), 0.f, 1.f) : 0.f;
+    }
+
+    glm::quat CompressedClip::GetRotation(std::uint32_t const joint, float const position) const
+    {
+        Track const & track = _rotationTracks[joint];
+        if (track.Count == 0) return { 1.f, 0.f, 0.f, 0.f };
+
+        std::uint32_t k0, k1;
+        float         t;
+        FindKeys(track, position, k0, k1, t);
+        glm::quat const q0 = DecodeRotation(&_rotations[std::size_t(k0) * 3]);
+        return t > 0.f ? Nlerp(q0, DecodeRotation(&_rotations[std::size_t(k1) * 3]), t) : q0;
+    }
+
+    glm::vec3 CompressedClip::GetOffset(std::uint32_t const joint, float const position) const
+    {
+        RangeTrack const & track = _offsetTracks[joint];
+        if (track.Count == 0) return _skeleton->Offsets[joint];
+
+        std::uint32_t k0, k1;
+        float         t;
+        FindKeys(track, position, k0, k1, t);
+        auto decode = [&](std::uint32_t const k) {
+            glm::vec3 const v(_offsets[std::size_t(k) * 3], _offsets[std::size_t(k) * 3 + 1], _offsets[std::size_t(k) * 3 + 2]);
+            return track.Min + track.Extent * (v / 65535.f);
+        };
+        return glm::mix(decode(k0), decode(k1), t);
+    }
+
+    void CompressedClip::SampleFrame(std::uint32_t const frame, Pose & out) const
+    {
+        std::uint32_t const joints   = _skeleton->GetJointCount();
+        float const         position = float(std::min(frame, _frames - 1));
+        out.Resize(joints);
+        for (std::uint32_t j = 0; j < joints; ++j)
+        {
+            out.Rotations[j] = GetRotation(j, position);
+            out.Offsets[j]   = GetOffset(j, position);
+        }
+    }
+
+    void CompressedClip::Sample(float const time, bool const loop, Pose & out) const
+    {
+        std::uint32_t const joints = _skeleton->GetJointCount();
+        out.Resize(joints);
+        if (_frames == 0) return;
+
+        float       pos = std::max(time, 0.f) / _frameTime;
+        float const end = float(_frames - 1);
+        if (loop && _frames > 1) pos = std::fmod(pos, float(_frames));
+        else pos = std::min(pos, end);
+
+        // Past the last frame of a loop, blend back into the first
+        float const wrap = pos > end ? pos - end : 0.f;
+        for (std::uint32_t j = 0; j < joints; ++j)
+        {
+            out.Rotations[j] = GetRotation(j, std::min(pos, end));
+            out.Offsets[j]   = GetOffset(j, std::min(pos, end));
+            if (wrap == 0.f) continue;
+            out.Rotations[j] = Nlerp(out.Rotations[j], GetRotation(j, 0.f), wrap);
+            out.Offsets[j]   = glm::mix(out.Offsets[j], GetOffset(j, 0.f), wrap);
+        }
+    }
+
+    CompressionReport MeasureCompression(Clip const & clip, CompressedClip const & compressed)
+    {
+        SkeletonDef const & def    = *clip.Skeleton;
+        std::uint32_t const joints = def.GetJointCount();
+        CompressionReport   report {
+              .RawBytes        = std::size_t(clip.Frames) * def.ChannelCount * sizeof(float),
+              .CompressedBytes = compressed.GetByteSize(),
+              .Keys            = compressed.GetKeyCount(),
+        };
+
+        Skeleton               skeleton;
+        Pose                   pose;
+        std::vector<glm::vec3> reference(joints);
+        double                 total = 0.;
+        skeleton.Build(clip.Skeleton);
+        for (std::uint32_t f = 0; f < clip.Frames; ++f)
+        {
+            float const * row = clip.GetFrame(f);
+            for (std::uint32_t j = 0; j < joints; ++j)
+            {
+                skeleton.Joints[j]->LocalRotation = def.GetLocalRotation(j, row);
+                skeleton.Joints[j]->LocalOffset   = def.GetLocalOffset(j, row);
+            }
+            skeleton.ForwardKinematics();
+            for (std::uint32_t j = 0; j < joints; ++j) reference[j] = skeleton.Joints[j]->GlobalPosition;
+
+            compressed.SampleFrame(f, pose);
+            for (std::uint32_t j = 0; j < joints; ++j)
+            {
+                skeleton.Joints[j]->LocalRotation = pose.Rotations[j];
+                skeleton.Joints[j]->LocalOffset   = pose.Offsets[j];
+            }
+            skeleton.ForwardKinematics();
+            for (std::uint32_t j = 0; j < joints; ++j)
+            {
+                float const error = glm::length(skeleton.Joints[j]->GlobalPosition - reference[j]);
+                report.MaxError   = std::max(report.MaxError, error);
+                total            += error;
+            }
+        }
+        report.MeanError = clip.Frames ? float(total / (double(clip.Frames) * joints)) : 0.f;
+        return report;
+    }
+}
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "Labs/FinalProject/Clip.h"
+#include "Labs/FinalProject/Pose.h"
+
+namespace VCX::Labs::FinalProject
+{
+    // Clip motion in a fraction of the memory: rotations are smallest-three quaternions in 48 bits,
+    // translations are quantized to 16 bits per axis within each track's range, and every track
+    // keeps only the keyframes needed to stay within a positional tolerance, interpolating linearly
+    // (nlerp for rotations) in between. A frame is decoded track by track from its two surrounding
+    // keys, without decoding anything else.
+    class CompressedClip
+    {
+    public:
+        // `tolerance` bounds the error of every joint position in scene units, as computed by
+        // Skeleton::ForwardKinematics. The per-track budgets are tightened until the measured error
+        // over all frames is within it; failing that, every frame is kept as a key and only the
+        // quantization error remains, which GetError reports. nullptr for clips without frames.
+        static std::shared_ptr<CompressedClip const> Compress(Clip const & clip, float const tolerance);
+
+        std::shared_ptr<SkeletonDef const> const & GetSkeleton() const { return _skeleton; }
+        std::uint32_t                              GetFrameCount() const { return _frames; }
+        float                                      GetFrameTime() const { return _frameTime; }
+        float                                      GetDuration() const { return _frames * _frameTime; }
+        std::size_t                                GetKeyCount() const { return _keyCount; }
+        float                                      GetError() const { return _error; }  // Max joint position error, measured by Compress
+        std::size_t                                GetByteSize() const;
+
+        void SampleFrame(std::uint32_t const frame, Pose & out) const;
+        // Between frames the tracks are evaluated at the fractional frame, wrapping or clamping at the end.
+        void Sample(float const time, bool const loop, Pose & out) const;
+
+    private:
+        struct Track
+        {
+            std::uint32_t   Keys   = 0;     // First key in the value array, in keys
+            std::uint32_t   Frames = 0;     // First key frame in _keyFrames, unused for dense tracks
+            std::uint32_t   Count  = 0;     // 0 for joints without the channel; equal to the frame count when dense
+        };
+
+        struct RangeTrack : Track
+        {
+            glm::vec3       Min    = { 0.f, 0.f, 0.f };
+            glm::vec3       Extent = { 0.f, 0.f, 0.f };
+        };
+
+        static std::shared_ptr<CompressedClip> Encode(BakedClip const & baked, std::vector<float> const & angleTolerance, float const translationTolerance);
+
+        // Surrounding keys of a fractional frame and the weight of the second one.
+        void      FindKeys(Track const & track, float const position, std::uint32_t & k0, std::uint32_t & k1, float & t) const;
+        glm::quat GetRotation(std::uint32_t const joint, float const position) const;
+        glm::vec3 GetOffset(std::uint32_t const joint, float const position) const;
+
+        std::shared_ptr<SkeletonDef const>  _skeleton;
+        std::uint32_t                       _frames    = 0;
+        float                               _frameTime = 0.f;
+        std::size_t                         _keyCount  = 0;
+        float                               _error     = 0.f;
+        std::vector<Track>                  _rotationTracks;    // One per joint
+        std::vector<RangeTrack>             _offsetTracks;      // One per joint, only 6-channel joints have keys
+        std::vector<std::uint16_t>          _keyFrames;         // Frame of each key of the sparse tracks
+        std::vector<std::uint16_t>          _rotations;         // Three per key, the largest component's index in the top bits
+        std::vector<std::uint16_t>          _offsets;           // Three per key, within the track range
+    };
+
+    struct CompressionReport
+    {
+        std::size_t     RawBytes        = 0;    // Frames x channels x 4, as decoded
+        std::size_t     CompressedBytes = 0;
+        std::size_t     Keys            = 0;
+        float           MaxError        = 0.f;  // Joint positions through Skeleton::ForwardKinematics, scene units
+        float           MeanError       = 0.f;
+
+        float GetRatio() const { return CompressedBytes ? float(RawBytes) / CompressedBytes : 0.f; }
+    };
+
+    // Compares every frame of the compressed clip with the original through the tree FK.
+    CompressionReport MeasureCompression(Clip const & clip, CompressedClip const & compressed);
+}
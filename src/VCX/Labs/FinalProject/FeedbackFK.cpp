@@ -0,0 +1,101 @@
+#include <algorithm>
+
+#include "Labs/FinalProject/FeedbackFK.h"
+
+namespace VCX::Labs::FinalProject
+{
+    // u_Source shares unit 0 with the output, as both are pose buffers; instances bring their own
+    static constexpr std::uint32_t c_TracksUnit    = 2;
+    static constexpr std::uint32_t c_HierarchyUnit = 3;
+
+    FeedbackFK::FeedbackFK() :
+        _program(
+            Engine::GL::UniqueProgram(
+                { Engine::GL::SharedShader("assets/shaders/fk.vert") },
+                { "o_Position", "o_Rotation" })),
+        _tracks(GL_RGBA32F, c_TracksUnit),
+        _hierarchy(GL_RG32I, c_HierarchyUnit)
+    {
+        auto & uniforms = _program.GetUniforms();
+        uniforms.SetByName("u_Source", 0);
+        uniforms.SetByName("u_Tracks", int(c_TracksUnit));
+        uniforms.SetByName("u_Hierarchy", int(c_HierarchyUnit));
+        uniforms.SetByName("u_Scale", SceneScale);
+        uniforms.SetByName("u_Offset", SceneOffset);
+    }
+
+    void FeedbackFK::Build(std::vector<std::shared_ptr<BakedClip const>> const & clips, bool const inPlace)
+    {
+        _ranges.clear();
+        _joints = clips.empty() ? 0 : clips.front()->Skeleton->GetJointCount();
+        _levels = 0;
+        if (_joints == 0) return;
+
+        // Depth of each joint, parents come first
+        SkeletonDef const &     def = *clips.front()->Skeleton;
+        std::vector<glm::ivec2> hierarchy(_joints);
+        for (std::uint32_t j = 0; j < _joints; ++j)
+        {
+            int const parent = def.Parents[j];
+            hierarchy[j]     = { parent, parent < 0 ? 0 : hierarchy[parent].y + 1 };
+            _levels          = std::max(_levels, std::uint32_t(hierarchy[j].y) + 1);
+        }
+        _hierarchy.Update(Engine::make_span_bytes<glm::ivec2>(hierarchy));
+
+        PoseBuffer::FrameList frames;
+        _ranges = PoseBuffer::LayOut(clips, frames);
+
+        std::vector<glm::vec4> texels(frames.size() * _joints * PoseBuffer::TexelsPerJoint);
+        for (std::size_t i = 0; i < frames.size(); ++i)
+        {
+            BakedClip const & clip = *clips[frames[i].first];
+            std::size_t const row  = std::size_t(frames[i].second) * _joints;
+            glm::vec4 *       out  = texels.data() + i * _joints * PoseBuffer::TexelsPerJoint;
+            for (std::uint32_t j = 0; j < _joints; ++j)
+            {
+                glm::vec3         offset   = clip.Offsets[row + j];
+                glm::quat const & rotation = clip.Rotations[row + j];
+                if (inPlace && j == 0) offset.x = offset.z = 0.f;
+                out[PoseBuffer::TexelsPerJoint * j]     = glm::vec4(offset, 0.f);
+                out[PoseBuffer::TexelsPerJoint * j + 1] = glm::vec4(rotation.x, rotation.y, rotation.z, rotation.w);
+            }
+        }
+        _tracks.Update(Engine::make_span_bytes<glm::vec4>(texels));
+        _program.GetUniforms().SetByName("u_Joints", int(_joints));
+    }
+
+    void FeedbackFK::Evaluate(Engine::GL::UniqueTextureBuffer const & instances, std::uint32_t const count, float const time)
+    {
+        if (IsEmpty() || count == 0) return;
+
+        std::size_t const vertices = std::size_t(count) * _joints;
+        std::size_t const bytes    = vertices * PoseBuffer::TexelsPerJoint * sizeof(glm::vec4);
+        if (_poses[0].GetByteSize() < bytes)
+            for (auto & poses : _poses) poses.Allocate(bytes);
+
+        auto & uniforms = _program.GetUniforms();
+        uniforms.SetByName("u_Instances", int(instances.GetUnit()));
+        uniforms.SetByName("u_Time", time);
+
+        auto const useVao       { _vao.Use() };
+        auto const useTracks    { _tracks.Use() };
+        auto const useHierarchy { _hierarchy.Use() };
+        auto const useInstances { instances.Use() };
+        Engine::GL::State::Enable(GL_RASTERIZER_DISCARD);
+        for (std::uint32_t level = 0; level < _levels; ++level)
+        {
+            // Level l is captured into buffer l % 2 and reads the other one
+            _result = level % 2;
+            uniforms.SetByName("u_Level", int(level));
+            auto const useProgram { _program.Use() };
+            auto const useSource  { _poses[1 - _result].Use() };
+            glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, _poses[_result].GetBuffer());
+            glBeginTransformFeedback(GL_POINTS);
+            Engine::GL::State::CountDraw();
+            glDrawArrays(GL_POINTS, 0, GLsizei(vertices));
+            glEndTransformFeedback();
+        }
+        glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, 0);
+        Engine::GL::State::Disable(GL_RASTERIZER_DISCARD);
+    }
+}
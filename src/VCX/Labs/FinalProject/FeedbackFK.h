@@ -0,0 +1,53 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "Engine/GL/Program.h"
+#include "Engine/GL/TextureBuffer.hpp"
+#include "Labs/FinalProject/PoseBuffer.h"
+
+namespace VCX::Labs::FinalProject
+{
+    // Forward kinematics of many characters on the GPU. GL 4.1 has no compute shaders, so each
+    // level of the hierarchy is one vertex pass with the rasterizer off, capturing the globals of
+    // every (character, joint) with transform feedback. Two pose buffers alternate as source and
+    // target, since a buffer may not be sampled while it is captured into.
+    //
+    // The output has the layout of one PoseBuffer frame per character, in place (without the
+    // placement), so the skeleton shaders read it the same way.
+    class FeedbackFK
+    {
+    public:
+        FeedbackFK();
+
+        // Uploads the local tracks of the clips, which share one topology, with the frame ranges
+        // of PoseBuffer::LayOut. With `inPlace` the roots stay above the origin.
+        void Build(std::vector<std::shared_ptr<BakedClip const>> const & clips, bool const inPlace);
+
+        // Poses `count` characters at `time` from an instance table of two texels each, (placement,
+        // phase) and (first frame, frames, frame time, 0), on any unit but those of FeedbackFK.
+        void Evaluate(Engine::GL::UniqueTextureBuffer const & instances, std::uint32_t const count, float const time);
+
+        bool                                    IsEmpty() const { return _ranges.empty(); }
+        std::vector<PoseBuffer::Range> const &  GetRanges() const { return _ranges; }
+        std::uint32_t                           GetJointCount() const { return _joints; }
+        std::uint32_t                           GetLevelCount() const { return _levels; }
+
+        // On unit 0, like PoseBuffer; valid after Evaluate.
+        Engine::GL::UniqueTextureBuffer const & GetPoses() const { return _poses[_result]; }
+
+    private:
+        Engine::GL::UniqueProgram                       _program;
+        Engine::GL::UniqueVertexArray                   _vao;       // No attributes, the shader works from gl_VertexID
+        Engine::GL::UniqueTextureBuffer                 _tracks;
+        Engine::GL::UniqueTextureBuffer                 _hierarchy;
+        std::array<Engine::GL::UniqueTextureBuffer, 2>  _poses;
+        std::uint32_t                                   _result = 0;
+        std::vector<PoseBuffer::Range>                  _ranges;
+        std::uint32_t                                   _joints = 0;
+        std::uint32_t                                   _levels = 0;
+    };
+}
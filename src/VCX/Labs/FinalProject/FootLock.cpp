@@ -0,0 +1,218 @@
+#include <algorithm>
+#include <cmath>
+#include <glm/gtx/quaternion.hpp>
+
+#include "Engine/ThreadPool.hpp"
+#include "Labs/FinalProject/FootLock.h"
+
+namespace VCX::Labs::FinalProject
+{
+    // Hip, knee and ankle names per side, CMU first
+    static constexpr char const * c_LegNames[2][3][2] = {
+        { { "LeftUpLeg", "thigh_l" }, { "LeftLeg", "calf_l" }, { "LeftFoot", "foot_l" } },
+        { { "RightUpLeg", "thigh_r" }, { "RightLeg", "calf_r" }, { "RightFoot", "foot_r" } },
+    };
+
+    static constexpr float c_FloorPercentile = .02f;
+
+    static std::uint32_t SubtreeEnd(SkeletonDef const & def, int const joint)
+    {
+        std::uint32_t end = std::uint32_t(joint) + 1;
+        while (end < def.GetJointCount() && def.Parents[end] >= joint) ++end;
+        return end;
+    }
+
+    LegRig LegRig::Find(SkeletonDef const & def)
+    {
+        LegRig rig;
+        for (int side = 0; side < 2; ++side)
+        {
+            int joints[3];
+            for (int k = 0; k < 3; ++k)
+            {
+                joints[k] = def.Find(c_LegNames[side][k][0]);
+                if (joints[k] < 0) joints[k] = def.Find(c_LegNames[side][k][1]);
+            }
+            if (joints[0] < 0 || joints[1] < 0 || joints[2] < 0 || def.Parents[joints[1]] != joints[0] || def.Parents[joints[2]] != joints[1]) return { };
+
+            Leg & leg     = rig.Legs[side];
+            leg.Hip       = joints[0];
+            leg.Knee      = joints[1];
+            leg.Ankle     = joints[2];
+            leg.HipEnd    = SubtreeEnd(def, leg.Hip);
+            leg.KneeEnd   = SubtreeEnd(def, leg.Knee);
+            leg.AnkleEnd  = SubtreeEnd(def, leg.Ankle);
+            leg.Length    = SceneScale * (glm::length(def.Offsets[leg.Knee]) + glm::length(def.Offsets[leg.Ankle]));
+        }
+        return rig;
+    }
+
+    // Keeps runs of `value` of at least `minRun` frames, the shorter ones take the other value.
+    static void DropShortRuns(std::vector<std::uint8_t> & flags, std::uint8_t const bit, bool const value, std::uint32_t const minRun)
+    {
+        std::size_t const n = flags.size();
+        for (std::size_t begin = 0; begin < n;)
+        {
+            std::size_t end = begin;
+            while (end < n && bool(flags[end] & bit) == bool(flags[begin] & bit)) ++end;
+            // Runs touching the ends of the clip may continue past them, they are kept
+            if (bool(flags[begin] & bit) == value && end - begin < minRun && begin > 0 && end < n)
+                for (std::size_t f = begin; f < end; ++f) flags[f] ^= bit;
+            begin = end;
+        }
+    }
+
+    FootContacts FootContacts::Detect(BakedClip const & clip, LegRig const & legs, FootLockSettings const & settings)
+    {
+        FootContacts result;
+        result.FrameTime = clip.FrameTime;
+        if (! legs.IsValid() || clip.Frames == 0) return result;
+
+        // Ankle positions as flat per-frame arrays, one per axis and foot
+        std::uint32_t const n = clip.Frames;
+        std::vector<float>  xs[2], ys[2], zs[2];
+        for (int side = 0; side < 2; ++side) xs[side].resize(n), ys[side].resize(n), zs[side].resize(n);
+        Engine::ThreadPool::Global().ParallelFor(n, 64, [&](std::size_t const begin, std::size_t const end) {
+            Pose                   pose;
+            std::vector<glm::vec3> positions(clip.Skeleton->GetJointCount());
+            std::vector<glm::quat> rotations(clip.Skeleton->GetJointCount());
+            for (std::size_t f = begin; f < end; ++f)
+            {
+                clip.SampleFrame(std::uint32_t(f), pose);
+                ForwardKinematics(*clip.Skeleton, pose, positions.data(), rotations.data());
+                for (int side = 0; side < 2; ++side)
+                {
+                    glm::vec3 const & p = positions[legs.Legs[side].Ankle];
+                    xs[side][f] = p.x, ys[side][f] = p.y, zs[side][f] = p.z;
+                }
+            }
+        });
+
+        // The floor is a low percentile of both ankles' heights, a glitched frame does not lower it
+        std::vector<float> heights(ys[0]);
+        heights.insert(heights.end(), ys[1].begin(), ys[1].end());
+        auto const percentile = heights.begin() + std::ptrdiff_t(c_FloorPercentile * (heights.size() - 1));
+        std::nth_element(heights.begin(), percentile, heights.end());
+        float const floor = *percentile;
+        result.Flags.assign(n, 0);
+        for (int side = 0; side < 2; ++side)
+        {
+            // Central differences over two frames, one at the ends
+            float const         length = legs.Legs[side].Length;
+            float const         height = floor + settings.HeightTolerance * length;
+            float const         step   = settings.SpeedThreshold * length * clip.FrameTime;
+            float const *       x      = xs[side].data();
+            float const *       y      = ys[side].data();
+            float const *       z      = zs[side].data();
+            std::uint8_t *      flags  = result.Flags.data();
+            std::uint8_t const  bit    = std::uint8_t(1u << side);
+            for (std::uint32_t f = 0; f < n; ++f)
+            {
+                std::uint32_t const a = f > 0 ? f - 1 : 0;
+                std::uint32_t const b = f + 1 < n ? f + 1 : n - 1;
+                float const dx = x[b] - x[a], dy = y[b] - y[a], dz = z[b] - z[a];
+                float const limit = step * float(b - a);
+                flags[f] |= (y[f] < height) & (dx * dx + dy * dy + dz * dz <= limit * limit) ? bit : 0;
+            }
+
+            std::uint32_t const minRun = std::max(1u, std::uint32_t(std::lround(settings.MinDuration / clip.FrameTime)));
+            DropShortRuns(result.Flags, bit, false, minRun);
+            DropShortRuns(result.Flags, bit, true, minRun);
+        }
+        return result;
+    }
+
+    std::uint8_t FootContacts::At(float const time, bool const loop) const
+    {
+        if (Flags.empty() || FrameTime <= 0.f) return 0;
+        std::size_t const frame = std::size_t(std::max(time, 0.f) / FrameTime);
+        return Flags[loop ? frame % Flags.size() : std::min(frame, Flags.size() - 1)];
+    }
+
+    static void RotateSubtree(std::uint32_t const begin, std::uint32_t const end, glm::vec3 const & pivot, glm::quat const & rotation, glm::vec3 * positions, glm::quat * rotations)
+    {
+        for (std::uint32_t j = begin; j < end; ++j)
+        {
+            positions[j] = pivot + rotation * (positions[j] - pivot);
+            rotations[j] = rotation * rotations[j];
+        }
+    }
+
+    void SolveTwoBone(LegRig::Leg const & leg, glm::vec3 const & target, bool const keepAnkle, glm::vec3 * positions, glm::quat * rotations)
+    {
+        glm::vec3 const a     = positions[leg.Hip];
+        glm::vec3 const b     = positions[leg.Knee];
+        glm::vec3 const c     = positions[leg.Ankle];
+        float const     upper = glm::length(b - a);
+        float const     lower = glm::length(c - b);
+        if (upper < 1e-6f || lower < 1e-6f || glm::length(target - a) < 1e-6f) return;
+        glm::quat const ankle = rotations[leg.Ankle];
+
+        // Knee angle from the law of cosines, kept off the fully stretched and folded poses
+        float const reach   = std::clamp(glm::length(target - a), std::abs(upper - lower) + 1e-4f * (upper + lower), .9999f * (upper + lower));
+        float const current = std::acos(std::clamp(glm::dot(glm::normalize(a - b), glm::normalize(c - b)), -1.f, 1.f));
+        float const desired = std::acos(std::clamp((upper * upper + lower * lower - reach * reach) / (2.f * upper * lower), -1.f, 1.f));
+        glm::vec3   axis    = glm::cross(c - b, a - b);
+        axis                = glm::length(axis) > 1e-6f * upper * lower ? glm::normalize(axis) : rotations[leg.Knee] * glm::vec3(1.f, 0.f, 0.f);
+        RotateSubtree(leg.Knee, leg.KneeEnd, b, glm::angleAxis(current - desired, axis), positions, rotations);
+
+        // Swing the leg from the hip onto the target
+        glm::quat const swing = glm::rotation(glm::normalize(positions[leg.Ankle] - a), glm::normalize(target - a));
+        RotateSubtree(leg.Hip, leg.HipEnd, a, swing, positions, rotations);
+
+        if (keepAnkle) RotateSubtree(leg.Ankle, leg.AnkleEnd, positions[leg.Ankle], ankle * glm::inverse(rotations[leg.Ankle]), positions, rotations);
+    }
+
+    void FootLock::Reset()
+    {
+        _feet = { };
+    }
+
+    void FootLock::Apply(LegRig const & legs, std::uint8_t const contacts, float const dt, glm::vec3 * positions, glm::quat * rotations, glm::vec3 const & groundShift)
+    {
+        if (! legs.IsValid()) return;
+        float const step = Settings.BlendTime > 0.f ? dt / Settings.BlendTime : 1.f;
+        for (int side = 0; side < 2; ++side)
+        {
+            LegRig::Leg const & leg     = legs.Legs[side];
+            Foot &              foot    = _feet[side];
+            glm::vec3 const     ankle   = positions[leg.Ankle];
+            bool const          contact = (contacts >> side) & 1;
+
+            // A new contact pins where the foot is shown, which is not the animated ankle while
+            // the previous lock still fades out
+            foot.Pin += groundShift;
+            if (contact && ! foot.Planted) foot.Pin = glm::mix(ankle, foot.Pin, foot.Weight);
+            foot.Planted = contact;
+            foot.Weight  = std::clamp(foot.Weight + (contact ? step : -step), 0.f, 1.f);
+            if (glm::length(foot.Pin - ankle) > Settings.MaxDrift * leg.Length)
+            {
+                // Jumped (a seek, a loop or a cut), pinned again on the next contact frame
+                foot.Planted = false;
+                foot.Weight  = 0.f;
+            }
+            if (foot.Weight <= 0.f) continue;
+
+            float const w = foot.Weight * foot.Weight * (3.f - 2.f * foot.Weight);
+            SolveTwoBone(leg, glm::mix(ankle, foot.Pin, w), true, positions, rotations);
+        }
+    }
+
+    void FootLock::Apply(LegRig const & legs, std::uint8_t const contacts, float const dt, Skeleton & skeleton)
+    {
+        std::size_t const joints = skeleton.Joints.size();
+        _positions.resize(joints);
+        _rotations.resize(joints);
+        for (std::size_t j = 0; j < joints; ++j)
+        {
+            _positions[j] = skeleton.Joints[j]->GlobalPosition;
+            _rotations[j] = skeleton.Joints[j]->GlobalRotation;
+        }
+        Apply(legs, contacts, dt, _positions.data(), _rotations.data());
+        for (std::size_t j = 0; j < joints; ++j)
+        {
+            skeleton.Joints[j]->GlobalPosition = _positions[j];
+            skeleton.Joints[j]->GlobalRotation = _rotations[j];
+        }
+    }
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+#include <glm/ext/quaternion_float.hpp>
+
+#include "Labs/FinalProject/Pose.h"
+#include "Labs/FinalProject/Skeleton.h"
+
+namespace VCX::Labs::FinalProject
+{
+    // Thresholds are in leg lengths (hip to knee to ankle), so they hold across rigs and units.
+    struct FootLockSettings
+    {
+        float   HeightTolerance = .06f;     // Above the floor, about the lowest the ankles get in the clip
+        float   SpeedThreshold  = .4f;      // Ankle speed, leg lengths per second
+        float   MinDuration     = .05f;     // Shorter contacts and gaps are dropped, seconds
+        float   BlendTime       = .15f;     // Locks fade in and out over this long, seconds
+        float   MaxDrift        = .5f;      // Locks further from the animated foot are released
+    };
+
+    // Hip, knee and ankle of each leg, left then right. Subtrees are contiguous in SkeletonDef
+    // order, so each joint's subtree is [joint, end).
+    struct LegRig
+    {
+        struct Leg
+        {
+            int             Hip      = -1;
+            int             Knee     = -1;
+            int             Ankle    = -1;
+            std::uint32_t   HipEnd   = 0;
+            std::uint32_t   KneeEnd  = 0;
+            std::uint32_t   AnkleEnd = 0;
+            float           Length   = 0.f; // Scene units
+        };
+
+        std::array<Leg, 2> Legs;
+
+        // CMU or Unreal-style leg names; invalid if a leg is missing or not a parent chain.
+        static LegRig Find(SkeletonDef const & def);
+        bool          IsValid() const { return Legs[0].Ankle >= 0 && Legs[1].Ankle >= 0; }
+    };
+
+    // Per-frame ground contacts of the two ankles of a clip: low and slow, with flickers removed.
+    struct FootContacts
+    {
+        std::vector<std::uint8_t>   Flags;      // Per frame, bit 0 for the left foot, bit 1 for the right
+        float                       FrameTime = 0.f;
+
+        // Forward kinematics over all frames in parallel, then the thresholds over flat per-frame
+        // arrays of heights and speeds. Empty if the skeleton has no legs.
+        static FootContacts Detect(BakedClip const & clip, LegRig const & legs, FootLockSettings const & settings = { });
+
+        std::uint8_t At(float const time, bool const loop) const;
+    };
+
+    // Two-bone IK: bends the knee to reach `target` from the hip, then swings the leg onto it.
+    // The hip subtree is carried along rigidly; `keepAnkle` keeps the ankle's global rotation.
+    void SolveTwoBone(LegRig::Leg const & leg, glm::vec3 const & target, bool const keepAnkle, glm::vec3 * positions, glm::quat * rotations);
+
+    // Pins each foot where its contact began, for one character. Runs after forward kinematics on
+    // the global pose, whether flat buffers or a joint tree.
+    class FootLock
+    {
+    public:
+        FootLockSettings Settings;
+
+        void Reset();
+        // `groundShift` moves the pins with the ground, for characters played in place.
+        void Apply(LegRig const & legs, std::uint8_t const contacts, float const dt, glm::vec3 * positions, glm::quat * rotations, glm::vec3 const & groundShift = glm::vec3(0.f));
+        void Apply(LegRig const & legs, std::uint8_t const contacts, float const dt, Skeleton & skeleton);
+
+    private:
+        struct Foot
+        {
+            glm::vec3   Pin     = glm::vec3(0.f);
+            float       Weight  = 0.f;
+            bool        Planted = false;
+        };
+
+        std::array<Foot, 2>     _feet;
+        std::vector<glm::vec3>  _positions;     // Joint tree scratch
+        std::vector<glm::quat>  _rotations;
+    };
+}
@@ -0,0 +1,74 @@
+#include <algorithm>
+#include <cstring>
+
+#include "Labs/FinalProject/FrameUniforms.h"
+
+namespace VCX::Labs::FinalProject
+{
+    static constexpr std::uint32_t c_InitialDraws = 64;
+
+    FrameUniforms::FrameUniforms() :
+        _frame(FrameBinding, Engine::GL::DrawFrequency::Dynamic)
+    {
+        GLint alignment = 0;
+        glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+        alignment = std::max(alignment, 1);
+        _stride   = std::uint32_t((sizeof(DrawConstants) + alignment - 1) / alignment * alignment);
+    }
+
+    FrameUniforms & FrameUniforms::Global()
+    {
+        static FrameUniforms uniforms;
+        return uniforms;
+    }
+
+    void FrameUniforms::Bind(Engine::GL::UniqueProgram & program)
+    {
+        Global();
+        program.BindUniformBlock("FrameConstants", FrameBinding);
+        program.BindUniformBlock("DrawConstants", DrawBinding);
+    }
+
+    void FrameUniforms::Begin(glm::mat4 const & projection, glm::mat4 const & view, float const time)
+    {
+        _frame.Update(FrameConstants {
+            .Projection = projection,
+            .View       = view,
+            .Eye        = glm::vec3(glm::inverse(view)[3]),
+            .Time       = time,
+        });
+        _lastDraws   = _queued;
+        _lastUploads = _uploads;
+        _queued = _uploaded = _uploads = 0;
+    }
+
+    std::uint32_t FrameUniforms::Queue(DrawConstants const & draw)
+    {
+        _staging.resize(std::max<std::size_t>(_staging.size(), std::size_t(_queued + 1) * _stride));
+        std::memcpy(_staging.data() + std::size_t(_queued) * _stride, &draw, sizeof(draw));
+        return _queued++;
+    }
+
+    Engine::GL::scope_t FrameUniforms::Use(std::uint32_t const draw)
+    {
+        if (draw >= _uploaded) Upload();
+        Engine::GL::State::BindUniformRange(DrawBinding, _draws.Get(), GLintptr(draw) * _stride, sizeof(DrawConstants));
+        return Engine::GL::scope_t([] {});
+    }
+
+    void FrameUniforms::Upload()
+    {
+        auto const use = _draws.Use();
+        if (_uploaded == 0 || _queued > _capacity)
+        {
+            // Fresh storage on the first upload of a frame, so the last frame's draws need not
+            // finish first; it drops the contents, everything queued goes up again
+            if (_queued > _capacity) _capacity = std::max(_capacity * 2, std::max(_queued, c_InitialDraws));
+            glBufferData(GL_UNIFORM_BUFFER, GLsizeiptr(_capacity) * _stride, nullptr, GL_DYNAMIC_DRAW);
+            _uploaded = 0;
+        }
+        glBufferSubData(GL_UNIFORM_BUFFER, GLintptr(_uploaded) * _stride, GLsizeiptr(_queued - _uploaded) * _stride, _staging.data() + std::size_t(_uploaded) * _stride);
+        _uploaded = _queued;
+        ++_uploads;
+    }
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "Engine/GL/Program.h"
+#include "Engine/GL/UniformBlock.hpp"
+
+namespace VCX::Labs::FinalProject
+{
+    // Mirrors the FrameConstants block of the shaders (std140): the camera, set once per frame.
+    struct FrameConstants
+    {
+        glm::mat4   Projection { 1.f };
+        glm::mat4   View       { 1.f };
+        glm::vec3   Eye        { 0.f };
+        float       Time       = 0.f;
+    };
+
+    // Mirrors the DrawConstants block (std140): what changes between draws with one program.
+    struct DrawConstants
+    {
+        glm::vec4   Color  { 1.f };
+        glm::vec4   Offset { 0.f };     // xyz added to positions, in scene space
+    };
+
+    // The camera block shared by every program, and one buffer of per-draw blocks. Draws are
+    // queued as they come and uploaded together before the first of them is drawn; each draw then
+    // only binds its range. Both blocks sit at fixed binding points, so a program maps its block
+    // indices once, in Bind, and takes no camera uniforms per frame.
+    class FrameUniforms
+    {
+    public:
+        static constexpr std::uint32_t FrameBinding = 1;    // 0 is SkinRender's PassConstants
+        static constexpr std::uint32_t DrawBinding  = 2;
+
+        static FrameUniforms & Global();
+        static void            Bind(Engine::GL::UniqueProgram & program);
+
+        // Uploads the camera and empties the draw queue.
+        void                Begin(glm::mat4 const & projection, glm::mat4 const & view, float const time = 0.f);
+        std::uint32_t       Queue(DrawConstants const & draw);
+        Engine::GL::scope_t Use(std::uint32_t const draw);
+
+        // Of the previous frame
+        std::uint32_t GetDrawCount() const { return _lastDraws; }
+        std::uint32_t GetUploadCount() const { return _lastUploads; }
+
+    private:
+        FrameUniforms();
+
+        void Upload();
+
+        Engine::GL::UniqueUniformBlock<FrameConstants>  _frame;
+        Engine::GL::UniqueUniformBuffer                 _draws;
+        std::vector<std::byte>                          _staging;       // Stride bytes per queued draw
+        std::uint32_t                                   _stride      = 0;   // Rounded up to the offset alignment
+        std::uint32_t                                   _capacity    = 0;   // Draws the buffer holds
+        std::uint32_t                                   _queued      = 0;
+        std::uint32_t                                   _uploaded    = 0;
+        std::uint32_t                                   _uploads     = 0;
+        std::uint32_t                                   _lastDraws   = 0;
+        std::uint32_t                                   _lastUploads = 0;
+    };
+}
@@ -0,0 +1,268 @@
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iterator>
+#include <limits>
+#include <mutex>
+
+#if defined(__SSE2__) || defined(_M_X64)
+    #include <emmintrin.h>
+#endif
+
+#include <fmt/core.h>
+#include <spdlog/spdlog.h>
+
+#include "Engine/ThreadPool.hpp"
+#include "Labs/FinalProject/AtomicFile.h"
+#include "Labs/FinalProject/ClipIndex.h"
+#include "Labs/FinalProject/LoopPoints.h"
+#include "Labs/FinalProject/Pose.h"
+
+namespace VCX::Labs::FinalProject
+{
+    static constexpr std::uint32_t c_LoopMagic    = 0x504F4F4C; // "LOOP"
+    static constexpr std::uint32_t c_LoopVersion  = 1;
+    static constexpr std::uint32_t c_Tile         = 64;         // Frames per side of a distance matrix tile
+    static constexpr std::size_t   c_Candidates   = 8;          // Coarse matches refined at the full rate
+    static constexpr float         c_VelocityTime = .1f;        // Seconds of root displacement in a feature row
+
+    struct LoopCandidate
+    {
+        float           Cost = 0.f;
+        std::uint32_t   In   = 0;
+        std::uint32_t   Out  = 0;
+    };
+
+    // Keeps the c_Candidates cheapest, one per neighbourhood of `radius` frames, cheapest first.
+    static void Offer(std::vector<LoopCandidate> & best, LoopCandidate const & candidate, std::uint32_t const radius)
+    {
+        auto near = [&](LoopCandidate const & other) {
+            return std::max(other.In, candidate.In) - std::min(other.In, candidate.In) < radius
+                && std::max(other.Out, candidate.Out) - std::min(other.Out, candidate.Out) < radius;
+        };
+        if (auto const iter = std::find_if(best.begin(), best.end(), near); iter != best.end())
+        {
+            if (iter->Cost <= candidate.Cost) return;
+            best.erase(iter);
+        }
+        else if (best.size() == c_Candidates && best.back().Cost <= candidate.Cost) return;
+
+        best.insert(std::upper_bound(best.begin(), best.end(), candidate, [](auto const & a, auto const & b) { return a.Cost < b.Cost; }), candidate);
+        if (best.size() > c_Candidates) best.pop_back();
+    }
+
+    // Squared distance of two feature rows, `dims` a multiple of 8.
+    static float Distance(float const * a, float const * b, std::uint32_t const dims)
+    {
+#if defined(__SSE2__) || defined(_M_X64)
+        __m128 a0 = _mm_setzero_ps(), a1 = _mm_setzero_ps();
+        for (std::uint32_t d = 0; d < dims; d += 8)
+        {
+            __m128 const d0 = _mm_sub_ps(_mm_loadu_ps(a + d), _mm_loadu_ps(b + d));
+            __m128 const d1 = _mm_sub_ps(_mm_loadu_ps(a + d + 4), _mm_loadu_ps(b + d + 4));
+            a0              = _mm_add_ps(a0, _mm_mul_ps(d0, d0));
+            a1              = _mm_add_ps(a1, _mm_mul_ps(d1, d1));
+        }
+        float sums[4];
+        _mm_storeu_ps(sums, _mm_add_ps(a0, a1));
+        return (sums[0] + sums[1]) + (sums[2] + sums[3]);
+#else
+        float sum = 0.f;
+        for (std::uint32_t d = 0; d < dims; ++d)
+        {
+            float const e = a[d] - b[d];
+            sum          += e * e;
+        }
+        return sum;
+#endif
+    }
+
+    // Per frame, every joint position in the root's ground frame, then the root displacement over
+    // c_VelocityTime in the same frame, scaled so that squared distances carry the weights.
+    static std::vector<float> Featurize(Clip const & clip, float const velocityWeight, std::uint32_t & stride)
+    {
+        auto const          baked  = BakedClip::Bake(clip);
+        std::uint32_t const joints = clip.Skeleton->GetJointCount();
+        std::uint32_t const frames = clip.Frames;
+        std::vector<glm::vec3> positions(std::size_t(frames) * joints);
+        std::vector<glm::quat> rotations(std::size_t(frames) * joints);
+        Engine::ThreadPool::Global().ParallelFor(frames, 256, [&](std::size_t const begin, std::size_t const end) {
+            Pose pose;
+            for (std::size_t f = begin; f < end; ++f)
+            {
+                baked->SampleFrame(std::uint32_t(f), pose);
+                ForwardKinematics(*clip.Skeleton, pose, positions.data() + f * joints, rotations.data() + f * joints);
+            }
+        });
+
+        stride = (3 * joints + 3 + 7) / 8 * 8;
+        std::vector<float>  features(std::size_t(frames) * stride, 0.f);
+        std::uint32_t const reach = std::max<std::uint32_t>(1, std::uint32_t(std::lround(.5f * c_VelocityTime / clip.FrameTime)));
+        float const         scale = std::sqrt(std::max(velocityWeight, 0.f));
+        Engine::ThreadPool::Global().ParallelFor(frames, 256, [&](std::size_t const begin, std::size_t const end) {
+            for (std::size_t f = begin; f < end; ++f)
+            {
+                glm::vec3 const * p = positions.data() + f * joints;
+                float *           out = features.data() + f * stride;
+                glm::vec3         origin;
+                glm::quat         inverse;
+                GetGroundFrame(p[0], rotations[f * joints], origin, inverse);
+                for (std::uint32_t j = 0; j < joints; ++j, out += 3)
+                {
+                    glm::vec3 const local = inverse * (p[j] - origin);
+                    out[0] = local.x, out[1] = local.y, out[2] = local.z;
+                }
+
+                std::uint32_t f0, f1;
+                GetDifferenceFrames(std::uint32_t(f), reach, frames, f0, f1);
+                if (f1 == f0) continue;
+                glm::vec3 const displacement = inverse * (positions[std::size_t(f1) * joints] - positions[std::size_t(f0) * joints]) * (scale * c_VelocityTime / (float(f1 - f0) * clip.FrameTime));
+                out[0] = displacement.x, out[1] = displacement.y, out[2] = displacement.z;
+            }
+        });
+        return features;
+    }
+
+    LoopPoints FindLoopPoints(Clip const & clip, LoopSettings const & settings)
+    {
+        std::uint32_t const frames = clip.Frames;
+        if (frames < 2 || clip.FrameTime <= 0.f) return { };
+
+        // In >= blend for the fade-in source to exist, and Out - In >= minLength
+        std::uint32_t const blend     = std::uint32_t(std::lround(std::max(settings.BlendTime, 0.f) / clip.FrameTime));
+        std::uint32_t const minLength = std::max<std::uint32_t>(1, std::uint32_t(std::ceil(std::clamp(settings.MinCoverage, 0.f, 1.f) * (frames - 1))));
+        if (blend + minLength > frames - 1) return { };
+
+        std::uint32_t      stride;
+        std::vector<float> features = Featurize(clip, settings.VelocityWeight, stride);
+        auto               row      = [&](std::uint32_t const f) { return features.data() + std::size_t(f) * stride; };
+
+        // Coarse pass over every step-th frame: the cost of jumping from b to a is the distance
+        // summed along the diagonal over the crossfade window, D(a - k, b - k) for k in [0, window]
+        std::uint32_t const step      = settings.AnalysisRate > 0.f ? std::max<std::uint32_t>(1, std::uint32_t(std::lround(1.f / (clip.FrameTime * settings.AnalysisRate)))) : 1;
+        std::uint32_t const coarse    = (frames - 1) / step + 1;
+        std::uint32_t const window    = std::uint32_t(std::lround(float(blend) / step));
+        std::uint32_t const minSpan   = (minLength + step - 1) / step;
+        std::uint32_t const tiles     = (coarse + c_Tile - 1) / c_Tile;
+        std::vector<std::pair<std::uint32_t, std::uint32_t>> work;
+        for (std::uint32_t ta = 0; ta < tiles; ++ta)
+            for (std::uint32_t tb = ta; tb < tiles; ++tb)
+                if (std::min(tb * c_Tile + c_Tile, coarse) - 1 >= ta * c_Tile + minSpan) work.emplace_back(ta * c_Tile, tb * c_Tile);
+
+        // Each tile computes its block of the matrix with a halo of `window` rows and columns, as
+        // running sums along the diagonals so that every window sum is one subtraction
+        std::mutex                 mutex;
+        std::vector<LoopCandidate> candidates;
+        std::uint32_t const        side = c_Tile + window;
+        Engine::ThreadPool::Global().ParallelFor(work.size(), 1, [&](std::size_t const begin, std::size_t const end) {
+            std::vector<float>         sums(std::size_t(side) * side);
+            std::vector<LoopCandidate> local;
+            for (std::size_t w = begin; w < end; ++w)
+            {
+                auto const [a0, b0] = work[w];
+                for (std::uint32_t r = 0; r < side; ++r)
+                    for (std::uint32_t c = 0; c < side; ++c)
+                    {
+                        // Only diagonals at least minSpan above the main one are ever summed
+                        std::int64_t const a = std::int64_t(a0) - window + r;
+                        std::int64_t const b = std::int64_t(b0) - window + c;
+                        float const        d = a < 0 || b >= coarse || b - a < minSpan ? 0.f : Distance(row(std::uint32_t(a) * step), row(std::uint32_t(b) * step), stride);
+                        sums[std::size_t(r) * side + c] = d + (r > 0 && c > 0 ? sums[std::size_t(r - 1) * side + c - 1] : 0.f);
+                    }
+
+                for (std::uint32_t r = window; r < side; ++r)
+                {
+                    std::uint32_t const a = a0 + r - window;
+                    if (a < window || a >= coarse) continue;
+                    for (std::uint32_t c = window; c < side; ++c)
+                    {
+                        std::uint32_t const b = b0 + c - window;
+                        if (b >= coarse || b < a + minSpan) continue;
+                        float cost = sums[std::size_t(r) * side + c];
+                        if (std::min(r, c) > window) cost -= sums[std::size_t(r - window - 1) * side + c - window - 1];
+                        Offer(local, { cost, a * step, b * step }, 2 * step);
+                    }
+                }
+            }
+
+            std::lock_guard lock(mutex);
+            for (auto const & candidate : local) Offer(candidates, candidate, 2 * step);
+        });
+
+        // Full-rate pass around each coarse candidate
+        LoopPoints best;
+        float      bestCost = std::numeric_limits<float>::infinity();
+        for (auto const & candidate : candidates)
+        {
+            std::uint32_t const inBegin  = std::max(candidate.In, blend + step - 1) - (step - 1);
+            std::uint32_t const inEnd    = std::min(candidate.In + step, frames);
+            std::uint32_t const outBegin = candidate.Out > step - 1 ? candidate.Out - (step - 1) : 0;
+            std::uint32_t const outEnd   = std::min(candidate.Out + step, frames);
+            for (std::uint32_t in = inBegin; in < inEnd; ++in)
+                for (std::uint32_t out = std::max(outBegin, in + minLength); out < outEnd; ++out)
+                {
+                    float cost = 0.f;
+                    for (std::uint32_t k = 0; k <= blend && cost <= bestCost; ++k) cost += Distance(row(in - k), row(out - k), stride);
+                    if (cost < bestCost || (cost == bestCost && out - in > best.Out - best.In))
+                    {
+                        bestCost = cost;
+                        best     = LoopPoints { .In = in, .Out = out, .Blend = blend };
+                    }
+                }
+        }
+        if (best.IsValid()) best.Error = std::sqrt(bestCost / (float(blend + 1) * clip.Skeleton->GetJointCount()));
+        return best;
+    }
+
+    static bool ReadCache(std::filesystem::path const & path, std::uint64_t const hash, LoopPoints & points)
+    {
+        std::ifstream file(path, std::ios::binary);
+        if (! file.is_open()) return false;
+
+        auto read = [&file](auto & value) { file.read(reinterpret_cast<char *>(&value), sizeof(value)); };
+
+        std::uint32_t magic = 0, version = 0;
+        std::uint64_t stored = 0;
+        read(magic);
+        read(version);
+        read(stored);
+        if (! file || magic != c_LoopMagic || version != c_LoopVersion || stored != hash) return false;
+        read(points.In);
+        read(points.Out);
+        read(points.Blend);
+        read(points.Error);
+        return bool(file);
+    }
+
+    static void WriteCache(std::filesystem::path const & path, std::uint64_t const hash, LoopPoints const & points)
+    {
+        bool const written = WriteFileAtomic(path, [&](std::ostream & file) {
+            auto write = [&file](auto const & value) { file.write(reinterpret_cast<char const *>(&value), sizeof(value)); };
+
+            write(c_LoopMagic);
+            write(c_LoopVersion);
+            write(hash);
+            write(points.In);
+            write(points.Out);
+            write(points.Blend);
+            write(points.Error);
+        });
+        if (! written) spdlog::warn("LoopPoints: cannot write \"{}\".", path.string());
+    }
+
+    LoopPoints GetLoopPoints(std::string const & path, Clip const & clip, std::filesystem::path const & cacheDir)
+    {
+        std::ifstream file(path, std::ios::binary);
+        if (! file.is_open()) return FindLoopPoints(clip);
+
+        std::string const   bytes { std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>() };
+        std::uint64_t const hash  = ClipIndexer::HashBytes(bytes);
+        auto const          cache = cacheDir / fmt::format("{:016x}.loop", hash);
+
+        LoopPoints points;
+        if (ReadCache(cache, hash, points)) return points;
+        points = FindLoopPoints(clip);
+        WriteCache(cache, hash, points);
+        return points;
+    }
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <string>
+
+#include "Labs/FinalProject/Clip.h"
+
+namespace VCX::Labs::FinalProject
+{
+    struct LoopSettings
+    {
+        float   MinCoverage    = .5f;   // Shortest loop, as a fraction of the clip
+        float   BlendTime      = .25f;  // Crossfade before the jump, seconds
+        float   AnalysisRate   = 30.f;  // Frames per second of the coarse search, refined at the full rate
+        float   VelocityWeight = 4.f;   // Root displacement over a tenth of a second counts like this many joints
+    };
+
+    // Where a clip loops: playback runs up to Out, then continues from In, the frames [Out - Blend,
+    // Out) fading into [In - Blend, In) so that the jump lands where both already agree.
+    struct LoopPoints
+    {
+        std::uint32_t   In    = 0;
+        std::uint32_t   Out   = 0;
+        std::uint32_t   Blend = 0;
+        float           Error = 0.f;    // RMS joint distance over the crossfade window, scene units
+
+        bool IsValid() const { return Out > In; }
+    };
+
+    // Compares every pair of frames by joint positions relative to the root on the ground, summed
+    // over the crossfade window. The distance matrix is computed tile by tile over the thread pool
+    // at the analysis rate, keeping only the best candidates, which are then refined at the full
+    // frame rate; memory does not grow with the square of the clip length. Invalid points when the
+    // clip is too short for a loop.
+    LoopPoints FindLoopPoints(Clip const & clip, LoopSettings const & settings = { });
+
+    // Loop points of the clip loaded from `path` with the default settings, from the cache keyed by
+    // the file hash when present, otherwise found and cached.
+    LoopPoints GetLoopPoints(std::string const & path, Clip const & clip, std::filesystem::path const & cacheDir = ".cache/loops");
+}
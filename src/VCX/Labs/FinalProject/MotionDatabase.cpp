@@ -0,0 +1,624 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <utility>
+
+#if defined(__SSE2__) || defined(_M_X64)
+    #include <emmintrin.h>
+#endif
+
+#include <spdlog/spdlog.h>
+
+#include "Engine/ThreadPool.hpp"
+#include "Labs/FinalProject/AtomicFile.h"
+#include "Labs/FinalProject/MotionDatabase.h"
+#include "Labs/FinalProject/Pose.h"
+
+namespace VCX::Labs::FinalProject
+{
+    static constexpr std::uint32_t c_DatabaseMagic   = 0x42444D4D; // "MMDB"
+    static constexpr std::uint32_t c_DatabaseVersion = 1;
+    static constexpr std::size_t   c_Tile            = 16;         // Slots stored together, also a KD-tree leaf
+    static constexpr std::size_t   c_ParallelChunk   = 64 * 1024;
+    static constexpr std::size_t   c_SplitSamples    = 1024;       // Slots sampled to pick a split feature
+    static constexpr std::size_t   c_MaxDepth        = 64;
+
+    // Slots are stored in tiles of c_Tile, each tile feature by feature, so that a feature of a
+    // tile is one SIMD row and a whole tile is one contiguous read.
+    static std::size_t GetFeatureIndex(std::size_t const slot, std::uint32_t const feature, std::uint32_t const dims)
+    {
+        return (slot / c_Tile) * c_Tile * dims + feature * c_Tile + slot % c_Tile;
+    }
+
+    // Features that share a weight and a deviation, e.g. the three coordinates of one joint.
+    struct FeatureGroup
+    {
+        std::uint32_t   Offset;
+        std::uint32_t   Count;
+        float           Weight;
+    };
+
+    static std::vector<FeatureGroup> GetGroups(MotionFeatureSettings const & settings)
+    {
+        std::vector<FeatureGroup> groups;
+        std::uint32_t             offset = 0;
+        auto                      add    = [&](std::uint32_t const count, float const weight) {
+            groups.push_back({ offset, count, weight });
+            offset += count;
+        };
+        for (std::size_t i = 0; i < settings.Joints.size(); ++i) add(3, settings.PositionWeight);
+        for (std::size_t i = 0; i < settings.Joints.size(); ++i) add(3, settings.VelocityWeight);
+        add(3, settings.RootVelocityWeight);
+        add(2 * std::uint32_t(settings.TrajectoryTimes.size()), settings.TrajectoryPositionWeight);
+        add(2 * std::uint32_t(settings.TrajectoryTimes.size()), settings.TrajectoryDirectionWeight);
+        return groups;
+    }
+
+    static bool FindJoints(SkeletonDef const & def, MotionFeatureSettings const & settings, std::vector<int> & joints)
+    {
+        joints.clear();
+        for (auto const & name : settings.Joints)
+        {
+            joints.push_back(def.Find(name));
+            if (joints.back() < 0) return false;
+        }
+        return true;
+    }
+
+    static void Featurize(
+        MotionFeatureSettings const & settings,
+        std::vector<int> const &      joints,
+        std::uint32_t const           jointCount,
+        float const                   frameTime,
+        std::uint32_t const           frames,
+        glm::vec3 const *             positions,
+        glm::quat const *             rotations,
+        std::uint32_t const           frame,
+        float *                       out)
+    {
+        auto position = [&](std::uint32_t const f, int const j) { return positions[std::size_t(f) * jointCount + j]; };
+        auto velocity = [&](int const j) {
+            std::uint32_t f0, f1;
+            GetDifferenceFrames(frame, 1, frames, f0, f1);
+            return f1 > f0 ? (position(f1, j) - position(f0, j)) / (float(f1 - f0) * frameTime) : glm::vec3(0.f);
+        };
+        auto write = [&out](float const value) { *out++ = value; };
+
+        glm::vec3 origin;
+        glm::quat inverse;
+        GetGroundFrame(position(frame, 0), rotations[std::size_t(frame) * jointCount], origin, inverse);
+
+        for (int const j : joints)
+        {
+            glm::vec3 const p = inverse * (position(frame, j) - origin);
+            write(p.x), write(p.y), write(p.z);
+        }
+        for (int const j : joints)
+        {
+            glm::vec3 const v = inverse * velocity(j);
+            write(v.x), write(v.y), write(v.z);
+        }
+        glm::vec3 const root = inverse * velocity(0);
+        write(root.x), write(root.y), write(root.z);
+
+        // The future trajectory is held at the last frame near the end of the clip
+        auto future = [&](float const time) { return std::min(frame + std::uint32_t(std::lround(time / frameTime)), frames - 1); };
+        for (float const time : settings.TrajectoryTimes)
+        {
+            glm::vec3 const p = inverse * (position(future(time), 0) - origin);
+            write(p.x), write(p.z);
+        }
+        for (float const time : settings.TrajectoryTimes)
+        {
+            glm::vec3 const d = inverse * (rotations[std::size_t(future(time)) * jointCount] * glm::vec3(0.f, 0.f, 1.f));
+            float const     l = std::sqrt(d.x * d.x + d.z * d.z);
+            write(l > 1e-6f ? d.x / l : 0.f), write(l > 1e-6f ? d.z / l : 1.f);
+        }
+    }
+
+    // Squared distances of the c_Tile frames of a tile to the query.
+    static void ScanTile(float const * tile, float const * query, std::uint32_t const dims, float * costs)
+    {
+#if defined(__SSE2__) || defined(_M_X64)
+        __m128 a0 = _mm_setzero_ps(), a1 = _mm_setzero_ps(), a2 = _mm_setzero_ps(), a3 = _mm_setzero_ps();
+        for (std::uint32_t d = 0; d < dims; ++d, tile += c_Tile)
+        {
+            __m128 const q  = _mm_set1_ps(query[d]);
+            __m128 const d0 = _mm_sub_ps(_mm_loadu_ps(tile), q);
+            __m128 const d1 = _mm_sub_ps(_mm_loadu_ps(tile + 4), q);
+            __m128 const d2 = _mm_sub_ps(_mm_loadu_ps(tile + 8), q);
+            __m128 const d3 = _mm_sub_ps(_mm_loadu_ps(tile + 12), q);
+            a0              = _mm_add_ps(a0, _mm_mul_ps(d0, d0));
+            a1              = _mm_add_ps(a1, _mm_mul_ps(d1, d1));
+            a2              = _mm_add_ps(a2, _mm_mul_ps(d2, d2));
+            a3              = _mm_add_ps(a3, _mm_mul_ps(d3, d3));
+        }
+        _mm_storeu_ps(costs, a0);
+        _mm_storeu_ps(costs + 4, a1);
+        _mm_storeu_ps(costs + 8, a2);
+        _mm_storeu_ps(costs + 12, a3);
+#else
+        std::fill_n(costs, c_Tile, 0.f);
+        for (std::uint32_t d = 0; d < dims; ++d, tile += c_Tile)
+            for (std::size_t i = 0; i < c_Tile; ++i)
+            {
+                float const e = tile[i] - query[d];
+                costs[i]     += e * e;
+            }
+#endif
+    }
+
+    // Squared distance from the query to a box, stopping early once it exceeds `bound`. Never more
+    // than the distance to any frame inside, with the same rounding as the scan.
+    static float BoxDistance(float const * lo, float const * hi, float const * query, std::uint32_t const dims, float const bound)
+    {
+        float sum = 0.f;
+        for (std::uint32_t d = 0; d < dims && sum <= bound; ++d)
+        {
+            float const e = std::max({ lo[d] - query[d], query[d] - hi[d], 0.f });
+            sum          += e * e;
+        }
+        return sum;
+    }
+
+    // Ties go to the earliest frame, whatever order frames were visited in.
+    static bool IsBetter(float const cost, std::size_t const frame, MotionDatabase::Match const & best)
+    {
+        return cost < best.Cost || (cost == best.Cost && frame < best.Frame);
+    }
+
+
+    void MotionDatabase::Initialize(MotionFeatureSettings const & settings)
+    {
+        _settings         = settings;
+        _trajectoryOffset = 6 * std::uint32_t(settings.Joints.size()) + 3;
+        _dims             = _trajectoryOffset + 4 * std::uint32_t(settings.TrajectoryTimes.size());
+    }
+
+    std::shared_ptr<MotionDatabase const> MotionDatabase::Build(std::vector<std::string> const & names, ClipSource const & source, MotionFeatureSettings const & settings)
+    {
+        auto const start = std::chrono::steady_clock::now();
+        auto       db    = std::make_shared<MotionDatabase>();
+        db->Initialize(settings);
+        std::uint32_t const dims = db->_dims;
+
+        // Raw features row by row, one block per clip
+        std::vector<std::vector<float>> rows(names.size());
+        std::vector<Range>              ranges(names.size());
+        Engine::ThreadPool::Global().ParallelFor(names.size(), 1, [&](std::size_t const begin, std::size_t const end) {
+            std::vector<glm::vec3> positions;
+            std::vector<glm::quat> rotations;
+            std::vector<int>       joints;
+            Pose                   pose;
+            for (std::size_t i = begin; i < end; ++i)
+            {
+                std::shared_ptr<Clip const> clip;
+                try
+                {
+                    clip = source(i);
+                }
+                catch (std::exception const & e)
+                {
+                    spdlog::warn("MotionDatabase: cannot load \"{}\": {}", names[i], e.what());
+                }
+                if (! clip || clip->Frames == 0) continue;
+                if (! FindJoints(*clip->Skeleton, settings, joints))
+                {
+                    spdlog::warn("MotionDatabase: \"{}\" lacks a feature joint, skipped.", names[i]);
+                    continue;
+                }
+
+                auto const          baked  = BakedClip::Bake(*clip);
+                std::uint32_t const count  = clip->Skeleton->GetJointCount();
+                positions.resize(std::size_t(clip->Frames) * count);
+                rotations.resize(std::size_t(clip->Frames) * count);
+                for (std::uint32_t f = 0; f < clip->Frames; ++f)
+                {
+                    baked->SampleFrame(f, pose);
+                    ForwardKinematics(*clip->Skeleton, pose, positions.data() + std::size_t(f) * count, rotations.data() + std::size_t(f) * count);
+                }
+
+                rows[i].resize(std::size_t(clip->Frames) * dims);
+                for (std::uint32_t f = 0; f < clip->Frames; ++f)
+                    Featurize(settings, joints, count, clip->FrameTime, clip->Frames, positions.data(), rotations.data(), f, rows[i].data() + std::size_t(f) * dims);
+                ranges[i] = Range { .Name = names[i], .Frames = clip->Frames, .FrameTime = clip->FrameTime };
+            }
+        });
+
+        // Skipped clips leave no range
+        std::vector<std::vector<float>> kept;
+        for (std::size_t i = 0; i < names.size(); ++i)
+        {
+            if (rows[i].empty()) continue;
+            ranges[i].Start = db->_frames;
+            db->_frames    += ranges[i].Frames;
+            db->_ranges.push_back(ranges[i]);
+            kept.push_back(std::move(rows[i]));
+        }
+        db->_mean.assign(dims, 0.f);
+        db->_scale.assign(dims, 1.f);
+
+        // Mean and variance of every feature, in double since a million frames are summed
+        std::vector<double> variance(dims, 0.);
+        Engine::ThreadPool::Global().ParallelFor(dims, 1, [&](std::size_t const begin, std::size_t const end) {
+            for (std::size_t d = begin; d < end; ++d)
+            {
+                double sum = 0., squares = 0.;
+                for (auto const & clip : kept)
+                    for (std::size_t r = d; r < clip.size(); r += dims)
+                    {
+                        sum     += clip[r];
+                        squares += double(clip[r]) * clip[r];
+                    }
+                double const mean = db->_frames ? sum / db->_frames : 0.;
+                db->_mean[d]      = float(mean);
+                variance[d]       = db->_frames ? std::max(squares / db->_frames - mean * mean, 0.) : 0.;
+            }
+        });
+
+        // Every group is scaled by its mean deviation, so no group dominates just by its units
+        for (auto const & group : GetGroups(settings))
+        {
+            double total = 0.;
+            for (std::uint32_t d = group.Offset; d < group.Offset + group.Count; ++d) total += variance[d];
+            float const deviation = float(std::sqrt(total / std::max(group.Count, 1u)));
+            for (std::uint32_t d = group.Offset; d < group.Offset + group.Count; ++d)
+                db->_scale[d] = group.Weight / std::max(deviation, 1e-5f);
+        }
+
+        // Normalized rows of all frames, in place
+        Engine::ThreadPool::Global().ParallelFor(kept.size(), 1, [&](std::size_t const begin, std::size_t const end) {
+            for (std::size_t i = begin; i < end; ++i)
+                for (std::size_t r = 0; r < kept[i].size(); ++r)
+                    kept[i][r] = (kept[i][r] - db->_mean[r % dims]) * db->_scale[r % dims];
+        });
+        std::vector<float> points;
+        points.reserve(std::size_t(db->_frames) * dims);
+        for (auto & clip : kept)
+        {
+            points.insert(points.end(), clip.begin(), clip.end());
+            std::vector<float>().swap(clip);
+        }
+
+        db->BuildTree();
+        db->Partition(points);
+
+        db->_features.assign((std::size_t(db->_frames) + c_Tile - 1) / c_Tile * c_Tile * dims, 0.f);
+        Engine::ThreadPool::Global().ParallelFor(db->_frames, 4096, [&](std::size_t const begin, std::size_t const end) {
+            for (std::size_t slot = begin; slot < end; ++slot)
+                for (std::uint32_t d = 0; d < dims; ++d)
+                    db->_features[GetFeatureIndex(slot, d, dims)] = points[std::size_t(db->_order[slot]) * dims + d];
+        });
+        db->BuildBounds();
+
+        spdlog::info(
+            "MotionDatabase: {} frames from {} clips, {} features, built in {:.1f} s.",
+            db->_frames,
+            db->_ranges.size(),
+            dims,
+            std::chrono::duration<float>(std::chrono::steady_clock::now() - start).count());
+        return db;
+    }
+
+    void MotionDatabase::BuildTree()
+    {
+        // The left child takes the first half rounded up to whole tiles, so every leaf is one tile
+        // and the shape only depends on the frame count
+        _nodes.clear();
+        _levels.clear();
+        if (_frames == 0) return;
+
+        auto add = [&](auto && self, std::uint32_t const begin, std::uint32_t const end, std::size_t const depth) -> void {
+            std::uint32_t const index = std::uint32_t(_nodes.size());
+            _nodes.push_back(Node { .Begin = begin, .End = end });
+            if (_levels.size() <= depth) _levels.emplace_back();
+            _levels[depth].push_back(index);
+            if (end - begin <= c_Tile) return;
+
+            std::uint32_t const mid = begin + std::uint32_t(((end - begin) / 2 + c_Tile - 1) / c_Tile * c_Tile);
+            self(self, begin, mid, depth + 1);
+            _nodes[index].Right = std::uint32_t(_nodes.size());
+            self(self, mid, end, depth + 1);
+        };
+        add(add, 0, _frames, 0);
+    }
+
+    void MotionDatabase::Partition(std::vector<float> const & points)
+    {
+        _order.resize(_frames);
+        for (std::uint32_t i = 0; i < _frames; ++i) _order[i] = i;
+
+        // Top-down, the nodes of one level own disjoint slot ranges and split in parallel. Each
+        // splits at its median along the feature of largest (sampled) variance.
+        for (auto const & level : _levels)
+        {
+            Engine::ThreadPool::Global().ParallelFor(level.size(), 1, [&](std::size_t const begin, std::size_t const end) {
+                std::vector<double>                              sum(_dims), squares(_dims);
+                std::vector<std::pair<float, std::uint32_t>>     keys;
+                for (std::size_t n = begin; n < end; ++n)
+                {
+                    Node const & node = _nodes[level[n]];
+                    if (node.Right == 0) continue;
+
+                    std::fill(sum.begin(), sum.end(), 0.);
+                    std::fill(squares.begin(), squares.end(), 0.);
+                    std::size_t const step    = std::max<std::size_t>((node.End - node.Begin) / c_SplitSamples, 1);
+                    std::size_t       samples = 0;
+                    for (std::size_t slot = node.Begin; slot < node.End; slot += step, ++samples)
+                        for (std::uint32_t d = 0; d < _dims; ++d)
+                        {
+                            double const value = points[std::size_t(_order[slot]) * _dims + d];
+                            sum[d]            += value;
+                            squares[d]        += value * value;
+                        }
+                    std::uint32_t split = 0;
+                    double        most  = -1.;
+                    for (std::uint32_t d = 0; d < _dims; ++d)
+                    {
+                        double const spread = squares[d] - sum[d] * sum[d] / samples;
+                        if (spread > most) most = spread, split = d;
+                    }
+
+                    // Select on a compact copy of the keys rather than through the order
+                    keys.clear();
+                    for (std::size_t slot = node.Begin; slot < node.End; ++slot)
+                        keys.emplace_back(points[std::size_t(_order[slot]) * _dims + split], _order[slot]);
+                    std::uint32_t const mid = _nodes[level[n] + 1].End;
+                    std::nth_element(keys.begin(), keys.begin() + (mid - node.Begin), keys.end());
+                    for (std::size_t slot = node.Begin; slot < node.End; ++slot)
+                        _order[slot] = keys[slot - node.Begin].second;
+                }
+            });
+        }
+    }
+
+    void MotionDatabase::BuildBounds()
+    {
+        _slots.resize(_frames);
+        for (std::uint32_t slot = 0; slot < _frames; ++slot) _slots[_order[slot]] = slot;
+
+        // Bottom-up, leaves from their tile and inner nodes from their children
+        _bounds.assign(_nodes.size() * 2 * _dims, 0.f);
+        for (auto level = _levels.rbegin(); level != _levels.rend(); ++level)
+        {
+            Engine::ThreadPool::Global().ParallelFor(level->size(), 256, [&](std::size_t const begin, std::size_t const end) {
+                for (std::size_t n = begin; n < end; ++n)
+                {
+                    std::uint32_t const index = (*level)[n];
+                    Node const &        node  = _nodes[index];
+                    float *             lo    = _bounds.data() + std::size_t(index) * 2 * _dims;
+                    float *             hi    = lo + _dims;
+                    if (node.Right == 0)
+                    {
+                        for (std::uint32_t d = 0; d < _dims; ++d)
+                        {
+                            lo[d] = std::numeric_limits<float>::infinity();
+                            hi[d] = -std::numeric_limits<float>::infinity();
+                            for (std::size_t slot = node.Begin; slot < node.End; ++slot)
+                            {
+                                float const value = _features[GetFeatureIndex(slot, d, _dims)];
+                                lo[d]             = std::min(lo[d], value);
+                                hi[d]             = std::max(hi[d], value);
+                            }
+                        }
+                        continue;
+                    }
+                    float const * left  = _bounds.data() + std::size_t(index + 1) * 2 * _dims;
+                    float const * right = _bounds.data() + std::size_t(node.Right) * 2 * _dims;
+                    for (std::uint32_t d = 0; d < _dims; ++d)
+                    {
+                        lo[d] = std::min(left[d], right[d]);
+                        hi[d] = std::max(left[_dims + d], right[_dims + d]);
+                    }
+                }
+            });
+        }
+    }
+
+    MotionDatabase::Range const & MotionDatabase::FindRange(std::uint32_t const frame) const
+    {
+        auto const it = std::upper_bound(_ranges.begin(), _ranges.end(), frame, [](std::uint32_t const f, Range const & range) { return f < range.Start; });
+        return it == _ranges.begin() ? _ranges.front() : *std::prev(it);
+    }
+
+    bool MotionDatabase::ComputeFeatures(SkeletonDef const & def, float const frameTime, std::uint32_t const frames, glm::vec3 const * positions, glm::quat const * rotations, std::uint32_t const frame, float * out) const
+    {
+        std::vector<int> joints;
+        if (! FindJoints(def, _settings, joints) || frame >= frames) return false;
+        Featurize(_settings, joints, def.GetJointCount(), frameTime, frames, positions, rotations, frame, out);
+        return true;
+    }
+
+    void MotionDatabase::Normalize(float * features) const
+    {
+        for (std::uint32_t d = 0; d < _dims; ++d) features[d] = (features[d] - _mean[d]) * _scale[d];
+    }
+
+    void MotionDatabase::GetFeatures(std::uint32_t const frame, float * out) const
+    {
+        for (std::uint32_t d = 0; d < _dims; ++d) out[d] = _features[GetFeatureIndex(_slots[frame], d, _dims)];
+    }
+
+    void MotionDatabase::ScanSlots(float const * query, std::size_t const begin, std::size_t const end, Match & best) const
+    {
+        alignas(16) float costs[c_Tile];
+        for (std::size_t first = begin; first < end; first += c_Tile)
+        {
+            ScanTile(_features.data() + first * _dims, query, _dims, costs);
+            for (std::size_t i = 0; i < std::min(c_Tile, end - first); ++i)
+                if (IsBetter(costs[i], _order[first + i], best)) best = Match { _order[first + i], costs[i] };
+        }
+    }
+
+    MotionDatabase::Match MotionDatabase::SearchBruteForce(float const * query, bool const parallel) const
+    {
+        Match best;
+        if (! parallel || _frames <= c_ParallelChunk)
+        {
+            ScanSlots(query, 0, _frames, best);
+            return best;
+        }
+
+        std::vector<Match> results((_frames + c_ParallelChunk - 1) / c_ParallelChunk);
+        Engine::ThreadPool::Global().ParallelFor(results.size(), 1, [&](std::size_t const begin, std::size_t const end) {
+            for (std::size_t c = begin; c < end; ++c)
+                ScanSlots(query, c * c_ParallelChunk, std::min<std::size_t>(_frames, (c + 1) * c_ParallelChunk), results[c]);
+        });
+        for (auto const & result : results)
+            if (IsBetter(result.Cost, result.Frame, best)) best = result;
+        return best;
+    }
+
+    MotionDatabase::Match MotionDatabase::Search(float const * query) const
+    {
+        Match best;
+        if (_nodes.empty()) return best;
+
+        // Depth first, nearer child first, skipping subtrees whose box is farther than the best match
+        struct Entry
+        {
+            std::uint32_t   Node;
+            float           Bound;
+        };
+        Entry       stack[2 * c_MaxDepth];
+        std::size_t top = 0;
+        stack[top++]    = { 0, 0.f };
+        while (top > 0)
+        {
+            Entry const entry = stack[--top];
+            if (entry.Bound > best.Cost) continue;
+
+            Node const & node = _nodes[entry.Node];
+            if (node.Right == 0)
+            {
+                ScanSlots(query, node.Begin, node.End, best);
+                continue;
+            }
+
+            std::uint32_t const left   = entry.Node + 1;
+            float const *       bounds = _bounds.data();
+            float const         near   = BoxDistance(bounds + std::size_t(left) * 2 * _dims, bounds + (std::size_t(left) * 2 + 1) * _dims, query, _dims, best.Cost);
+            float const         far    = BoxDistance(bounds + std::size_t(node.Right) * 2 * _dims, bounds + (std::size_t(node.Right) * 2 + 1) * _dims, query, _dims, best.Cost);
+            Entry const         a { left, near }, b { node.Right, far };
+            Entry const &       first  = near <= far ? a : b;
+            Entry const &       second = near <= far ? b : a;
+            if (second.Bound <= best.Cost) stack[top++] = second;
+            if (first.Bound <= best.Cost) stack[top++] = first;
+        }
+        return best;
+    }
+
+    bool MotionDatabase::Save(std::filesystem::path const & path) const
+    {
+        return WriteFileAtomic(path, [this](std::ostream & file) {
+            auto write  = [&file](auto const & value) { file.write(reinterpret_cast<char const *>(&value), sizeof(value)); };
+            auto string = [&](std::string const & value) {
+                write(std::uint32_t(value.size()));
+                file.write(value.data(), value.size());
+            };
+            auto array = [&file](auto const & values) { file.write(reinterpret_cast<char const *>(values.data()), values.size() * sizeof(values[0])); };
+
+            write(c_DatabaseMagic);
+            write(c_DatabaseVersion);
+            write(std::uint32_t(_settings.Joints.size()));
+            for (auto const & joint : _settings.Joints) string(joint);
+            write(std::uint32_t(_settings.TrajectoryTimes.size()));
+            array(_settings.TrajectoryTimes);
+            write(_settings.PositionWeight);
+            write(_settings.VelocityWeight);
+            write(_settings.RootVelocityWeight);
+            write(_settings.TrajectoryPositionWeight);
+            write(_settings.TrajectoryDirectionWeight);
+
+            write(_dims);
+            write(_frames);
+            write(std::uint32_t(_ranges.size()));
+            for (auto const & range : _ranges)
+            {
+                string(range.Name);
+                write(range.Start);
+                write(range.Frames);
+                write(range.FrameTime);
+            }
+            array(_mean);
+            array(_scale);
+            // Frames in tree order, the tree shape follows from the frame count
+            array(_order);
+            array(_features);
+        });
+    }
+
+    std::shared_ptr<MotionDatabase const> MotionDatabase::Load(std::filesystem::path const & path)
+    {
+        std::ifstream file(path, std::ios::binary);
+        if (! file.is_open()) return nullptr;
+
+        auto read   = [&file](auto & value) { file.read(reinterpret_cast<char *>(&value), sizeof(value)); };
+        auto string = [&](std::string & value) {
+            std::uint32_t size = 0;
+            read(size);
+            if (! file || size > (1u << 16)) return false;
+            value.resize(size);
+            file.read(value.data(), size);
+            return bool(file);
+        };
+        auto array = [&file](auto & values) { file.read(reinterpret_cast<char *>(values.data()), values.size() * sizeof(values[0])); };
+
+        std::uint32_t magic = 0, version = 0, count = 0;
+        read(magic);
+        read(version);
+        if (! file || magic != c_DatabaseMagic || version != c_DatabaseVersion) return nullptr;
+
+        MotionFeatureSettings settings;
+        read(count);
+        if (! file || count > 256) return nullptr;
+        settings.Joints.resize(count);
+        for (auto & joint : settings.Joints)
+            if (! string(joint)) return nullptr;
+        read(count);
+        if (! file || count > 256) return nullptr;
+        settings.TrajectoryTimes.resize(count);
+        array(settings.TrajectoryTimes);
+        read(settings.PositionWeight);
+        read(settings.VelocityWeight);
+        read(settings.RootVelocityWeight);
+        read(settings.TrajectoryPositionWeight);
+        read(settings.TrajectoryDirectionWeight);
+
+        auto          db   = std::make_shared<MotionDatabase>();
+        std::uint32_t dims = 0;
+        db->Initialize(settings);
+        read(dims);
+        read(db->_frames);
+        read(count);
+        if (! file || dims != db->_dims) return nullptr;
+
+        for (std::uint32_t i = 0; i < count; ++i)
+        {
+            Range range;
+            if (! string(range.Name)) return nullptr;
+            read(range.Start);
+            read(range.Frames);
+            read(range.FrameTime);
+            if (! file || range.Start + std::uint64_t(range.Frames) > db->_frames) return nullptr;
+            db->_ranges.push_back(std::move(range));
+        }
+
+        db->_mean.resize(dims);
+        db->_scale.resize(dims);
+        db->_order.resize(db->_frames);
+        db->_features.resize((std::size_t(db->_frames) + c_Tile - 1) / c_Tile * c_Tile * dims);
+        array(db->_mean);
+        array(db->_scale);
+        array(db->_order);
+        array(db->_features);
+        if (! file) return nullptr;
+        for (std::uint32_t const frame : db->_order)
+            if (frame >= db->_frames) return nullptr;
+
+        db->BuildTree();
+        db->BuildBounds();
+        return db;
+    }
+}
@@ -0,0 +1,110 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <string>
+#include <vector>
+#include <glm/glm.hpp>
+#include <glm/ext/quaternion_float.hpp>
+
+#include "Labs/FinalProject/Clip.h"
+#include "Labs/FinalProject/ClipLibrary.h"
+
+namespace VCX::Labs::FinalProject
+{
+    // What a frame's feature vector holds. Everything is expressed in the character's ground frame:
+    // the root projected onto the floor, turned so that its heading is +Z.
+    struct MotionFeatureSettings
+    {
+        std::vector<std::string>    Joints          { "LeftFoot", "RightFoot" };    // Position and velocity each
+        std::vector<float>          TrajectoryTimes { 1.f / 3.f, 2.f / 3.f, 1.f };  // Seconds ahead, root position and heading
+
+        float   PositionWeight            = 1.f;
+        float   VelocityWeight            = 1.f;
+        float   RootVelocityWeight        = 1.f;
+        float   TrajectoryPositionWeight  = 1.f;
+        float   TrajectoryDirectionWeight = 1.5f;
+    };
+
+    // Per-frame features of a set of clips for motion matching. Features are normalized per group
+    // (each joint position, each velocity, the trajectory positions, ...) and stored in tiles of
+    // 16 frames, feature by feature within a tile, so one feature of a tile is a SIMD row and a
+    // tile is one contiguous read. Frames are ordered by a KD-tree whose leaves are tiles, and the
+    // bounding boxes of its nodes let the accelerated search skip most of the database.
+    class MotionDatabase
+    {
+    public:
+        // Frames [Start, Start + Frames) of the database come from this clip.
+        struct Range
+        {
+            std::string     Name;
+            std::uint32_t   Start     = 0;
+            std::uint32_t   Frames    = 0;
+            float           FrameTime = 0.f;
+        };
+
+        struct Match
+        {
+            std::uint32_t   Frame = std::numeric_limits<std::uint32_t>::max();
+            float           Cost  = std::numeric_limits<float>::infinity();     // Squared distance in normalized space
+        };
+
+        // Featurizes clips in parallel. Clips missing one of the feature joints are skipped.
+        static std::shared_ptr<MotionDatabase const> Build(std::vector<std::string> const & names, ClipSource const & source, MotionFeatureSettings const & settings = { });
+
+        // nullptr if the file is missing or was written by another version.
+        static std::shared_ptr<MotionDatabase const> Load(std::filesystem::path const & path);
+        bool                                         Save(std::filesystem::path const & path) const;
+
+        std::uint32_t                   GetFrameCount() const { return _frames; }
+        std::uint32_t                   GetDimensionCount() const { return _dims; }
+        std::uint32_t                   GetTrajectoryOffset() const { return _trajectoryOffset; } // First trajectory feature
+        MotionFeatureSettings const &   GetSettings() const { return _settings; }
+        std::vector<Range> const &      GetRanges() const { return _ranges; }
+        Range const &                   FindRange(std::uint32_t const frame) const;
+
+        // Raw features of `frame` before normalization, false if a feature joint is missing. `positions`
+        // and `rotations` hold the global joint transforms of all `frames` frames, see ForwardKinematics.
+        bool ComputeFeatures(SkeletonDef const & def, float const frameTime, std::uint32_t const frames, glm::vec3 const * positions, glm::quat const * rotations, std::uint32_t const frame, float * out) const;
+        void Normalize(float * features) const;
+        void GetFeatures(std::uint32_t const frame, float * out) const;             // Normalized
+
+        // Nearest frame to a normalized query, scanning every frame with the SIMD kernel.
+        Match SearchBruteForce(float const * query, bool const parallel = true) const;
+        // Same result, descending the KD-tree nearer child first and skipping subtrees whose bounding
+        // box is farther than the best match so far.
+        Match Search(float const * query) const;
+
+    private:
+        // A KD-tree node over the slots [Begin, End); the left child directly follows its parent.
+        struct Node
+        {
+            std::uint32_t   Begin = 0;
+            std::uint32_t   End   = 0;
+            std::uint32_t   Right = 0;      // 0 for leaves, which are single tiles
+        };
+
+        void Initialize(MotionFeatureSettings const & settings);
+        void BuildTree();
+        void Partition(std::vector<float> const & points);
+        void BuildBounds();
+        void ScanSlots(float const * query, std::size_t const begin, std::size_t const end, Match & best) const;
+
+        MotionFeatureSettings               _settings;
+        std::uint32_t                       _dims             = 0;
+        std::uint32_t                       _trajectoryOffset = 0;
+        std::uint32_t                       _frames           = 0;
+        std::vector<float>                  _mean;
+        std::vector<float>                  _scale;             // Group weight over group deviation
+        std::vector<Range>                  _ranges;
+        std::vector<std::uint32_t>          _order;             // Frame stored in each slot, in tree order
+        std::vector<std::uint32_t>          _slots;             // Slot of each frame
+        std::vector<float>                  _features;          // Normalized, by slot in tiles of 16, feature by feature within a tile
+        std::vector<Node>                   _nodes;             // Depth first
+        std::vector<std::vector<std::uint32_t>> _levels;        // Nodes by depth
+        std::vector<float>                  _bounds;            // Min then max row of _dims per node
+    };
+}
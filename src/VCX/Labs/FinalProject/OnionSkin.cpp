@@ -0,0 +1,103 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+#include "Labs/FinalProject/OnionSkin.h"
+
+namespace VCX::Labs::FinalProject
+{
+    static constexpr float c_NearAlpha = .6f;   // Of the ghosts next to the frame
+    static constexpr float c_FarAlpha  = .1f;   // At the edge of the window
+
+    OnionSkin::OnionSkin() :
+        _program(
+            Engine::GL::UniqueProgram({
+                Engine::GL::SharedShader("assets/shaders/ghost.vert"),
+                Engine::GL::SharedShader("assets/shaders/ghost.frag")})),
+        _bones(Engine::GL::VertexLayout().Add<float>("joint", Engine::GL::DrawFrequency::Static, 0), Engine::GL::PrimitiveType::Lines),
+        _poses(0),
+        _ghosts(GL_RGBA32F, 1)
+    {
+        FrameUniforms::Bind(_program);
+        _program.GetUniforms().SetByName("u_Poses", int(_poses.GetUnit()));
+        _program.GetUniforms().SetByName("u_Ghosts", int(_ghosts.GetUnit()));
+        _program.GetUniforms().SetByName("u_NearAlpha", c_NearAlpha);
+        _program.GetUniforms().SetByName("u_FarAlpha", c_FarAlpha);
+    }
+
+    void OnionSkin::Bind(std::shared_ptr<Clip const> const & clip)
+    {
+        if (clip == _clip) return;
+        _clip = clip;
+        _table.clear();
+        if (! clip || clip->Frames == 0)
+        {
+            _baked.reset();
+            return;
+        }
+
+        // As captured, the placement of the shown frame is applied as an offset
+        _baked = BakedClip::Bake(*clip);
+        _poses.Build({ _baked }, false);
+
+        auto const &       skeleton = *_baked->Skeleton;
+        std::vector<float> joints;
+        for (std::uint32_t j = 0; j < skeleton.GetJointCount(); ++j)
+        {
+            if (skeleton.Parents[j] < 0) continue;
+            joints.push_back(float(skeleton.Parents[j]));
+            joints.push_back(float(j));
+        }
+        _bones.UpdateVertexBuffer("joint", Engine::make_span_bytes<float>(joints));
+        _program.GetUniforms().SetByName("u_Joints", int(skeleton.GetJointCount()));
+    }
+
+    void OnionSkin::Update(std::uint32_t const frame, glm::vec3 const & root)
+    {
+        _table.clear();
+        if (! _baked || _poses.IsEmpty()) return;
+
+        auto const start = std::chrono::steady_clock::now();
+
+        // Offset of the shown pose from the captured one, e.g. under accumulated root motion
+        Pose                   pose;
+        std::vector<glm::vec3> positions(_baked->Skeleton->GetJointCount());
+        std::vector<glm::quat> rotations(positions.size());
+        _baked->SampleFrame(std::min(frame, _baked->Frames - 1), pose);
+        ForwardKinematics(*_baked->Skeleton, pose, positions.data(), rotations.data());
+        _offset = root - positions[0];
+
+        // The buffer may hold every n-th frame only, ghosts take the nearest stored one
+        PoseBuffer::Range const & range = _poses.GetRanges().front();
+        int const                 step  = std::max(1, Step);
+        int const                 reach = int(Window / _baked->FrameTime);
+        for (int k = -reach / step; k <= reach / step; ++k)
+        {
+            std::int64_t const f = std::int64_t(frame) + std::int64_t(k) * step;
+            if (k == 0 || f < 0 || f >= _baked->Frames || (k < 0 && ! Past) || (k > 0 && ! Future)) continue;
+            std::uint32_t const stored = std::min(std::uint32_t(std::lround(f * _baked->FrameTime / range.FrameTime)), range.Frames - 1);
+            _table.emplace_back(float(range.First + stored), float(k * step) * _baked->FrameTime / Window, 0.f, 0.f);
+        }
+        if (! _table.empty()) _ghosts.Update(Engine::make_span_bytes<glm::vec4>(_table), Engine::GL::DrawFrequency::Stream);
+        _updateMs = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    void OnionSkin::Render()
+    {
+        if (_table.empty()) return;
+        auto const start = std::chrono::steady_clock::now();
+        _program.GetUniforms().SetByName("u_PastColor", PastColor);
+        _program.GetUniforms().SetByName("u_FutureColor", FutureColor);
+
+        auto & uniforms = FrameUniforms::Global();
+        Engine::GL::State::Enable(GL_BLEND);
+        Engine::GL::State::BlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+        Engine::GL::State::LineWidth(1.f);
+        _bones.Draw({ _program.Use(), _poses.Use(), _ghosts.Use(), uniforms.Use(uniforms.Queue({ .Offset = glm::vec4(_offset, 0.f) })) }, 0, 0, GetGhostCount());
+        Engine::GL::State::Disable(GL_BLEND);
+
+        // CPU side only, the GPU work is queued
+        float const ms = _updateMs + std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+        _ms            = _ms == 0.f ? ms : .9f * _ms + .1f * ms;
+    }
+}
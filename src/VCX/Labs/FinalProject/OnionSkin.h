@@ -0,0 +1,51 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "Engine/GL/Program.h"
+#include "Engine/GL/RenderItem.h"
+#include "Engine/GL/TextureBuffer.hpp"
+#include "Labs/FinalProject/Clip.h"
+#include "Labs/FinalProject/FrameUniforms.h"
+#include "Labs/FinalProject/PoseBuffer.h"
+
+namespace VCX::Labs::FinalProject
+{
+    // Past and future poses of the shown clip, drawn around it as skeletons fading with their
+    // distance in time. The clip is baked into a PoseBuffer once when bound; per frame only the
+    // ghost table changes, one texel per ghost, and all ghosts take one instanced draw.
+    class OnionSkin
+    {
+    public:
+        OnionSkin();
+
+        void Bind(std::shared_ptr<Clip const> const & clip); // Bakes the clip unless it is bound already
+        // Ghosts every Step frames around `frame`, moved so that the frame's root lands on `root`.
+        void Update(std::uint32_t const frame, glm::vec3 const & root);
+        void Render();  // With the camera of FrameUniforms
+
+        std::uint32_t GetGhostCount() const { return std::uint32_t(_table.size()); }
+        std::size_t   GetByteSize() const { return _poses.GetByteSize(); }
+        float         GetMs() const { return _ms; }
+
+        float       Window      = 1.f;  // Seconds before and after the frame
+        int         Step        = 10;   // Frames between ghosts
+        bool        Past        = true;
+        bool        Future      = true;
+        glm::vec3   PastColor   { .35f, .6f, 1.f };
+        glm::vec3   FutureColor { 1.f, .55f, .3f };
+
+    private:
+        Engine::GL::UniqueProgram           _program;
+        Engine::GL::UniqueRenderItem        _bones;     // Joint index pairs
+        PoseBuffer                          _poses;
+        Engine::GL::UniqueTextureBuffer     _ghosts;    // (buffer frame, signed distance in time over Window, 0, 0)
+        std::shared_ptr<Clip const>         _clip;
+        std::shared_ptr<BakedClip const>    _baked;
+        std::vector<glm::vec4>              _table;
+        glm::vec3                           _offset    { 0.f };
+        float                               _updateMs  = 0.f;
+        float                               _ms        = 0.f;   // Smoothed update and draw submission time
+    };
+}
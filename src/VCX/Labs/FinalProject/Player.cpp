@@ -1,9 +1,23 @@
+#include <algorithm>
+#include <cmath>
+
 #include "Labs/FinalProject/Player.h"
+#include "Labs/FinalProject/Pose.h"
 
 namespace VCX::Labs::FinalProject
 {
     Action::Action(){}
 
+    void Action::Bind(std::shared_ptr<Clip const> motion)
+    {
+        Motion     = std::move(motion);
+        Frames     = Motion ? Motion->Frames : 0;
+        FrameTime  = Motion ? Motion->FrameTime : 0.f;
+        LoopRange  = { };
+        Trajectory = nullptr;
+        Reset();
+    }
+
     void Action::Load(Skeleton & skeleton, const float dt)
     {
         // TimeIndex += 1;
@@ -12,71 +26,142 @@ namespace VCX::Labs::FinalProject
         // Play(skeleton.Root, FrameParams.at(TimeIndex), idx);
         // skeleton.ForwardKinematics();
 
+        // Only the latest frame is visible, intermediate ones need not be posed
+        if (Advance(dt)) Apply(skeleton, GetFrame());
+    }
+
+    bool Action::Advance(const float dt)
+    {
+        if (Frames == 0) return false;
+
         TotalTime += dt;
         std::uint32_t frame = TotalTime/FrameTime;
+        if (Loop && LoopRange.IsValid() && frame > LoopRange.Out)
+        {
+            // Continue from In, keeping the time past the jump
+            while (frame > LoopRange.Out)
+            {
+                Wrap(LoopRange.Out, LoopRange.In);
+                TotalTime -= (LoopRange.Out - LoopRange.In) * FrameTime;
+                frame      = TotalTime/FrameTime;
+            }
+            TimeIndex = frame;
+            return true;
+        }
         if (frame >= Frames)
         {
-            Reset();
-            TotalTime += dt;
+            if (! Loop)
+            {
+                bool const changed = TimeIndex < Frames;
+                TimeIndex = Frames;
+                return changed;
+            }
+            // From the start again, the accumulated trajectory continues from the end
+            Wrap(Frames, 0);
+            TimeIndex = 0;
+            TotalTime = dt;
             frame = TotalTime/FrameTime;
         }
-        for (; TimeIndex < frame; ++TimeIndex)
+
+        if (TimeIndex < frame)
         {
-            std::uint32_t idx = 0;
-            Play(skeleton.Root, FrameParams.at(TimeIndex), idx);
-            skeleton.ForwardKinematics();
-        } 
+            TimeIndex = frame;
+            return true;
+        }
+        return false;
+    }
+
+    void Action::Apply(Skeleton & skeleton, std::uint32_t const frame)
+    {
+        Play(skeleton, Motion->GetFrame(std::min(frame, Frames - 1)));
+        if (Loop && LoopRange.IsValid() && frame < LoopRange.Out && frame + LoopRange.Blend >= LoopRange.Out) Fade(skeleton, frame);
+        Place(skeleton, frame);
+        skeleton.ForwardKinematics();
     }
 
     void Action::Reset()
     {
         TimeIndex = 0;
         TotalTime = 0.f;
+        HasOrigin = false;
     }
 
-    void Action::Play(Joint *ptr, const std::vector<float>& params, std::uint32_t & idx)
+    void Action::Seek(std::uint32_t const frame)
     {
-        if (idx == 0)
-        {
-            // Position
-            for (std::uint32_t i = 0; i < 3; ++i)
-                ptr->LocalOffset[ptr->PositionIdx[i]] = params.at(idx + i);
-            idx += 3;
-            // Rotation
-            glm::mat4 res { 1.0f };
-            for (std::uint32_t i = 0; i < 3; ++i)
-            {
-                glm::vec3 axis = { 0.f, 0.f, 0.f };
-                axis[ptr->RotationIdx[i]] = 1.f;
-                res *= glm::rotate(glm::radians(params.at(idx+i)), axis);
-            }
-            ptr->LocalRotation = glm::quat_cast(res);
-            idx += 3;
-        }
-        else if (ptr->Name == EndSiteName)
+        // TimeIndex runs one past the frame shown, see GetFrame
+        TimeIndex = std::min(frame + 1, Frames);
+        TotalTime = TimeIndex * FrameTime;
+    }
+
+    void Action::Play(Skeleton & skeleton, float const * params)
+    {
+        SkeletonDef const & def = *Motion->Skeleton;
+        for (std::uint32_t i = 0; i < skeleton.Joints.size(); ++i)
         {
-            return;
+            if (def.Channels[i] == 0) continue;
+            Joint * ptr = skeleton.Joints[i];
+            if (def.Channels[i] == 6) ptr->LocalOffset = def.GetLocalOffset(i, params);
+            ptr->LocalRotation = def.GetLocalRotation(i, params);
         }
-        else
+    }
+
+    // Blends towards the frame as far before In as this one is before Out. That frame is moved onto
+    // this one's ground position and heading first, so that the fade only changes the pose.
+    void Action::Fade(Skeleton & skeleton, std::uint32_t const frame)
+    {
+        SkeletonDef const & def    = *Motion->Skeleton;
+        float const *       out    = Motion->GetFrame(frame);
+        float const *       in     = Motion->GetFrame(frame - (LoopRange.Out - LoopRange.In));
+        float const         weight = float(frame + LoopRange.Blend + 1 - LoopRange.Out) / (LoopRange.Blend + 1);
+
+        auto heading = [](glm::quat const & rotation) {
+            glm::vec3 const forward = rotation * glm::vec3(0.f, 0.f, 1.f);
+            return glm::angleAxis(std::atan2(forward.x, forward.z), glm::vec3(0.f, 1.f, 0.f));
+        };
+        glm::quat const align = heading(def.GetLocalRotation(0, out)) * glm::inverse(heading(def.GetLocalRotation(0, in)));
+        for (std::uint32_t i = 0; i < skeleton.Joints.size(); ++i)
         {
-            // Rotation
-            glm::mat4 res { 1.0f };
-            for (std::uint32_t i = 0; i < 3; ++i)
+            if (def.Channels[i] == 0) continue;
+            Joint *   ptr      = skeleton.Joints[i];
+            glm::quat rotation = def.GetLocalRotation(i, in);
+            if (def.Channels[i] == 6)
             {
-                glm::vec3 axis = { 0.f, 0.f, 0.f };
-                axis[ptr->RotationIdx[i]] = 1.f;
-                res *= glm::rotate(glm::radians(params.at(idx+i)), axis);
+                glm::vec3 offset = def.GetLocalOffset(i, in);
+                if (i == 0)
+                {
+                    glm::vec3 const from = def.GetLocalOffset(0, in);
+                    glm::vec3 const to   = def.GetLocalOffset(0, out);
+                    offset               = align * (offset - glm::vec3(from.x, 0.f, from.z)) + glm::vec3(to.x, 0.f, to.z);
+                    rotation             = align * rotation;
+                }
+                ptr->LocalOffset = glm::mix(ptr->LocalOffset, offset, weight);
             }
-            ptr->LocalRotation = glm::quat_cast(res);
-            idx += 3;
+            ptr->LocalRotation = glm::slerp(ptr->LocalRotation, rotation, weight);
         }
+    }
 
-
-        Joint *NextPtr = ptr->ChiPtr;
-        while(NextPtr != nullptr)
+    // Moves the root from the trajectory onto the placement, either at every frame (in place) or
+    // once for the whole clip, shifted at each loop (accumulated).
+    void Action::Place(Skeleton & skeleton, std::uint32_t const frame)
+    {
+        if (Root == RootMode::Captured || ! Trajectory || Trajectory->GetFrameCount() != Frames) return;
+        if (! HasOrigin)
         {
-            Play(NextPtr, params, idx);
-            NextPtr = NextPtr->BroPtr;
+            Origin    = Trajectory->At(0).Inverse();
+            HasOrigin = true;
         }
+
+        GroundTransform const placement { Placement.Position / SceneScale, Placement.Heading };
+        GroundTransform const transform = placement * (Root == RootMode::InPlace ? Trajectory->At(std::min(frame, Frames - 1)).Inverse() : Origin);
+        Joint *               root      = skeleton.Joints[0];
+        root->LocalOffset               = transform.Apply(root->LocalOffset);
+        root->LocalRotation             = transform.GetRotation() * root->LocalRotation;
+    }
+
+    // Frame `to` is shown where frame `from` would have been.
+    void Action::Wrap(std::uint32_t const from, std::uint32_t const to)
+    {
+        if (! HasOrigin || ! Trajectory || Trajectory->GetFrameCount() != Frames) return;
+        Origin = Origin * Trajectory->At(from) * Trajectory->At(to).Inverse();
     }
-}
\ No newline at end of file
+}
@@ -2,6 +2,9 @@
 
 #include <vector>
 #include <string>
+#include "Labs/FinalProject/Clip.h"
+#include "Labs/FinalProject/LoopPoints.h"
+#include "Labs/FinalProject/RootMotion.h"
 #include "Labs/FinalProject/Skeleton.h"
 #include <glm/glm.hpp>
 #include <glm/ext/quaternion_float.hpp>
@@ -11,23 +14,47 @@
 
 namespace VCX::Labs::FinalProject 
 {
+    enum class RootMode
+    {
+        Captured,       // The root track as recorded
+        InPlace,        // The residual of the root motion only, standing on Placement
+        Accumulated,    // The trajectory from Placement on, continued across loops instead of jumping back
+    };
+
     struct Action
     {    
         Action();
 
+        void Bind(std::shared_ptr<Clip const> motion); // Play another clip from its first frame
         void Load(Skeleton &, const float);
+        bool Advance(const float);                         // Step playback time only, true when the frame changed
+        void Apply(Skeleton &, std::uint32_t const frame); // Pose the skeleton at a frame, without touching playback time
         void Reset();
+        void Seek(std::uint32_t const frame);              // Show a frame next and continue playback from it
+
+        std::uint32_t GetFrame() const { return TimeIndex ? TimeIndex - 1 : 0; } // Frame currently shown
+        float         GetTime() const { return TotalTime; }
+        bool          IsFinished() const { return ! Loop && Frames > 0 && TimeIndex >= Frames; }
 
 
-        std::vector<std::vector<float>>     FrameParams;
+        std::shared_ptr<Clip const>         Motion;
         std::uint32_t                       TimeIndex = 0;
-        std::uint32_t                       Frames;
-        float                               FrameTime;
+        std::uint32_t                       Frames    = 0;
+        float                               FrameTime = 0.f;
+        bool                                Loop      = true;  // Otherwise hold the last frame at the end
+        LoopPoints                          LoopRange;         // When valid, looping jumps from Out back to In with a crossfade
+        std::shared_ptr<RootMotion const>   Trajectory;        // Root motion of Motion, cleared in Bind; without it the root is as captured
+        RootMode                            Root      = RootMode::Captured;
+        GroundTransform                     Placement;         // Per instance, scene units; the clip's first frame lands on it when accumulated
 
     private:
-        void Play(Joint*, const std::vector<float> &, std::uint32_t &);
+        void Play(Skeleton &, float const *);
+        void Fade(Skeleton &, std::uint32_t const frame);
+        void Place(Skeleton &, std::uint32_t const frame);
+        void Wrap(std::uint32_t const from, std::uint32_t const to); // Playback jumps back, the trajectory continues
 
         float                               TotalTime = 0.f;
-        const std::string                   EndSiteName = "???";
+        GroundTransform                     Origin;            // Maps the trajectory onto Placement when accumulated
+        bool                                HasOrigin = false;
     };
 }
\ No newline at end of file
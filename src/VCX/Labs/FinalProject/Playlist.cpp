@@ -0,0 +1,324 @@
+#include <algorithm>
+
+#include <spdlog/spdlog.h>
+
+#include "Labs/FinalProject/Playlist.h"
+
+namespace VCX::Labs::FinalProject
+{
+    Playlist::Playlist()
+    {
+        _worker = std::thread([this]() { Work(); });
+    }
+
+    Playlist::~Playlist()
+    {
+        {
+            std::lock_guard lock(_mutex);
+            _stopping = true;
+        }
+        _wake.notify_all();
+        _worker.join();
+    }
+
+    void Playlist::Add(std::string const & path)
+    {
+        {
+            std::lock_guard lock(_mutex);
+            _items.push_back(path);
+        }
+        Wake();
+    }
+
+    void Playlist::Remove(std::size_t const index)
+    {
+        if (index >= _items.size()) return;
+        {
+            std::lock_guard lock(_mutex);
+            _items.erase(_items.begin() + index);
+            if (index == _current)
+            {
+                _waiting = true;
+                _fading  = false;
+            }
+            if (index < _current || _current >= _items.size()) _current = _current > 0 ? _current - 1 : 0;
+        }
+        Wake();
+    }
+
+    void Playlist::Swap(std::size_t const a, std::size_t const b)
+    {
+        if (a >= _items.size() || b >= _items.size()) return;
+        {
+            std::lock_guard lock(_mutex);
+            std::swap(_items[a], _items[b]);
+            if (_current == a) _current = b;
+            else if (_current == b) _current = a;
+            _fading = false;
+        }
+        Wake();
+    }
+
+    void Playlist::Clear()
+    {
+        {
+            std::lock_guard lock(_mutex);
+            _items.clear();
+            _current = 0;
+            _waiting = true;
+            _fading  = false;
+        }
+        Wake();
+    }
+
+    void Playlist::Start(std::size_t const index)
+    {
+        if (index >= _items.size()) return;
+        {
+            std::lock_guard lock(_mutex);
+            _current = index;
+            _waiting = true;
+            _fading  = false;
+        }
+        Wake();
+    }
+
+    void Playlist::SetLoop(bool const loop)
+    {
+        {
+            std::lock_guard lock(_mutex);
+            _loop = loop;
+        }
+        Wake();
+    }
+
+    void Playlist::SetLookahead(std::uint32_t const count)
+    {
+        {
+            std::lock_guard lock(_mutex);
+            _lookahead = count;
+        }
+        Wake();
+    }
+
+    void Playlist::SetBudget(std::size_t const bytes)
+    {
+        {
+            std::lock_guard lock(_mutex);
+            _budget = bytes;
+        }
+        Wake();
+    }
+
+    bool Playlist::IsReady(std::string const & path) const
+    {
+        std::lock_guard lock(_mutex);
+        return std::any_of(_cache.begin(), _cache.end(), [&](Entry const & e) { return e.Path == path; });
+    }
+
+    std::size_t Playlist::GetCachedBytes() const
+    {
+        std::lock_guard lock(_mutex);
+        std::size_t bytes = 0;
+        for (auto const & e : _cache) bytes += e.Bytes;
+        return bytes;
+    }
+
+    std::size_t Playlist::GetNext() const
+    {
+        if (_current + 1 < _items.size()) return _current + 1;
+        return _loop && ! _items.empty() ? 0 : _items.size();
+    }
+
+    bool Playlist::Update(Skeleton & skeleton, float const dt)
+    {
+        if (_items.empty()) return false;
+
+        bool rebuilt = false;
+        if (_waiting)
+        {
+            auto const clip = Find(_items[_current]);
+            if (! clip) return false;
+            if (! *clip)
+            {
+                // Unreadable item, move on to the next one (or stop at the end)
+                if (std::size_t const next = GetNext(); next < _items.size() && next != _current)
+                {
+                    std::lock_guard lock(_mutex);
+                    _current = next;
+                }
+                Wake();
+                return false;
+            }
+            _action.Bind(*clip);
+            _action.Loop = false;
+            _waiting     = false;
+            if (skeleton.Def != (*clip)->Skeleton)
+            {
+                skeleton.Build((*clip)->Skeleton);
+                rebuilt = true;
+            }
+            _action.Apply(skeleton, 0);
+            Wake();
+        }
+
+        bool changed = _action.Advance(dt);
+
+        // Start fading into the next item once it is within CrossfadeTime of the end
+        std::size_t const next      = GetNext();
+        float const       remaining = _action.Frames * _action.FrameTime - _action.GetTime();
+        if (! _fading && next < _items.size() && (remaining <= CrossfadeTime || _action.IsFinished()))
+        {
+            auto const clip = Find(_items[next]);
+            bool const fade = CrossfadeTime > 0.f && clip && *clip
+                && (*clip)->Skeleton->TopologyHash == _action.Motion->Skeleton->TopologyHash;
+            if (fade)
+            {
+                _incoming.Bind(*clip);
+                _incoming.Loop = false;
+                _fading        = true;
+            }
+            else if (_action.IsFinished() && clip)
+            {
+                {
+                    std::lock_guard lock(_mutex);
+                    _current = next;
+                }
+                _waiting = true;
+                return Update(skeleton, 0.f) || rebuilt;
+            }
+        }
+
+        if (_fading)
+        {
+            _incoming.Advance(dt);
+            float const t = std::clamp(_incoming.GetTime() / CrossfadeTime, 0.f, 1.f);
+            if (t >= 1.f)
+            {
+                _action = _incoming;
+                _fading = false;
+                {
+                    std::lock_guard lock(_mutex);
+                    _current = next;
+                }
+                if (skeleton.Def != _action.Motion->Skeleton)
+                {
+                    skeleton.Build(_action.Motion->Skeleton);
+                    rebuilt = true;
+                }
+                _action.Apply(skeleton, _action.GetFrame());
+                Wake();
+                return rebuilt;
+            }
+
+            // Smoothstep weight, rotations slerped and offsets (bone lengths included) lerped
+            float const         w    = t * t * (3.f - 2.f * t);
+            SkeletonDef const & from = *_action.Motion->Skeleton;
+            SkeletonDef const & to   = *_incoming.Motion->Skeleton;
+            float const *       rowA = _action.Motion->GetFrame(_action.GetFrame());
+            float const *       rowB = _incoming.Motion->GetFrame(_incoming.GetFrame());
+            for (std::uint32_t i = 0; i < skeleton.Joints.size(); ++i)
+            {
+                Joint * ptr        = skeleton.Joints[i];
+                ptr->LocalOffset   = glm::mix(from.GetLocalOffset(i, rowA), to.GetLocalOffset(i, rowB), w);
+                ptr->LocalRotation = glm::slerp(from.GetLocalRotation(i, rowA), to.GetLocalRotation(i, rowB), w);
+            }
+            skeleton.ForwardKinematics();
+            return rebuilt;
+        }
+
+        if (changed || rebuilt) _action.Apply(skeleton, _action.GetFrame());
+        return rebuilt;
+    }
+
+    void Playlist::Wake()
+    {
+        {
+            std::lock_guard lock(_mutex);
+            _dropped.clear();
+        }
+        _wake.notify_one();
+    }
+
+    std::vector<std::string> Playlist::GetWanted() const
+    {
+        std::vector<std::string> wanted;
+        if (_items.empty()) return wanted;
+
+        wanted.push_back(_items[_current]);
+        for (std::size_t i = 1; i <= _lookahead; ++i)
+        {
+            std::size_t const index = _current + i;
+            if (index >= _items.size() && ! _loop) break;
+            auto const & path = _items[index % _items.size()];
+            if (std::find(wanted.begin(), wanted.end(), path) == wanted.end()) wanted.push_back(path);
+        }
+        return wanted;
+    }
+
+    std::string Playlist::GetMissing() const
+    {
+        for (auto const & path : GetWanted())
+        {
+            if (_dropped.count(path)) continue;
+            if (std::none_of(_cache.begin(), _cache.end(), [&](Entry const & e) { return e.Path == path; })) return path;
+        }
+        return { };
+    }
+
+    std::optional<std::shared_ptr<Clip const>> Playlist::Find(std::string const & path)
+    {
+        std::lock_guard lock(_mutex);
+        auto const iter = std::find_if(_cache.begin(), _cache.end(), [&](Entry const & e) { return e.Path == path; });
+        if (iter == _cache.end()) return std::nullopt;
+        _cache.splice(_cache.begin(), _cache, iter);
+        return _cache.front().Motion;
+    }
+
+    void Playlist::Work()
+    {
+        BVHLoader loader;
+        while (true)
+        {
+            std::string path;
+            {
+                std::unique_lock lock(_mutex);
+                _wake.wait(lock, [&]() { return _stopping || ! (path = GetMissing()).empty(); });
+                if (_stopping) return;
+            }
+
+            std::shared_ptr<Clip const> motion;
+            try
+            {
+                motion = loader.LoadClip(path.c_str());
+            }
+            catch (std::exception const & e)
+            {
+                spdlog::warn("Playlist: cannot load \"{}\": {}", path, e.what());
+            }
+            std::size_t const bytes = motion ? sizeof(Clip) + motion->Channels.size() * sizeof(float) : 0;
+
+            std::lock_guard lock(_mutex);
+            _cache.push_front(Entry { .Path = path, .Motion = std::move(motion), .Bytes = bytes });
+
+            // Evict least recently used clips that are not about to play, then drop this one if
+            // it is a lookahead item that still does not fit
+            auto const  wanted = GetWanted();
+            std::size_t total  = 0;
+            for (auto const & e : _cache) total += e.Bytes;
+            for (auto iter = _cache.end(); total > _budget && iter != _cache.begin();)
+            {
+                --iter;
+                if (std::find(wanted.begin(), wanted.end(), iter->Path) != wanted.end()) continue;
+                total -= iter->Bytes;
+                iter = _cache.erase(iter);
+            }
+            bool const urgent = wanted.size() < 2 || path == wanted[0] || path == wanted[1];
+            if (total > _budget && ! urgent)
+            {
+                _cache.pop_front();
+                _dropped.insert(path);
+            }
+        }
+    }
+}
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Labs/FinalProject/BVHLoader.h"
+#include "Labs/FinalProject/Clip.h"
+#include "Labs/FinalProject/Player.h"
+#include "Labs/FinalProject/Skeleton.h"
+
+namespace VCX::Labs::FinalProject
+{
+    // Ordered queue of clips played back to back. The clips after the current one are parsed on a
+    // background thread, within a memory budget, so advancing never loads on the UI thread.
+    class Playlist
+    {
+    public:
+        Playlist();
+        ~Playlist();
+
+        Playlist(Playlist const &)             = delete;
+        Playlist & operator=(Playlist const &) = delete;
+
+        void Add(std::string const & path);
+        void Remove(std::size_t const index);
+        void Swap(std::size_t const a, std::size_t const b);
+        void Clear();
+        void Start(std::size_t const index); // Jump to an item, shown as soon as it is loaded
+
+        // Steps playback and poses the skeleton, rebuilding it when the rig changes. Returns true
+        // when the skeleton was rebuilt, so its index buffer needs to be uploaded again.
+        bool Update(Skeleton & skeleton, float const dt);
+
+        std::vector<std::string> const & GetItems() const { return _items; }
+        std::size_t                      GetCurrent() const { return _current; }
+        Action const &                   GetAction() const { return _action; }
+        bool                             IsWaiting() const { return _waiting; }  // Current item not loaded yet
+        bool                             IsFading() const { return _fading; }
+        bool                             IsReady(std::string const & path) const;
+        std::size_t                      GetCachedBytes() const;
+
+        // Settings read by the prefetch thread
+        bool                             GetLoop() const { return _loop; }
+        std::uint32_t                    GetLookahead() const { return _lookahead; }
+        std::size_t                      GetBudget() const { return _budget; }
+        void                             SetLoop(bool const loop);
+        void                             SetLookahead(std::uint32_t const count);
+        void                             SetBudget(std::size_t const bytes);
+
+        float                            CrossfadeTime = 0.f; // Seconds, 0 cuts between clips
+
+    private:
+        struct Entry
+        {
+            std::string                 Path;
+            std::shared_ptr<Clip const> Motion;  // nullptr if the file could not be loaded
+            std::size_t                 Bytes = 0;
+        };
+
+        void                        Work();
+        void                        Wake();
+        std::vector<std::string>    GetWanted() const;   // Current item first, then the lookahead, under _mutex
+        std::string                 GetMissing() const;  // Next wanted item to load, empty if none, under _mutex
+        std::size_t                 GetNext() const;     // Item after the current one, _items.size() at the end
+
+        // std::nullopt while loading, nullptr if the file could not be loaded.
+        std::optional<std::shared_ptr<Clip const>> Find(std::string const & path);
+
+        std::vector<std::string>    _items;
+        std::size_t                 _current = 0;
+        Action                      _action;
+        Action                      _incoming;
+        bool                        _waiting = true;
+        bool                        _fading  = false;
+
+        mutable std::mutex          _mutex;
+        std::condition_variable     _wake;
+        std::list<Entry>            _cache;         // Most recently used first
+        std::set<std::string>       _dropped;       // Over budget, not retried until the wanted items change
+        bool                        _loop      = true;
+        std::uint32_t               _lookahead = 2;
+        std::size_t                 _budget    = 64 << 20; // Prefetched clips beyond the next one are dropped over this
+        bool                        _stopping  = false;
+        std::thread                 _worker;
+    };
+}
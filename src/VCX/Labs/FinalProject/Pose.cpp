@@ -0,0 +1,107 @@
+#include <algorithm>
+#include <cmath>
+
+#include "Labs/FinalProject/Pose.h"
+
+namespace VCX::Labs::FinalProject
+{
+    void Pose::Resize(std::uint32_t const joints)
+    {
+        Rotations.resize(joints, glm::quat(1.f, 0.f, 0.f, 0.f));
+        Offsets.resize(joints, glm::vec3(0.f));
+    }
+
+    std::shared_ptr<BakedClip const> BakedClip::Bake(Clip const & clip)
+    {
+        auto                baked  = std::make_shared<BakedClip>();
+        SkeletonDef const & def    = *clip.Skeleton;
+        std::uint32_t const joints = def.GetJointCount();
+
+        baked->Skeleton  = clip.Skeleton;
+        baked->Frames    = clip.Frames;
+        baked->FrameTime = clip.FrameTime;
+        baked->Rotations.resize(std::size_t(clip.Frames) * joints);
+        baked->Offsets.resize(std::size_t(clip.Frames) * joints);
+        for (std::uint32_t f = 0; f < clip.Frames; ++f)
+        {
+            float const * row = clip.GetFrame(f);
+            for (std::uint32_t j = 0; j < joints; ++j)
+            {
+                baked->Rotations[std::size_t(f) * joints + j] = def.GetLocalRotation(j, row);
+                baked->Offsets[std::size_t(f) * joints + j]   = def.GetLocalOffset(j, row);
+            }
+        }
+        return baked;
+    }
+
+    void BakedClip::SampleFrame(std::uint32_t const frame, Pose & out) const
+    {
+        std::uint32_t const joints = Skeleton->GetJointCount();
+        std::size_t const   base   = std::size_t(std::min(frame, Frames - 1)) * joints;
+        out.Resize(joints);
+        std::copy_n(Rotations.begin() + base, joints, out.Rotations.begin());
+        std::copy_n(Offsets.begin() + base, joints, out.Offsets.begin());
+    }
+
+    void BakedClip::Sample(float const time, bool const loop, Pose & out) const
+    {
+        std::uint32_t const joints = Skeleton->GetJointCount();
+        out.Resize(joints);
+        if (Frames == 0) return;
+
+        float       pos = std::max(time, 0.f) / FrameTime;
+        float const end = float(Frames - 1);
+        if (loop && Frames > 1) pos = std::fmod(pos, float(Frames));
+        else pos = std::min(pos, end);
+
+        std::uint32_t const f0 = std::min(std::uint32_t(pos), Frames - 1);
+        std::uint32_t const f1 = f0 + 1 < Frames ? f0 + 1 : (loop ? 0 : f0);
+        float const         a  = pos - float(f0);
+
+        glm::quat const * r0 = Rotations.data() + std::size_t(f0) * joints;
+        glm::quat const * r1 = Rotations.data() + std::size_t(f1) * joints;
+        glm::vec3 const * o0 = Offsets.data() + std::size_t(f0) * joints;
+        glm::vec3 const * o1 = Offsets.data() + std::size_t(f1) * joints;
+        for (std::uint32_t j = 0; j < joints; ++j)
+        {
+            // Neighbouring frames are close, nlerp along the short arc is enough
+            glm::quat const q1 = glm::dot(r0[j], r1[j]) < 0.f ? -r1[j] : r1[j];
+            out.Rotations[j]   = glm::normalize(r0[j] * (1.f - a) + q1 * a);
+            out.Offsets[j]     = o0[j] + (o1[j] - o0[j]) * a;
+        }
+    }
+
+    void ForwardKinematics(SkeletonDef const & def, Pose const & pose, glm::vec3 * positions, glm::quat * rotations)
+    {
+        std::uint32_t const joints = def.GetJointCount();
+        for (std::uint32_t j = 0; j < joints; ++j)
+        {
+            int const parent = def.Parents[j];
+            if (parent < 0)
+            {
+                rotations[j] = pose.Rotations[j];
+                positions[j] = pose.Offsets[j];
+            }
+            else
+            {
+                rotations[j] = rotations[parent] * pose.Rotations[j];
+                positions[j] = positions[parent] + rotations[parent] * pose.Offsets[j];
+            }
+        }
+        for (std::uint32_t j = 0; j < joints; ++j)
+            positions[j] = SceneScale * positions[j] + SceneOffset;
+    }
+
+    void GetGroundFrame(glm::vec3 const & position, glm::quat const & rotation, glm::vec3 & origin, glm::quat & inverse)
+    {
+        glm::vec3 const forward = rotation * glm::vec3(0.f, 0.f, 1.f);
+        origin                  = glm::vec3(position.x, 0.f, position.z);
+        inverse                 = glm::angleAxis(-std::atan2(forward.x, forward.z), glm::vec3(0.f, 1.f, 0.f));
+    }
+
+    void GetDifferenceFrames(std::uint32_t const frame, std::uint32_t const reach, std::uint32_t const frames, std::uint32_t & f0, std::uint32_t & f1)
+    {
+        f0 = frame > reach ? frame - reach : 0;
+        f1 = std::min(frame + reach, frames - 1);
+    }
+}
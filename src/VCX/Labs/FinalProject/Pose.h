@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include <glm/glm.hpp>
+#include <glm/ext/quaternion_float.hpp>
+
+#include "Labs/FinalProject/Clip.h"
+#include "Labs/FinalProject/SkeletonDef.h"
+
+namespace VCX::Labs::FinalProject
+{
+    // Same placement as Skeleton::ForwardKinematics, so flat and tree poses line up in the scene.
+    inline float constexpr SceneScale = 0.1f;
+    inline glm::vec3 const SceneOffset { 0.f, 0.15f, 0.f };
+
+    // Local pose in flat buffers, one entry per joint of a SkeletonDef.
+    struct Pose
+    {
+        std::vector<glm::quat>  Rotations;
+        std::vector<glm::vec3>  Offsets;    // Rest offsets, or the animated translation of 6-channel joints
+
+        void          Resize(std::uint32_t const joints);
+        std::uint32_t GetJointCount() const { return std::uint32_t(Rotations.size()); }
+    };
+
+    // Clip converted once to quaternions and offsets, so sampling is interpolation only.
+    struct BakedClip
+    {
+        std::shared_ptr<SkeletonDef const>  Skeleton;
+        std::uint32_t                       Frames    = 0;
+        float                               FrameTime = 0.f;
+        std::vector<glm::quat>              Rotations;  // Frames rows of joint count
+        std::vector<glm::vec3>              Offsets;    // Frames rows of joint count
+
+        static std::shared_ptr<BakedClip const> Bake(Clip const & clip);
+
+        float GetDuration() const { return Frames * FrameTime; }
+
+        // Interpolates the two frames around `time`, wrapping or clamping at the end.
+        void  Sample(float const time, bool const loop, Pose & out) const;
+        void  SampleFrame(std::uint32_t const frame, Pose & out) const;
+    };
+
+    // Global positions and rotations in scene space, parents before children as in SkeletonDef.
+    void ForwardKinematics(SkeletonDef const & def, Pose const & pose, glm::vec3 * positions, glm::quat * rotations);
+
+    // The root on the floor, turned so that its heading (local +Z) is +Z: `inverse * (p - origin)`
+    // is p relative to the root on the ground. The frame of every pose feature.
+    void GetGroundFrame(glm::vec3 const & position, glm::quat const & rotation, glm::vec3 & origin, glm::quat & inverse);
+
+    // Frames of a central difference at `frame`, `reach` frames each way, one-sided at the ends of a
+    // clip of `frames`; equal for a single frame.
+    void GetDifferenceFrames(std::uint32_t const frame, std::uint32_t const reach, std::uint32_t const frames, std::uint32_t & f0, std::uint32_t & f1);
+}
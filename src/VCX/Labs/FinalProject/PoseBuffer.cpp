@@ -0,0 +1,73 @@
+#include <algorithm>
+
+#include <spdlog/spdlog.h>
+
+#include "Engine/ThreadPool.hpp"
+#include "Labs/FinalProject/PoseBuffer.h"
+
+namespace VCX::Labs::FinalProject
+{
+    PoseBuffer::PoseBuffer(std::uint32_t const unit) :
+        _texture(GL_RGBA32F, unit)
+    {
+    }
+
+    std::vector<PoseBuffer::Range> PoseBuffer::LayOut(std::vector<std::shared_ptr<BakedClip const>> const & clips, FrameList & frames)
+    {
+        std::vector<Range> ranges;
+        frames.clear();
+        if (clips.empty()) return ranges;
+
+        // Keep every stride-th frame when all of them would not fit
+        std::size_t const joints = clips.front()->Skeleton->GetJointCount();
+        std::size_t       total  = 0;
+        for (auto const & clip : clips) total += clip->Frames;
+        std::size_t const   limit  = Engine::GL::UniqueTextureBuffer::GetMaxTexelCount() / (joints * TexelsPerJoint);
+        std::uint32_t const stride = limit > 0 ? std::uint32_t(std::max<std::size_t>(1, (total + limit - 1) / limit)) : 1;
+        if (stride > 1) spdlog::warn("PoseBuffer: {} frames exceed the buffer texture limit, keeping every {}th.", total, stride);
+
+        for (std::uint32_t c = 0; c < clips.size(); ++c)
+        {
+            Range range { .First = std::uint32_t(frames.size()), .FrameTime = clips[c]->FrameTime * stride };
+            for (std::uint32_t f = 0; f < clips[c]->Frames; f += stride) frames.emplace_back(c, f);
+            range.Frames = std::uint32_t(frames.size()) - range.First;
+            ranges.push_back(range);
+        }
+        return ranges;
+    }
+
+    void PoseBuffer::Build(std::vector<std::shared_ptr<BakedClip const>> const & clips, bool const inPlace)
+    {
+        _ranges.clear();
+        _frames = 0;
+        _joints = clips.empty() ? 0 : clips.front()->Skeleton->GetJointCount();
+        if (_joints == 0) return;
+
+        // All frames bake in one parallel loop
+        FrameList frames;
+        _ranges = LayOut(clips, frames);
+        _frames = std::uint32_t(frames.size());
+
+        std::vector<glm::vec4> texels(std::size_t(_frames) * _joints * TexelsPerJoint);
+        Engine::ThreadPool::Global().ParallelFor(frames.size(), 64, [&](std::size_t const begin, std::size_t const end) {
+            Pose                   pose;
+            std::vector<glm::vec3> positions(_joints);
+            std::vector<glm::quat> rotations(_joints);
+            for (std::size_t i = begin; i < end; ++i)
+            {
+                BakedClip const & clip = *clips[frames[i].first];
+                clip.SampleFrame(frames[i].second, pose);
+                if (inPlace) pose.Offsets[0].x = pose.Offsets[0].z = 0.f;
+                ForwardKinematics(*clip.Skeleton, pose, positions.data(), rotations.data());
+
+                glm::vec4 * out = texels.data() + i * _joints * TexelsPerJoint;
+                for (std::uint32_t j = 0; j < _joints; ++j)
+                {
+                    out[TexelsPerJoint * j]     = glm::vec4(positions[j], 1.f);
+                    out[TexelsPerJoint * j + 1] = glm::vec4(rotations[j].x, rotations[j].y, rotations[j].z, rotations[j].w);
+                }
+            }
+        });
+        _texture.Update(Engine::make_span_bytes<glm::vec4>(texels));
+    }
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "Engine/GL/TextureBuffer.hpp"
+#include "Labs/FinalProject/Pose.h"
+
+namespace VCX::Labs::FinalProject
+{
+    // Global joint transforms of whole clips, computed once on the CPU and kept on the GPU in one
+    // buffer texture, so that a shader can pose any number of characters from a clip and a time.
+    // Each joint of each frame takes TexelsPerJoint RGBA32F texels: the scene-space position
+    // (w = 1), then the rotation (x, y, z, w). Frame f of a range starts at texel
+    // (First + f) * joints * TexelsPerJoint.
+    class PoseBuffer
+    {
+    public:
+        struct Range
+        {
+            std::uint32_t   First     = 0;      // Frame index into the buffer
+            std::uint32_t   Frames    = 0;
+            float           FrameTime = 0.f;    // Of the stored frames, longer than the clip's when decimated to fit
+        };
+
+        static constexpr std::uint32_t TexelsPerJoint = 2;
+
+        using FrameList = std::vector<std::pair<std::uint32_t, std::uint32_t>>; // (clip, source frame)
+
+        explicit PoseBuffer(std::uint32_t const unit = 0);
+
+        // Frames of the clips kept in a buffer texture, all of them or every n-th when they exceed
+        // the texel limit. Anything storing TexelsPerJoint texels per joint gets the same ranges.
+        static std::vector<Range> LayOut(std::vector<std::shared_ptr<BakedClip const>> const & clips, FrameList & frames);
+
+        // Clips must share one topology. With `inPlace` the root stays above the origin, as in the
+        // crowd. When all frames exceed the buffer texture limit, every n-th frame is kept.
+        void Build(std::vector<std::shared_ptr<BakedClip const>> const & clips, bool const inPlace);
+
+        bool                        IsEmpty() const { return _ranges.empty(); }
+        std::vector<Range> const &  GetRanges() const { return _ranges; }
+        std::uint32_t               GetJointCount() const { return _joints; }
+        std::uint32_t               GetFrameCount() const { return _frames; }
+        std::size_t                 GetByteSize() const { return _texture.GetByteSize(); }
+        std::uint32_t               GetUnit() const { return _texture.GetUnit(); }
+
+        Engine::GL::scope_t Use() const { return _texture.Use(); }
+
+    private:
+        Engine::GL::UniqueTextureBuffer _texture;
+        std::vector<Range>              _ranges;
+        std::uint32_t                   _joints = 0;
+        std::uint32_t                   _frames = 0;
+    };
+}
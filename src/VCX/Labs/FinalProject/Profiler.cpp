@@ -0,0 +1,252 @@
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <string>
+
+#include <imgui.h>
+#include <spdlog/spdlog.h>
+
+#include "Labs/FinalProject/Profiler.h"
+
+namespace VCX::Labs::FinalProject
+{
+    static constexpr char const * c_TracePath = "profile-trace.json";
+
+    Profiler::Zone::Zone(char const * const name) :
+        _name(Profiler::Global().Enabled ? name : nullptr),
+        _start(_name ? Clock::now() : Clock::time_point())
+    {
+    }
+
+    Profiler::Zone::~Zone()
+    {
+        if (_name) Profiler::Global().Record(_name, _start, Clock::now());
+    }
+
+    void Profiler::History::Push(float const value)
+    {
+        Values[Head] = value;
+        Head         = (Head + 1) % c_History;
+        Count        = std::min(Count + 1, c_History);
+    }
+
+    Profiler::Profiler() :
+        _events(c_TraceSize),
+        _epoch(Clock::now()),
+        _frameStart(_epoch)
+    {
+    }
+
+    Profiler & Profiler::Global()
+    {
+        static Profiler profiler;
+        return profiler;
+    }
+
+    Engine::GL::scope_t Profiler::BeginGpu(char const * const name)
+    {
+        if (! Enabled || _gpuOpen) return Engine::GL::scope_t([] {});
+
+        std::lock_guard lock(_mutex);
+        Track & track = GetTrack(name);
+        track.Gpu     = true;
+        if (! track.Queries) track.Queries = std::make_unique<std::array<Query, c_QueryRing>>();
+        Query & query = (*track.Queries)[track.Next];
+        if (query.Pending) Collect(name, track);
+        if (query.Pending)
+        {
+            // The GPU is more than the ring behind, this time goes unmeasured rather than waited for
+            ++track.Dropped;
+            return Engine::GL::scope_t([] {});
+        }
+
+        query.IssuedUs = ToUs(Clock::now());
+        glBeginQuery(GL_TIME_ELAPSED, query.Object.Get());
+        _gpuOpen = true;
+        return Engine::GL::scope_t([this, &track, &query] {
+            glEndQuery(GL_TIME_ELAPSED);
+            query.Pending = true;
+            track.Next    = (track.Next + 1) % c_QueryRing;
+            _gpuOpen      = false;
+        });
+    }
+
+    void Profiler::NewFrame()
+    {
+        auto const now = Clock::now();
+
+        std::lock_guard lock(_mutex);
+        _frames.Push(std::chrono::duration<float, std::milli>(now - _frameStart).count());
+        if (Enabled) Trace("Frame", GetThread(), ToUs(_frameStart), ToUs(now) - ToUs(_frameStart));
+        _frameStart = now;
+
+        for (auto & [name, track] : _tracks)
+        {
+            if (track.Queries) Collect(name.data(), track);
+            if (track.Calls > 0) track.Totals.Push(float(track.FrameMs));
+            track.LastCalls = track.Calls;
+            track.FrameMs   = 0.;
+            track.Calls     = 0;
+        }
+    }
+
+    void Profiler::RenderOverlay()
+    {
+        ImGui::SetNextWindowPos(ImVec2(40.f, 40.f), ImGuiCond_FirstUseEver);
+        ImGui::SetNextWindowSize(ImVec2(440.f, 360.f), ImGuiCond_FirstUseEver);
+        ImGui::SetNextWindowCollapsed(true, ImGuiCond_FirstUseEver);
+        ImGui::SetNextWindowBgAlpha(.85f);
+        if (ImGui::Begin("Profiler"))
+        {
+            ZoneStats const frame = GetStats(_frames);
+            ImGui::Text("Frame: %.2f ms mean, %.2f ms p95, %.2f ms max", frame.Mean, frame.P95, frame.Max);
+            // Oldest first once the ring is full
+            ImGui::PlotLines("##Frames", _frames.Values.data(), int(_frames.Count), _frames.Count < c_History ? 0 : int(_frames.Head),
+                nullptr, 0.f, std::max(frame.Max, 1000.f / 60.f), ImVec2(-1.f, 60.f));
+
+            bool enabled = Enabled;
+            if (ImGui::Checkbox("Enabled", &enabled)) Enabled = enabled;
+            ImGui::SameLine();
+            if (ImGui::Button("Write Trace"))
+            {
+                if (WriteTrace(c_TracePath)) spdlog::info("Profiler: trace written to {}.", c_TracePath);
+                else spdlog::warn("Profiler: cannot write {}.", c_TracePath);
+            }
+
+            // Per frame, CPU zones summed over calls and threads; GPU results lag a few frames
+            if (ImGui::BeginTable("Zones", 5, ImGuiTableFlags_RowBg | ImGuiTableFlags_Borders))
+            {
+                ImGui::TableSetupColumn("Zone", ImGuiTableColumnFlags_WidthStretch);
+                ImGui::TableSetupColumn("Mean ms");
+                ImGui::TableSetupColumn("P95 ms");
+                ImGui::TableSetupColumn("Max ms");
+                ImGui::TableSetupColumn("Calls");
+                ImGui::TableHeadersRow();
+
+                std::lock_guard lock(_mutex);
+                for (auto const & [name, track] : _tracks)
+                {
+                    ZoneStats const stats = GetStats(track.Totals);
+                    ImGui::TableNextRow();
+                    ImGui::TableNextColumn();
+                    ImGui::Text("%s%s", name.data(), track.Gpu ? " (GPU)" : "");
+                    ImGui::TableNextColumn();
+                    ImGui::Text("%.3f", stats.Mean);
+                    ImGui::TableNextColumn();
+                    ImGui::Text("%.3f", stats.P95);
+                    ImGui::TableNextColumn();
+                    ImGui::Text("%.3f", stats.Max);
+                    ImGui::TableNextColumn();
+                    ImGui::Text("%u", track.LastCalls);
+                }
+                ImGui::EndTable();
+            }
+        }
+        ImGui::End();
+    }
+
+    bool Profiler::WriteTrace(std::filesystem::path const & path) const
+    {
+        std::ofstream file(path, std::ios::trunc);
+        if (! file) return false;
+
+        auto const escape = [](char const * name) {
+            std::string text;
+            for (; *name; ++name)
+            {
+                if (*name == '"' || *name == '\\') text += '\\';
+                text += *name;
+            }
+            return text;
+        };
+
+        std::lock_guard lock(_mutex);
+        file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+        file << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << c_GpuThread << ",\"args\":{\"name\":\"GPU\"}}";
+        // GPU events start where they were issued, the GPU may have run them later
+        for (std::uint64_t i = _eventCount > c_TraceSize ? _eventCount - c_TraceSize : 0; i < _eventCount; ++i)
+        {
+            Event const & event = _events[i % c_TraceSize];
+            file << ",\n{\"name\":\"" << escape(event.Name) << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << event.Thread
+                 << ",\"ts\":" << event.StartUs << ",\"dur\":" << event.DurationUs << "}";
+        }
+        file << "\n]}\n";
+        return bool(file);
+    }
+
+    ZoneStats Profiler::GetStats(std::string_view const name) const
+    {
+        std::lock_guard lock(_mutex);
+        auto const      iter = _tracks.find(name);
+        return iter == _tracks.end() ? ZoneStats { } : GetStats(iter->second.Totals);
+    }
+
+    void Profiler::Record(char const * const name, Clock::time_point const start, Clock::time_point const end)
+    {
+        std::lock_guard lock(_mutex);
+        Track & track  = GetTrack(name);
+        track.FrameMs += std::chrono::duration<double, std::milli>(end - start).count();
+        ++track.Calls;
+        Trace(name, GetThread(), ToUs(start), ToUs(end) - ToUs(start));
+    }
+
+    void Profiler::Collect(char const * const name, Track & track)
+    {
+        // In issue order, so the first one not done ends the scan
+        for (std::uint32_t k = 0; k < c_QueryRing; ++k)
+        {
+            Query & query = (*track.Queries)[(track.Next + k) % c_QueryRing];
+            if (! query.Pending) continue;
+            GLint available = 0;
+            glGetQueryObjectiv(query.Object.Get(), GL_QUERY_RESULT_AVAILABLE, &available);
+            if (! available) break;
+            GLuint64 ns = 0;
+            glGetQueryObjectui64v(query.Object.Get(), GL_QUERY_RESULT, &ns);
+            query.Pending  = false;
+            track.FrameMs += ns * 1e-6;
+            ++track.Calls;
+            Trace(name, c_GpuThread, query.IssuedUs, std::int64_t(ns / 1000));
+        }
+    }
+
+    void Profiler::Trace(char const * const name, std::uint32_t const thread, std::int64_t const startUs, std::int64_t const durationUs)
+    {
+        _events[_eventCount++ % c_TraceSize] = Event { name, thread, startUs, durationUs };
+    }
+
+    Profiler::Track & Profiler::GetTrack(char const * const name)
+    {
+        auto iter = _tracks.find(std::string_view(name));
+        if (iter == _tracks.end()) iter = _tracks.try_emplace(std::string_view(name)).first;
+        return iter->second;
+    }
+
+    std::int64_t Profiler::ToUs(Clock::time_point const time) const
+    {
+        return std::chrono::duration_cast<std::chrono::microseconds>(time - _epoch).count();
+    }
+
+    ZoneStats Profiler::GetStats(History const & history)
+    {
+        if (history.Count == 0) return { };
+        std::vector<float> values(history.Values.begin(), history.Values.begin() + history.Count);
+        std::sort(values.begin(), values.end());
+        double sum = 0.;
+        for (float const value : values) sum += value;
+        std::size_t const p95 = std::size_t(std::ceil(.95 * values.size())) - 1;
+        return {
+            .Mean    = float(sum / values.size()),
+            .P95     = values[p95],
+            .Max     = values.back(),
+            .Samples = history.Count,
+        };
+    }
+
+    std::uint32_t Profiler::GetThread()
+    {
+        // Small ids in order of first use, 0 is the GPU
+        static std::atomic<std::uint32_t> next { 1 };
+        thread_local std::uint32_t const  thread = next++;
+        return thread;
+    }
+}
@@ -0,0 +1,137 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string_view>
+#include <vector>
+
+#include "Engine/GL/resource.hpp"
+
+#define PROFILE_CONCAT_(a, b) a##b
+#define PROFILE_CONCAT(a, b)  PROFILE_CONCAT_(a, b)
+// Times the rest of the enclosing scope as the zone `name`, a string literal. Any thread.
+#define PROFILE_ZONE(name) \
+    ::VCX::Labs::FinalProject::Profiler::Zone const PROFILE_CONCAT(_profileZone, __LINE__) { name }
+// Times the GPU work issued in the rest of the scope. GL thread only; a GPU zone inside another
+// one is not measured, GL_TIME_ELAPSED queries do not nest.
+#define PROFILE_GPU_ZONE(name) \
+    auto const PROFILE_CONCAT(_profileGpuZone, __LINE__) { ::VCX::Labs::FinalProject::Profiler::Global().BeginGpu(name) }
+
+namespace VCX::Labs::FinalProject
+{
+    struct ZoneStats
+    {
+        float         Mean    = 0.f;    // Milliseconds per frame over the window
+        float         P95     = 0.f;
+        float         Max     = 0.f;
+        std::uint32_t Samples = 0;      // Frames the zone ran in
+    };
+
+    // Per-frame timing of named zones. CPU zones sum over their calls and threads in a frame;
+    // GPU zones take a GL_TIME_ELAPSED query from a small ring each time, read back once the
+    // result is available, a few frames later, so the GPU never stalls on them. Each zone keeps
+    // the totals of its last frames for rolling statistics, and the last events of all zones are
+    // kept for a Chrome trace (chrome://tracing or Perfetto).
+    class Profiler
+    {
+    public:
+        using Clock = std::chrono::steady_clock;
+
+        class Zone
+        {
+        public:
+            explicit Zone(char const * const name);
+            ~Zone();
+
+            Zone(Zone const &)             = delete;
+            Zone & operator=(Zone const &) = delete;
+
+        private:
+            char const *      _name;
+            Clock::time_point _start;
+        };
+
+        static Profiler & Global();
+
+        Engine::GL::scope_t BeginGpu(char const * const name);
+
+        // Closes the last frame: its time, the totals of its zones and the GPU results arrived.
+        void NewFrame();
+        void RenderOverlay();
+        // The kept events as Chrome trace JSON; false if the file cannot be written.
+        bool WriteTrace(std::filesystem::path const & path) const;
+
+        ZoneStats GetFrameStats() const { return GetStats(_frames); }
+        ZoneStats GetStats(std::string_view const name) const;
+
+        std::atomic<bool> Enabled { true };
+
+    private:
+        static constexpr std::uint32_t c_History   = 240;   // Frames of rolling statistics
+        static constexpr std::uint32_t c_QueryRing = 4;     // Queries in flight per GPU zone
+        static constexpr std::uint32_t c_TraceSize = 1u << 16;
+        static constexpr std::uint32_t c_GpuThread = 0;     // Trace thread of the GPU zones
+
+        struct History
+        {
+            std::array<float, c_History> Values { };
+            std::uint32_t                Head  = 0;    // Next to write
+            std::uint32_t                Count = 0;
+
+            void Push(float const value);
+        };
+
+        struct Query
+        {
+            Engine::GL::UniqueQuery Object;
+            std::int64_t            IssuedUs = 0;
+            bool                    Pending  = false;
+        };
+
+        struct Track
+        {
+            bool                                            Gpu       = false;
+            double                                          FrameMs   = 0.;  // Of the open frame
+            std::uint32_t                                   Calls     = 0;
+            std::uint32_t                                   LastCalls = 0;
+            History                                         Totals;
+            std::unique_ptr<std::array<Query, c_QueryRing>> Queries;         // GPU zones only
+            std::uint32_t                                   Next      = 0;
+            std::uint32_t                                   Dropped   = 0;   // The next query was still in flight
+        };
+
+        struct Event
+        {
+            char const *  Name;
+            std::uint32_t Thread;
+            std::int64_t  StartUs;
+            std::int64_t  DurationUs;
+        };
+
+        Profiler();
+
+        void                 Record(char const * const name, Clock::time_point const start, Clock::time_point const end);
+        void                 Collect(char const * const name, Track & track);
+        void                 Trace(char const * const name, std::uint32_t const thread, std::int64_t const startUs, std::int64_t const durationUs);
+        Track &              GetTrack(char const * const name);
+        std::int64_t         ToUs(Clock::time_point const time) const;
+        static ZoneStats     GetStats(History const & history);
+        static std::uint32_t GetThread();
+
+        mutable std::mutex                             _mutex;
+        std::map<std::string_view, Track, std::less<>> _tracks;      // By name, as the overlay lists them
+        std::vector<Event>                             _events;      // Ring of c_TraceSize
+        std::uint64_t                                  _eventCount = 0;
+        Clock::time_point                              _epoch;
+        Clock::time_point                              _frameStart;
+        History                                        _frames;      // Frame times
+        bool                                           _gpuOpen    = false;
+    };
+}
@@ -0,0 +1,155 @@
+#include <algorithm>
+#include <cmath>
+#include <glm/gtc/quaternion.hpp>
+
+#include "Labs/FinalProject/Resample.h"
+
+namespace VCX::Labs::FinalProject
+{
+    // out += weight * in over a row, the loop the whole resampler reduces to
+    static void Accumulate(float * out, float const * in, float const weight, std::size_t const count)
+    {
+        for (std::size_t i = 0; i < count; ++i) out[i] += weight * in[i];
+    }
+
+    static void NormalizeRotations(float * row, std::uint32_t const joints)
+    {
+        for (std::uint32_t j = 0; j < joints; ++j)
+        {
+            float * q      = row + 4 * j;
+            float   length = std::sqrt(q[0] * q[0] + q[1] * q[1] + q[2] * q[2] + q[3] * q[3]);
+            float   scale  = length > 0.f ? 1.f / length : 0.f;
+            for (int c = 0; c < 4; ++c) q[c] *= scale;
+        }
+    }
+
+    std::shared_ptr<BakedClip const> Resample(BakedClip const & clip, ResampleSettings const & settings)
+    {
+        auto                result = std::make_shared<BakedClip>();
+        std::uint32_t const joints = clip.Skeleton->GetJointCount();
+        std::uint32_t const n      = clip.Frames;
+        result->Skeleton           = clip.Skeleton;
+        result->FrameTime          = 1.f / settings.FrameRate;
+        if (n == 0 || joints == 0 || settings.FrameRate <= 0.f) return result;
+
+        // Source frames per output frame, above 1 when downsampling
+        double const        ratio  = double(result->FrameTime) / clip.FrameTime;
+        std::uint32_t const frames = std::uint32_t(double(n - 1) / ratio + 1e-6) + 1;
+        std::size_t const   width  = std::size_t(joints) * 7;
+        std::size_t const   split  = std::size_t(joints) * 4;   // Offsets start here within a row
+
+        // Source rows, each quaternion on the side of the previous frame's so that they can be averaged
+        std::vector<float> rows(std::size_t(n) * width);
+        for (std::uint32_t f = 0; f < n; ++f)
+        {
+            float *       row  = rows.data() + f * width;
+            float const * prev = f > 0 ? row - width : nullptr;
+            for (std::uint32_t j = 0; j < joints; ++j)
+            {
+                glm::quat q = clip.Rotations[std::size_t(f) * joints + j];
+                if (prev && q.x * prev[4 * j] + q.y * prev[4 * j + 1] + q.z * prev[4 * j + 2] + q.w * prev[4 * j + 3] < 0.f) q = -q;
+                row[4 * j] = q.x, row[4 * j + 1] = q.y, row[4 * j + 2] = q.z, row[4 * j + 3] = q.w;
+                glm::vec3 const & o = clip.Offsets[std::size_t(f) * joints + j];
+                row[split + 3 * j] = o.x, row[split + 3 * j + 1] = o.y, row[split + 3 * j + 2] = o.z;
+            }
+        }
+
+        // Box of `ratio` frames centered on each frame, the end frames weighted by their overlap
+        // and the box renormalized where it leaves the clip
+        if (settings.Prefilter && ratio > 1.)
+        {
+            std::vector<float> filtered(rows.size(), 0.f);
+            double const       half = .5 * ratio;
+            for (std::uint32_t f = 0; f < n; ++f)
+            {
+                float *            out   = filtered.data() + f * width;
+                std::int64_t const first = std::max<std::int64_t>(0, std::int64_t(std::floor(f - half + .5)));
+                std::int64_t const last  = std::min<std::int64_t>(n - 1, std::int64_t(std::ceil(f + half - .5)));
+                double             total = 0.;
+                for (std::int64_t g = first; g <= last; ++g)
+                {
+                    double const overlap = std::min(g + .5, f + half) - std::max(g - .5, f - half);
+                    if (overlap <= 0.) continue;
+                    Accumulate(out, rows.data() + g * width, float(overlap), width);
+                    total += overlap;
+                }
+                for (std::size_t i = 0; i < width; ++i) out[i] *= float(1. / total);
+                NormalizeRotations(out, joints);
+            }
+            rows.swap(filtered);
+        }
+
+        std::vector<float> sample(width);
+        result->Frames = frames;
+        result->Rotations.resize(std::size_t(frames) * joints);
+        result->Offsets.resize(std::size_t(frames) * joints);
+        for (std::uint32_t i = 0; i < frames; ++i)
+        {
+            double const        pos = std::min(i * ratio, double(n - 1));
+            std::uint32_t const f   = std::min(std::uint32_t(pos), n - 1);
+            float const         a   = float(pos - f);
+            auto const          row = [&](std::int64_t const g) { return rows.data() + std::clamp<std::int64_t>(g, 0, n - 1) * width; };
+
+            // Catmull-Rom weights of frames f - 1 to f + 2
+            float const w[4] = {
+                .5f * a * ((2.f - a) * a - 1.f),
+                .5f * (a * a * (3.f * a - 5.f) + 2.f),
+                .5f * a * ((4.f - 3.f * a) * a + 1.f),
+                .5f * a * a * (a - 1.f),
+            };
+            std::fill(sample.begin(), sample.end(), 0.f);
+            for (int k = 0; k < 4; ++k) Accumulate(sample.data(), row(std::int64_t(f) + k - 1), w[k], width);
+
+            glm::quat * rotations = result->Rotations.data() + std::size_t(i) * joints;
+            glm::vec3 * offsets   = result->Offsets.data() + std::size_t(i) * joints;
+            NormalizeRotations(sample.data(), joints);
+            for (std::uint32_t j = 0; j < joints; ++j)
+            {
+                float const * q = settings.Rotations == RotationInterpolation::Cubic ? sample.data() + 4 * j : nullptr;
+                if (q) rotations[j] = glm::quat(q[3], q[0], q[1], q[2]);
+                else
+                {
+                    float const * q0 = row(f) + 4 * j;
+                    float const * q1 = row(std::int64_t(f) + 1) + 4 * j;
+                    rotations[j]     = glm::slerp(glm::quat(q0[3], q0[0], q0[1], q0[2]), glm::quat(q1[3], q1[0], q1[1], q1[2]), a);
+                }
+                float const * o = sample.data() + split + 3 * j;
+                offsets[j]      = { o[0], o[1], o[2] };
+            }
+        }
+        return result;
+    }
+
+    std::shared_ptr<Clip const> Unbake(BakedClip const & clip)
+    {
+        auto                result = std::make_shared<Clip>();
+        SkeletonDef const & def    = *clip.Skeleton;
+        std::uint32_t const joints = def.GetJointCount();
+        result->Skeleton           = clip.Skeleton;
+        result->Frames             = clip.Frames;
+        result->FrameTime          = clip.FrameTime;
+        result->Channels.resize(std::size_t(clip.Frames) * def.ChannelCount);
+        for (std::uint32_t f = 0; f < clip.Frames; ++f)
+        {
+            float * row = result->Channels.data() + std::size_t(f) * def.ChannelCount;
+            for (std::uint32_t j = 0; j < joints; ++j)
+            {
+                if (def.Channels[j] == 0) continue;
+                float * channel = row + def.ChannelOffsets[j];
+                if (def.Channels[j] == 6)
+                {
+                    glm::vec3 const & offset = clip.Offsets[std::size_t(f) * joints + j];
+                    for (int i = 0; i < 3; ++i) channel[i] = offset[def.PositionOrder[j][i]];
+                    channel += 3;
+                }
+                glm::vec3 const angles = QuatToEuler(clip.Rotations[std::size_t(f) * joints + j], def.RotationOrder[j]);
+                for (int i = 0; i < 3; ++i)
+                {
+                    float const previous = f > 0 ? channel[i - std::ptrdiff_t(def.ChannelCount)] : 0.f;
+                    channel[i]           = angles[i] + 360.f * std::round((previous - angles[i]) / 360.f);
+                }
+            }
+        }
+        return result;
+    }
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <memory>
+
+#include "Labs/FinalProject/Clip.h"
+#include "Labs/FinalProject/Pose.h"
+
+namespace VCX::Labs::FinalProject
+{
+    enum class RotationInterpolation
+    {
+        Slerp,  // Between the two frames around a sample
+        Cubic,  // Catmull-Rom over four frames on the quaternion components, then normalized
+    };
+
+    struct ResampleSettings
+    {
+        float                   FrameRate = 30.f;
+        RotationInterpolation   Rotations = RotationInterpolation::Cubic;
+        bool                    Prefilter = true;   // Box filter over the source frames an output frame spans when downsampling
+    };
+
+    // A clip at another frame rate over the same duration, the last frame no later than the
+    // source's. Translations are interpolated with Catmull-Rom. Frames are processed as flat rows
+    // of floats (all rotations, then all offsets), so every step is a weighted sum of whole rows.
+    std::shared_ptr<BakedClip const> Resample(BakedClip const & clip, ResampleSettings const & settings);
+
+    // Back to channel rows in the skeleton's rotation orders, each angle kept within 180 degrees of
+    // the previous frame's, so that the clip can be written as BVH or packed into a ClipArchive.
+    std::shared_ptr<Clip const> Unbake(BakedClip const & clip);
+}
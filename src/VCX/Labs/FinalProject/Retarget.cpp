@@ -0,0 +1,262 @@
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <string_view>
+#include <unordered_map>
+#include <glm/gtc/quaternion.hpp>
+#include <glm/gtx/quaternion.hpp>
+
+#include <spdlog/spdlog.h>
+
+#include "Engine/ThreadPool.hpp"
+#include "Labs/FinalProject/Retarget.h"
+
+namespace VCX::Labs::FinalProject
+{
+    // Body joints under the names of common rigs, normalized (lower case, letters and digits only,
+    // no namespace prefix). Spine joints are left out on purpose: rigs split the spine differently,
+    // so they are paired by their position along the chain instead of by name.
+    static constexpr std::pair<char const *, char const *> c_JointNames[] = {
+        { "hips",        "hips pelvis hip bip01pelvis" },
+        { "neck",        "neck neck01 bip01neck" },
+        { "head",        "head bip01head" },
+        { "lthigh",      "leftupleg thighl lthigh leftthigh upperlegl bip01lthigh" },
+        { "lcalf",       "leftleg calfl lcalf leftshin lowerlegl leftknee bip01lcalf" },
+        { "lfoot",       "leftfoot footl lfoot leftankle bip01lfoot" },
+        { "ltoe",        "lefttoebase lefttoe balll ltoe toel bip01ltoe0" },
+        { "lclavicle",   "leftshoulder claviclel lclavicle leftcollar bip01lclavicle" },
+        { "lupperarm",   "leftarm upperarml lupperarm leftupperarm bip01lupperarm" },
+        { "lforearm",    "leftforearm lowerarml lforearm leftelbow bip01lforearm" },
+        { "lhand",       "lefthand handl lhand leftwrist bip01lhand" },
+        { "rthigh",      "rightupleg thighr rthigh rightthigh upperlegr bip01rthigh" },
+        { "rcalf",       "rightleg calfr rcalf rightshin lowerlegr rightknee bip01rcalf" },
+        { "rfoot",       "rightfoot footr rfoot rightankle bip01rfoot" },
+        { "rtoe",        "righttoebase righttoe ballr rtoe toer bip01rtoe0" },
+        { "rclavicle",   "rightshoulder clavicler rclavicle rightcollar bip01rclavicle" },
+        { "rupperarm",   "rightarm upperarmr rupperarm rightupperarm bip01rupperarm" },
+        { "rforearm",    "rightforearm lowerarmr rforearm rightelbow bip01rforearm" },
+        { "rhand",       "righthand handr rhand rightwrist bip01rhand" },
+    };
+
+    static std::string Normalize(std::string_view name)
+    {
+        if (auto const colon = name.find_last_of(':'); colon != std::string_view::npos) name.remove_prefix(colon + 1);
+        std::string result;
+        for (char const c : name)
+            if (std::isalnum(static_cast<unsigned char>(c))) result += char(std::tolower(static_cast<unsigned char>(c)));
+        return result;
+    }
+
+    // Key a joint is paired by: its entry of the name table, its normalized name for joints the
+    // table does not know, empty for spine joints and end sites.
+    static std::string GetPairingKey(std::string const & name)
+    {
+        static std::unordered_map<std::string, std::string> const aliases = []() {
+            std::unordered_map<std::string, std::string> map;
+            for (auto const & [key, names] : c_JointNames)
+            {
+                std::string_view rest = names;
+                while (! rest.empty())
+                {
+                    std::size_t const space = std::min(rest.find(' '), rest.size());
+                    map.emplace(std::string(rest.substr(0, space)), key);
+                    rest.remove_prefix(std::min(space + 1, rest.size()));
+                }
+            }
+            return map;
+        }();
+
+        std::string const normalized = Normalize(name);
+        if (auto const iter = aliases.find(normalized); iter != aliases.end()) return iter->second;
+        if (name == "???" || normalized.find("spine") != std::string::npos || normalized.find("lowerback") != std::string::npos || normalized.find("chest") != std::string::npos) return { };
+        return normalized;
+    }
+
+    static std::vector<glm::vec3> GetRestPositions(SkeletonDef const & def)
+    {
+        std::vector<glm::vec3> positions(def.GetJointCount());
+        for (std::uint32_t j = 0; j < def.GetJointCount(); ++j)
+            positions[j] = (def.Parents[j] >= 0 ? positions[def.Parents[j]] : glm::vec3(0.f)) + def.Offsets[j];
+        return positions;
+    }
+
+    static bool IsAncestor(SkeletonDef const & def, int const ancestor, int joint)
+    {
+        while (joint >= 0 && joint != ancestor) joint = def.Parents[joint];
+        return joint == ancestor;
+    }
+
+    // Joints strictly between an ancestor (or above the root, for -1) and a joint, root to leaf.
+    static std::vector<std::uint32_t> GetPath(SkeletonDef const & def, int const ancestor, int joint)
+    {
+        std::vector<std::uint32_t> path;
+        for (joint = def.Parents[joint]; joint >= 0 && joint != ancestor; joint = def.Parents[joint]) path.push_back(std::uint32_t(joint));
+        std::reverse(path.begin(), path.end());
+        return path;
+    }
+
+    std::shared_ptr<RetargetMap const> RetargetMap::Build(std::shared_ptr<SkeletonDef const> source, std::shared_ptr<SkeletonDef const> target, RetargetSettings const & settings)
+    {
+        SkeletonDef const & src    = *source;
+        SkeletonDef const & dst    = *target;
+        std::uint32_t const joints = dst.GetJointCount();
+
+        auto map     = std::make_shared<RetargetMap>();
+        map->_source = source;
+        map->_target = target;
+        map->_pairs.assign(joints, -1);
+        auto & pairs = map->_pairs;
+
+        // By name: overrides, then the name table
+        std::unordered_map<std::string, int> keys;
+        for (std::uint32_t j = src.GetJointCount(); j-- > 0;)
+            if (auto key = GetPairingKey(src.Names[j]); ! key.empty()) keys[std::move(key)] = int(j);
+        for (std::uint32_t j = 0; j < joints; ++j)
+        {
+            for (auto const & [to, from] : settings.Overrides)
+                if (to == dst.Names[j]) pairs[j] = src.Find(from);
+            if (pairs[j] >= 0) continue;
+            if (auto const iter = keys.find(GetPairingKey(dst.Names[j])); iter != keys.end()) pairs[j] = iter->second;
+        }
+
+        // Nearest paired ancestor of every joint; pairs that do not keep the source's ancestry
+        // cannot compose into a chain and are dropped
+        std::vector<int> above(joints, -1);
+        for (std::uint32_t j = 0; j < joints; ++j)
+        {
+            int const parent = dst.Parents[j];
+            above[j]         = parent < 0 ? -1 : pairs[parent] >= 0 ? parent : above[parent];
+            if (pairs[j] >= 0 && above[j] >= 0 && (pairs[above[j]] == pairs[j] || ! IsAncestor(src, pairs[above[j]], pairs[j])))
+            {
+                spdlog::warn("RetargetMap: \"{}\" is not below \"{}\" in the source, left unpaired.", dst.Names[j], dst.Names[above[j]]);
+                pairs[j] = -1;
+            }
+        }
+
+        // Unpaired runs between two pairs (the spine, mostly) take the source joints between the
+        // same pair, spread evenly
+        for (std::uint32_t j = 0; j < joints; ++j)
+        {
+            if (pairs[j] < 0 || above[j] < 0) continue;
+            std::vector<std::uint32_t> const from = GetPath(src, pairs[above[j]], pairs[j]);
+            std::vector<std::uint32_t> const to   = GetPath(dst, above[j], int(j));
+            if (from.empty() || to.empty()) continue;
+            for (std::size_t i = 0; i < to.size(); ++i)
+                pairs[to[i]] = int(from[to.size() > 1 ? (i * (from.size() - 1) + (to.size() - 1) / 2) / (to.size() - 1) : from.size() / 2]);
+        }
+        for (std::uint32_t j = 0; j < joints; ++j)
+        {
+            int const parent = dst.Parents[j];
+            above[j]         = parent < 0 ? -1 : pairs[parent] >= 0 ? parent : above[parent];
+        }
+        if (std::none_of(pairs.begin(), pairs.end(), [](int const p) { return p >= 0; })) return nullptr;
+
+        // Rest correction of each pair: turns the target bones onto the source bones, from the
+        // directions to the first two paired children (one fixes the bone, two its twist as well)
+        std::vector<glm::vec3> const srcRest = GetRestPositions(src);
+        std::vector<glm::vec3> const dstRest = GetRestPositions(dst);
+        std::vector<glm::quat>       corrections(joints, glm::quat(1.f, 0.f, 0.f, 0.f));
+        for (std::uint32_t j = 0; j < joints; ++j)
+        {
+            if (pairs[j] < 0) continue;
+            if (above[j] >= 0) corrections[j] = corrections[above[j]];
+
+            std::vector<glm::vec3> from, to;
+            for (std::uint32_t c = j + 1; c < joints && from.size() < 2; ++c)
+            {
+                if (pairs[c] < 0 || above[c] != int(j)) continue;
+                glm::vec3 const t = dstRest[c] - dstRest[j];
+                glm::vec3 const s = srcRest[pairs[c]] - srcRest[pairs[j]];
+                if (glm::length(t) < 1e-6f || glm::length(s) < 1e-6f) continue;
+                if (! to.empty() && glm::length(glm::cross(glm::normalize(to[0]), glm::normalize(t))) < 1e-3f) continue;
+                to.push_back(glm::normalize(t));
+                from.push_back(glm::normalize(s));
+            }
+            if (to.size() == 1) corrections[j] = glm::rotation(to[0], from[0]);
+            else if (to.size() == 2)
+            {
+                auto frame = [](glm::vec3 const & a, glm::vec3 const & b) {
+                    glm::vec3 const z = glm::normalize(glm::cross(a, b));
+                    return glm::mat3(a, glm::cross(z, a), z);
+                };
+                corrections[j] = glm::normalize(glm::quat_cast(frame(from[0], from[1]) * glm::transpose(frame(to[0], to[1]))));
+            }
+        }
+
+        // The program: target local = inverse(parent correction) * source chain * own correction
+        map->_ops.resize(joints);
+        for (std::uint32_t j = 0; j < joints; ++j)
+        {
+            if (pairs[j] < 0) continue;
+            Op & op  = map->_ops[j];
+            op.Pre   = above[j] >= 0 ? glm::inverse(corrections[above[j]]) : glm::quat(1.f, 0.f, 0.f, 0.f);
+            op.Post  = corrections[j];
+            op.Begin = std::uint32_t(map->_chain.size());
+            int const ancestor = above[j] >= 0 ? pairs[above[j]] : -1;
+            if (ancestor != pairs[j])
+            {
+                for (std::uint32_t const k : GetPath(src, ancestor, pairs[j])) map->_chain.push_back(k);
+                map->_chain.push_back(std::uint32_t(pairs[j]));
+            }
+            op.End = std::uint32_t(map->_chain.size());
+        }
+
+        auto height = [](std::vector<glm::vec3> const & rest) {
+            float lo = 0.f, hi = 0.f;
+            for (auto const & p : rest) lo = std::min(lo, p.y), hi = std::max(hi, p.y);
+            return hi - lo;
+        };
+        float const srcHeight = height(srcRest);
+        map->_scale           = srcHeight > 0.f ? height(dstRest) / srcHeight : 1.f;
+        return map;
+    }
+
+    std::uint32_t RetargetMap::GetPairedCount() const
+    {
+        return std::uint32_t(std::count_if(_pairs.begin(), _pairs.end(), [](int const p) { return p >= 0; }));
+    }
+
+    void RetargetMap::ApplyFrame(glm::quat const * sourceRotations, glm::vec3 const * sourceOffsets, glm::quat * targetRotations, glm::vec3 * targetOffsets) const
+    {
+        std::uint32_t const joints = std::uint32_t(_ops.size());
+        for (std::uint32_t j = 0; j < joints; ++j)
+        {
+            Op const & op = _ops[j];
+            glm::quat  q  = op.Pre;
+            for (std::uint32_t k = op.Begin; k < op.End; ++k) q = q * sourceRotations[_chain[k]];
+            targetRotations[j] = q * op.Post;
+        }
+        std::copy(_target->Offsets.begin(), _target->Offsets.end(), targetOffsets);
+        if (_target->Channels[0] == 6) targetOffsets[0] = _scale * sourceOffsets[0];
+    }
+
+    void RetargetMap::Apply(Pose const & source, Pose & target) const
+    {
+        target.Resize(_target->GetJointCount());
+        ApplyFrame(source.Rotations.data(), source.Offsets.data(), target.Rotations.data(), target.Offsets.data());
+    }
+
+    void RetargetMap::Apply(Pose const * sources, Pose * targets, std::size_t const count) const
+    {
+        Engine::ThreadPool::Global().ParallelFor(count, 64, [&](std::size_t const begin, std::size_t const end) {
+            for (std::size_t i = begin; i < end; ++i) Apply(sources[i], targets[i]);
+        });
+    }
+
+    std::shared_ptr<BakedClip const> RetargetMap::Retarget(BakedClip const & source) const
+    {
+        std::uint32_t const srcJoints = _source->GetJointCount();
+        std::uint32_t const dstJoints = _target->GetJointCount();
+        auto                clip      = std::make_shared<BakedClip>();
+        clip->Skeleton                = _target;
+        clip->Frames                  = source.Frames;
+        clip->FrameTime               = source.FrameTime;
+        clip->Rotations.resize(std::size_t(source.Frames) * dstJoints);
+        clip->Offsets.resize(std::size_t(source.Frames) * dstJoints);
+        Engine::ThreadPool::Global().ParallelFor(source.Frames, 256, [&](std::size_t const begin, std::size_t const end) {
+            for (std::size_t f = begin; f < end; ++f)
+                ApplyFrame(source.Rotations.data() + f * srcJoints, source.Offsets.data() + f * srcJoints, clip->Rotations.data() + f * dstJoints, clip->Offsets.data() + f * dstJoints);
+        });
+        return clip;
+    }
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+#include <glm/glm.hpp>
+#include <glm/ext/quaternion_float.hpp>
+
+#include "Labs/FinalProject/Pose.h"
+#include "Labs/FinalProject/SkeletonDef.h"
+
+namespace VCX::Labs::FinalProject
+{
+    struct RetargetSettings
+    {
+        // Target joint name to source joint name, checked before the built-in name table, which
+        // knows the CMU, Mixamo, Unreal-style and Biped names of the main body joints.
+        std::vector<std::pair<std::string, std::string>> Overrides;
+    };
+
+    // Moves motion from one skeleton hierarchy to another. Joints are paired once by name, and the
+    // pairing is compiled into a flat program: per target joint, the run of source joints whose
+    // local rotations compose into it, between two rest-pose correction quaternions. The
+    // corrections turn each target bone onto the direction of its source bone in the rest pose, so
+    // a target in A-pose follows a source in T-pose. Unpaired target joints keep their rest pose,
+    // and the root translation is scaled by the ratio of the rest heights.
+    class RetargetMap
+    {
+    public:
+        // nullptr if no joint can be paired.
+        static std::shared_ptr<RetargetMap const> Build(std::shared_ptr<SkeletonDef const> source, std::shared_ptr<SkeletonDef const> target, RetargetSettings const & settings = { });
+
+        std::shared_ptr<SkeletonDef const> const & GetSource() const { return _source; }
+        std::shared_ptr<SkeletonDef const> const & GetTarget() const { return _target; }
+        int                                        GetSourceJoint(std::uint32_t const targetJoint) const { return _pairs[targetJoint]; } // -1 when unpaired
+        std::uint32_t                              GetPairedCount() const;
+        float                                      GetScale() const { return _scale; }
+
+        void Apply(Pose const & source, Pose & target) const;
+        // Many poses at once over the thread pool, as for a crowd.
+        void Apply(Pose const * sources, Pose * targets, std::size_t const count) const;
+        // Every frame of a clip of the source skeleton, in parallel batches of frames.
+        std::shared_ptr<BakedClip const> Retarget(BakedClip const & source) const;
+
+    private:
+        // Target rotation = Pre * (source rotations of _chain[Begin, End), root to leaf) * Post.
+        struct Op
+        {
+            std::uint32_t   Begin = 0;
+            std::uint32_t   End   = 0;
+            glm::quat       Pre   = { 1.f, 0.f, 0.f, 0.f };
+            glm::quat       Post  = { 1.f, 0.f, 0.f, 0.f };
+        };
+
+        void ApplyFrame(glm::quat const * sourceRotations, glm::vec3 const * sourceOffsets, glm::quat * targetRotations, glm::vec3 * targetOffsets) const;
+
+        std::shared_ptr<SkeletonDef const>  _source;
+        std::shared_ptr<SkeletonDef const>  _target;
+        std::vector<int>                    _pairs;     // Source joint of each target joint
+        std::vector<Op>                     _ops;       // One per target joint
+        std::vector<std::uint32_t>          _chain;
+        float                               _scale = 1.f;
+    };
+}
@@ -0,0 +1,152 @@
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iterator>
+#include <glm/gtc/constants.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include <fmt/core.h>
+#include <spdlog/spdlog.h>
+
+#include "Labs/FinalProject/AtomicFile.h"
+#include "Labs/FinalProject/ClipIndex.h"
+#include "Labs/FinalProject/RootMotion.h"
+
+namespace VCX::Labs::FinalProject
+{
+    static constexpr std::uint32_t c_RootMagic   = 0x544F4F52; // "ROOT"
+    static constexpr std::uint32_t c_RootVersion = 1;
+
+    glm::quat GroundTransform::GetRotation() const
+    {
+        return glm::angleAxis(Heading, glm::vec3(0.f, 1.f, 0.f));
+    }
+
+    glm::vec3 GroundTransform::Apply(glm::vec3 const & point) const
+    {
+        return Position + GetRotation() * point;
+    }
+
+    GroundTransform GroundTransform::Inverse() const
+    {
+        return { glm::angleAxis(-Heading, glm::vec3(0.f, 1.f, 0.f)) * -Position, -Heading };
+    }
+
+    GroundTransform GroundTransform::operator*(GroundTransform const & rhs) const
+    {
+        return { Apply(rhs.Position), Heading + rhs.Heading };
+    }
+
+    GroundTransform RootMotion::At(std::uint32_t const frame) const
+    {
+        std::uint32_t const n = GetFrameCount();
+        if (frame < n) return Trajectory[frame];
+        if (n < 2) return n ? Trajectory.back() : GroundTransform { };
+        GroundTransform const step = Trajectory[n - 2].Inverse() * Trajectory[n - 1];
+        GroundTransform       at   = Trajectory[n - 1];
+        for (std::uint32_t f = n; f <= frame; ++f) at = at * step;
+        return at;
+    }
+
+    RootMotion RootMotion::Extract(Clip const & clip, float const smoothing)
+    {
+        RootMotion motion;
+        motion.FrameTime = clip.FrameTime;
+        SkeletonDef const & def = *clip.Skeleton;
+        if (clip.Frames == 0 || def.GetJointCount() == 0 || def.Channels[0] != 6) return motion;
+
+        // Heading of the root's forward axis, unwrapped so that the average does not jump at +-pi
+        std::uint32_t const n = clip.Frames;
+        std::vector<double> headings(n);
+        motion.Offsets.resize(n);
+        motion.Rotations.resize(n);
+        for (std::uint32_t f = 0; f < n; ++f)
+        {
+            motion.Offsets[f]       = def.GetLocalOffset(0, clip.GetFrame(f));
+            motion.Rotations[f]     = def.GetLocalRotation(0, clip.GetFrame(f));
+            glm::vec3 const forward = motion.Rotations[f] * glm::vec3(0.f, 0.f, 1.f);
+            double          heading = std::atan2(forward.x, forward.z);
+            if (f > 0) heading += 2. * glm::pi<double>() * std::round((headings[f - 1] - heading) / (2. * glm::pi<double>()));
+            headings[f] = heading;
+        }
+
+        // Centered box filter from prefix sums, the window shrinking at the ends
+        std::vector<double> sums(n + 1, 0.);
+        for (std::uint32_t f = 0; f < n; ++f) sums[f + 1] = sums[f] + headings[f];
+        std::uint32_t const half = std::uint32_t(std::lround(.5f * smoothing / clip.FrameTime));
+
+        motion.Trajectory.resize(n);
+        for (std::uint32_t f = 0; f < n; ++f)
+        {
+            std::uint32_t const radius = std::min({ half, f, n - 1 - f });
+            GroundTransform &   ground = motion.Trajectory[f];
+            ground.Heading             = float((sums[f + radius + 1] - sums[f - radius]) / (2 * radius + 1));
+            ground.Position            = { motion.Offsets[f].x, 0.f, motion.Offsets[f].z };
+
+            GroundTransform const inverse = ground.Inverse();
+            motion.Offsets[f]             = inverse.Apply(motion.Offsets[f]);
+            motion.Rotations[f]           = inverse.GetRotation() * motion.Rotations[f];
+        }
+        return motion;
+    }
+
+    static bool ReadCache(std::filesystem::path const & path, std::uint64_t const hash, RootMotion & motion)
+    {
+        std::ifstream file(path, std::ios::binary);
+        if (! file.is_open()) return false;
+
+        auto read  = [&file](auto & value) { file.read(reinterpret_cast<char *>(&value), sizeof(value)); };
+        auto array = [&file](auto & values) { file.read(reinterpret_cast<char *>(values.data()), std::streamsize(values.size() * sizeof(values[0]))); };
+
+        std::uint32_t magic = 0, version = 0, frames = 0;
+        std::uint64_t stored = 0;
+        read(magic);
+        read(version);
+        read(stored);
+        if (! file || magic != c_RootMagic || version != c_RootVersion || stored != hash) return false;
+        read(motion.FrameTime);
+        read(frames);
+        if (! file) return false;
+        motion.Trajectory.resize(frames);
+        motion.Offsets.resize(frames);
+        motion.Rotations.resize(frames);
+        array(motion.Trajectory);
+        array(motion.Offsets);
+        array(motion.Rotations);
+        return bool(file);
+    }
+
+    static void WriteCache(std::filesystem::path const & path, std::uint64_t const hash, RootMotion const & motion)
+    {
+        bool const written = WriteFileAtomic(path, [&](std::ostream & file) {
+            auto write = [&file](auto const & value) { file.write(reinterpret_cast<char const *>(&value), sizeof(value)); };
+            auto array = [&file](auto const & values) { file.write(reinterpret_cast<char const *>(values.data()), std::streamsize(values.size() * sizeof(values[0]))); };
+
+            write(c_RootMagic);
+            write(c_RootVersion);
+            write(hash);
+            write(motion.FrameTime);
+            write(motion.GetFrameCount());
+            array(motion.Trajectory);
+            array(motion.Offsets);
+            array(motion.Rotations);
+        });
+        if (! written) spdlog::warn("RootMotion: cannot write \"{}\".", path.string());
+    }
+
+    RootMotion GetRootMotion(std::string const & path, Clip const & clip, std::filesystem::path const & cacheDir)
+    {
+        std::ifstream file(path, std::ios::binary);
+        if (! file.is_open()) return RootMotion::Extract(clip);
+
+        std::string const   bytes { std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>() };
+        std::uint64_t const hash  = ClipIndexer::HashBytes(bytes);
+        auto const          cache = cacheDir / fmt::format("{:016x}.root", hash);
+
+        RootMotion motion;
+        if (ReadCache(cache, hash, motion) && motion.GetFrameCount() == (clip.Skeleton->Channels[0] == 6 ? clip.Frames : 0)) return motion;
+        motion = RootMotion::Extract(clip);
+        WriteCache(cache, hash, motion);
+        return motion;
+    }
+}
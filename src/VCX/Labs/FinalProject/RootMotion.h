@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <vector>
+#include <glm/glm.hpp>
+#include <glm/ext/quaternion_float.hpp>
+
+#include "Labs/FinalProject/Clip.h"
+
+namespace VCX::Labs::FinalProject
+{
+    // Position on the ground and heading about +Y, a rigid transform of the ground plane.
+    struct GroundTransform
+    {
+        glm::vec3   Position = { 0.f, 0.f, 0.f };  // y is 0
+        float       Heading  = 0.f;                // Radians, 0 faces +Z
+
+        glm::quat       GetRotation() const;
+        glm::vec3       Apply(glm::vec3 const & point) const;
+        GroundTransform Inverse() const;
+        GroundTransform operator*(GroundTransform const & rhs) const;  // rhs first, then this
+    };
+
+    // A clip's root track split in two: the trajectory, the root projected on the ground with its
+    // heading smoothed over the gait's sway, and the residual left once the trajectory is removed,
+    // which plays in place at the origin facing +Z. Root offset = Trajectory.Apply(residual offset),
+    // root rotation = trajectory rotation * residual rotation. Units are the clip's (BVH units).
+    struct RootMotion
+    {
+        float                           FrameTime = 0.f;
+        std::vector<GroundTransform>    Trajectory;     // Per frame
+        std::vector<glm::vec3>          Offsets;        // Residual root offset per frame
+        std::vector<glm::quat>          Rotations;      // Residual root rotation per frame
+
+        std::uint32_t GetFrameCount() const { return std::uint32_t(Trajectory.size()); }
+        // Trajectory at a frame; past the last frame the last step is repeated, so that a loop can
+        // continue the motion.
+        GroundTransform At(std::uint32_t const frame) const;
+
+        // Heading smoothed over a centered window of `smoothing` seconds. Empty for clips
+        // without root position channels.
+        static RootMotion Extract(Clip const & clip, float const smoothing = .5f);
+    };
+
+    // Root motion of the clip loaded from `path`, from the cache keyed by the file hash when
+    // present, next to the clip metadata of ClipIndexer, otherwise extracted and cached.
+    RootMotion GetRootMotion(std::string const & path, Clip const & clip, std::filesystem::path const & cacheDir = ".cache/clips");
+}
@@ -1,4 +1,5 @@
 #include "Labs/FinalProject/Skeleton.h"
+#include "Labs/FinalProject/SkinPalette.h"
 
 namespace VCX::Labs::FinalProject
 {
@@ -13,6 +14,38 @@ namespace VCX::Labs::FinalProject
             ClearJoint(Root);
             Root = nullptr;
         }
+        Def.reset();
+        Joints.clear();
+    }
+
+    void Skeleton::Build(std::shared_ptr<SkeletonDef const> def)
+    {
+        Clear();
+        Def = std::move(def);
+
+        // Parents come before their children, children of a joint keep their file order
+        std::vector<Joint *> lastChild(Def->GetJointCount(), nullptr);
+        for (std::uint32_t i = 0; i < Def->GetJointCount(); ++i)
+        {
+            Joint * ptr       = new Joint();
+            ptr->Name         = Def->Names[i];
+            ptr->LocalOffset  = Def->Offsets[i];
+            for (int k = 0; k < 3; ++k)
+            {
+                ptr->PositionIdx[k] = Def->PositionOrder[i][k];
+                ptr->RotationIdx[k] = Def->RotationOrder[i][k];
+            }
+            Joints.push_back(ptr);
+
+            int const parent = Def->Parents[i];
+            if (parent < 0) Root = ptr;
+            else
+            {
+                if (lastChild[parent]) lastChild[parent]->BroPtr = ptr;
+                else Joints[parent]->ChiPtr = ptr;
+                lastChild[parent] = ptr;
+            }
+        }
     }
     
     void Skeleton::ClearJoint(Joint* ptr) {
@@ -172,4 +205,33 @@ namespace VCX::Labs::FinalProject
             NextPtr = NextPtr->BroPtr;
         }
     }
+
+    void Skeleton::GatherGlobals() const
+    {
+        _globalRotations.resize(Joints.size());
+        _globalPositions.resize(Joints.size());
+        for (std::size_t j = 0; j < Joints.size(); ++j)
+        {
+            _globalRotations[j] = Joints[j]->GlobalRotation;
+            _globalPositions[j] = Joints[j]->GlobalPosition;
+        }
+    }
+
+    void Skeleton::GetMatrixPalette(std::vector<glm::vec3> const & rest, std::vector<glm::vec4> & palette) const
+    {
+        palette.clear();
+        if (rest.size() != Joints.size() || Joints.empty()) return;
+        GatherGlobals();
+        palette.resize(Joints.size() * TexelsPerMatrix);
+        ComputeMatrixPalette(_globalRotations.data(), _globalPositions.data(), rest.data(), std::uint32_t(Joints.size()), 1, palette.data());
+    }
+
+    void Skeleton::GetDualQuaternionPalette(std::vector<glm::vec3> const & rest, std::vector<glm::vec4> & palette) const
+    {
+        palette.clear();
+        if (rest.size() != Joints.size() || Joints.empty()) return;
+        GatherGlobals();
+        palette.resize(Joints.size() * TexelsPerDualQuaternion);
+        ComputeDualQuaternionPalette(_globalRotations.data(), _globalPositions.data(), rest.data(), std::uint32_t(Joints.size()), 1, palette.data());
+    }
 }
\ No newline at end of file
@@ -8,6 +8,8 @@
 #include <glm/ext.hpp>
 #include <glm/gtx/quaternion.hpp>
 
+#include "Labs/FinalProject/SkeletonDef.h"
+
 namespace VCX::Labs::FinalProject 
 {
     struct Joint
@@ -30,14 +32,24 @@ namespace VCX::Labs::FinalProject
         Skeleton();
         ~Skeleton();
 
+        void                                                          Build(std::shared_ptr<SkeletonDef const> def); // Instantiate a joint tree in rest pose
         std::pair<std::vector<glm::vec3>, std::vector<std::uint32_t>> Convert() const;
         void                                                          ForwardKinematics();
         void                                                          Clear();
         int                                                           GetJointCount() const;
         std::string                                                   GetJointName(int index) const;
 
+        // Skinning palettes for the current pose, given the joints' rest positions in scene space
+        // (see SkinPalette.h): three texels per joint for a 3x4 matrix, or two for a dual quaternion.
+        // They share scratch storage, so one skeleton is not to be used from several threads at once.
+        void                                                          GetMatrixPalette(std::vector<glm::vec3> const & rest, std::vector<glm::vec4> & palette) const;
+        void                                                          GetDualQuaternionPalette(std::vector<glm::vec3> const & rest, std::vector<glm::vec4> & palette) const;
+
         Joint *Root = nullptr;
+        std::shared_ptr<SkeletonDef const>                            Def;
+        std::vector<Joint *>                                          Joints; // Same order as Def's joints
     private:
+        void GatherGlobals() const; // Into _globalRotations and _globalPositions
         void Construct(const Joint *, std::vector<glm::vec3> &, std::vector<std::uint32_t> &) const;
         void ItsMyGo(Joint* ptr); // Inner Forward Kinematics
         void Adjust(Joint* ptr);
@@ -47,5 +59,9 @@ namespace VCX::Labs::FinalProject
 
         float                                                         Scale = 0.1f;
         glm::vec3                                                     Offset = { 0.f, 0.15f, 0.f };
+
+        // Flat global pose of the palette getters, kept so that per-frame calls do not allocate
+        mutable std::vector<glm::quat>                                _globalRotations;
+        mutable std::vector<glm::vec3>                                _globalPositions;
     };
 }
\ No newline at end of file
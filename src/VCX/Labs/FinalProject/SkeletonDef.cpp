@@ -0,0 +1,131 @@
+#include <algorithm>
+#include <cmath>
+#include <glm/gtc/quaternion.hpp>
+
+#include "Labs/FinalProject/SkeletonDef.h"
+
+namespace VCX::Labs::FinalProject
+{
+    glm::quat EulerToQuat(float const * degrees, glm::ivec3 const & order)
+    {
+        glm::quat res { 1.f, 0.f, 0.f, 0.f };
+        for (int i = 0; i < 3; ++i)
+        {
+            glm::vec3 axis = { 0.f, 0.f, 0.f };
+            axis[order[i]] = 1.f;
+            res *= glm::angleAxis(glm::radians(degrees[i]), axis);
+        }
+        return res;
+    }
+
+    glm::vec3 QuatToEuler(glm::quat const & rotation, glm::ivec3 const & order)
+    {
+        // With M = R_i(a) R_j(b) R_k(c), M[i][k] = s sin b, where s is the parity of (i, j, k)
+        glm::mat3 const m = glm::mat3_cast(rotation);
+        int const       i = order[0], j = order[1], k = order[2];
+        float const     s = (j - i + 3) % 3 == 1 ? 1.f : -1.f;
+        auto const      M = [&m](int const row, int const col) { return m[col][row]; }; // glm is column-major
+
+        // cos b from the rest of the row, which stays accurate where asin would not near +-90 degrees
+        float const cosB = std::hypot(M(i, i), M(i, j));
+        glm::vec3   angles;
+        angles[1] = std::atan2(s * M(i, k), cosB);
+        if (cosB > 1e-4f)
+        {
+            angles[0] = std::atan2(-s * M(j, k), M(k, k));
+            angles[2] = std::atan2(-s * M(i, j), M(i, i));
+        }
+        else
+        {
+            // Gimbal lock, only a + c or a - c is defined, c is taken as 0
+            angles[0] = std::atan2(s * M(k, j), M(j, j));
+            angles[2] = 0.f;
+        }
+        return glm::degrees(angles);
+    }
+
+    int SkeletonDef::Find(std::string_view const name) const
+    {
+        auto const iter = std::find(Names.begin(), Names.end(), name);
+        return iter == Names.end() ? -1 : int(iter - Names.begin());
+    }
+
+    glm::quat SkeletonDef::GetLocalRotation(std::uint32_t const joint, float const * frame) const
+    {
+        if (Channels[joint] == 0) return { 1.f, 0.f, 0.f, 0.f };
+        return EulerToQuat(frame + ChannelOffsets[joint] + (Channels[joint] == 6 ? 3 : 0), RotationOrder[joint]);
+    }
+
+    glm::vec3 SkeletonDef::GetLocalOffset(std::uint32_t const joint, float const * frame) const
+    {
+        if (Channels[joint] != 6) return Offsets[joint];
+        glm::vec3 offset;
+        for (int i = 0; i < 3; ++i)
+            offset[PositionOrder[joint][i]] = frame[ChannelOffsets[joint] + i];
+        return offset;
+    }
+
+    std::uint64_t SkeletonDef::ComputeHash(bool const withOffsets) const
+    {
+        std::uint64_t hash = 14695981039346656037ull;
+        auto mix = [&hash](void const * data, std::size_t const size) {
+            auto const bytes = static_cast<unsigned char const *>(data);
+            for (std::size_t i = 0; i < size; ++i)
+            {
+                hash ^= bytes[i];
+                hash *= 1099511628211ull;
+            }
+        };
+        for (std::uint32_t i = 0; i < GetJointCount(); ++i)
+        {
+            mix(Names[i].data(), Names[i].size() + 1);
+            mix(&Parents[i], sizeof(int));
+            if (withOffsets) mix(&Offsets[i], sizeof(glm::vec3));
+            mix(&PositionOrder[i], sizeof(glm::ivec3));
+            mix(&RotationOrder[i], sizeof(glm::ivec3));
+            mix(&Channels[i], sizeof(std::uint8_t));
+        }
+        return hash;
+    }
+
+    bool SkeletonDef::operator==(SkeletonDef const & rhs) const
+    {
+        return Names == rhs.Names
+            && Parents == rhs.Parents
+            && Offsets == rhs.Offsets
+            && PositionOrder == rhs.PositionOrder
+            && RotationOrder == rhs.RotationOrder
+            && Channels == rhs.Channels;
+    }
+
+    SkeletonRegistry & SkeletonRegistry::Global()
+    {
+        static SkeletonRegistry registry;
+        return registry;
+    }
+
+    std::shared_ptr<SkeletonDef const> SkeletonRegistry::Intern(SkeletonDef && def)
+    {
+        def.Hash         = def.ComputeHash();
+        def.TopologyHash = def.ComputeHash(false);
+
+        std::lock_guard lock(_mutex);
+        auto [begin, end] = _defs.equal_range(def.Hash);
+        for (auto iter = begin; iter != end;)
+        {
+            auto shared = iter->second.lock();
+            if (! shared) iter = _defs.erase(iter);
+            else if (*shared == def) return shared;
+            else ++iter;
+        }
+        auto shared = std::make_shared<SkeletonDef const>(std::move(def));
+        _defs.emplace(shared->Hash, shared);
+        return shared;
+    }
+
+    std::size_t SkeletonRegistry::GetCount() const
+    {
+        std::lock_guard lock(_mutex);
+        return std::count_if(_defs.begin(), _defs.end(), [](auto const & kv) { return ! kv.second.expired(); });
+    }
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include <glm/glm.hpp>
+#include <glm/ext/quaternion_float.hpp>
+
+namespace VCX::Labs::FinalProject
+{
+    // Immutable skeleton topology, joints flattened in file (depth-first) order so that a parent
+    // always comes before its children and a frame's channels can be walked front to back.
+    struct SkeletonDef
+    {
+        std::vector<std::string>    Names;          // End sites are named "???"
+        std::vector<int>            Parents;        // -1 for the root
+        std::vector<glm::vec3>      Offsets;
+        std::vector<glm::ivec3>     PositionOrder;  // Axis of each position channel
+        std::vector<glm::ivec3>     RotationOrder;  // Axis of each rotation channel, applied left to right
+        std::vector<std::uint8_t>   Channels;       // 0, 3 (rotation) or 6 (position, then rotation)
+        std::vector<int>            ChannelOffsets; // Into a frame row, -1 for joints without channels
+        std::uint32_t               ChannelCount = 0;
+        std::uint64_t               Hash         = 0;   // Topology and offsets, the interning key
+        std::uint64_t               TopologyHash = 0;   // Names, parents and channels only, equal across subjects of one rig
+
+        std::uint32_t GetJointCount() const { return std::uint32_t(Names.size()); }
+        int           Find(std::string_view const name) const; // -1 if absent
+
+        // Local rotation and (for 6-channel joints) local offset of a joint in one frame row.
+        glm::quat     GetLocalRotation(std::uint32_t const joint, float const * frame) const;
+        glm::vec3     GetLocalOffset(std::uint32_t const joint, float const * frame) const;
+
+        std::uint64_t ComputeHash(bool const withOffsets = true) const;
+        bool          operator==(SkeletonDef const & rhs) const;
+    };
+
+    // Interns skeleton definitions, so clips captured on the same rig share one instance.
+    // Definitions are held weakly and released once no clip uses them anymore.
+    class SkeletonRegistry
+    {
+    public:
+        static SkeletonRegistry & Global();
+
+        std::shared_ptr<SkeletonDef const> Intern(SkeletonDef && def);
+        std::size_t                        GetCount() const;
+
+    private:
+        mutable std::mutex                                                            _mutex;
+        std::unordered_multimap<std::uint64_t, std::weak_ptr<SkeletonDef const>>      _defs;
+    };
+
+    // Rotation of three Euler angles in degrees, applied in the given axis order.
+    glm::quat EulerToQuat(float const * degrees, glm::ivec3 const & order);
+    // Inverse of EulerToQuat for orders of three distinct axes, the middle angle within +-90 degrees.
+    glm::vec3 QuatToEuler(glm::quat const & rotation, glm::ivec3 const & order);
+}
@@ -0,0 +1,85 @@
+#if defined(__SSE2__) || defined(_M_X64)
+    #include <emmintrin.h>
+#endif
+
+#include "Labs/FinalProject/SkinPalette.h"
+
+namespace VCX::Labs::FinalProject
+{
+    static_assert(sizeof(glm::quat) == 4 * sizeof(float) && sizeof(glm::vec3) == 3 * sizeof(float));
+
+    void ComputeMatrixPalette(glm::quat const * rotations, glm::vec3 const * positions, glm::vec3 const * rest, std::uint32_t const joints, std::size_t const characters, glm::vec4 * palette)
+    {
+        for (std::size_t i = 0; i < characters * joints; ++i)
+        {
+            glm::mat3 const rotation    = glm::mat3_cast(rotations[i]);
+            glm::vec3 const translation = positions[i] - rotation * rest[i % joints];
+            for (int r = 0; r < 3; ++r) palette[TexelsPerMatrix * i + r] = glm::vec4(rotation[0][r], rotation[1][r], rotation[2][r], translation[r]);
+        }
+    }
+
+#if defined(__SSE2__) || defined(_M_X64)
+    // Lanes of the cross product a x b, component by component
+    static inline void Cross(__m128 const ax, __m128 const ay, __m128 const az, __m128 const bx, __m128 const by, __m128 const bz, __m128 & cx, __m128 & cy, __m128 & cz)
+    {
+        cx = _mm_sub_ps(_mm_mul_ps(ay, bz), _mm_mul_ps(az, by));
+        cy = _mm_sub_ps(_mm_mul_ps(az, bx), _mm_mul_ps(ax, bz));
+        cz = _mm_sub_ps(_mm_mul_ps(ax, by), _mm_mul_ps(ay, bx));
+    }
+#endif
+
+    void ComputeDualQuaternionPalette(glm::quat const * rotations, glm::vec3 const * positions, glm::vec3 const * rest, std::uint32_t const joints, std::size_t const characters, glm::vec4 * palette)
+    {
+        std::size_t const count = characters * joints;
+        std::size_t       i     = 0;
+#if defined(__SSE2__) || defined(_M_X64)
+        // Quaternions are transposed to lanes, vectors gathered; the math is ToDualQuaternion's
+        __m128 const half = _mm_set1_ps(.5f);
+        __m128 const two  = _mm_set1_ps(2.f);
+        for (std::uint32_t k0 = 0; i + 4 <= count; i += 4)
+        {
+            __m128 qx = _mm_loadu_ps(&rotations[i].x);
+            __m128 qy = _mm_loadu_ps(&rotations[i + 1].x);
+            __m128 qz = _mm_loadu_ps(&rotations[i + 2].x);
+            __m128 qw = _mm_loadu_ps(&rotations[i + 3].x);
+            _MM_TRANSPOSE4_PS(qx, qy, qz, qw);
+
+            glm::vec3 const * p  = positions + i;
+            std::uint32_t     k1 = k0 + 1 < joints ? k0 + 1 : 0, k2 = k1 + 1 < joints ? k1 + 1 : 0, k3 = k2 + 1 < joints ? k2 + 1 : 0;
+            __m128 const      px = _mm_setr_ps(p[0].x, p[1].x, p[2].x, p[3].x);
+            __m128 const      py = _mm_setr_ps(p[0].y, p[1].y, p[2].y, p[3].y);
+            __m128 const      pz = _mm_setr_ps(p[0].z, p[1].z, p[2].z, p[3].z);
+            __m128 const      rx = _mm_setr_ps(rest[k0].x, rest[k1].x, rest[k2].x, rest[k3].x);
+            __m128 const      ry = _mm_setr_ps(rest[k0].y, rest[k1].y, rest[k2].y, rest[k3].y);
+            __m128 const      rz = _mm_setr_ps(rest[k0].z, rest[k1].z, rest[k2].z, rest[k3].z);
+            k0                   = k3 + 1 < joints ? k3 + 1 : 0;
+
+            // Rest position rotated: r + w * c + v x c, with c = 2 v x r
+            __m128 cx, cy, cz, ex, ey, ez;
+            Cross(qx, qy, qz, rx, ry, rz, cx, cy, cz);
+            cx = _mm_mul_ps(cx, two), cy = _mm_mul_ps(cy, two), cz = _mm_mul_ps(cz, two);
+            Cross(qx, qy, qz, cx, cy, cz, ex, ey, ez);
+            __m128 const tx = _mm_sub_ps(px, _mm_add_ps(rx, _mm_add_ps(_mm_mul_ps(qw, cx), ex)));
+            __m128 const ty = _mm_sub_ps(py, _mm_add_ps(ry, _mm_add_ps(_mm_mul_ps(qw, cy), ey)));
+            __m128 const tz = _mm_sub_ps(pz, _mm_add_ps(rz, _mm_add_ps(_mm_mul_ps(qw, cz), ez)));
+
+            // Dual part: (w * t + t x v, -t . v) / 2
+            Cross(tx, ty, tz, qx, qy, qz, cx, cy, cz);
+            __m128 dx = _mm_mul_ps(half, _mm_add_ps(_mm_mul_ps(qw, tx), cx));
+            __m128 dy = _mm_mul_ps(half, _mm_add_ps(_mm_mul_ps(qw, ty), cy));
+            __m128 dz = _mm_mul_ps(half, _mm_add_ps(_mm_mul_ps(qw, tz), cz));
+            __m128 dw = _mm_sub_ps(_mm_setzero_ps(), _mm_mul_ps(half, _mm_add_ps(_mm_add_ps(_mm_mul_ps(tx, qx), _mm_mul_ps(ty, qy)), _mm_mul_ps(tz, qz))));
+
+            _MM_TRANSPOSE4_PS(qx, qy, qz, qw);
+            _MM_TRANSPOSE4_PS(dx, dy, dz, dw);
+            float * out = &palette[TexelsPerDualQuaternion * i].x;
+            _mm_storeu_ps(out, qx), _mm_storeu_ps(out + 4, dx);
+            _mm_storeu_ps(out + 8, qy), _mm_storeu_ps(out + 12, dy);
+            _mm_storeu_ps(out + 16, qz), _mm_storeu_ps(out + 20, dz);
+            _mm_storeu_ps(out + 24, qw), _mm_storeu_ps(out + 28, dw);
+        }
+#endif
+        for (; i < count; ++i)
+            ToDualQuaternion(rotations[i], positions[i] - rotations[i] * rest[i % joints], palette + TexelsPerDualQuaternion * i);
+    }
+}
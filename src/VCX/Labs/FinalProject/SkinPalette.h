@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+namespace VCX::Labs::FinalProject
+{
+    // Skinning transforms from global joint poses and the joints' rest positions. BVH rest poses
+    // have identity rotations, so each transform rotates about the rest position and moves it to
+    // the current one. Poses of `characters` skeletons with `joints` joints each lie back to back,
+    // the rest positions are shared.
+    inline constexpr std::uint32_t TexelsPerMatrix         = 3;    // Rows of a 3x4 matrix
+    inline constexpr std::uint32_t TexelsPerDualQuaternion = 2;    // Rotation, then dual part
+
+    void ComputeMatrixPalette(glm::quat const * rotations, glm::vec3 const * positions, glm::vec3 const * rest, std::uint32_t const joints, std::size_t const characters, glm::vec4 * palette);
+
+    // Four joints at a time with SSE2 where available.
+    void ComputeDualQuaternionPalette(glm::quat const * rotations, glm::vec3 const * positions, glm::vec3 const * rest, std::uint32_t const joints, std::size_t const characters, glm::vec4 * palette);
+
+    // One joint: the rotation q and the dual part t * q / 2, as (x, y, z, w) texels.
+    inline void ToDualQuaternion(glm::quat const & q, glm::vec3 const & translation, glm::vec4 * out)
+    {
+        glm::vec3 const v = { q.x, q.y, q.z };
+        glm::vec3 const d = .5f * (q.w * translation + glm::cross(translation, v));
+        out[0]            = glm::vec4(q.x, q.y, q.z, q.w);
+        out[1]            = glm::vec4(d, -.5f * glm::dot(translation, v));
+    }
+}
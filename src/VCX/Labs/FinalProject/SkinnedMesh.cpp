@@ -0,0 +1,318 @@
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <limits>
+#include <numeric>
+#include <sstream>
+#include <unordered_map>
+
+#include <spdlog/spdlog.h>
+
+#include "Engine/ThreadPool.hpp"
+#include "Engine/loader.h"
+#include "Labs/FinalProject/Pose.h"
+#include "Labs/FinalProject/SkinnedMesh.h"
+
+namespace VCX::Labs::FinalProject
+{
+    static constexpr std::uint32_t c_PassConstantsBinding = 0;
+    static constexpr int           c_TubeSides            = 12;
+    static constexpr int           c_TubeRings            = 6;
+    static constexpr float         c_MatchCell            = 1e-3f;  // Of the grid matching sidecar lines to vertices
+
+    static std::vector<glm::vec3> GetRestPositions(SkeletonDef const & def)
+    {
+        Pose pose;
+        pose.Resize(def.GetJointCount());
+        pose.Offsets = def.Offsets;
+        std::vector<glm::vec3> positions(def.GetJointCount());
+        std::vector<glm::quat> rotations(def.GetJointCount());
+        ForwardKinematics(def, pose, positions.data(), rotations.data());
+        return positions;
+    }
+
+    static float DistanceToSegment(glm::vec3 const & p, glm::vec3 const & a, glm::vec3 const & b)
+    {
+        glm::vec3 const ab = b - a;
+        float const     t  = glm::clamp(glm::dot(p - a, ab) / std::max(glm::dot(ab, ab), 1e-12f), 0.f, 1.f);
+        return glm::length(p - (a + t * ab));
+    }
+
+    SkinnedMesh SkinnedMesh::Load(std::filesystem::path const & path, std::shared_ptr<SkeletonDef const> skeleton)
+    {
+        std::error_code ec;
+        if (! std::filesystem::exists(path, ec)) return Generate(std::move(skeleton));
+
+        SkinnedMesh skin;
+        skin.Mesh = Engine::LoadSurfaceMesh(path);
+        if (skin.Mesh.GetVertexCount() == 0)
+        {
+            spdlog::warn("SkinnedMesh: no vertices in {}, generating a body.", path.string());
+            return Generate(std::move(skeleton));
+        }
+        skin.Skeleton      = std::move(skeleton);
+        skin.RestPositions = GetRestPositions(*skin.Skeleton);
+
+        // The sidecar is matched in the OBJ's own units, binding works in scene space
+        std::filesystem::path sidecar = path;
+        sidecar.replace_extension(".skin");
+        bool const weighted = std::filesystem::exists(sidecar, ec) && skin.LoadWeights(path, sidecar);
+        for (auto & p : skin.Mesh.Positions) p = SceneScale * p + SceneOffset;
+        if (! skin.Mesh.IsNormalAvailable()) skin.Mesh.Normals = skin.Mesh.ComputeNormals();
+        if (weighted) skin.Weighting = Source::Sidecar;
+        else skin.AutoBind();
+        return skin;
+    }
+
+    SkinnedMesh SkinnedMesh::Generate(std::shared_ptr<SkeletonDef const> skeleton)
+    {
+        SkinnedMesh skin;
+        skin.Skeleton      = std::move(skeleton);
+        skin.RestPositions = GetRestPositions(*skin.Skeleton);
+
+        // An open tube around each bone, with enough rings to bend smoothly at the joints
+        auto & mesh = skin.Mesh;
+        for (std::uint32_t j = 0; j < skin.Skeleton->GetJointCount(); ++j)
+        {
+            int const parent = skin.Skeleton->Parents[j];
+            if (parent < 0) continue;
+            glm::vec3 const a      = skin.RestPositions[parent];
+            glm::vec3 const b      = skin.RestPositions[j];
+            float const     length = glm::length(b - a);
+            if (length < 1e-4f) continue;
+
+            glm::vec3 const axis   = (b - a) / length;
+            glm::vec3 const u      = glm::normalize(glm::cross(axis, std::abs(axis.y) < .9f ? glm::vec3(0.f, 1.f, 0.f) : glm::vec3(1.f, 0.f, 0.f)));
+            glm::vec3 const v      = glm::cross(axis, u);
+            float const     radius = glm::clamp(.18f * length, .015f, .06f);
+            auto const      first  = std::uint32_t(mesh.Positions.size());
+            for (int r = 0; r <= c_TubeRings; ++r)
+            {
+                float const t = float(r) / c_TubeRings;
+                for (int s = 0; s <= c_TubeSides; ++s)
+                {
+                    float const     angle  = 2.f * glm::pi<float>() * s / c_TubeSides;
+                    glm::vec3 const normal = std::cos(angle) * u + std::sin(angle) * v;
+                    mesh.Positions.push_back(a + t * (b - a) + radius * normal);
+                    mesh.Normals.push_back(normal);
+                    mesh.TexCoords.emplace_back(float(s) / c_TubeSides, t);
+                }
+            }
+            for (int r = 0; r < c_TubeRings; ++r)
+            {
+                for (int s = 0; s < c_TubeSides; ++s)
+                {
+                    std::uint32_t const i0 = first + r * (c_TubeSides + 1) + s;
+                    std::uint32_t const i1 = i0 + c_TubeSides + 1;
+                    mesh.Indices.insert(mesh.Indices.end(), { i0, i0 + 1, i1 + 1, i0, i1 + 1, i1 });
+                }
+            }
+        }
+        skin.AutoBind();
+        skin.Weighting = Source::Generated;
+        return skin;
+    }
+
+    void SkinnedMesh::AutoBind()
+    {
+        Weighting = Source::Automatic;
+        std::uint32_t const joints = Skeleton->GetJointCount();
+        std::size_t const   count  = Mesh.GetVertexCount();
+        Joints.assign(count, glm::vec4(0.f));
+        Weights.assign(count, glm::vec4(1.f, 0.f, 0.f, 0.f));
+
+        Engine::ThreadPool::Global().ParallelFor(count, 256, [&](std::size_t const begin, std::size_t const end) {
+            // Each bone, from a joint to one of its children, moves with that joint
+            std::vector<float>         distance(joints);
+            std::vector<std::uint32_t> order(joints);
+            for (std::size_t i = begin; i < end; ++i)
+            {
+                std::fill(distance.begin(), distance.end(), std::numeric_limits<float>::infinity());
+                for (std::uint32_t j = 0; j < joints; ++j)
+                {
+                    int const parent = Skeleton->Parents[j];
+                    if (parent < 0) continue;
+                    distance[parent] = std::min(distance[parent], DistanceToSegment(Mesh.Positions[i], RestPositions[parent], RestPositions[j]));
+                }
+
+                std::uint32_t const influences = std::min(joints, MaxInfluences);
+                std::iota(order.begin(), order.end(), 0u);
+                std::partial_sort(order.begin(), order.begin() + influences, order.end(), [&](std::uint32_t const a, std::uint32_t const b) { return distance[a] < distance[b]; });
+
+                glm::vec4 weights(0.f);
+                for (std::uint32_t k = 0; k < influences && std::isfinite(distance[order[k]]); ++k)
+                {
+                    float const d = std::max(distance[order[k]], 1e-3f);
+                    Joints[i][k]  = float(order[k]);
+                    weights[k]    = 1.f / (d * d * d * d);
+                }
+                float const sum = weights.x + weights.y + weights.z + weights.w;
+                if (sum > 0.f) Weights[i] = weights / sum;
+            }
+        });
+    }
+
+    bool SkinnedMesh::LoadWeights(std::filesystem::path const & mesh, std::filesystem::path const & sidecar)
+    {
+        std::ifstream obj(mesh), skin(sidecar);
+        if (! obj || ! skin) return false;
+
+        // The loader welds and splits vertices by their attributes, so each loaded vertex finds its
+        // "v" line by position, on a grid to be safe from parsers rounding differently
+        auto const cell = [](glm::vec3 const & p) {
+            return glm::ivec3(glm::floor(p / c_MatchCell));
+        };
+        auto const key = [](glm::ivec3 const & c) {
+            return (std::uint64_t(std::uint32_t(c.x) & 0x1fffff) << 42) | (std::uint64_t(std::uint32_t(c.y) & 0x1fffff) << 21) | (std::uint32_t(c.z) & 0x1fffff);
+        };
+        std::vector<glm::vec3>                                          lines;
+        std::unordered_map<std::uint64_t, std::vector<std::uint32_t>>   grid;
+        std::string                                                     line;
+        while (std::getline(obj, line))
+        {
+            if (line.size() < 2 || line[0] != 'v' || (line[1] != ' ' && line[1] != '\t')) continue;
+            std::istringstream in(line.substr(2));
+            double             x = 0., y = 0., z = 0.;
+            in >> x >> y >> z;
+            grid[key(cell(glm::vec3(x, y, z)))].push_back(std::uint32_t(lines.size()));
+            lines.emplace_back(x, y, z);
+        }
+
+        // Up to MaxInfluences "joint weight" pairs per line, the strongest kept
+        std::vector<std::array<std::pair<float, int>, MaxInfluences>> influences;
+        std::size_t                                                   unknown = 0;
+        while (std::getline(skin, line))
+        {
+            if (line.empty() || line[0] == '#') continue;
+            std::istringstream in(line);
+            std::array<std::pair<float, int>, MaxInfluences> entry;
+            entry.fill({ 0.f, 0 });
+            std::string name;
+            float       weight = 0.f;
+            while (in >> name >> weight)
+            {
+                int const joint = Skeleton->Find(name);
+                if (joint < 0)
+                {
+                    ++unknown;
+                    continue;
+                }
+                auto weakest = std::min_element(entry.begin(), entry.end());
+                if (weight > weakest->first) *weakest = { weight, joint };
+            }
+            influences.push_back(entry);
+        }
+        if (unknown > 0) spdlog::warn("SkinnedMesh: {} weights in {} refer to joints missing from the skeleton.", unknown, sidecar.string());
+        if (influences.size() != lines.size())
+        {
+            spdlog::warn("SkinnedMesh: {} has {} lines for {} vertices, binding automatically.", sidecar.string(), influences.size(), lines.size());
+            return false;
+        }
+
+        std::size_t const count = Mesh.GetVertexCount();
+        Joints.assign(count, glm::vec4(0.f));
+        Weights.assign(count, glm::vec4(1.f, 0.f, 0.f, 0.f));
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            glm::vec3 const & p       = Mesh.Positions[i];
+            glm::ivec3 const  center  = cell(p);
+            float             nearest = std::numeric_limits<float>::infinity();
+            std::uint32_t     match   = 0;
+            for (int dx = -1; dx <= 1; ++dx)
+                for (int dy = -1; dy <= 1; ++dy)
+                    for (int dz = -1; dz <= 1; ++dz)
+                    {
+                        auto const iter = grid.find(key(center + glm::ivec3(dx, dy, dz)));
+                        if (iter == grid.end()) continue;
+                        for (std::uint32_t const index : iter->second)
+                        {
+                            float const d = glm::length(lines[index] - p);
+                            if (d >= nearest) continue;
+                            nearest = d;
+                            match   = index;
+                        }
+                    }
+            if (! std::isfinite(nearest)) continue;
+
+            glm::vec4 weights(0.f);
+            for (std::uint32_t k = 0; k < MaxInfluences; ++k)
+            {
+                Joints[i][k] = float(influences[match][k].second);
+                weights[k]   = influences[match][k].first;
+            }
+            float const sum = weights.x + weights.y + weights.z + weights.w;
+            if (sum > 0.f) Weights[i] = weights / sum;
+        }
+        return true;
+    }
+
+    SkinRender::SkinRender() :
+        _program(
+            Engine::GL::UniqueProgram({
+                Engine::GL::SharedShader("assets/shaders/skin.vert"),
+                Engine::GL::SharedShader("assets/shaders/three.geom"),
+                Engine::GL::SharedShader("assets/shaders/three.frag")})),
+        _item(
+            Engine::GL::VertexLayout()
+                .Add<glm::vec3>("position", Engine::GL::DrawFrequency::Static, 0)
+                .Add<glm::vec3>("normal", Engine::GL::DrawFrequency::Static, 1)
+                .Add<glm::vec2>("texcoord", Engine::GL::DrawFrequency::Static, 2)
+                .Add<glm::vec4>("joints", Engine::GL::DrawFrequency::Static, 3)
+                .Add<glm::vec4>("weights", Engine::GL::DrawFrequency::Static, 4),
+            Engine::GL::PrimitiveType::Triangles),
+        _palette(GL_RGBA32F, 0),
+        _constants(c_PassConstantsBinding, Engine::GL::DrawFrequency::Dynamic)
+    {
+        _program.BindUniformBlock("PassConstants", c_PassConstantsBinding);
+        _program.GetUniforms().SetByName("u_Palette", int(_palette.GetUnit()));
+    }
+
+    void SkinRender::Load(SkinnedMesh const & skin)
+    {
+        auto const & mesh = skin.Mesh;
+        _hasTexCoord      = mesh.IsTexCoordAvailable();
+        _item.UpdateVertexBuffer("position", Engine::make_span_bytes<glm::vec3>(mesh.Positions));
+        _item.UpdateVertexBuffer("normal", Engine::make_span_bytes<glm::vec3>(mesh.Normals));
+        _item.UpdateVertexBuffer("texcoord", Engine::make_span_bytes<glm::vec2>(_hasTexCoord ? mesh.TexCoords : mesh.GetEmptyTexCoords()));
+        _item.UpdateVertexBuffer("joints", Engine::make_span_bytes<glm::vec4>(skin.Joints));
+        _item.UpdateVertexBuffer("weights", Engine::make_span_bytes<glm::vec4>(skin.Weights));
+        _item.UpdateElementBuffer(mesh.Indices);
+        _rest = skin.RestPositions;
+    }
+
+    void SkinRender::Update(Skeleton const & pose)
+    {
+        if (pose.Joints.size() != _rest.size()) return;
+
+        auto const start = std::chrono::steady_clock::now();
+        if (Skinning == Method::DualQuaternion) pose.GetDualQuaternionPalette(_rest, _texels);
+        else pose.GetMatrixPalette(_rest, _texels);
+        _palette.Update(Engine::make_span_bytes<glm::vec4>(_texels), Engine::GL::DrawFrequency::Stream);
+        if (_uploaded != Skinning)
+        {
+            _uploaded = Skinning;
+            _program.GetUniforms().SetByName("u_DualQuaternion", int(Skinning == Method::DualQuaternion));
+        }
+        float const ms = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+        _paletteMs     = _paletteMs == 0.f ? ms : .9f * _paletteMs + .1f * ms;
+    }
+
+    void SkinRender::Render(glm::mat4 const & projection, glm::mat4 const & view)
+    {
+        if (IsEmpty()) return;
+        PassConstants constants;
+        constants.View           = view;
+        constants.Projection     = projection;
+        constants.LightDirection = glm::normalize(glm::vec3(-1.f, -3.f, -2.f));
+        constants.ObjectColor    = Color;
+        constants.Ambient        = .25f;
+        constants.HasTexCoord    = _hasTexCoord;
+        _constants.Update(constants);
+
+        Engine::GL::State::Enable(GL_DEPTH_TEST);
+        _item.Draw({ _program.Use(), _palette.Use() });
+        Engine::GL::State::Disable(GL_DEPTH_TEST);
+    }
+}
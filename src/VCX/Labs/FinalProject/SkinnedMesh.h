@@ -0,0 +1,98 @@
+#pragma once
+
+#include <filesystem>
+#include <memory>
+#include <vector>
+
+#include "Engine/GL/Program.h"
+#include "Engine/GL/RenderItem.h"
+#include "Engine/GL/TextureBuffer.hpp"
+#include "Engine/GL/UniformBlock.hpp"
+#include "Engine/SurfaceMesh.h"
+#include "Labs/FinalProject/Skeleton.h"
+
+namespace VCX::Labs::FinalProject
+{
+    // Triangle mesh bound to the rest pose of a skeleton with up to four joint influences per
+    // vertex. Positions are in scene space like the joints, joint indices follow the SkeletonDef.
+    struct SkinnedMesh
+    {
+        static constexpr std::uint32_t MaxInfluences = 4;
+
+        enum class Source { Sidecar, Automatic, Generated };
+
+        Engine::SurfaceMesh                 Mesh;
+        std::vector<glm::vec4>              Joints;         // Indices as floats, for the vertex attribute
+        std::vector<glm::vec4>              Weights;        // Summing to one
+        std::vector<glm::vec3>              RestPositions;  // Of the joints, in scene space
+        std::shared_ptr<SkeletonDef const>  Skeleton;
+        Source                              Weighting = Source::Automatic;
+
+        // An OBJ modelled in the skeleton's units around its rest pose. Weights come from a sidecar
+        // with the extension ".skin" when there is one: a line per "v" of the OBJ with up to four
+        // "joint weight" pairs, joints by name. Otherwise vertices are bound to the nearest bones.
+        // Without a mesh file, tubes are generated around the bones instead.
+        static SkinnedMesh Load(std::filesystem::path const & path, std::shared_ptr<SkeletonDef const> skeleton);
+        static SkinnedMesh Generate(std::shared_ptr<SkeletonDef const> skeleton);
+
+        // Weights from the distance to each joint's bones, inverse fourth power over the nearest
+        // MaxInfluences joints, so vertices near a joint blend the bones on both sides.
+        void AutoBind();
+        bool LoadWeights(std::filesystem::path const & mesh, std::filesystem::path const & sidecar);
+
+        std::size_t GetVertexCount() const { return Mesh.GetVertexCount(); }
+    };
+
+    // Mirrors the PassConstants block of three.vert/three.geom/three.frag (std140).
+    struct PassConstants
+    {
+        glm::mat4   NormalTransform { 1.f };
+        glm::mat4   Model           { 1.f };
+        glm::mat4   View            { 1.f };
+        glm::mat4   Projection      { 1.f };
+        glm::vec3   LightDirection  { 0.f, -1.f, 0.f };
+        float       Padding0        = 0.f;
+        glm::vec3   LightColor      { 1.f };
+        float       Padding1        = 0.f;
+        glm::vec3   ObjectColor     { 1.f };
+        float       Ambient         = 0.2f;
+        int         HasTexCoord     = 0;
+        int         Wireframe       = 0;
+        int         Flat            = 0;
+        int         Padding2        = 0;
+    };
+
+    // Draws a skinned mesh with the lighting of the three.* shaders. Per frame the CPU only fills
+    // the palette, one transform per joint in a buffer texture; vertices are skinned in skin.vert,
+    // so the CPU cost does not grow with the vertex count. Dual quaternions take two texels per
+    // joint instead of three and keep the volume of twisting joints, where blended matrices shrink.
+    class SkinRender
+    {
+    public:
+        enum class Method { Linear, DualQuaternion };
+
+        SkinRender();
+
+        void Load(SkinnedMesh const & mesh);
+        void Update(Skeleton const & pose);
+        void Render(glm::mat4 const & projection, glm::mat4 const & view);
+
+        bool  IsEmpty() const { return _rest.empty(); }
+        float GetPaletteMs() const { return _paletteMs; }
+        std::size_t GetPaletteBytes() const { return _palette.GetByteSize(); }
+
+        glm::vec3 Color   { .8f, .62f, .48f };
+        Method    Skinning = Method::DualQuaternion;
+
+    private:
+        Engine::GL::UniqueProgram                       _program;
+        Engine::GL::UniqueIndexedRenderItem             _item;
+        Engine::GL::UniqueTextureBuffer                 _palette;
+        Engine::GL::UniqueUniformBlock<PassConstants>   _constants;
+        std::vector<glm::vec3>                          _rest;
+        std::vector<glm::vec4>                          _texels;        // Three or two per joint
+        Method                                          _uploaded    = Method::Linear;  // What the palette and u_DualQuaternion hold
+        bool                                            _hasTexCoord = false;
+        float                                           _paletteMs   = 0.f; // Smoothed palette update time
+    };
+}
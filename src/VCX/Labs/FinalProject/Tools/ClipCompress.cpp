@@ -0,0 +1,84 @@
+// Compresses every clip of the library within a positional tolerance and reports the size, the
+// error measured through forward kinematics, and the encode and single-frame decode times.
+//
+//   xmake run clip-compress [--data assets/BVH_data] [--tolerance 0.001]
+
+#include <chrono>
+#include <cstdlib>
+#include <string>
+#include <string_view>
+
+#include <fmt/core.h>
+
+#include "Labs/FinalProject/BVHLoader.h"
+#include "Labs/FinalProject/ClipLibrary.h"
+#include "Labs/FinalProject/CompressedClip.h"
+
+using namespace VCX::Labs::FinalProject;
+
+static double Seconds(std::chrono::steady_clock::time_point const start)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+int main(int argc, char ** argv)
+{
+    std::string data      = "assets/BVH_data";
+    float       tolerance = 1e-3f;
+    for (int i = 1; i + 1 < argc; i += 2)
+    {
+        std::string_view const arg = argv[i];
+        if (arg == "--data") data = argv[i + 1];
+        else if (arg == "--tolerance") tolerance = std::strtof(argv[i + 1], nullptr);
+        else
+        {
+            fmt::print(stderr, "Unknown option {}\n", arg);
+            return 1;
+        }
+    }
+
+    BVHLoader         loader;
+    CompressionReport total;
+    std::size_t       clips = 0;
+    std::size_t       over  = 0;    // Not within the tolerance even with every frame kept
+    fmt::print("Tolerance {} scene units\n", tolerance);
+    fmt::print("{:<32} {:>7} {:>10} {:>10} {:>7} {:>7} {:>10} {:>10} {:>9} {:>11}\n", "Clip", "Frames", "Raw KB", "Packed KB", "Ratio", "Keys", "Max err", "Mean err", "Encode ms", "Decode us/f");
+    for (auto const & path : FindClips(data))
+    {
+        auto clip = loader.LoadClip(path.c_str());
+        if (! clip || clip->Frames == 0) continue;
+
+        auto const start      = std::chrono::steady_clock::now();
+        auto       compressed = CompressedClip::Compress(*clip, tolerance);
+        double const encode   = Seconds(start);
+
+        // Frames in a scattered order, so that decoding cannot lean on the previous frame
+        Pose         pose;
+        auto const   begin = std::chrono::steady_clock::now();
+        for (std::uint32_t i = 0; i < clip->Frames; ++i)
+            compressed->SampleFrame(std::uint32_t((std::uint64_t(i) * 7919) % clip->Frames), pose);
+        double const decode = Seconds(begin);
+
+        auto const report = MeasureCompression(*clip, *compressed);
+        fmt::print("{:<32} {:>7} {:>10.1f} {:>10.1f} {:>6.1f}x {:>7} {:>10.6f} {:>10.6f} {:>9.1f} {:>11.2f}\n",
+            std::string_view(path).substr(path.find_last_of("/\\") + 1), clip->Frames,
+            report.RawBytes / 1024., report.CompressedBytes / 1024., report.GetRatio(), report.Keys,
+            report.MaxError, report.MeanError, 1e3 * encode, 1e6 * decode / clip->Frames);
+
+        total.RawBytes        += report.RawBytes;
+        total.CompressedBytes += report.CompressedBytes;
+        total.Keys            += report.Keys;
+        total.MaxError         = std::max(total.MaxError, report.MaxError);
+        if (compressed->GetError() > tolerance) ++over;
+        ++clips;
+    }
+    if (clips == 0)
+    {
+        fmt::print(stderr, "No clips under {}\n", data);
+        return 1;
+    }
+    fmt::print("{} clips: {:.1f} KB -> {:.1f} KB ({:.1f}x), {} keys, max error {:.6f}\n",
+        clips, total.RawBytes / 1024., total.CompressedBytes / 1024., total.GetRatio(), total.Keys, total.MaxError);
+    if (over > 0) fmt::print(stderr, "{} clips exceed the tolerance after quantization\n", over);
+    return over == 0 ? 0 : 1;
+}
@@ -0,0 +1,127 @@
+// Packs the clip library into one archive, then reopens it and reports how long opening, looking
+// up every clip by name and reading all of their rows take, against parsing the BVH files.
+//
+//   xmake run clip-pack [--data assets/BVH_data] [--out assets/BVH_data.clar] [--verify 0|1]
+//
+// Clips are named by their path below --data, e.g. "01_01.bvh". With --verify 1 every clip is
+// parsed again and compared row for row with its archived copy.
+
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <filesystem>
+#include <string>
+#include <string_view>
+
+#include <fmt/core.h>
+
+#include "Labs/FinalProject/BVHLoader.h"
+#include "Labs/FinalProject/ClipArchive.h"
+#include "Labs/FinalProject/ClipLibrary.h"
+
+using namespace VCX::Labs::FinalProject;
+
+static double Seconds(std::chrono::steady_clock::time_point const start)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+int main(int argc, char ** argv)
+{
+    std::string data   = "assets/BVH_data";
+    std::string output = "assets/BVH_data.clar";
+    bool        verify = false;
+    for (int i = 1; i + 1 < argc; i += 2)
+    {
+        std::string_view const arg = argv[i];
+        if (arg == "--data") data = argv[i + 1];
+        else if (arg == "--out") output = argv[i + 1];
+        else if (arg == "--verify") verify = std::strtol(argv[i + 1], nullptr, 10) != 0;
+        else
+        {
+            fmt::print(stderr, "Unknown option {}\n", arg);
+            return 1;
+        }
+    }
+
+    ClipList const           paths = FindClips(data);
+    std::vector<std::string> names;
+    for (auto const & path : paths) names.push_back(std::filesystem::path(path).lexically_relative(data).generic_string());
+
+    auto start = std::chrono::steady_clock::now();
+    if (! ClipArchive::Pack(names, LoadClipFiles(paths), output))
+    {
+        fmt::print(stderr, "Cannot write {}\n", output);
+        return 1;
+    }
+    double const packTime = Seconds(start);
+
+    start                 = std::chrono::steady_clock::now();
+    auto const   archive  = ClipArchive::Open(output);
+    double const openTime = Seconds(start);
+    if (! archive)
+    {
+        fmt::print(stderr, "Cannot open {}\n", output);
+        return 1;
+    }
+
+    // Every clip by name, then a pass over all rows, the first touch of the mapped pages
+    start = std::chrono::steady_clock::now();
+    std::vector<std::shared_ptr<Clip const>> clips;
+    for (auto const & name : names)
+        if (auto clip = archive->GetClip(name)) clips.push_back(std::move(clip));
+    double const lookupTime = Seconds(start);
+
+    start               = std::chrono::steady_clock::now();
+    std::size_t frames  = 0;
+    double      checksum = 0.;
+    for (auto const & clip : clips)
+    {
+        std::size_t const count = std::size_t(clip->Frames) * clip->Skeleton->ChannelCount;
+        for (std::size_t k = 0; k < count; ++k) checksum += clip->GetData()[k];
+        frames += clip->Frames;
+    }
+    double const readTime = Seconds(start);
+
+    fmt::print(
+        "{} of {} clips, {} frames, {} skeletons, {:.1f} MB\n"
+        "parse and pack {:.2f} s, open {:.3f} ms, {} lookups by name {:.3f} ms, first read of all rows {:.1f} ms (checksum {:.6g})\n",
+        archive->GetClipCount(), paths.size(), frames, archive->GetSkeletons().size(), archive->GetByteSize() / 1e6,
+        packTime, openTime * 1e3, clips.size(), lookupTime * 1e3, readTime * 1e3, checksum);
+
+    // Pack leaves out clips that failed to parse
+    std::size_t const skipped = paths.size() - archive->GetClipCount();
+    if (skipped > 0) fmt::print(stderr, "{} clips could not be parsed and were left out\n", skipped);
+    if (! verify) return skipped == 0 ? 0 : 1;
+
+    std::size_t mismatches = 0, failed = 0;
+    for (std::size_t i = 0; i < paths.size(); ++i)
+    {
+        std::shared_ptr<Clip const> parsed;
+        try
+        {
+            BVHLoader loader;
+            parsed = loader.LoadClip(paths[i].c_str());
+        }
+        catch (std::exception const & e)
+        {
+            fmt::print(stderr, "Cannot parse {}: {}\n", names[i], e.what());
+        }
+        if (! parsed)
+        {
+            ++failed;
+            continue;
+        }
+        auto const archived = archive->GetClip(names[i]);
+        bool const same     = archived && parsed->Skeleton == archived->Skeleton && parsed->Frames == archived->Frames && parsed->FrameTime == archived->FrameTime
+            && std::memcmp(parsed->GetData(), archived->GetData(), parsed->Channels.size() * sizeof(float)) == 0;
+        if (! same)
+        {
+            fmt::print(stderr, "Mismatch in {}\n", names[i]);
+            ++mismatches;
+        }
+    }
+    fmt::print("Verified against the BVH files: {} mismatches, {} not parsed\n", mismatches, failed);
+    return mismatches == 0 && failed == 0 && skipped == 0 ? 0 : 1;
+}
@@ -0,0 +1,183 @@
+// Resamples every clip of the library to one frame rate in parallel and writes the results as BVH
+// files, or packs them into one ClipArchive as a binary cache. Reports frames and baked memory
+// before and after, the resampling time, and how far the joints move from the source clips.
+//
+//   xmake run clip-resample [--data assets/BVH_data] [--fps 30] [--rotations cubic|slerp]
+//                           [--prefilter 1] [--format bvh|archive] [--out resampled]
+//
+// BVH files keep their path below --data; an archive is written to --out plus ".clar".
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <fmt/core.h>
+
+#include "Engine/ThreadPool.hpp"
+#include "Labs/FinalProject/BVHLoader.h"
+#include "Labs/FinalProject/ClipArchive.h"
+#include "Labs/FinalProject/ClipLibrary.h"
+#include "Labs/FinalProject/Resample.h"
+
+using namespace VCX::Labs::FinalProject;
+
+static double Seconds(std::chrono::steady_clock::time_point const start)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+static std::size_t GetBakedBytes(BakedClip const & clip)
+{
+    return clip.Rotations.size() * sizeof(glm::quat) + clip.Offsets.size() * sizeof(glm::vec3);
+}
+
+// Joint position distances, in BVH units, between each resampled frame and the source at the same
+// time. The mean shows the smoothing of the prefilter; the largest is usually a glitched source
+// frame (often the first one) spread over its neighbours.
+struct Deviation
+{
+    float       Max   = 0.f;
+    double      Sum   = 0.;
+    std::size_t Count = 0;
+};
+
+static Deviation MeasureError(BakedClip const & source, BakedClip const & resampled)
+{
+    std::uint32_t const    joints = source.Skeleton->GetJointCount();
+    Pose                   a, b;
+    std::vector<glm::vec3> pa(joints), pb(joints);
+    std::vector<glm::quat> ra(joints), rb(joints);
+    Deviation              error;
+    for (std::uint32_t f = 0; f < resampled.Frames; ++f)
+    {
+        source.Sample(f * resampled.FrameTime, false, a);
+        resampled.SampleFrame(f, b);
+        ForwardKinematics(*source.Skeleton, a, pa.data(), ra.data());
+        ForwardKinematics(*source.Skeleton, b, pb.data(), rb.data());
+        for (std::uint32_t j = 0; j < joints; ++j)
+        {
+            float const distance = glm::length(pa[j] - pb[j]) / SceneScale;
+            error.Max            = std::max(error.Max, distance);
+            error.Sum           += distance;
+        }
+        error.Count += joints;
+    }
+    return error;
+}
+
+int main(int argc, char ** argv)
+{
+    std::string      data    = "assets/BVH_data";
+    std::string      output  = "resampled";
+    bool             archive = false;
+    ResampleSettings settings;
+    for (int i = 1; i + 1 < argc; i += 2)
+    {
+        std::string_view const arg   = argv[i];
+        std::string_view const value = argv[i + 1];
+        if (arg == "--data") data = value;
+        else if (arg == "--out") output = value;
+        else if (arg == "--fps") settings.FrameRate = std::strtof(argv[i + 1], nullptr);
+        else if (arg == "--rotations") settings.Rotations = value == "slerp" ? RotationInterpolation::Slerp : RotationInterpolation::Cubic;
+        else if (arg == "--prefilter") settings.Prefilter = std::strtol(argv[i + 1], nullptr, 10) != 0;
+        else if (arg == "--format") archive = value == "archive";
+        else
+        {
+            fmt::print(stderr, "Unknown option {}\n", arg);
+            return 1;
+        }
+    }
+    if (settings.FrameRate <= 0.f)
+    {
+        fmt::print(stderr, "--fps must be positive\n");
+        return 1;
+    }
+
+    ClipList const           paths = FindClips(data);
+    std::vector<std::string> names;
+    for (auto const & path : paths) names.push_back(std::filesystem::path(path).lexically_relative(data).generic_string());
+
+    std::atomic<std::size_t>   framesIn = 0, framesOut = 0, bytesIn = 0, bytesOut = 0, nanoseconds = 0, failed = 0;
+    std::mutex                 mutex;
+    Deviation                  error;
+    auto const process = [&](std::size_t const index) -> std::shared_ptr<Clip const> {
+        std::shared_ptr<Clip const> clip;
+        try
+        {
+            BVHLoader loader;
+            clip = loader.LoadClip(paths[index].c_str());
+        }
+        catch (std::exception const & e)
+        {
+            // Malformed files throw from the parser, and the pool must not see it
+            std::lock_guard lock(mutex);
+            fmt::print(stderr, "Cannot load {}: {}\n", paths[index], e.what());
+        }
+        if (! clip || clip->Frames == 0)
+        {
+            ++failed;
+            return nullptr;
+        }
+        auto const source    = BakedClip::Bake(*clip);
+        auto const start     = std::chrono::steady_clock::now();
+        auto const resampled = Resample(*source, settings);
+        nanoseconds += std::size_t(Seconds(start) * 1e9);
+
+        Deviation const deviation = MeasureError(*source, *resampled);
+        framesIn  += source->Frames;
+        framesOut += resampled->Frames;
+        bytesIn   += GetBakedBytes(*source);
+        bytesOut  += GetBakedBytes(*resampled);
+        std::lock_guard lock(mutex);
+        error.Max    = std::max(error.Max, deviation.Max);
+        error.Sum   += deviation.Sum;
+        error.Count += deviation.Count;
+        return Unbake(*resampled);
+    };
+
+    auto const start = std::chrono::steady_clock::now();
+    if (archive)
+    {
+        // Packing loads its batches of clips in parallel, the resampling happens there
+        if (! ClipArchive::Pack(names, process, output + ".clar"))
+        {
+            fmt::print(stderr, "Cannot write {}.clar\n", output);
+            return 1;
+        }
+    }
+    else
+    {
+        VCX::Engine::ThreadPool::Global().ParallelFor(paths.size(), 1, [&](std::size_t const begin, std::size_t const end) {
+            for (std::size_t i = begin; i < end; ++i)
+            {
+                auto const clip = process(i);
+                if (! clip) continue;
+                std::filesystem::path const path = std::filesystem::path(output) / names[i];
+                std::error_code             ec;
+                std::filesystem::create_directories(path.parent_path(), ec);
+                if (! SaveBVH(*clip, path.string()))
+                {
+                    ++failed;
+                    std::lock_guard lock(mutex);
+                    fmt::print(stderr, "Cannot write {}\n", path.string());
+                }
+            }
+        });
+    }
+    double const seconds = Seconds(start);
+
+    fmt::print(
+        "{} clips to {} fps ({} rotations{}): {} -> {} frames, {:.1f} -> {:.1f} MB baked\n"
+        "resampling {:.1f} ms ({:.0f} frames/s), total with loading and writing {:.2f} s\n"
+        "joint deviation from the source {:.3f} units on average, {:.3f} at most\n",
+        paths.size() - failed, settings.FrameRate, settings.Rotations == RotationInterpolation::Cubic ? "cubic" : "slerp", settings.Prefilter ? ", box prefilter" : "",
+        framesIn.load(), framesOut.load(), bytesIn / 1e6, bytesOut / 1e6,
+        nanoseconds / 1e6, framesOut / std::max(nanoseconds / 1e9, 1e-9), seconds, error.Sum / std::max<std::size_t>(error.Count, 1), error.Max);
+    return failed == 0 ? 0 : 1;
+}
@@ -0,0 +1,134 @@
+// Finds the clips (or stretches of clips) most similar to a query clip by dynamic time warping, and
+// times the search with and without lower-bound pruning and early abandoning. `--copies` grows the
+// library with jittered copies of the clips to measure throughput on more than a handful of pairs.
+//
+//   xmake run clip-similar [--data assets/BVH_data] [--query <clip>] [--from 0] [--to <seconds>]
+//                          [--mode clip|sub] [--k 5] [--band 0.1] [--copies 0]
+
+#include <chrono>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <string_view>
+
+#include <fmt/core.h>
+
+#include "Engine/ThreadPool.hpp"
+#include "Labs/FinalProject/BVHLoader.h"
+#include "Labs/FinalProject/ClipLibrary.h"
+#include "Labs/FinalProject/ClipSimilarity.h"
+
+using namespace VCX::Labs::FinalProject;
+
+// Copy of a clip with every rotation channel jittered by up to a degree.
+static std::shared_ptr<Clip const> Jitter(Clip const & source, std::uint32_t const seed)
+{
+    auto                                  clip = std::make_shared<Clip>(source);
+    std::mt19937                          rng(seed);
+    std::uniform_real_distribution<float> noise(-1.f, 1.f);
+    SkeletonDef const &                   def = *clip->Skeleton;
+    for (std::uint32_t f = 0; f < clip->Frames; ++f)
+    {
+        float * row = clip->Channels.data() + std::size_t(f) * def.ChannelCount;
+        for (std::uint32_t j = 0; j < def.GetJointCount(); ++j)
+        {
+            if (def.ChannelOffsets[j] < 0) continue;
+            int const rotation = def.ChannelOffsets[j] + (def.Channels[j] == 6 ? 3 : 0);
+            for (int c = 0; c < 3; ++c) row[rotation + c] += noise(rng);
+        }
+    }
+    return clip;
+}
+
+int main(int argc, char ** argv)
+{
+    std::string              data   = "assets/BVH_data";
+    std::string              query;
+    float                    from   = 0.f;
+    float                    to     = -1.f;
+    std::uint32_t            copies = 0;
+    SimilarityIndex::Query   options { .K = 5 };
+    for (int i = 1; i + 1 < argc; i += 2)
+    {
+        std::string_view const arg = argv[i];
+        if (arg == "--data") data = argv[i + 1];
+        else if (arg == "--query") query = argv[i + 1];
+        else if (arg == "--from") from = std::strtof(argv[i + 1], nullptr);
+        else if (arg == "--to") to = std::strtof(argv[i + 1], nullptr);
+        else if (arg == "--mode") options.Subsequence = std::string_view(argv[i + 1]) == "sub";
+        else if (arg == "--k") options.K = std::uint32_t(std::strtoul(argv[i + 1], nullptr, 10));
+        else if (arg == "--band") options.Band = std::strtof(argv[i + 1], nullptr);
+        else if (arg == "--copies") copies = std::uint32_t(std::strtoul(argv[i + 1], nullptr, 10));
+        else
+        {
+            fmt::print(stderr, "Unknown option {}\n", arg);
+            return 1;
+        }
+    }
+
+    BVHLoader                                loader;
+    std::vector<std::shared_ptr<Clip const>> clips;
+    std::vector<std::string>                 paths;
+    for (auto const & path : FindClips(data))
+    {
+        if (auto clip = loader.LoadClip(path.c_str()); clip && clip->Frames > 0)
+        {
+            clips.push_back(clip);
+            paths.push_back(path);
+        }
+    }
+    if (clips.empty())
+    {
+        fmt::print(stderr, "No clips under {}\n", data);
+        return 1;
+    }
+    if (query.empty()) query = paths.front();
+
+    // Originals first, then the copies
+    std::vector<std::string> names = paths;
+    for (std::uint32_t c = 1; c <= copies; ++c)
+        for (auto const & path : paths) names.push_back(fmt::format("{}#{}", path, c));
+    auto const index = SimilarityIndex::Build(names, [&](std::size_t const i) {
+        return i < clips.size() ? clips[i] : Jitter(*clips[i % clips.size()], std::uint32_t(i));
+    });
+
+    auto const source = loader.LoadClip(query.c_str());
+    if (! source)
+    {
+        fmt::print(stderr, "Cannot load {}\n", query);
+        return 1;
+    }
+    std::uint32_t const begin = std::min(std::uint32_t(std::max(from, 0.f) / source->FrameTime), source->Frames - 1);
+    std::uint32_t const end   = to > 0.f ? std::clamp(std::uint32_t(to / source->FrameTime), begin + 1, source->Frames) : source->Frames;
+    std::vector<float>  features;
+    if (! index->Featurize(*source, begin, end, features))
+    {
+        fmt::print(stderr, "{} lacks a feature joint\n", query);
+        return 1;
+    }
+    options.Exclude      = query;
+    options.ExcludeBegin = begin;
+    options.ExcludeEnd   = end;
+
+    std::uint32_t const length = std::uint32_t(features.size() / index->GetDimensionCount());
+    fmt::print("Query {} frames [{}, {}) as {} feature frames, {} sequences, {} threads\n",
+        query, begin, end, length, index->GetSequences().size(), VCX::Engine::ThreadPool::Global().GetThreadCount());
+
+    SimilarityIndex::Stats stats, reference;
+    auto const             matches = index->Search(features.data(), length, options, &stats);
+    options.Prune                  = false;
+    auto const             full    = index->Search(features.data(), length, options, &reference);
+
+    for (auto const & match : matches)
+    {
+        auto const & sequence = index->GetSequences()[match.Sequence];
+        fmt::print("  {:<40} frames [{:>6}, {:>6})  distance {:.4f}\n", sequence.Name, match.Begin, match.End, match.Distance);
+    }
+    bool same = matches.size() == full.size();
+    for (std::size_t i = 0; same && i < matches.size(); ++i) same = matches[i].Sequence == full[i].Sequence && matches[i].Begin == full[i].Begin;
+    fmt::print("Pruned:   {} pairs in {:.1f} ms, {:.0f} pairs/s ({} bounded, {} abandoned)\n",
+        stats.Pairs, 1e3 * stats.Seconds, stats.GetPairsPerSecond(), stats.Bounded, stats.Abandoned);
+    fmt::print("Full DTW: {} pairs in {:.1f} ms, {:.0f} pairs/s, {}\n",
+        reference.Pairs, 1e3 * reference.Seconds, reference.GetPairsPerSecond(), same ? "same matches" : "DIFFERENT MATCHES");
+    return same ? 0 : 1;
+}
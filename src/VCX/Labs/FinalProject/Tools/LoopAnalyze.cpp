@@ -0,0 +1,77 @@
+// Finds the loop points of every clip of the library and reports them with the time taken.
+// `--repeat` plays each clip several times over in one long clip, which must loop on a repetition
+// with no error, and shows how the search scales with the clip length.
+//
+//   xmake run loop-analyze [--data assets/BVH_data] [--blend 0.25] [--coverage 0.5] [--rate 30] [--repeat 1]
+
+#include <chrono>
+#include <cstdlib>
+#include <string>
+#include <string_view>
+
+#include <fmt/core.h>
+
+#include "Engine/ThreadPool.hpp"
+#include "Labs/FinalProject/BVHLoader.h"
+#include "Labs/FinalProject/ClipLibrary.h"
+#include "Labs/FinalProject/LoopPoints.h"
+
+using namespace VCX::Labs::FinalProject;
+
+static double Seconds(std::chrono::steady_clock::time_point const start)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+int main(int argc, char ** argv)
+{
+    std::string   data   = "assets/BVH_data";
+    LoopSettings  settings;
+    std::uint32_t repeat = 1;
+    for (int i = 1; i + 1 < argc; i += 2)
+    {
+        std::string_view const arg = argv[i];
+        if (arg == "--data") data = argv[i + 1];
+        else if (arg == "--blend") settings.BlendTime = std::strtof(argv[i + 1], nullptr);
+        else if (arg == "--coverage") settings.MinCoverage = std::strtof(argv[i + 1], nullptr);
+        else if (arg == "--rate") settings.AnalysisRate = std::strtof(argv[i + 1], nullptr);
+        else if (arg == "--repeat") repeat = std::max<std::uint32_t>(1, std::uint32_t(std::strtoul(argv[i + 1], nullptr, 10)));
+        else
+        {
+            fmt::print(stderr, "Unknown option {}\n", arg);
+            return 1;
+        }
+    }
+
+    BVHLoader   loader;
+    std::size_t clips = 0;
+    fmt::print("{} threads, analysis at {} fps, blend {} s, loops of at least {:.0f}% of the clip\n",
+        VCX::Engine::ThreadPool::Global().GetThreadCount(), settings.AnalysisRate, settings.BlendTime, 100.f * settings.MinCoverage);
+    fmt::print("{:<32} {:>7} {:>7} {:>7} {:>6} {:>9} {:>9}\n", "Clip", "Frames", "In", "Out", "Blend", "Error", "Time ms");
+    for (auto const & path : FindClips(data))
+    {
+        auto source = loader.LoadClip(path.c_str());
+        if (! source || source->Frames == 0) continue;
+
+        auto clip = std::make_shared<Clip>(*source);
+        for (std::uint32_t r = 1; r < repeat; ++r) clip->Channels.insert(clip->Channels.end(), source->Channels.begin(), source->Channels.end());
+        clip->Frames *= repeat;
+
+        auto const       start  = std::chrono::steady_clock::now();
+        LoopPoints const points = FindLoopPoints(*clip, settings);
+        double const     time   = Seconds(start);
+
+        std::string_view const name = std::string_view(path).substr(path.find_last_of("/\\") + 1);
+        if (points.IsValid())
+            fmt::print("{:<32} {:>7} {:>7} {:>7} {:>6} {:>9.5f} {:>9.1f}\n", name, clip->Frames, points.In, points.Out, points.Blend, points.Error, 1e3 * time);
+        else
+            fmt::print("{:<32} {:>7} {:>7} {:>7} {:>6} {:>9} {:>9.1f}\n", name, clip->Frames, "-", "-", "-", "-", 1e3 * time);
+        ++clips;
+    }
+    if (clips == 0)
+    {
+        fmt::print(stderr, "No clips under {}\n", data);
+        return 1;
+    }
+    return 0;
+}
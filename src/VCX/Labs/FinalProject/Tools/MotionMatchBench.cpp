@@ -0,0 +1,162 @@
+// Builds a motion-matching database over the clip library, grown to the requested size with
+// jittered copies of the clips, then times save/load and the three search paths.
+//
+//   xmake run mm-bench [--data assets/BVH_data] [--frames 1000000] [--queries 200] [--db .cache/motion.mmdb]
+
+#include <chrono>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <string_view>
+
+#include <fmt/core.h>
+
+#include "Engine/ThreadPool.hpp"
+#include "Labs/FinalProject/BVHLoader.h"
+#include "Labs/FinalProject/ClipLibrary.h"
+#include "Labs/FinalProject/MotionDatabase.h"
+
+using namespace VCX::Labs::FinalProject;
+
+static double Seconds(std::chrono::steady_clock::time_point const start)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Copy of a clip with every rotation channel jittered by up to a degree, so the copies are
+// distinct frames rather than exact duplicates.
+static std::shared_ptr<Clip const> Jitter(Clip const & source, std::uint32_t const seed)
+{
+    auto                                  clip = std::make_shared<Clip>(source);
+    std::mt19937                          rng(seed);
+    std::uniform_real_distribution<float> noise(-1.f, 1.f);
+    SkeletonDef const &                   def = *clip->Skeleton;
+    for (std::uint32_t f = 0; f < clip->Frames; ++f)
+    {
+        float * row = clip->Channels.data() + std::size_t(f) * def.ChannelCount;
+        for (std::uint32_t j = 0; j < def.GetJointCount(); ++j)
+        {
+            if (def.ChannelOffsets[j] < 0) continue;
+            int const rotation = def.ChannelOffsets[j] + (def.Channels[j] == 6 ? 3 : 0);
+            for (int c = 0; c < 3; ++c) row[rotation + c] += noise(rng);
+        }
+    }
+    return clip;
+}
+
+int main(int argc, char ** argv)
+{
+    std::string   data    = "assets/BVH_data";
+    std::string   output  = ".cache/motion.mmdb";
+    std::size_t   target  = 1000000;
+    std::uint32_t queries = 200;
+    for (int i = 1; i + 1 < argc; i += 2)
+    {
+        std::string_view const arg = argv[i];
+        if (arg == "--data") data = argv[i + 1];
+        else if (arg == "--db") output = argv[i + 1];
+        else if (arg == "--frames") target = std::strtoull(argv[i + 1], nullptr, 10);
+        else if (arg == "--queries") queries = std::uint32_t(std::strtoul(argv[i + 1], nullptr, 10));
+        else
+        {
+            fmt::print(stderr, "Unknown option {}\n", arg);
+            return 1;
+        }
+    }
+
+    // Originals first, then jittered copies until the target frame count is reached
+    BVHLoader                                loader;
+    std::vector<std::shared_ptr<Clip const>> clips;
+    std::vector<std::string>                 paths;
+    std::size_t                              frames = 0;
+    for (auto const & path : FindClips(data))
+    {
+        if (auto clip = loader.LoadClip(path.c_str()); clip && clip->Frames > 0)
+        {
+            clips.push_back(clip);
+            paths.push_back(path);
+            frames += clip->Frames;
+        }
+    }
+    if (clips.empty())
+    {
+        fmt::print(stderr, "No clips under {}\n", data);
+        return 1;
+    }
+
+    std::vector<std::string> names;
+    for (std::size_t total = 0; total < target || names.size() < clips.size();)
+    {
+        std::size_t const i = names.size();
+        names.push_back(fmt::format("{}#{}", paths[i % clips.size()], i / clips.size()));
+        total += clips[i % clips.size()]->Frames;
+    }
+    fmt::print("{} clips ({} frames), {} sources, {} threads\n", clips.size(), frames, names.size(), VCX::Engine::ThreadPool::Global().GetThreadCount());
+
+    auto start = std::chrono::steady_clock::now();
+    auto db    = MotionDatabase::Build(names, [&](std::size_t const index) {
+        std::size_t const original = index % clips.size();
+        return index < clips.size() ? clips[original] : Jitter(*clips[original], std::uint32_t(index));
+    });
+    double const build = Seconds(start);
+    fmt::print("Build: {} frames x {} features in {:.2f} s ({:.0f} frames/s)\n", db->GetFrameCount(), db->GetDimensionCount(), build, db->GetFrameCount() / build);
+
+    start = std::chrono::steady_clock::now();
+    if (! db->Save(output))
+    {
+        fmt::print(stderr, "Cannot write {}\n", output);
+        return 1;
+    }
+    double const save = Seconds(start);
+    start             = std::chrono::steady_clock::now();
+    auto loaded       = MotionDatabase::Load(output);
+    double const load = Seconds(start);
+    if (! loaded || loaded->GetFrameCount() != db->GetFrameCount())
+    {
+        fmt::print(stderr, "Reloading {} failed\n", output);
+        return 1;
+    }
+    fmt::print("Save: {:.2f} s, load: {:.2f} s ({})\n", save, load, output);
+    if (loaded->GetFrameCount() == 0)
+    {
+        fmt::print(stderr, "No frames to query in {}\n", output);
+        return 1;
+    }
+
+    // Queries are database poses with a perturbed trajectory, as when steering a character. The
+    // farther the desired trajectory is from anything recorded, the less the tree can prune.
+    std::uint32_t const                dims = loaded->GetDimensionCount();
+    std::vector<float>                 batch(std::size_t(queries) * dims);
+    std::vector<MotionDatabase::Match> reference(queries);
+    for (float const steering : { .1f, .25f, .5f })
+    {
+        std::mt19937                    rng(42);
+        std::uniform_int_distribution<> pick(0, int(loaded->GetFrameCount()) - 1);
+        std::normal_distribution<float> steer(0.f, steering);
+        for (std::uint32_t q = 0; q < queries; ++q)
+        {
+            float * query = batch.data() + std::size_t(q) * dims;
+            loaded->GetFeatures(std::uint32_t(pick(rng)), query);
+            for (std::uint32_t d = loaded->GetTrajectoryOffset(); d < dims; ++d) query[d] += steer(rng);
+        }
+
+        fmt::print("Steering deviation {:.2f}:\n", steering);
+        std::fill(reference.begin(), reference.end(), MotionDatabase::Match());
+        auto run = [&](char const * name, auto && search) {
+            std::uint32_t mismatches = 0;
+            auto const    begin      = std::chrono::steady_clock::now();
+            for (std::uint32_t q = 0; q < queries; ++q)
+            {
+                auto const match = search(batch.data() + std::size_t(q) * dims);
+                if (reference[q].Frame == MotionDatabase::Match().Frame) reference[q] = match;
+                else if (match.Frame != reference[q].Frame) ++mismatches;
+            }
+            double const seconds = Seconds(begin);
+            fmt::print("  {:<24} {:9.3f} ms/query, {} mismatches\n", name, 1e3 * seconds / queries, mismatches);
+        };
+        run("Brute force (1 thread)", [&](float const * query) { return loaded->SearchBruteForce(query, false); });
+        run("Brute force (parallel)", [&](float const * query) { return loaded->SearchBruteForce(query, true); });
+        run("KD-tree", [&](float const * query) { return loaded->Search(query); });
+    }
+    return 0;
+}
@@ -0,0 +1,314 @@
+// Converts a directory of clips into joint position, rotation and velocity arrays for Python,
+// loading and running forward kinematics on the clips in parallel. Each array is computed in one
+// buffer and written from it in a single sequential write, as .npy files per clip or appended to
+// one archive of three arrays, which numpy.load(..., mmap_mode="r") maps without reading it.
+//
+//   xmake run npy-export [--data assets/BVH_data] [--out export] [--layout files|archive]
+//                        [--joints Hips,LeftFoot,...] [--fps 0] [--up y|z] [--scale 1]
+//                        [--quat xyzw|wxyz]
+//
+// Positions are in BVH units times --scale, not the scene's; rotations are global. With --fps 0
+// the clips keep their own rate. `joints.txt` lists the exported joints, and an archive comes with
+// `clips.txt`, one "path begin end" line per clip in the order the clips were appended.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <glm/gtc/quaternion.hpp>
+
+#include <fmt/core.h>
+
+#include "Engine/ThreadPool.hpp"
+#include "Labs/FinalProject/BVHLoader.h"
+#include "Labs/FinalProject/ClipLibrary.h"
+#include "Labs/FinalProject/Pose.h"
+
+using namespace VCX::Labs::FinalProject;
+
+static constexpr std::size_t c_HeaderSize = 128; // Fixed, so that a streamed array's shape can be patched
+
+static double Seconds(std::chrono::steady_clock::time_point const start)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Little-endian float32 .npy (format 1.0) written as rows of a fixed shape, the row count patched
+// into the header on Close.
+class NpyWriter
+{
+public:
+    ~NpyWriter() { Close(); }
+
+    bool Open(std::filesystem::path const & path, std::vector<std::size_t> const & row)
+    {
+        _row  = row;
+        _rows = 0;
+        _file = std::fopen(path.string().c_str(), "wb");
+        if (! _file) return false;
+        std::setvbuf(_file, nullptr, _IOFBF, std::size_t(1) << 22);
+        return WriteHeader();
+    }
+
+    bool Append(float const * data, std::size_t const rows)
+    {
+        std::size_t count = rows;
+        for (std::size_t const n : _row) count *= n;
+        _rows += rows;
+        return std::fwrite(data, sizeof(float), count, _file) == count;
+    }
+
+    bool Close()
+    {
+        if (! _file) return true;
+        bool const ok = std::fseek(_file, 0, SEEK_SET) == 0 && WriteHeader();
+        std::fclose(_file);
+        _file = nullptr;
+        return ok;
+    }
+
+private:
+    bool WriteHeader()
+    {
+        std::string shape = fmt::format("{},", _rows);
+        for (std::size_t const n : _row) shape += fmt::format(" {},", n);
+        if (! _row.empty()) shape.pop_back();
+        std::string header = fmt::format("{{'descr': '<f4', 'fortran_order': False, 'shape': ({}), }}", shape);
+        header.resize(c_HeaderSize - 10 - 1, ' ');
+        header += '\n';
+
+        std::uint16_t const length = std::uint16_t(header.size());
+        char const          prefix[8] = { '\x93', 'N', 'U', 'M', 'P', 'Y', 1, 0 };
+        char const          size[2]   = { char(length & 0xFF), char(length >> 8) };
+        return std::fwrite(prefix, 1, 8, _file) == 8 && std::fwrite(size, 1, 2, _file) == 2 && std::fwrite(header.data(), 1, header.size(), _file) == header.size();
+    }
+
+    std::FILE *                 _file = nullptr;
+    std::vector<std::size_t>    _row;
+    std::size_t                 _rows = 0;
+};
+
+struct ExportOptions
+{
+    std::vector<std::string>    Joints;             // Empty for every joint but end sites of the first clip
+    float                       Fps     = 0.f;      // 0 for the clip's own rate
+    bool                        ZUp     = false;
+    float                       Scale   = 1.f;
+    bool                        WFirst  = false;
+};
+
+// Frames x joints x (3 + 4 + 3) floats of one clip, as three contiguous arrays.
+struct ClipArrays
+{
+    std::uint32_t       Frames = 0;
+    std::vector<float>  Positions;
+    std::vector<float>  Rotations;
+    std::vector<float>  Velocities;
+};
+
+static bool Convert(Clip const & clip, ExportOptions const & options, ClipArrays & out)
+{
+    // Looked up by name, so that skeletons listing the joints in another order still line up
+    SkeletonDef const & def = *clip.Skeleton;
+    std::vector<int>    joints;
+    for (auto const & name : options.Joints)
+    {
+        joints.push_back(def.Find(name));
+        if (joints.back() < 0) return false;
+    }
+
+    auto const          baked = BakedClip::Bake(clip);
+    float const         rate  = options.Fps > 0.f ? options.Fps : 1.f / clip.FrameTime;
+    std::uint32_t const n     = options.Fps > 0.f ? std::uint32_t((clip.Frames - 1) * clip.FrameTime * rate) + 1 : clip.Frames;
+    std::size_t const   count = joints.size();
+    out.Frames                = n;
+    out.Positions.resize(std::size_t(n) * count * 3);
+    out.Rotations.resize(std::size_t(n) * count * 4);
+    out.Velocities.resize(std::size_t(n) * count * 3);
+
+    // Scene space back to BVH units, then the requested convention
+    glm::quat const        basis = options.ZUp ? glm::angleAxis(glm::radians(90.f), glm::vec3(1.f, 0.f, 0.f)) : glm::quat(1.f, 0.f, 0.f, 0.f);
+    Pose                   pose;
+    std::vector<glm::vec3> positions(def.GetJointCount());
+    std::vector<glm::quat> rotations(def.GetJointCount());
+    for (std::uint32_t f = 0; f < n; ++f)
+    {
+        if (options.Fps > 0.f) baked->Sample(f / rate, false, pose);
+        else baked->SampleFrame(f, pose);
+        ForwardKinematics(def, pose, positions.data(), rotations.data());
+        float * p = out.Positions.data() + std::size_t(f) * count * 3;
+        float * q = out.Rotations.data() + std::size_t(f) * count * 4;
+        for (std::size_t k = 0; k < count; ++k)
+        {
+            glm::vec3 const position = basis * ((positions[joints[k]] - SceneOffset) * (options.Scale / SceneScale));
+            glm::quat const rotation = basis * rotations[joints[k]] * glm::inverse(basis);
+            p[3 * k + 0] = position.x, p[3 * k + 1] = position.y, p[3 * k + 2] = position.z;
+            if (options.WFirst) q[4 * k + 0] = rotation.w, q[4 * k + 1] = rotation.x, q[4 * k + 2] = rotation.y, q[4 * k + 3] = rotation.z;
+            else q[4 * k + 0] = rotation.x, q[4 * k + 1] = rotation.y, q[4 * k + 2] = rotation.z, q[4 * k + 3] = rotation.w;
+        }
+    }
+
+    // Central differences, one-sided at the ends, in units per second
+    std::size_t const row = count * 3;
+    for (std::uint32_t f = 0; f < n; ++f)
+    {
+        std::uint32_t const a = f > 0 ? f - 1 : 0;
+        std::uint32_t const b = f + 1 < n ? f + 1 : n - 1;
+        float const         s = b > a ? rate / float(b - a) : 0.f;
+        for (std::size_t i = 0; i < row; ++i) out.Velocities[f * row + i] = (out.Positions[b * row + i] - out.Positions[a * row + i]) * s;
+    }
+    return true;
+}
+
+int main(int argc, char ** argv)
+{
+    std::string   data    = "assets/BVH_data";
+    std::string   outDir  = "export";
+    bool          archive = false;
+    ExportOptions options;
+    for (int i = 1; i + 1 < argc; i += 2)
+    {
+        std::string_view const arg   = argv[i];
+        std::string_view const value = argv[i + 1];
+        if (arg == "--data") data = value;
+        else if (arg == "--out") outDir = value;
+        else if (arg == "--layout") archive = value == "archive";
+        else if (arg == "--fps") options.Fps = std::strtof(argv[i + 1], nullptr);
+        else if (arg == "--up") options.ZUp = value == "z";
+        else if (arg == "--scale") options.Scale = std::strtof(argv[i + 1], nullptr);
+        else if (arg == "--quat") options.WFirst = value == "wxyz";
+        else if (arg == "--joints")
+        {
+            for (std::size_t begin = 0; begin <= value.size();)
+            {
+                std::size_t const end = std::min(value.find(',', begin), value.size());
+                if (end > begin) options.Joints.emplace_back(value.substr(begin, end - begin));
+                begin = end + 1;
+            }
+        }
+        else
+        {
+            fmt::print(stderr, "Unknown option {}\n", arg);
+            return 1;
+        }
+    }
+
+    ClipList const paths = FindClips(data);
+    if (paths.empty())
+    {
+        fmt::print(stderr, "No clips under {}\n", data);
+        return 1;
+    }
+    std::filesystem::path const out(outDir);
+    std::error_code             ec;
+    std::filesystem::create_directories(out, ec);
+
+    // The joint list of the first readable clip, which every other clip must contain
+    std::vector<std::string> & names = options.Joints;
+    for (std::size_t c = 0; names.empty() && c < paths.size(); ++c)
+    {
+        try
+        {
+            BVHLoader loader;
+            if (auto const clip = loader.LoadClip(paths[c].c_str()))
+                for (auto const & name : clip->Skeleton->Names)
+                    if (name != "???") names.push_back(name);
+        }
+        catch (std::exception const &) { }
+    }
+    if (names.empty())
+    {
+        fmt::print(stderr, "No readable clips under {}\n", data);
+        return 1;
+    }
+    {
+        std::ofstream file(out / "joints.txt");
+        for (auto const & name : names) file << name << '\n';
+    }
+
+    std::vector<std::size_t> const position { names.size(), 3 }, rotation { names.size(), 4 };
+    NpyWriter                      positions, rotations, velocities;
+    if (archive && ! (positions.Open(out / "positions.npy", position) && rotations.Open(out / "rotations.npy", rotation) && velocities.Open(out / "velocities.npy", position)))
+    {
+        fmt::print(stderr, "Cannot write to {}\n", outDir);
+        return 1;
+    }
+    std::mutex                 mutex;
+    std::vector<std::string>   index;   // Archive rows of each clip
+    std::size_t                rows   = 0;
+    std::atomic<std::size_t>   frames = 0, failed = 0;
+    auto const                 start  = std::chrono::steady_clock::now();
+
+    VCX::Engine::ThreadPool::Global().ParallelFor(paths.size(), 1, [&](std::size_t const begin, std::size_t const end) {
+        BVHLoader  loader;
+        ClipArrays arrays;
+        for (std::size_t c = begin; c < end; ++c)
+        {
+            std::string error;
+            try
+            {
+                auto const clip = loader.LoadClip(paths[c].c_str());
+                if (! clip || clip->Frames == 0) error = "no frames";
+                else if (auto const missing = std::find_if(names.begin(), names.end(), [&](std::string const & name) { return clip->Skeleton->Find(name) < 0; }); missing != names.end())
+                    error = fmt::format("no joint {}", *missing);
+                else if (! Convert(*clip, options, arrays)) error = "cannot convert";
+            }
+            catch (std::exception const & e) { error = e.what(); }
+            if (! error.empty())
+            {
+                ++failed;
+                std::lock_guard lock(mutex);
+                fmt::print(stderr, "Skipped {}: {}\n", paths[c], error);
+                continue;
+            }
+
+            if (archive)
+            {
+                std::lock_guard lock(mutex);
+                positions.Append(arrays.Positions.data(), arrays.Frames);
+                rotations.Append(arrays.Rotations.data(), arrays.Frames);
+                velocities.Append(arrays.Velocities.data(), arrays.Frames);
+                index.push_back(fmt::format("{} {} {}", paths[c], rows, rows + arrays.Frames));
+                rows += arrays.Frames;
+            }
+            else
+            {
+                // Subdirectories flattened into the file name
+                std::string stem = std::filesystem::path(paths[c]).lexically_relative(data).replace_extension().generic_string();
+                std::replace(stem.begin(), stem.end(), '/', '_');
+                NpyWriter file;
+                bool      written = file.Open(out / (stem + ".positions.npy"), position) && file.Append(arrays.Positions.data(), arrays.Frames) && file.Close();
+                written          &= file.Open(out / (stem + ".rotations.npy"), rotation) && file.Append(arrays.Rotations.data(), arrays.Frames) && file.Close();
+                written          &= file.Open(out / (stem + ".velocities.npy"), position) && file.Append(arrays.Velocities.data(), arrays.Frames) && file.Close();
+                if (! written)
+                {
+                    ++failed;
+                    std::lock_guard lock(mutex);
+                    fmt::print(stderr, "Cannot write {}\n", stem);
+                    continue;
+                }
+            }
+            frames += arrays.Frames;
+        }
+    });
+
+    bool const closed = positions.Close() && rotations.Close() && velocities.Close();
+    if (archive)
+    {
+        std::ofstream file(out / "clips.txt");
+        for (auto const & line : index) file << line << '\n';
+    }
+    double const      seconds = Seconds(start);
+    std::size_t const cores   = VCX::Engine::ThreadPool::Global().GetThreadCount();
+    fmt::print("{} clips, {} frames of {} joints to {} in {:.2f} s: {:.0f} frames/s, {:.0f} frames/s/core ({} threads)\n",
+        paths.size() - failed, frames.load(), names.size(), outDir, seconds, frames / seconds, frames / seconds / cores, cores);
+    return failed == 0 && closed ? 0 : 1;
+}
@@ -0,0 +1,121 @@
+// Times the skinning palettes for a crowd's worth of poses of one clip: 3x4 matrices against dual
+// quaternions, the latter joint by joint and in SIMD batches. The batches are checked against the
+// joint-by-joint path, and points near each joint against the matrices, which give the same rigid
+// transforms; blending is where the two differ, on the GPU.
+//
+//   xmake run palette-bench [--data assets/BVH_data] [--crowd 1000] [--repeat 20]
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <string>
+#include <string_view>
+
+#include <fmt/core.h>
+
+#include "Labs/FinalProject/BVHLoader.h"
+#include "Labs/FinalProject/ClipLibrary.h"
+#include "Labs/FinalProject/Pose.h"
+#include "Labs/FinalProject/SkinPalette.h"
+
+using namespace VCX::Labs::FinalProject;
+
+static double Seconds(std::chrono::steady_clock::time_point const start)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Skinned by a dual quaternion: rotation, then the translation 2 * dual * conjugate(real)
+static glm::vec3 Transform(glm::vec4 const * dq, glm::vec3 const & p)
+{
+    glm::vec3 const real { dq[0] }, dual { dq[1] };
+    float const     w = dq[0].w, dw = dq[1].w;
+    glm::vec3 const rotated = p + 2.f * glm::cross(real, glm::cross(real, p) + w * p);
+    return rotated + 2.f * (w * dual - dw * real + glm::cross(real, dual));
+}
+
+int main(int argc, char ** argv)
+{
+    std::string   data   = "assets/BVH_data";
+    std::size_t   crowd  = 1000;
+    std::uint32_t repeat = 20;
+    for (int i = 1; i + 1 < argc; i += 2)
+    {
+        std::string_view const arg = argv[i];
+        if (arg == "--data") data = argv[i + 1];
+        else if (arg == "--crowd") crowd = std::max<std::size_t>(1, std::strtoull(argv[i + 1], nullptr, 10));
+        else if (arg == "--repeat") repeat = std::max(1u, std::uint32_t(std::strtoul(argv[i + 1], nullptr, 10)));
+        else
+        {
+            fmt::print(stderr, "Unknown option {}\n", arg);
+            return 1;
+        }
+    }
+
+    BVHLoader                         loader;
+    std::shared_ptr<BakedClip const>  clip;
+    std::string                       name;
+    for (auto const & path : FindClips(data))
+    {
+        auto const loaded = loader.LoadClip(path.c_str());
+        if (! loaded || loaded->Frames == 0) continue;
+        clip = BakedClip::Bake(*loaded);
+        name = path;
+        break;
+    }
+    if (! clip)
+    {
+        fmt::print(stderr, "No clips under {}\n", data);
+        return 1;
+    }
+
+    // Rest positions from the rest offsets, and the crowd's poses spread over the clip
+    SkeletonDef const &    def    = *clip->Skeleton;
+    std::uint32_t const    joints = def.GetJointCount();
+    std::size_t const      count  = crowd * joints;
+    Pose                   pose;
+    std::vector<glm::vec3> rest(joints), positions(count);
+    std::vector<glm::quat> rotations(count);
+    pose.Resize(joints);
+    pose.Offsets = def.Offsets;
+    ForwardKinematics(def, pose, rest.data(), rotations.data());
+    for (std::size_t i = 0; i < crowd; ++i)
+    {
+        clip->SampleFrame(std::uint32_t(i * 37 % clip->Frames), pose);
+        ForwardKinematics(def, pose, positions.data() + i * joints, rotations.data() + i * joints);
+    }
+
+    std::vector<glm::vec4> matrices(count * TexelsPerMatrix), single(count * TexelsPerDualQuaternion), batched(count * TexelsPerDualQuaternion);
+    auto start = std::chrono::steady_clock::now();
+    for (std::uint32_t r = 0; r < repeat; ++r) ComputeMatrixPalette(rotations.data(), positions.data(), rest.data(), joints, crowd, matrices.data());
+    double const matrixTime = Seconds(start) / repeat;
+    start = std::chrono::steady_clock::now();
+    for (std::uint32_t r = 0; r < repeat; ++r)
+        for (std::size_t i = 0; i < count; ++i)
+            ToDualQuaternion(rotations[i], positions[i] - rotations[i] * rest[i % joints], single.data() + TexelsPerDualQuaternion * i);
+    double const singleTime = Seconds(start) / repeat;
+    start = std::chrono::steady_clock::now();
+    for (std::uint32_t r = 0; r < repeat; ++r) ComputeDualQuaternionPalette(rotations.data(), positions.data(), rest.data(), joints, crowd, batched.data());
+    double const batchTime = Seconds(start) / repeat;
+
+    float batchError = 0.f, transformError = 0.f;
+    for (std::size_t i = 0; i < single.size(); ++i) batchError = std::max(batchError, glm::length(single[i] - batched[i]));
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        glm::vec3 const   p   = rest[i % joints] + glm::vec3(.03f, -.02f, .05f);
+        glm::vec4 const * m   = matrices.data() + TexelsPerMatrix * i;
+        glm::vec3 const   lbs = { glm::dot(glm::vec3(m[0]), p) + m[0].w, glm::dot(glm::vec3(m[1]), p) + m[1].w, glm::dot(glm::vec3(m[2]), p) + m[2].w };
+        transformError        = std::max(transformError, glm::distance(lbs, Transform(batched.data() + TexelsPerDualQuaternion * i, p)));
+    }
+
+    auto const report = [&](char const * label, double const seconds, std::uint32_t const texels) {
+        fmt::print("  {:<24} {:>7.3f} ms/frame, {:>6.2f} ns/joint, {:>5} bytes/character\n",
+            label, 1e3 * seconds, 1e9 * seconds / count, joints * texels * sizeof(glm::vec4));
+    };
+    fmt::print("{}: {} joints, {} characters\n", name, joints, crowd);
+    report("matrices", matrixTime, TexelsPerMatrix);
+    report("dual quaternions", singleTime, TexelsPerDualQuaternion);
+    report("dual quaternions, batch", batchTime, TexelsPerDualQuaternion);
+    fmt::print("Batch against single {:.2e}, dual quaternions against matrices {:.2e}\n", batchError, transformError);
+    return batchError < 1e-5f && transformError < 1e-4f ? 0 : 1;
+}
@@ -0,0 +1,171 @@
+// Retargets the clips onto a game-style rig and times it: whole clips in frames per second, and a
+// crowd's worth of poses per frame. The target rig is derived from each clip's own skeleton (only
+// CMU rigs ship), with Unreal-style names, the hip and extra neck joints folded away, no fingers,
+// a quarter larger and with the arms in an A-pose, which exercises the name table, the chain
+// composition and the rest-pose corrections. Bone directions are checked against the source.
+//
+//   xmake run retarget-bench [--data assets/BVH_data] [--crowd 1000] [--repeat 5]
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <glm/gtc/quaternion.hpp>
+
+#include <fmt/core.h>
+
+#include "Engine/ThreadPool.hpp"
+#include "Labs/FinalProject/BVHLoader.h"
+#include "Labs/FinalProject/ClipLibrary.h"
+#include "Labs/FinalProject/Retarget.h"
+
+using namespace VCX::Labs::FinalProject;
+
+static double Seconds(std::chrono::steady_clock::time_point const start)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+static std::shared_ptr<SkeletonDef const> MakeGameRig(SkeletonDef const & source)
+{
+    static std::unordered_map<std::string_view, std::string_view> const names = {
+        { "Hips", "pelvis" }, { "LowerBack", "spine_01" }, { "Spine", "spine_02" }, { "Spine1", "spine_03" }, { "Neck", "neck_01" }, { "Head", "head" },
+        { "LeftUpLeg", "thigh_l" }, { "LeftLeg", "calf_l" }, { "LeftFoot", "foot_l" }, { "LeftToeBase", "ball_l" },
+        { "RightUpLeg", "thigh_r" }, { "RightLeg", "calf_r" }, { "RightFoot", "foot_r" }, { "RightToeBase", "ball_r" },
+        { "LeftShoulder", "clavicle_l" }, { "LeftArm", "upperarm_l" }, { "LeftForeArm", "lowerarm_l" }, { "LeftHand", "hand_l" },
+        { "RightShoulder", "clavicle_r" }, { "RightArm", "upperarm_r" }, { "RightForeArm", "lowerarm_r" }, { "RightHand", "hand_r" },
+    };
+
+    // Joints kept, and the new index of each; folded joints pass their offset on to their children
+    std::uint32_t const joints = source.GetJointCount();
+    std::vector<int>    remap(joints, -1);
+    std::vector<bool>   removed(joints, false);
+    SkeletonDef         def;
+    for (std::uint32_t j = 0; j < joints; ++j)
+    {
+        int const         parent = source.Parents[j];
+        std::string const name   = source.Names[j];
+        if (parent >= 0 && removed[parent]) removed[j] = true;
+        else if (name != "???" && ! names.contains(name)) removed[j] = name.find("Hand") != std::string::npos || name.find("Finger") != std::string::npos || name.find("Thumb") != std::string::npos;
+        if (removed[j]) continue;
+
+        glm::vec3 offset   = source.Offsets[j];
+        int       ancestor = parent;
+        for (; ancestor >= 0 && remap[ancestor] < 0; ancestor = source.Parents[ancestor]) offset += source.Offsets[ancestor];
+        if (name != "???" && ! names.contains(name) && ancestor >= 0) continue; // Folded into its children
+
+        remap[j] = int(def.Names.size());
+        def.Names.push_back(name == "???" ? name : std::string(names.at(name)));
+        def.Parents.push_back(ancestor >= 0 ? remap[ancestor] : -1);
+        def.Offsets.push_back(1.25f * offset);
+        def.PositionOrder.push_back(source.PositionOrder[j]);
+        def.RotationOrder.push_back(source.RotationOrder[j]);
+        def.Channels.push_back(source.Channels[j]);
+        def.ChannelOffsets.push_back(source.Channels[j] ? int(def.ChannelCount) : -1);
+        def.ChannelCount += source.Channels[j];
+    }
+
+    // A-pose: everything below the upper arms turned 45 degrees down
+    for (auto const & [arm, sign] : { std::pair { "upperarm_l", 1.f }, std::pair { "upperarm_r", -1.f } })
+    {
+        int const root = def.Find(arm);
+        if (root < 0) continue;
+        glm::quat const down = glm::angleAxis(sign * glm::radians(-45.f), glm::vec3(0.f, 0.f, 1.f));
+        for (std::uint32_t j = root + 1; j < def.GetJointCount(); ++j)
+        {
+            int p = def.Parents[j];
+            while (p > root) p = def.Parents[p];
+            if (p == root) def.Offsets[j] = down * def.Offsets[j];
+        }
+    }
+    return SkeletonRegistry::Global().Intern(std::move(def));
+}
+
+// Largest angle between a target bone and its source bone over a clip, in degrees. Bones spanning
+// joints the target folds away are skipped: they cannot follow the folded joint's own rotation.
+static float MeasureError(RetargetMap const & map, BakedClip const & source, BakedClip const & target)
+{
+    SkeletonDef const &    src = *map.GetSource();
+    SkeletonDef const &    dst = *map.GetTarget();
+    Pose                   srcPose, dstPose;
+    std::vector<glm::vec3> srcPositions(src.GetJointCount()), dstPositions(dst.GetJointCount());
+    std::vector<glm::quat> srcRotations(src.GetJointCount()), dstRotations(dst.GetJointCount());
+    float                  error = 0.f;
+    for (std::uint32_t f = 0; f < source.Frames; f += 7)
+    {
+        source.SampleFrame(f, srcPose);
+        target.SampleFrame(f, dstPose);
+        ForwardKinematics(src, srcPose, srcPositions.data(), srcRotations.data());
+        ForwardKinematics(dst, dstPose, dstPositions.data(), dstRotations.data());
+        for (std::uint32_t j = 1; j < dst.GetJointCount(); ++j)
+        {
+            int parent = dst.Parents[j];
+            while (parent >= 0 && map.GetSourceJoint(parent) < 0) parent = dst.Parents[parent];
+            if (map.GetSourceJoint(j) < 0 || parent < 0 || src.Parents[map.GetSourceJoint(j)] != map.GetSourceJoint(parent)) continue;
+            glm::vec3 const a = dstPositions[j] - dstPositions[parent];
+            glm::vec3 const b = srcPositions[map.GetSourceJoint(j)] - srcPositions[map.GetSourceJoint(parent)];
+            if (glm::length(a) < 1e-5f || glm::length(b) < 1e-5f) continue;
+            error = std::max(error, glm::degrees(std::acos(std::clamp(glm::dot(glm::normalize(a), glm::normalize(b)), -1.f, 1.f))));
+        }
+    }
+    return error;
+}
+
+int main(int argc, char ** argv)
+{
+    std::string   data   = "assets/BVH_data";
+    std::size_t   crowd  = 1000;
+    std::uint32_t repeat = 5;
+    for (int i = 1; i + 1 < argc; i += 2)
+    {
+        std::string_view const arg = argv[i];
+        if (arg == "--data") data = argv[i + 1];
+        else if (arg == "--crowd") crowd = std::strtoull(argv[i + 1], nullptr, 10);
+        else if (arg == "--repeat") repeat = std::max(1u, std::uint32_t(std::strtoul(argv[i + 1], nullptr, 10)));
+        else
+        {
+            fmt::print(stderr, "Unknown option {}\n", arg);
+            return 1;
+        }
+    }
+
+    BVHLoader loader;
+    fmt::print("{} threads, {} characters per crowd frame\n", VCX::Engine::ThreadPool::Global().GetThreadCount(), crowd);
+    float worst = 0.f;
+    for (auto const & path : FindClips(data))
+    {
+        auto const clip = loader.LoadClip(path.c_str());
+        if (! clip || clip->Frames == 0) continue;
+        auto const source = BakedClip::Bake(*clip);
+        auto const target = MakeGameRig(*clip->Skeleton);
+
+        auto       start = std::chrono::steady_clock::now();
+        auto const map   = RetargetMap::Build(clip->Skeleton, target);
+        double const build = Seconds(start);
+        if (! map)
+        {
+            fmt::print("  {:<40} cannot be paired\n", path);
+            continue;
+        }
+
+        std::shared_ptr<BakedClip const> result;
+        start = std::chrono::steady_clock::now();
+        for (std::uint32_t r = 0; r < repeat; ++r) result = map->Retarget(*source);
+        double const clipTime = Seconds(start) / repeat;
+
+        std::vector<Pose> sources(crowd), targets(crowd);
+        for (std::size_t i = 0; i < crowd; ++i) source->SampleFrame(std::uint32_t(i * 37 % source->Frames), sources[i]);
+        start = std::chrono::steady_clock::now();
+        for (std::uint32_t r = 0; r < repeat; ++r) map->Apply(sources.data(), targets.data(), crowd);
+        double const crowdTime = Seconds(start) / repeat;
+
+        float const error = MeasureError(*map, *source, *result);
+        worst             = std::max(worst, error);
+        fmt::print("  {:<40} {:>2}/{:<2} joints paired, build {:.2f} ms, {:.2f}M frames/s, crowd {:.2f} ms/frame, max bone error {:.3f} deg\n",
+            path, map->GetPairedCount(), target->GetJointCount(), 1e3 * build, source->Frames / clipTime * 1e-6, 1e3 * crowdTime, error);
+    }
+    fmt::print("Max bone error {:.3f} deg\n", worst);
+    return worst < 1.f ? 0 : 1;
+}
@@ -0,0 +1,123 @@
+#include <algorithm>
+#include <chrono>
+#include <string_view>
+
+#include "Engine/ThreadPool.hpp"
+#include "Labs/FinalProject/Pose.h"
+#include "Labs/FinalProject/TrajectoryCurves.h"
+
+namespace VCX::Labs::FinalProject
+{
+    static constexpr float c_SpeedPercentile = .95f;   // Speeds above it get the hottest colour
+
+    static std::vector<std::uint32_t> SelectJoints(SkeletonDef const & def, unsigned const groups)
+    {
+        std::vector<std::uint32_t> joints;
+        for (std::uint32_t j = 0; j < def.GetJointCount(); ++j)
+        {
+            std::string_view const name = def.Names[j];
+            if (((groups & TrajectoryCurves::Root) && def.Parents[j] < 0)
+                || ((groups & TrajectoryCurves::Hands) && name.ends_with("Hand"))
+                || ((groups & TrajectoryCurves::Feet) && name.ends_with("Foot")))
+                joints.push_back(j);
+        }
+        return joints;
+    }
+
+    TrajectoryCurves::TrajectoryCurves() :
+        _program(
+            Engine::GL::UniqueProgram({
+                Engine::GL::SharedShader("assets/shaders/trail.vert"),
+                Engine::GL::SharedShader("assets/shaders/ghost.frag")})),
+        _item(
+            Engine::GL::VertexLayout()
+                .Add<glm::vec3>("position", Engine::GL::DrawFrequency::Static, 0)
+                .Add<glm::vec2>("sample", Engine::GL::DrawFrequency::Static, 1),
+            Engine::GL::PrimitiveType::Lines)
+    {
+        FrameUniforms::Bind(_program);
+        _time = _program.GetUniforms().GetHandle<float>("u_Time");
+    }
+
+    void TrajectoryCurves::Build(std::shared_ptr<Clip const> const & clip, unsigned const groups)
+    {
+        if (clip == _clip && groups == _groups) return;
+        _clip   = clip;
+        _groups = groups;
+        _curves = 0;
+        _roots.clear();
+        if (! clip || clip->Frames < 2) return;
+
+        auto const                       start  = std::chrono::steady_clock::now();
+        auto const                       baked  = BakedClip::Bake(*clip);
+        SkeletonDef const &              def    = *baked->Skeleton;
+        std::vector<std::uint32_t> const joints = SelectJoints(def, groups);
+        std::uint32_t const              frames = baked->Frames;
+        _frameTime                              = baked->FrameTime;
+
+        // Curve by curve, frames in order; all frames posed in parallel
+        std::vector<glm::vec3> positions(std::size_t(joints.size()) * frames);
+        _roots.resize(frames);
+        Engine::ThreadPool::Global().ParallelFor(frames, 64, [&](std::size_t const begin, std::size_t const end) {
+            Pose                   pose;
+            std::vector<glm::vec3> globals(def.GetJointCount());
+            std::vector<glm::quat> rotations(def.GetJointCount());
+            for (std::size_t f = begin; f < end; ++f)
+            {
+                baked->SampleFrame(std::uint32_t(f), pose);
+                ForwardKinematics(def, pose, globals.data(), rotations.data());
+                _roots[f] = globals[0];
+                for (std::size_t c = 0; c < joints.size(); ++c) positions[c * frames + f] = globals[joints[c]];
+            }
+        });
+
+        // Central differences, one-sided at the ends
+        std::vector<glm::vec2> samples(positions.size());
+        std::vector<float>     speeds(positions.size());
+        for (std::size_t c = 0; c < joints.size(); ++c)
+            for (std::uint32_t f = 0; f < frames; ++f)
+            {
+                std::uint32_t const a = f > 0 ? f - 1 : f, b = f + 1 < frames ? f + 1 : f;
+                std::size_t const   i = c * frames + f;
+                speeds[i]             = glm::distance(positions[c * frames + a], positions[c * frames + b]) / ((b - a) * _frameTime);
+                samples[i]            = glm::vec2(f * _frameTime, speeds[i]);
+            }
+        _maxSpeed = 0.f;
+        if (! speeds.empty())
+        {
+            auto const nth = speeds.begin() + std::ptrdiff_t((speeds.size() - 1) * c_SpeedPercentile);
+            std::nth_element(speeds.begin(), nth, speeds.end());
+            _maxSpeed = *nth;
+        }
+
+        std::vector<std::uint32_t> indices;
+        indices.reserve(joints.size() * (frames - 1) * 2);
+        for (std::size_t c = 0; c < joints.size(); ++c)
+            for (std::uint32_t f = 0; f + 1 < frames; ++f)
+            {
+                indices.push_back(std::uint32_t(c * frames + f));
+                indices.push_back(std::uint32_t(c * frames + f + 1));
+            }
+        _item.UpdateVertexBuffer("position", Engine::make_span_bytes<glm::vec3>(positions));
+        _item.UpdateVertexBuffer("sample", Engine::make_span_bytes<glm::vec2>(samples));
+        _item.UpdateElementBuffer(indices);
+        _program.GetUniforms().SetByName("u_MaxSpeed", std::max(_maxSpeed, 1e-6f));
+        _curves  = std::uint32_t(joints.size());
+        _buildMs = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    void TrajectoryCurves::Render(std::uint32_t const frame, glm::vec3 const & root)
+    {
+        if (_curves == 0) return;
+        std::size_t const shown = std::min<std::size_t>(frame, _roots.size() - 1);
+        _program.GetUniforms().Set(_time, shown * _frameTime);
+
+        // Non-zero under accumulated root motion or foot locking
+        auto & uniforms = FrameUniforms::Global();
+        Engine::GL::State::Enable(GL_BLEND);
+        Engine::GL::State::BlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+        Engine::GL::State::LineWidth(1.f);
+        _item.Draw({ _program.Use(), uniforms.Use(uniforms.Queue({ .Offset = glm::vec4(root - _roots[shown], 0.f) })) });
+        Engine::GL::State::Disable(GL_BLEND);
+    }
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "Engine/GL/Program.h"
+#include "Engine/GL/RenderItem.h"
+#include "Labs/FinalProject/Clip.h"
+#include "Labs/FinalProject/FrameUniforms.h"
+
+namespace VCX::Labs::FinalProject
+{
+    // Paths of selected joints over a whole clip as polylines coloured by speed. The curves are
+    // computed from the clip's forward kinematics once per clip and selection, frames in parallel,
+    // and uploaded into static buffers; per frame only the current time is set and the root offset
+    // queued as a draw block, the path ahead of the current time being drawn faded.
+    class TrajectoryCurves
+    {
+    public:
+        enum Group : unsigned { Root = 1, Hands = 2, Feet = 4 };
+
+        TrajectoryCurves();
+
+        // Rebuilds only when the clip or the groups change.
+        void Build(std::shared_ptr<Clip const> const & clip, unsigned const groups);
+        // At `frame` the root lies at `root`, the curves are moved along like the onion skin. With
+        // the camera of FrameUniforms.
+        void Render(std::uint32_t const frame, glm::vec3 const & root);
+
+        std::uint32_t GetCurveCount() const { return _curves; }
+        std::size_t   GetVertexCount() const { return _roots.empty() ? 0 : std::size_t(_curves) * _roots.size(); }
+        float         GetBuildMs() const { return _buildMs; }
+        float         GetMaxSpeed() const { return _maxSpeed; }
+
+    private:
+        Engine::GL::UniqueProgram           _program;
+        Engine::GL::UniqueIndexedRenderItem _item;
+        std::shared_ptr<Clip const>         _clip;
+        unsigned                            _groups   = 0;
+        std::uint32_t                       _curves   = 0;
+        float                               _frameTime = 0.f;
+        std::vector<glm::vec3>              _roots;         // Root position per frame, for the offset
+        Engine::GL::UniformHandle<float>    _time;
+        float                               _maxSpeed  = 0.f;   // Scene units per second at full colour
+        float                               _buildMs   = 0.f;
+    };
+}
@@ -66,11 +66,80 @@ target("lab-common")
     add_headerfiles("src/VCX/Labs/Common/**.hpp")
     add_files("src/VCX/Labs/Common/**.cpp")
 
-target("final")
-    set_kind("binary")
+target("final-core")
+    set_kind("static")
     add_deps("lab-common")
-    add_defines("GLM_ENABLE_EXPERIMENTAL")
+    add_defines("GLM_ENABLE_EXPERIMENTAL", { public = true })
     add_cxflags("/utf-8")
     add_headerfiles("src/VCX/Labs/FinalProject/**.h")
     add_headerfiles("src/VCX/Labs/FinalProject/**.hpp")
-    add_files("src/VCX/Labs/FinalProject/**.cpp")
\ No newline at end of file
+    add_files("src/VCX/Labs/FinalProject/**.cpp|main.cpp|Tools/*.cpp")
+
+target("final")
+    set_kind("binary")
+    add_deps("final-core")
+    add_cxflags("/utf-8")
+    add_files("src/VCX/Labs/FinalProject/main.cpp")
+
+target("mm-bench")
+    set_kind("binary")
+    set_default(false)
+    add_deps("final-core")
+    add_cxflags("/utf-8")
+    add_files("src/VCX/Labs/FinalProject/Tools/MotionMatchBench.cpp")
+
+target("clip-compress")
+    set_kind("binary")
+    set_default(false)
+    add_deps("final-core")
+    add_cxflags("/utf-8")
+    add_files("src/VCX/Labs/FinalProject/Tools/ClipCompress.cpp")
+
+target("loop-analyze")
+    set_kind("binary")
+    set_default(false)
+    add_deps("final-core")
+    add_cxflags("/utf-8")
+    add_files("src/VCX/Labs/FinalProject/Tools/LoopAnalyze.cpp")
+
+target("clip-similar")
+    set_kind("binary")
+    set_default(false)
+    add_deps("final-core")
+    add_cxflags("/utf-8")
+    add_files("src/VCX/Labs/FinalProject/Tools/ClipSimilar.cpp")
+
+target("retarget-bench")
+    set_kind("binary")
+    set_default(false)
+    add_deps("final-core")
+    add_cxflags("/utf-8")
+    add_files("src/VCX/Labs/FinalProject/Tools/RetargetBench.cpp")
+
+target("npy-export")
+    set_kind("binary")
+    set_default(false)
+    add_deps("final-core")
+    add_cxflags("/utf-8")
+    add_files("src/VCX/Labs/FinalProject/Tools/NpyExport.cpp")
+
+target("clip-pack")
+    set_kind("binary")
+    set_default(false)
+    add_deps("final-core")
+    add_cxflags("/utf-8")
+    add_files("src/VCX/Labs/FinalProject/Tools/ClipPack.cpp")
+
+target("clip-resample")
+    set_kind("binary")
+    set_default(false)
+    add_deps("final-core")
+    add_cxflags("/utf-8")
+    add_files("src/VCX/Labs/FinalProject/Tools/ClipResample.cpp")
+
+target("palette-bench")
+    set_kind("binary")
+    set_default(false)
+    add_deps("final-core")
+    add_cxflags("/utf-8")
+    add_files("src/VCX/Labs/FinalProject/Tools/PaletteBench.cpp")